@@ -0,0 +1,261 @@
+// --- BENCHMARK DE LA CALIBRACIÓN DEL MQ135 Y DEL SUELO ---
+// compara las conversiones en enteros de common/lib/Calibracion/Calibracion.h (tablas generadas al compilar) con la
+//   fórmula de referencia en double:
+//   - MQ135: todos los raw de 1 a vc-1 con varias calibraciones y temperaturas/humedades. El error es el relativo que
+//     queda después de quitar el redondeo a ppm enteros (medio ppm), solo donde la referencia está entre 1 y 99999
+//     ppm. También la calibración en aire limpio: la R0 calculada tiene que devolver los mismos ppm.
+//   - Suelo: todos los raw de 0 a 1023 con varias curvas, contra la interpolación en double redondeada.
+//   - ns por muestra de la conversión en enteros, de la misma en float (powf, lo que haría el nodo con floats) y del
+//     map() de antes. Los tiempos son del ordenador, con FPU: en el ESP8266 los floats van por software y la
+//     diferencia es mucho mayor.
+//
+// Termina con 1 si el error del MQ135 pasa de --tol-ppm (% relativo, 0.5 por defecto) o alguna humedad del suelo se
+//   separa más de --tol-suelo puntos (0 por defecto) de la referencia.
+//
+// Uso: program [--muestras 2000000] [--repeticiones 5] [--tol-ppm 0.5] [--tol-suelo 0]
+#include <Calibracion.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Config {
+  uint32_t muestras = 2000000;
+  uint32_t repeticiones = 5;
+  double tolPpm = 0.5;
+  int tolSuelo = 0;
+};
+
+// --- REFERENCIAS ---
+double ppmRef(const calib::Mq135Param& p, int raw, double t, double h) {
+  const double rs = p.rl * double(p.vc - raw) / raw;
+  const double k = 0.00035 * t * t - 0.02718 * t + 1.39538 - 0.0018 * (h - 33);
+  return p.a / 1000.0 * std::pow(rs / (p.r0 * k), p.b / 1000.0);
+}
+
+// lo mismo en float, como lo escribiría el nodo con la librería de Arduino
+float ppmFloat(const calib::Mq135Param& p, int raw, float t, float h) {
+  const float rs = float(p.rl) * float(p.vc - raw) / float(raw);
+  const float k = 0.00035f * t * t - 0.02718f * t + 1.39538f - 0.0018f * (h - 33);
+  return float(p.a) / 1000.0f * powf(rs / (float(p.r0) * k), float(p.b) / 1000.0f);
+}
+
+double humedadRef(const calib::SueloParam& p, int raw) {
+  if (raw <= p.p[0].raw) return p.p[0].pct;
+  for (uint8_t i = 1; i < p.n; i++) {
+    if (raw < p.p[i].raw) {
+      return p.p[i - 1].pct +
+             double(raw - p.p[i - 1].raw) * (p.p[i].pct - p.p[i - 1].pct) / double(p.p[i].raw - p.p[i - 1].raw);
+    }
+  }
+  return p.p[p.n - 1].pct;
+}
+
+float humedadFloat(const calib::SueloParam& p, int raw) {
+  if (raw <= p.p[0].raw) return p.p[0].pct;
+  for (uint8_t i = 1; i < p.n; i++) {
+    if (raw < p.p[i].raw) {
+      return float(p.p[i - 1].pct) +
+             float(raw - p.p[i - 1].raw) * float(p.p[i].pct - p.p[i - 1].pct) / float(p.p[i].raw - p.p[i - 1].raw);
+    }
+  }
+  return p.p[p.n - 1].pct;
+}
+
+// el map() de Arduino, como lo usaba el driver del suelo
+long mapArduino(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// --- CALIBRACIONES PROBADAS ---
+struct CasoMq135 {
+  const char* nombre;
+  calib::Mq135Param p;
+};
+
+const CasoMq135 kCasosMq135[] = {
+    {"datasheet", {76630, 10000, 116602, -2769, 1023}},
+    {"r0 20k", {20000, 10000, 116602, -2769, 1023}},
+    {"r0 300k", {300000, 10000, 116602, -2769, 1023}},
+    {"rl 1k", {76630, 1000, 116602, -2769, 1023}},
+    {"nh3", {76630, 10000, 102200, -2473, 1023}},
+    {"vc 700", {76630, 10000, 116602, -2769, 700}},
+};
+
+struct CasoSuelo {
+  const char* nombre;
+  calib::SueloParam p;
+};
+
+const CasoSuelo kCasosSuelo[] = {
+    {"map 1023-0", {2, 0, {{1023, 0}, {0, 100}}}},
+    {"sonda 870-410", {2, 0, {{870, 0}, {410, 100}}}},
+    {"5 puntos", {5, 0, {{880, 0}, {760, 20}, {640, 45}, {520, 75}, {410, 100}}}},
+    {"8 puntos", {8, 0, {{900, 0}, {850, 5}, {780, 15}, {700, 30}, {620, 50}, {540, 70}, {470, 88}, {400, 100}}}},
+};
+
+const int16_t kTemps[] = {0, 1000, 2000, 3000, 4000}; // centésimas
+const int16_t kHums[] = {2000, 3300, 6000, 9000};
+
+// --- PRECISIÓN ---
+struct ErrorPpm {
+  double maxRel = 0, sumaRel = 0, maxRelFloat = 0;
+  int peorRaw = 0;
+  uint64_t n = 0;
+};
+
+ErrorPpm precisionMq135(const calib::Mq135Param& p) {
+  ErrorPpm e;
+  calib::Mq135 m(p);
+  for (int16_t t : kTemps) {
+    for (int16_t h : kHums) {
+      m.ambiente(t, h);
+      for (int raw = 1; raw < p.vc; raw++) {
+        const double ref = ppmRef(p, raw, t / 100.0, h / 100.0);
+        if (ref < 1 || ref > calib::Mq135::kPpmMax) continue;
+        const double rel = std::max(0.0, std::fabs(m.ppm(raw) - ref) - 0.5) / ref;
+        const double relFloat = std::fabs(ppmFloat(p, raw, t / 100.0f, h / 100.0f) - ref) / ref;
+        e.sumaRel += rel;
+        e.n++;
+        if (rel > e.maxRel) {
+          e.maxRel = rel;
+          e.peorRaw = raw;
+        }
+        e.maxRelFloat = std::max(e.maxRelFloat, relFloat);
+      }
+    }
+  }
+  return e;
+}
+
+// calibración en aire limpio: con la R0 calculada para (raw, 420 ppm) el mismo raw tiene que dar 420 ppm. R0 va en
+//   ohmios enteros: por debajo de 1 k el redondeo ya se nota (y ningún MQ135 está ahí)
+double precisionAire(const calib::Mq135Param& p) {
+  double peor = 0;
+  calib::Mq135 m(p);
+  for (int raw = 50; raw < p.vc - 50; raw += 10) {
+    calib::Mq135Param q = p;
+    q.r0 = m.r0Para(raw, 420);
+    if (q.r0 < 1000) continue;
+    const double ppm = ppmRef(q, raw, 20, 33);
+    peor = std::max(peor, std::fabs(ppm - 420) / 420);
+  }
+  return peor;
+}
+
+struct ErrorSuelo {
+  int maxDif = 0;
+  uint32_t distintos = 0;     // raws que no dan lo mismo que la referencia redondeada
+  uint32_t distintosMap = 0;  // raws que no dan lo mismo que el map() de antes (solo con la curva 1023-0)
+};
+
+ErrorSuelo precisionSuelo(const calib::SueloParam& p) {
+  ErrorSuelo e;
+  const calib::CurvaSuelo c(p);
+  for (int raw = 0; raw <= 1023; raw++) {
+    // la curva ya ordenada por raw. En un empate (x.5 exacto) vale redondear hacia cualquiera de los dos lados
+    const double ref = humedadRef(c.param(), raw);
+    const int abajo = int(std::floor(ref));
+    int dif = std::abs(c.humedad(raw) - int(std::lround(ref)));
+    if (std::fabs(ref - abajo - 0.5) < 1e-9) dif = std::min(dif, std::abs(c.humedad(raw) - abajo));
+    e.maxDif = std::max(e.maxDif, dif);
+    if (dif) e.distintos++;
+    if (c.humedad(raw) != std::clamp(mapArduino(raw, 1023, 0, 0, 100), 0L, 100L)) e.distintosMap++;
+  }
+  return e;
+}
+
+// --- COSTE ---
+// el mejor de varias pasadas sobre los mismos raws, sumando el resultado para que el compilador no se lo salte
+template <class F>
+double nsPorMuestra(const Config& cfg, const std::vector<int16_t>& raws, F&& f) {
+  double mejor = 1e300;
+  volatile int64_t sumidero = 0;
+  const size_t mascara = raws.size() - 1;
+  for (uint32_t r = 0; r < cfg.repeticiones; r++) {
+    int64_t suma = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < cfg.muestras; i++) suma += f(raws[i & mascara]);
+    const auto t1 = std::chrono::steady_clock::now();
+    sumidero = sumidero + suma;
+    mejor = std::min(mejor, std::chrono::duration<double, std::nano>(t1 - t0).count() / cfg.muestras);
+  }
+  return mejor;
+}
+
+bool leerArgs(int argc, char** argv, Config& c) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string k = argv[i];
+    const char* v = argv[i + 1];
+    if (k == "--muestras") c.muestras = uint32_t(std::max(1, std::atoi(v)));
+    else if (k == "--repeticiones") c.repeticiones = uint32_t(std::max(1, std::atoi(v)));
+    else if (k == "--tol-ppm") c.tolPpm = std::atof(v);
+    else if (k == "--tol-suelo") c.tolSuelo = std::atoi(v);
+    else return false;
+  }
+  return (argc % 2) == 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Config cfg;
+  if (!leerArgs(argc, argv, cfg)) {
+    std::fprintf(stderr, "argumentos no válidos (ver el comentario de bench/src/calibracion.cpp)\n");
+    return 2;
+  }
+  int fallos = 0;
+
+  std::printf("MQ135: error relativo frente a la referencia en double (sin el redondeo a ppm enteros)\n");
+  std::printf("%-12s %10s %10s %8s %12s %12s\n", "caso", "max %", "medio %", "peor raw", "float max %",
+              "aire max %");
+  for (const CasoMq135& c : kCasosMq135) {
+    const ErrorPpm e = precisionMq135(c.p);
+    const double aire = precisionAire(c.p);
+    std::printf("%-12s %10.4f %10.4f %8d %12.4f %12.4f\n", c.nombre, e.maxRel * 100, e.n ? e.sumaRel / e.n * 100 : 0,
+                e.peorRaw, e.maxRelFloat * 100, aire * 100);
+    if (e.maxRel * 100 > cfg.tolPpm || aire * 100 > cfg.tolPpm) fallos++;
+  }
+
+  std::printf("\nsuelo: diferencia con la interpolación en double redondeada (puntos de humedad)\n");
+  std::printf("%-14s %8s %10s %14s\n", "curva", "max", "distintos", "cambian (map)");
+  for (const CasoSuelo& c : kCasosSuelo) {
+    const ErrorSuelo e = precisionSuelo(c.p);
+    std::printf("%-14s %8d %10u %14u\n", c.nombre, e.maxDif, e.distintos, e.distintosMap);
+    if (e.maxDif > cfg.tolSuelo) fallos++;
+  }
+
+  // raws al azar en la zona útil, en un buffer de 4096 (cabe en la caché: se mide la conversión, no la memoria)
+  std::vector<int16_t> raws(4096);
+  uint32_t x = 1;
+  for (int16_t& r : raws) {
+    x = x * 1103515245u + 12345u;
+    r = int16_t(1 + (x >> 16) % 1022);
+  }
+  const calib::Mq135Param& p = kCasosMq135[0].p;
+  calib::Mq135 m(p);
+  m.ambiente(2350, 5500);
+  const calib::CurvaSuelo curva(kCasosSuelo[2].p);
+  const calib::SueloParam& s = curva.param();
+
+  std::printf("\ncoste por muestra (ns, el mejor de %u pasadas de %u)\n", cfg.repeticiones, cfg.muestras);
+  const double nsPpm = nsPorMuestra(cfg, raws, [&](int16_t r) { return m.ppm(r); });
+  const double nsPpmFloat = nsPorMuestra(cfg, raws, [&](int16_t r) { return int64_t(ppmFloat(p, r, 23.5f, 55.0f)); });
+  const double nsSuelo = nsPorMuestra(cfg, raws, [&](int16_t r) { return curva.humedad(r); });
+  const double nsSueloFloat = nsPorMuestra(cfg, raws, [&](int16_t r) { return int64_t(humedadFloat(s, r) + 0.5f); });
+  const double nsMap = nsPorMuestra(cfg, raws, [&](int16_t r) { return mapArduino(r, 1023, 0, 0, 100); });
+  std::printf("  mq135 tablas     %8.2f\n", nsPpm);
+  std::printf("  mq135 powf       %8.2f\n", nsPpmFloat);
+  std::printf("  suelo tramos     %8.2f\n", nsSuelo);
+  std::printf("  suelo float      %8.2f\n", nsSueloFloat);
+  std::printf("  suelo map()      %8.2f\n", nsMap);
+
+  if (fallos) std::printf("\n%d casos fuera de tolerancia (ppm %.2f %%, suelo %d)\n", fallos, cfg.tolPpm, cfg.tolSuelo);
+  return fallos ? 1 : 0;
+}
@@ -0,0 +1,99 @@
+// --- SIMULACIÓN DE CORTES DEL BROKER ---
+// ejecuta el nodo de suelo (SensorNode<SoilDriver>) contra los mocks, con un broker que se cae al azar, y comprueba
+//   que todas las lecturas que el nodo decidió publicar acaban llegando (directamente o reenviadas desde la flash).
+//   También comprueba la hora ("ts", del reloj del mock, que sigue al tiempo simulado): en directo avanza de periodo
+//   en periodo y en las reenviadas es la hora del reenvío menos "age", es decir, la hora de la lectura.
+//   Uso: program [horas simuladas] [semilla]
+#include <SensorNode.h>
+#include <SoilDriver.h>
+#include <Ticker.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+SensorNode<SoilDriver> nodo;
+
+// valor entero de un campo del JSON publicado (-1 si no está)
+static int64_t campo(const std::string& json, const char* nombre) {
+  const size_t p = json.find("\"" + std::string(nombre) + "\":");
+  return p == std::string::npos ? -1 : std::strtoll(json.c_str() + p + std::strlen(nombre) + 3, nullptr, 10);
+}
+
+int main(int argc, char** argv) {
+  const uint32_t horas = argc > 1 ? uint32_t(std::atoi(argv[1])) : 6;
+  std::mt19937 rng(argc > 2 ? uint32_t(std::atoi(argv[2])) : 1);
+  Serial.quiet = true;
+
+  // la humedad cambia lo bastante para que casi todas las lecturas pasen la banda muerta
+  std::uniform_int_distribution<int> adc(200, 900);
+  mock::adcSource = [&] { return adc(rng); };
+
+  // cortes: cada minuto hay un 5 % de probabilidad de que se caiga; cada corte dura entre 10 s y 15 min
+  std::uniform_real_distribution<double> u(0, 1);
+  std::uniform_int_distribution<uint32_t> duracion(10, 900);
+  uint32_t caidoHasta = 0, cortes = 0;
+
+  nodo.begin();
+  const uint32_t totalMs = horas * 3600 * 1000;
+  for (uint32_t ms = 0; ms < totalMs; ms++) {
+    if (ms % 60000 == 0 && mock::brokerUp && u(rng) < 0.05) {
+      mock::brokerUp = false;
+      caidoHasta = ms + duracion(rng) * 1000;
+      cortes++;
+    }
+    if (!mock::brokerUp && ms >= caidoHasta) mock::brokerUp = true;
+    nodo.loop();
+    mock::advance(1);
+  }
+  // dejamos que termine de vaciar la cola con el broker arriba
+  mock::brokerUp = true;
+  for (uint32_t ms = 0; ms < 600000 && nodo.storePending(); ms++) {
+    nodo.loop();
+    mock::advance(1);
+  }
+
+  // la hora de una lectura es la del mock en el ms en que se leyó: p.ms en directo, p.ms - age si se reenvía
+  size_t recibidas = 0, conAge = 0, stats = 0, sinTs = 0, tsMal = 0, pasoMal = 0;
+  int64_t tsAnterior = -1;
+  for (const auto& p : mock::publicaciones) {
+    if (p.topic == "soil/stats") stats++;
+    if (p.topic != "soil") continue;
+    recibidas++;
+    const int64_t age = campo(p.payload, "age");
+    if (age >= 0) conAge++;
+    const int64_t ts = campo(p.payload, "ts");
+    if (ts < 0) {
+      sinTs++;
+      continue;
+    }
+    if (ts != int64_t(mock::epochInicioMs) + p.ms - std::max<int64_t>(age, 0)) tsMal++;
+    if (age < 0) {
+      if (tsAnterior >= 0 && (ts <= tsAnterior || (ts - tsAnterior) % SoilDriver::kPeriodMs != 0)) pasoMal++;
+      tsAnterior = ts;
+    }
+  }
+  const PublishStats& ps = nodo.publishStats();
+  const FlashLogStats& fs = nodo.storeStats();
+  const uint32_t decididas = ps.enviados + ps.latidos;
+
+  uint32_t minBorrados = UINT32_MAX, maxBorrados = 0;
+  for (uint16_t s = 0; s < node_config::storeSectors; s++) {
+    minBorrados = std::min(minBorrados, mock::flashErases[s]);
+    maxBorrados = std::max(maxBorrados, mock::flashErases[s]);
+  }
+
+  std::printf("horas simuladas       %u\n", horas);
+  std::printf("cortes del broker     %u\n", cortes);
+  std::printf("lecturas a publicar   %u\n", decididas);
+  std::printf("recibidas             %zu (%zu reenviadas con age)\n", recibidas, conAge);
+  std::printf("guardadas en flash    %u, reenviadas %u, perdidas %u, pendientes %u\n", fs.guardados, fs.reenviados,
+              fs.perdidos, nodo.storePending());
+  std::printf("borrados por sector   min %u, max %u\n", minBorrados, maxBorrados);
+  std::printf("stats publicados      %zu (rechazados por el buffer del cliente %u)\n", stats, mock::rechazadas);
+  std::printf("hora (ts)             %zu sin ts, %zu distintas de la de la lectura, %zu saltos fuera de periodo\n",
+              sinTs, tsMal, pasoMal);
+  return recibidas + fs.perdidos == decididas && !mock::rechazadas && !sinTs && !tsMal && !pasoMal ? 0 : 1;
+}
@@ -0,0 +1,211 @@
+// --- BENCHMARK DE LA LECTURA ASÍNCRONA DEL DHT11 ---
+// reproduce trenes de pulsos del DHT11 (instantes de los flancos de bajada) contra dht11::decode() y contra el lector
+//   completo (dht11::Reader) sobre el GPIO simulado, y comprueba:
+//   - que las tramas buenas se decodifican al valor que llevan, con el jitter de tiempos de un sensor real
+//   - que las estropeadas (flancos perdidos, pulsos espurios, bits cambiados) se rechazan por timeout, pulso o
+//     checksum, y cuántas pasan con un valor erróneo (dos bits cambiados pueden cuadrar el checksum)
+//   - lo que cuesta decode() y lo que tarda una llamada a poll(): es lo que bloquea el loop, frente a los ~25 ms de la
+//     librería de Adafruit
+//
+// Con ficheros, además decodifica cada trama de cada uno (ver bench/trazas/README.md: una trama por línea, instantes
+//   en us separados por comas o espacios; las líneas con # se ignoran), por ejemplo capturas con un analizador lógico.
+//   Uso: program [tramas sintéticas] [fichero ...]
+#include <Dht11Async.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Trama {
+  std::vector<uint32_t> flancos;
+  dht11::Sample verdad;
+};
+
+// trama de un sensor con temperatura y humedad dadas (en décimas, lo que da el DHT11), con jitter de +-jitterUs en
+//   cada pulso como el de un sensor real (el oscilador del DHT11 no es preciso)
+Trama sintetica(std::mt19937& rng, int16_t tempDecimas, uint8_t humedad, uint32_t jitterUs) {
+  std::uniform_int_distribution<int> j(-int(jitterUs), int(jitterUs));
+  const uint16_t t = uint16_t(std::abs(tempDecimas));
+  const uint8_t b[5] = {humedad, 0, uint8_t(t / 10), uint8_t(t % 10 | (tempDecimas < 0 ? 0x80 : 0)),
+                        uint8_t(humedad + t / 10 + (t % 10 | (tempDecimas < 0 ? 0x80 : 0)))};
+  Trama tr;
+  tr.verdad.humedad = int16_t(humedad * 100);
+  tr.verdad.temperatura = int16_t(tempDecimas * 10);
+  uint32_t at = uint32_t(30 + j(rng));
+  tr.flancos.push_back(at);
+  at += uint32_t(160 + j(rng));
+  for (uint8_t i = 0; i < 40; i++) {
+    tr.flancos.push_back(at);
+    at += uint32_t(((b[i / 8] >> (7 - i % 8)) & 1 ? 120 : 77) + j(rng));
+  }
+  tr.flancos.push_back(at);
+  return tr;
+}
+
+enum Defecto { Ninguno, FlancoPerdido, Espurio, BitCambiado, DosBits, kDefectos };
+const char* const kNombres[kDefectos] = {"sin defectos", "flanco perdido", "pulso espurio", "bit cambiado",
+                                         "dos bits cambiados"};
+
+// cambia el bit i: el flanco siguiente se mueve lo que va de un 0 a un 1 y el resto de la trama con él
+void cambiarBit(Trama& tr, uint8_t i) {
+  const size_t k = 1 + i; // flancos[1 + i] es el inicio del bit i
+  const int32_t d = int32_t(tr.flancos[k + 1] - tr.flancos[k]) > int32_t(dht11::kBitSplitUs) ? -43 : 43;
+  for (size_t m = k + 1; m < tr.flancos.size(); m++) tr.flancos[m] = uint32_t(int32_t(tr.flancos[m]) + d);
+}
+
+void estropear(Trama& tr, Defecto d, std::mt19937& rng) {
+  std::uniform_int_distribution<int> bit(0, 39);
+  switch (d) {
+    case Ninguno: break;
+    case FlancoPerdido: tr.flancos.erase(tr.flancos.begin() + 1 + bit(rng)); break;
+    case Espurio: {
+      // un pico de ruido a mitad de un bit: dos intervalos cortos donde había uno
+      const size_t k = size_t(2 + bit(rng));
+      tr.flancos.insert(tr.flancos.begin() + long(k), tr.flancos[k - 1] + 20);
+      break;
+    }
+    case BitCambiado: cambiarBit(tr, uint8_t(bit(rng))); break;
+    case DosBits: {
+      const uint8_t a = uint8_t(bit(rng));
+      uint8_t b = uint8_t(bit(rng));
+      if (b == a) b = uint8_t((a + 1) % 40);
+      cambiarBit(tr, a);
+      cambiarBit(tr, b);
+      break;
+    }
+    case kDefectos: break;
+  }
+}
+
+struct Cuenta {
+  uint32_t n = 0, ok = 0, erroneas = 0, timeout = 0, pulso = 0, checksum = 0;
+};
+
+void sinteticas(uint32_t tramas) {
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<int> temp(-50, 500); // -5.0 a 50.0 ºC
+  std::uniform_int_distribution<int> hum(20, 95);
+  Cuenta c[kDefectos];
+  double ns = 0;
+  for (uint32_t i = 0; i < tramas; i++) {
+    const Defecto d = Defecto(i % kDefectos);
+    Trama tr = sintetica(rng, int16_t(temp(rng)), uint8_t(hum(rng)), 6);
+    estropear(tr, d, rng);
+    dht11::Sample s{};
+    const auto t0 = std::chrono::steady_clock::now();
+    const dht11::Error e = dht11::decode(tr.flancos.data(), uint8_t(tr.flancos.size()), s);
+    ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    Cuenta& k = c[d];
+    k.n++;
+    switch (e) {
+      case dht11::Ok:
+        if (s.temperatura == tr.verdad.temperatura && s.humedad == tr.verdad.humedad) k.ok++;
+        else k.erroneas++;
+        break;
+      case dht11::Timeout: k.timeout++; break;
+      case dht11::Pulse: k.pulso++; break;
+      case dht11::Checksum: k.checksum++; break;
+    }
+  }
+  std::printf("%u tramas sintéticas (jitter +-6 us), decode() %.0f ns\n", tramas, ns / tramas);
+  std::printf("  %-20s %8s %8s %8s %8s %8s %8s\n", "defecto", "tramas", "ok", "erróneas", "timeout", "pulso",
+              "checksum");
+  for (uint8_t d = 0; d < kDefectos; d++) {
+    std::printf("  %-20s %8u %8u %8u %8u %8u %8u\n", kNombres[d], c[d].n, c[d].ok, c[d].erroneas, c[d].timeout,
+                c[d].pulso, c[d].checksum);
+  }
+}
+
+// el lector completo sobre el GPIO del mock: cada conversión recibe una trama (buena o no) al soltar la línea
+void lector(uint32_t conversiones) {
+  std::mt19937 rng(11);
+  uint32_t fallos = 0;
+  Trama actual;
+  double simNs = 0; // lo que tarda el propio simulador en generar la trama: no es del lector
+  mock::dhtTrain = [&](uint32_t* edges, size_t max) {
+    const auto t0 = std::chrono::steady_clock::now();
+    actual = sintetica(rng, 215, 60, 6);
+    if (rng() % 10 == 0) {
+      estropear(actual, Defecto(1 + rng() % (kDefectos - 1)), rng);
+      fallos++;
+    }
+    const size_t n = std::min(max, actual.flancos.size());
+    for (size_t i = 0; i < n; i++) edges[i] = actual.flancos[i];
+    simNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    return n;
+  };
+  dht11::Reader r(2);
+  r.begin(millis());
+  Log2Histogram ns; // por llamada, en ns
+  while (r.stats().conversiones < conversiones || r.converting()) {
+    simNs = 0;
+    const auto t0 = std::chrono::steady_clock::now();
+    r.poll(millis());
+    ns.add(uint32_t(std::max(0.0, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() -
+                                  simNs)));
+    mock::advance(5); // kSampleMs del driver
+  }
+  mock::dhtTrain = nullptr;
+  const dht11::Stats& s = r.stats();
+  std::printf("lector: %u conversiones (%u estropeadas a propósito) en %.0f s simulados\n", s.conversiones, fallos,
+              millis() / 1000.0);
+  std::printf("  válidas %u, timeouts %u, pulsos %u, checksums %u, reintentos %u\n", s.validas, s.timeouts, s.pulsos,
+              s.checksums, s.reintentos);
+  std::printf("  latencia p99 %u us, máx %u us (señal de inicio incluida)\n", r.latency().percentile(99),
+              r.latency().max());
+  // el máximo en el ordenador incluye alguna interrupción del sistema operativo; el p99 es lo representativo
+  std::printf("  poll() (lo que bloquea el loop): p50 %u ns, p99 %u ns, máx %u ns\n", ns.percentile(50),
+              ns.percentile(99), ns.max());
+}
+
+bool fichero(const char* path) {
+  FILE* f = std::fopen(path, "r");
+  if (!f) {
+    std::fprintf(stderr, "no se pudo leer %s\n", path);
+    return false;
+  }
+  std::printf("%s\n", path);
+  char linea[2048];
+  uint32_t n = 0;
+  while (std::fgets(linea, sizeof(linea), f)) {
+    if (linea[0] == '#') continue;
+    std::vector<uint32_t> e;
+    for (char* p = linea; *p;) {
+      char* fin;
+      const unsigned long v = std::strtoul(p, &fin, 10);
+      if (fin == p) {
+        p++;
+        continue;
+      }
+      e.push_back(uint32_t(v));
+      p = fin;
+    }
+    if (e.empty()) continue;
+    dht11::Sample s{};
+    const dht11::Error err = dht11::decode(e.data(), uint8_t(std::min<size_t>(e.size(), 255)), s);
+    static const char* const kError[] = {"ok", "timeout", "pulso", "checksum"};
+    std::printf("  trama %u: %zu flancos, %s", ++n, e.size(), kError[err]);
+    if (err == dht11::Ok) std::printf(" (%.1f C, %.0f %%)", s.temperatura / 100.0, s.humedad / 100.0);
+    std::printf("\n");
+  }
+  std::fclose(f);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Serial.quiet = true;
+  const uint32_t tramas = argc > 1 ? uint32_t(std::atoi(argv[1])) : 100000;
+  sinteticas(tramas ? tramas : 100000);
+  lector(1000);
+  for (int i = 2; i < argc; i++) fichero(argv[i]);
+  return 0;
+}
@@ -0,0 +1,115 @@
+// --- BENCHMARK DE LOS FILTROS DEL A0 ---
+// pasa trazas del ADC por los mismos filtros que usan los drivers (bloques de 32 muestras, como en el nodo) y muestra:
+//   - ns por muestra (coste de push() + la parte proporcional de reduce())
+//   - ruido de la salida: desviación de la diferencia entre publicaciones consecutivas
+//   - error respecto a la referencia, si la traza la trae (segunda columna)
+// Sin argumentos genera una traza sintética (señal lenta + ruido + picos) para poder ejecutarlo sin datos reales.
+#include <Filters.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint8_t kBloque = 32; // muestras por publicación, igual que kOversample en los drivers
+
+struct Traza {
+  std::string nombre;
+  std::vector<int16_t> raw;
+  std::vector<double> ref; // vacío si la traza no trae referencia
+};
+
+bool cargar(const char* path, Traza& t) {
+  FILE* f = std::fopen(path, "r");
+  if (!f) return false;
+  t.nombre = path;
+  char linea[64];
+  while (std::fgets(linea, sizeof(linea), f)) {
+    char* fin;
+    const long raw = std::strtol(linea, &fin, 10);
+    if (fin == linea) continue; // cabecera o línea vacía
+    t.raw.push_back(int16_t(raw));
+    if (*fin == ',') t.ref.push_back(std::strtod(fin + 1, nullptr));
+  }
+  std::fclose(f);
+  if (t.ref.size() != t.raw.size()) t.ref.clear();
+  return !t.raw.empty();
+}
+
+// señal lenta (como la humedad de suelo al regar) + ruido gaussiano del ADC + picos aislados
+Traza sintetica() {
+  Traza t;
+  t.nombre = "sintetica";
+  std::mt19937 rng(1234);
+  std::normal_distribution<double> ruido(0.0, 6.0);
+  std::uniform_real_distribution<double> u(0.0, 1.0);
+  for (int i = 0; i < 200000; i++) {
+    const double verdad = 600 + 150 * std::sin(i / 20000.0);
+    double x = verdad + ruido(rng);
+    if (u(rng) < 0.01) x += (u(rng) < 0.5 ? -1 : 1) * 300; // pico
+    t.raw.push_back(int16_t(std::lround(std::fmin(1023, std::fmax(0, x)))));
+    t.ref.push_back(verdad);
+  }
+  return t;
+}
+
+template <class Filter>
+void medir(const char* nombre, const Traza& t) {
+  Filter filtro;
+  std::vector<int16_t> salida;
+  std::vector<double> refSalida;
+  salida.reserve(t.raw.size() / kBloque + 1);
+
+  const auto t0 = std::chrono::steady_clock::now();
+  for (size_t i = 0; i + kBloque <= t.raw.size(); i += kBloque) {
+    const int16_t* bloque = &t.raw[i];
+    for (uint8_t k = 0; k < kBloque; k++) filtro.push(bloque[k]);
+    salida.push_back(filtro.reduce(bloque, kBloque));
+    if (!t.ref.empty()) refSalida.push_back(t.ref[i + kBloque - 1]);
+  }
+  const auto t1 = std::chrono::steady_clock::now();
+  const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / double(salida.size() * kBloque);
+
+  double sumaDif = 0, sumaDif2 = 0;
+  for (size_t i = 1; i < salida.size(); i++) {
+    const double d = salida[i] - salida[i - 1];
+    sumaDif += d;
+    sumaDif2 += d * d;
+  }
+  const double n = double(salida.size() - 1);
+  const double ruido = std::sqrt(sumaDif2 / n - (sumaDif / n) * (sumaDif / n));
+
+  std::printf("  %-22s %8.2f ns/muestra  ruido %7.2f", nombre, ns, ruido);
+  if (!refSalida.empty()) {
+    double e2 = 0;
+    for (size_t i = 0; i < salida.size(); i++) e2 += (salida[i] - refSalida[i]) * (salida[i] - refSalida[i]);
+    std::printf("  rmse %7.2f", std::sqrt(e2 / double(salida.size())));
+  }
+  std::printf("\n");
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::vector<Traza> trazas;
+  for (int i = 1; i < argc; i++) {
+    Traza t;
+    if (cargar(argv[i], t)) trazas.push_back(std::move(t));
+    else std::fprintf(stderr, "no se pudo leer %s\n", argv[i]);
+  }
+  if (trazas.empty()) trazas.push_back(sintetica());
+
+  for (const Traza& t : trazas) {
+    std::printf("%s (%zu muestras, bloques de %u)\n", t.nombre.c_str(), t.raw.size(), kBloque);
+    medir<LastSample>("ultima muestra", t);
+    medir<MedianFilter<kBloque>>("mediana", t);
+    medir<TrimmedMeanFilter<kBloque, 25>>("media recortada 25%", t);
+    medir<EmaFilter<3>>("ema 1/8", t);
+  }
+  return 0;
+}
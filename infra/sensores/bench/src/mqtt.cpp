@@ -0,0 +1,533 @@
+// --- BENCHMARK DEL CLIENTE MQTT: PUBSUBCLIENT FRENTE A ASYNCMQTT ---
+// mide lo que para el loop() del nodo publicar por MQTT, y lo que llega al broker, con los dos clientes:
+//   - "pubsub": el camino actual. PubSubClient no compila en el ordenador, así que es un modelo de su publish(): arma
+//     el paquete en un buffer de 256 bytes (lo que no cabe se rechaza), lo escribe esperando a que quepa y, como el
+//     WiFiClient del core en modo síncrono (el de por defecto), espera al ACK de lo escrito. Si algo de eso pasa de
+//     tcpTimeoutMs (300 ms) la escritura se corta, el flujo MQTT queda roto y el nodo tiene que reconectar.
+//   - "async": AsyncMqtt (common/lib/NodeCore/AsyncMqtt.h) tal cual, con el estado de los actuadores en QoS 1.
+//
+// El broker es un servidor MQTT mínimo en un hilo (CONNACK, PUBACK de QoS 1, PINGRESP) que cuenta lo que recibe y
+//   la latencia desde que el nodo llamó a publish() (va en el payload). La WiFi del ESP8266 es un modelo delante del
+//   socket: 2920 bytes de buffer de envío de lwIP (TCP_SND_BUF), un ancho de banda y un RTT, y cada pocos segundos
+//   una racha en la que los ACK tardan mucho más (reintentos de la radio). Los bytes van por el socket enseguida;
+//   el modelo solo decide cuándo se liberan en el buffer de envío.
+//
+// Dos escenarios, cada uno con los dos clientes:
+//   - nodo: 10 lecturas/s (40 bytes), un lote binario por segundo (600 bytes) y el estado de un actuador cada 2 s
+//   - ráfaga: mensajes de 100 bytes tan rápido como los acepte el cliente (hasta 20 por pasada del loop)
+//
+// Uso: program [segundos por escenario] [rtt ms] [KB/s] [racha ms] [cada ms]   (por defecto 15 30 20 800 5000)
+#include <AsyncMqtt.h>
+#include <ESP8266WiFi.h>
+#include <Percentil.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+const Clock::time_point kInicio = Clock::now();
+
+uint64_t nowUs() {
+  return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - kInicio).count());
+}
+
+// millis() del mock al ritmo del reloj (nunca hacia atrás: delay() también lo avanza)
+void syncClock() {
+  const uint32_t ms = uint32_t(nowUs() / 1000);
+  if (int32_t(ms - mock::nowMs) > 0) {
+    mock::nowUs += (ms - mock::nowMs) * 1000;
+    mock::nowMs = ms;
+  }
+}
+
+struct Enlace {
+  uint32_t rttMs = 30;
+  uint32_t kbps = 20;      // KB/s
+  uint32_t rachaMs = 800;  // ACK retrasados durante la racha
+  uint32_t cadaMs = 5000;
+  size_t sndBuf = 2920;    // TCP_SND_BUF de lwIP en el ESP8266 (2 * MSS)
+};
+
+// --- WIFI DEL ESP8266 (MODELO) ---
+// un WiFiClient de verdad con el buffer de envío de lwIP delante: cada write() ocupa el buffer hasta que llega su ACK
+class TcpLento {
+ public:
+  explicit TcpLento(const Enlace& e) : e_(e) {}
+
+  int connect(const char* host, uint16_t port) {
+    enVuelo_.clear();
+    ocupado_ = 0;
+    ultimoUs_ = 0;
+    return tcp_.connect(host, port);
+  }
+
+  int availableForWrite() {
+    liberar();
+    return int(e_.sndBuf - ocupado_);
+  }
+
+  size_t write(const uint8_t* p, size_t n) {
+    liberar();
+    n = std::min(n, e_.sndBuf - ocupado_);
+    if (!n) return 0;
+    // el socket de verdad tiene sitio de sobra: lo acepta entero
+    size_t w = 0;
+    while (w < n && tcp_.connected()) {
+      const size_t r = tcp_.write(p + w, n - w);
+      if (!r) std::this_thread::sleep_for(std::chrono::microseconds(50));
+      w += r;
+    }
+    const uint64_t ahora = nowUs();
+    const uint64_t salida = std::max(ahora, ultimoUs_) + uint64_t(n) * 1000 / e_.kbps; // us a kbps KB/s
+    ultimoUs_ = salida;
+    uint64_t ack = salida + uint64_t(e_.rttMs) * 1000;
+    // dentro de una racha el ACK no llega hasta que acaba
+    const uint64_t fase = (ack / 1000) % e_.cadaMs;
+    if (fase >= e_.cadaMs - e_.rachaMs) ack += (e_.cadaMs - fase) * 1000;
+    enVuelo_.push_back({ack, n});
+    ocupado_ += n;
+    return w;
+  }
+
+  bool esperarAcks(uint32_t timeoutMs) {
+    const uint64_t limite = nowUs() + uint64_t(timeoutMs) * 1000;
+    while (liberar(), ocupado_) {
+      if (nowUs() >= limite) return false;
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return true;
+  }
+
+  int available() { return tcp_.available(); }
+  int read(uint8_t* p, size_t n) { return tcp_.read(p, n); }
+  uint8_t connected() { return tcp_.connected(); }
+  void stop() { tcp_.stop(); }
+
+ private:
+  struct Tramo {
+    uint64_t ackUs;
+    size_t bytes;
+  };
+
+  void liberar() {
+    const uint64_t ahora = nowUs();
+    while (!enVuelo_.empty() && enVuelo_.front().ackUs <= ahora) {
+      ocupado_ -= enVuelo_.front().bytes;
+      enVuelo_.pop_front();
+    }
+  }
+
+  const Enlace& e_;
+  WiFiClient tcp_;
+  std::deque<Tramo> enVuelo_;
+  size_t ocupado_ = 0;
+  uint64_t ultimoUs_ = 0;
+};
+
+// --- PUBSUBCLIENT (MODELO) ---
+class PubSubModelo {
+ public:
+  static constexpr uint16_t kBuffer = 256;    // MQTT_MAX_PACKET_SIZE
+  static constexpr uint32_t kTimeoutMs = 300; // node_config::tcpTimeoutMs
+
+  explicit PubSubModelo(TcpLento& tcp) : tcp_(tcp) {}
+
+  bool connect(const char* host, uint16_t port, const char* id) {
+    if (!tcp_.connect(host, port)) return false;
+    uint8_t p[64];
+    const size_t idLen = strlen(id);
+    size_t n = 0;
+    p[n++] = 0x10;
+    p[n++] = uint8_t(12 + idLen);
+    const uint8_t var[] = {0, 4, 'M', 'Q', 'T', 'T', 4, 0x02, 0, 15, 0, uint8_t(idLen)};
+    memcpy(p + n, var, sizeof(var));
+    n += sizeof(var);
+    memcpy(p + n, id, idLen);
+    n += idLen;
+    if (!escribir(p, n)) return false;
+    const uint32_t t0 = millis();
+    while (tcp_.available() < 4) {
+      if (millis() - t0 > 1000) return false;
+      delay(1);
+      syncClock();
+    }
+    uint8_t ack[4];
+    conectado_ = tcp_.read(ack, 4) == 4 && ack[3] == 0;
+    return conectado_;
+  }
+
+  bool connected() { return conectado_ && tcp_.connected(); }
+
+  bool publish(const char* topic, const uint8_t* payload, unsigned len, bool retained = false) {
+    if (!connected()) return false;
+    const size_t tl = strlen(topic);
+    const size_t rem = 2 + tl + len;
+    const size_t total = 1 + (rem > 127 ? 2 : 1) + rem;
+    if (total > kBuffer) return false; // no cabe en el buffer
+    uint8_t* p = buf_;
+    *p++ = uint8_t(0x30 | (retained ? 1 : 0));
+    if (rem > 127) {
+      *p++ = uint8_t(rem & 0x7F) | 0x80;
+      *p++ = uint8_t(rem >> 7);
+    } else {
+      *p++ = uint8_t(rem);
+    }
+    *p++ = uint8_t(tl >> 8);
+    *p++ = uint8_t(tl);
+    memcpy(p, topic, tl);
+    p += tl;
+    memcpy(p, payload, len);
+    if (!escribir(buf_, total) || !tcp_.esperarAcks(kTimeoutMs)) {
+      // escritura cortada a medias: el broker ve un paquete roto y hay que reconectar
+      conectado_ = false;
+      tcp_.stop();
+      return false;
+    }
+    return true;
+  }
+
+  // PINGRESP y demás: se leen y se tiran
+  bool loop() {
+    uint8_t sink[64];
+    while (tcp_.available() > 0 && tcp_.read(sink, sizeof(sink)) > 0) {
+    }
+    return connected();
+  }
+
+  void disconnect() {
+    tcp_.stop();
+    conectado_ = false;
+  }
+
+ private:
+  bool escribir(const uint8_t* p, size_t n) {
+    const uint32_t t0 = millis();
+    size_t w = 0;
+    while (w < n) {
+      const size_t r = tcp_.write(p + w, n - w);
+      w += r;
+      if (r) continue;
+      if (millis() - t0 > kTimeoutMs || !tcp_.connected()) return false;
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+      syncClock();
+    }
+    return true;
+  }
+
+  TcpLento& tcp_;
+  uint8_t buf_[kBuffer];
+  bool conectado_ = false;
+};
+
+// --- BROKER ---
+struct Recibido {
+  std::atomic<uint32_t> mensajes{0}, qos1{0}, duplicados{0};
+  std::atomic<uint64_t> bytes{0};
+  std::vector<uint32_t> latenciasUs; // solo el hilo del broker, leído al acabar cada prueba
+};
+
+class Broker {
+ public:
+  bool begin() {
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    const int uno = 1;
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &uno, sizeof(uno));
+    sockaddr_in a{};
+    a.sin_family = AF_INET;
+    a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(a);
+    if (bind(fd_, reinterpret_cast<sockaddr*>(&a), len) < 0 || listen(fd_, 4) < 0) return false;
+    getsockname(fd_, reinterpret_cast<sockaddr*>(&a), &len);
+    port_ = ntohs(a.sin_port);
+    hilo_ = std::thread([this] { aceptar(); });
+    return true;
+  }
+
+  void end() {
+    fin_ = true;
+    shutdown(fd_, SHUT_RDWR);
+    close(fd_);
+    hilo_.join();
+  }
+
+  uint16_t port() const { return port_; }
+  Recibido& recibido() { return rx_; }
+  void reset() {
+    rx_.mensajes = rx_.qos1 = rx_.duplicados = 0;
+    rx_.bytes = 0;
+    rx_.latenciasUs.clear();
+  }
+
+ private:
+  void aceptar() {
+    while (!fin_) {
+      const int c = accept(fd_, nullptr, nullptr);
+      if (c < 0) continue;
+      atender(c);
+      close(c);
+    }
+  }
+
+  // una conexión cada vez: el nodo reconecta por la misma
+  void atender(int c) {
+    std::vector<uint8_t> in;
+    uint8_t buf[4096];
+    for (;;) {
+      const ssize_t r = recv(c, buf, sizeof(buf), 0);
+      if (r <= 0) return;
+      in.insert(in.end(), buf, buf + r);
+      size_t off = 0;
+      for (;;) {
+        if (in.size() - off < 2) break;
+        uint32_t rem = 0;
+        size_t i = 1;
+        uint8_t shift = 0;
+        bool ok = false;
+        while (off + i < in.size() && i <= 4) {
+          const uint8_t b = in[off + i++];
+          rem |= uint32_t(b & 0x7F) << shift;
+          shift += 7;
+          if (!(b & 0x80)) {
+            ok = true;
+            break;
+          }
+        }
+        if (!ok || in.size() - off < i + rem) break;
+        if (!paquete(c, &in[off], i, rem)) return; // paquete roto (escritura cortada): se cierra la conexión
+        off += i + rem;
+      }
+      in.erase(in.begin(), in.begin() + long(off));
+    }
+  }
+
+  bool paquete(int c, const uint8_t* p, size_t h, uint32_t rem) {
+    const uint8_t tipo = p[0] & 0xF0;
+    const uint8_t* b = p + h;
+    if (tipo == 0x10) {
+      static const uint8_t kConnack[] = {0x20, 2, 0, 0};
+      send(c, kConnack, 4, MSG_NOSIGNAL);
+    } else if (tipo == 0x30) {
+      const uint8_t qos = (p[0] >> 1) & 3;
+      const uint16_t tl = uint16_t(b[0] << 8 | b[1]);
+      if (2u + tl + (qos ? 2u : 0u) > rem || tl > 128) return false;
+      const uint8_t* payload = b + 2 + tl + (qos ? 2 : 0);
+      const size_t plen = rem - 2 - tl - (qos ? 2 : 0);
+      rx_.mensajes++;
+      rx_.bytes += h + rem;
+      if (p[0] & 0x08) rx_.duplicados++;
+      if (qos) {
+        rx_.qos1++;
+        const uint8_t ack[] = {0x40, 2, b[2 + tl], b[3 + tl]};
+        send(c, ack, 4, MSG_NOSIGNAL);
+      }
+      // el payload empieza con el instante de publish() en us
+      if (plen >= 2 && payload[0] == 't' && payload[1] == '=') {
+        const uint64_t t = std::strtoull(reinterpret_cast<const char*>(payload) + 2, nullptr, 10);
+        rx_.latenciasUs.push_back(uint32_t(nowUs() - t));
+      }
+    } else if (tipo == 0x80) {
+      const uint8_t suback[] = {0x90, 3, b[0], b[1], 1};
+      send(c, suback, 5, MSG_NOSIGNAL);
+    } else if (tipo == 0xC0) {
+      static const uint8_t kPong[] = {0xD0, 0};
+      send(c, kPong, 2, MSG_NOSIGNAL);
+    } else if (tipo == 0xE0) {
+      return false;
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  int fd_ = -1;
+  uint16_t port_ = 0;
+  std::thread hilo_;
+  std::atomic<bool> fin_{false};
+  Recibido rx_;
+};
+
+// --- CARGA ---
+struct Resultado {
+  uint32_t intentos = 0, aceptados = 0, rechazados = 0;
+  uint32_t cortes = 0;              // reconexiones
+  std::vector<uint32_t> paradasUs; // lo que tarda cada pasada del loop en las llamadas MQTT
+};
+
+// payload de n bytes que empieza con el instante de publish()
+size_t payload(uint8_t* out, size_t n) {
+  int k = std::snprintf(reinterpret_cast<char*>(out), n, "t=%llu;", static_cast<unsigned long long>(nowUs()));
+  for (size_t i = size_t(k); i < n; i++) out[i] = 'x';
+  return n;
+}
+
+enum Escenario { Nodo, Rafaga };
+
+// los dos clientes detrás de la misma forma de publicar
+struct ClientePubSub {
+  PubSubModelo& m;
+  const char* host;
+  uint16_t port;
+  bool conectar() { return m.connect(host, port, "bench"); }
+  bool conectado() { return m.connected(); }
+  bool publicar(const char* t, const uint8_t* p, size_t n, bool qos1) { return m.publish(t, p, unsigned(n), qos1); }
+  bool loop() { return m.loop(); }
+  void desconectar() { m.disconnect(); }
+};
+
+template <class Mqtt>
+struct ClienteAsync {
+  Mqtt& m;
+  bool conectar() { return m.connect("bench"); }
+  bool conectado() { return m.connected(); }
+  bool publicar(const char* t, const uint8_t* p, size_t n, bool qos1) {
+    return m.publish(t, p, unsigned(n), qos1, qos1 ? 1 : 0);
+  }
+  bool loop() { return m.loop(); }
+  void desconectar() {
+    // lo que queda en cola sale antes de cortar
+    const uint32_t t0 = millis();
+    while ((m.queued() || m.inflight()) && millis() - t0 < 5000) {
+      syncClock();
+      m.loop();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    m.disconnect();
+  }
+};
+
+template <class Cliente>
+Resultado correr(Cliente& c, Escenario e, uint32_t segundos) {
+  Resultado r;
+  uint8_t buf[700];
+  syncClock();
+  c.conectar();
+  const uint64_t fin = nowUs() + uint64_t(segundos) * 1000000;
+  uint64_t sigLectura = nowUs(), sigLote = nowUs(), sigEstado = nowUs();
+  while (nowUs() < fin) {
+    syncClock();
+    const uint64_t t0 = nowUs();
+    if (!c.conectado()) {
+      r.cortes++;
+      c.conectar(); // bloquea lo mismo con los dos clientes
+    } else if (e == Nodo) {
+      const uint64_t ahora = t0;
+      if (ahora >= sigLectura) {
+        sigLectura += 100000;
+        r.intentos++;
+        (c.publicar("soil", buf, payload(buf, 40), false) ? r.aceptados : r.rechazados)++;
+      }
+      if (ahora >= sigLote) {
+        sigLote += 1000000;
+        r.intentos++;
+        (c.publicar("soil/bin", buf, payload(buf, 600), false) ? r.aceptados : r.rechazados)++;
+      }
+      if (ahora >= sigEstado) {
+        sigEstado += 2000000;
+        r.intentos++;
+        (c.publicar("invernadero/act/soil/riego", buf, payload(buf, 60), true) ? r.aceptados : r.rechazados)++;
+      }
+    } else {
+      for (int i = 0; i < 20; i++) {
+        r.intentos++;
+        if (!c.publicar("soil", buf, payload(buf, 100), false)) {
+          r.rechazados++;
+          break;
+        }
+        r.aceptados++;
+      }
+    }
+    c.loop();
+    r.paradasUs.push_back(uint32_t(nowUs() - t0));
+    // una pasada del loop por milisegundo
+    const uint64_t sig = (t0 / 1000 + 1) * 1000;
+    if (nowUs() < sig) std::this_thread::sleep_for(std::chrono::microseconds(sig - nowUs()));
+  }
+  c.desconectar();
+  return r;
+}
+
+// printf cuenta bytes: los acentos descuadran la tabla
+int ancho(const char* s, int n) {
+  for (; *s; s++) n += (uint8_t(*s) & 0xC0) == 0x80;
+  return n;
+}
+
+void fila(const char* escenario, const char* cliente, const Resultado& r, Broker& b, uint32_t segundos) {
+  Recibido& rx = b.recibido();
+  // el broker termina de leer lo último
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  size_t largas = 0;
+  for (uint32_t p : r.paradasUs) largas += p > 50000;
+  std::printf("%-*s %-7s %8u %8u %8.1f %9.1f %9.2f %9.2f %9.1f %6zu %6u %9.1f %9.1f %5u\n", ancho(escenario, 8),
+              escenario, cliente, r.aceptados, r.rechazados, double(rx.mensajes) / segundos, double(rx.bytes) / segundos / 1024.0,
+              percentil(r.paradasUs, 50) / 1000.0, percentil(r.paradasUs, 99) / 1000.0,
+              r.paradasUs.empty() ? 0.0 : *std::max_element(r.paradasUs.begin(), r.paradasUs.end()) / 1000.0, largas,
+              r.cortes, percentil(rx.latenciasUs, 50) / 1000.0, percentil(rx.latenciasUs, 99) / 1000.0,
+              rx.duplicados.load());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Serial.quiet = true;
+  mock::realTime = true;
+  const uint32_t segundos = argc > 1 ? uint32_t(std::max(1, std::atoi(argv[1]))) : 15;
+  Enlace enlace;
+  if (argc > 2) enlace.rttMs = uint32_t(std::atoi(argv[2]));
+  if (argc > 3) enlace.kbps = uint32_t(std::max(1, std::atoi(argv[3])));
+  if (argc > 4) enlace.rachaMs = uint32_t(std::atoi(argv[4]));
+  if (argc > 5) enlace.cadaMs = uint32_t(std::max(1, std::atoi(argv[5])));
+  if (enlace.rachaMs >= enlace.cadaMs) enlace.rachaMs = 0;
+
+  Broker broker;
+  if (!broker.begin()) {
+    std::fprintf(stderr, "no se puede abrir el broker local\n");
+    return 1;
+  }
+  std::printf("enlace: RTT %u ms, %u KB/s, buffer de envío %zu bytes, ACK retenidos %u ms cada %u ms; %u s por prueba\n",
+              enlace.rttMs, enlace.kbps, enlace.sndBuf, enlace.rachaMs, enlace.cadaMs, segundos);
+  std::printf("%-8s %-7s %8s %8s %8s %9s %9s %9s %*s %6s %6s %9s %9s %5s\n", "prueba", "cliente", "acept.", "rechaz.",
+              "msg/s", "KB/s", "loop p50", "loop p99", ancho("loop máx", 9), "loop máx", ">50ms", "cortes", "lat. p50", "lat. p99", "dup");
+
+  const char* const kNombres[] = {"nodo", "ráfaga"};
+  for (Escenario e : {Nodo, Rafaga}) {
+    {
+      broker.reset();
+      TcpLento tcp(enlace);
+      PubSubModelo m(tcp);
+      ClientePubSub c{m, "127.0.0.1", broker.port()};
+      const Resultado r = correr(c, e, segundos);
+      fila(kNombres[e], "pubsub", r, broker, segundos);
+    }
+    {
+      broker.reset();
+      TcpLento tcp(enlace);
+      AsyncMqtt<TcpLento> m(tcp);
+      m.setServer("127.0.0.1", broker.port()).setSocketTimeout(1);
+      ClienteAsync<AsyncMqtt<TcpLento>> c{m};
+      const Resultado r = correr(c, e, segundos);
+      fila(kNombres[e], "async", r, broker, segundos);
+      const MqttStats& s = m.stats();
+      std::printf("%17sasync: %u directos, %u por la cola (máx %u bytes), %u rechazados, %u QoS 1 confirmados, "
+                  "%u reenviados\n",
+                  "", s.directos, s.encolados, s.colaMax, s.rechazados, s.confirmados, s.reenvios);
+    }
+  }
+  broker.end();
+  return 0;
+}
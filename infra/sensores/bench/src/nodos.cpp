@@ -0,0 +1,286 @@
+// --- BENCHMARK DEL CAMINO DE PUBLICACIÓN DE LOS NODOS ---
+// ejecuta en bucle, contra los mocks, lo que hace cada nodo (ldr, soil, mq135, temp_hum) en un periodo de
+//   publicación: las muestras del A0 (o los pasos de la conversión del DHT11), la lectura del driver, la banda muerta, la escritura del JSON y el publish, igual
+//   que SensorNode::readAndPublish() (sin el log por el Serial). Por nodo mide:
+//   - ns_tick: ns por periodo (el mejor de --repeticiones pasadas de --ticks periodos, para quitar ruido del sistema)
+//   - bytes_tick: bytes del payload
+//   - pila_bytes: pila que usa un periodo, pintando la zona libre antes y viendo hasta dónde se ha escrito
+//   - allocs_tick: reservas de memoria dinámica por periodo (tiene que ser 0: el nodo no usa el heap)
+//
+// Los tiempos y la pila son del ordenador, no del ESP8266: sirven para comparar un cambio contra el anterior en la
+//   misma máquina, no como valor absoluto.
+//
+// Con --informe se escribe el resultado en JSON. Con --base se compara contra un informe anterior y el programa
+//   termina con 1 si algún nodo empeora: ns_tick más de --tol-ns (20 % por defecto), pila más de --tol-pila (10 %),
+//   o cualquier aumento de bytes o de reservas.
+//
+// Uso: program [--ticks 200000] [--repeticiones 5] [--informe nodos.json] [--base base.json] [--tol-ns 0.2]
+//              [--tol-pila 0.1]
+#include <DhtDriver.h>
+#include <LdrDriver.h>
+#include <Mq135Driver.h>
+#include <SoilDriver.h>
+
+#include <ESP8266WiFi.h>
+#include <PayloadWriter.h>
+#include <PubSubClient.h>
+#include <PublishPolicy.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+
+// --- CONTADOR DE RESERVAS ---
+// todas las reservas del programa pasan por aquí; solo se cuentan mientras contar es true
+namespace {
+bool contar = false;
+uint64_t reservas = 0;
+}  // namespace
+
+void* operator new(size_t n) {
+  if (contar) reservas++;
+  if (void* p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void* operator new[](size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+
+struct Config {
+  uint32_t ticks = 200000;
+  uint32_t repeticiones = 5;
+  std::string informe, base;
+  double tolNs = 0.2, tolPila = 0.1;
+};
+
+struct Resultado {
+  std::string nodo;
+  double nsTick = 0;
+  uint32_t bytesTick = 0;
+  uint32_t pilaBytes = 0;
+  double allocsTick = 0;
+};
+
+// --- PILA ---
+// pintar() y usada() se llaman desde el mismo marco que la función medida, así que su zona cae sobre la pila que esa
+//   función va a usar. La pila crece hacia abajo: lo usado es lo que ya no tiene el patrón, empezando por arriba.
+constexpr size_t kZona = 64 * 1024;
+constexpr uint8_t kPatron = 0xA5;
+
+// leer la zona sin inicializar es justo lo que queremos: lo que quedó de pintar() o de la función medida
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-but-set-variable"
+#pragma GCC diagnostic ignored "-Wuninitialized"
+
+__attribute__((noinline)) void pintar() {
+  volatile uint8_t zona[kZona];
+  for (size_t i = 0; i < kZona; i++) zona[i] = kPatron;
+}
+
+__attribute__((noinline)) uint32_t usada() {
+  volatile uint8_t zona[kZona];
+  size_t i = 0;
+  while (i < kZona && zona[i] == kPatron) i++;
+  return uint32_t(kZona - i);
+}
+#pragma GCC diagnostic pop
+
+// --- CAMINO DE UN NODO ---
+template <class Driver>
+class Camino {
+ public:
+  static constexpr uint32_t kMuestras = Driver::kSampleMs ? Driver::kPeriodMs / Driver::kSampleMs : 0;
+
+  Camino() {
+    driver_.begin();
+    mqtt_.connect(Driver::kClientId);
+  }
+
+  // un periodo de publicación; devuelve los bytes del payload (0 si no se ha publicado)
+  __attribute__((noinline)) uint32_t tick() {
+    // el reloj del mock avanza a mano (sin disparar nada) para que la conversión del DHT11 vaya por sus pasos
+    for (uint32_t i = 0; i < kMuestras; i++) {
+      mock::nowMs += Driver::kSampleMs;
+      mock::nowUs += Driver::kSampleMs * 1000;
+      driver_.sample();
+    }
+    typename Driver::Reading r;
+    if (!driver_.read(r)) return 0;
+    // la decisión se calcula pero publicamos siempre: medimos el peor caso, el de un periodo que sí publica
+    const auto decision = policy_.decide(r, nowMs_);
+    PayloadWriter w(payload_, sizeof(payload_));
+    w.begin();
+    Driver::write(w, r);
+    const size_t len = w.end();
+    if (!len || !mqtt_.publish(Driver::kTopic, reinterpret_cast<const uint8_t*>(payload_), len)) return 0;
+    policy_.sent(r, nowMs_, decision == PublishPolicy<Driver>::Suprimir ? PublishPolicy<Driver>::Cambio : decision);
+    nowMs_ += Driver::kPeriodMs;
+    return uint32_t(len);
+  }
+
+ private:
+  Driver driver_;
+  PublishPolicy<Driver> policy_;
+  WiFiClient wifi_;
+  PubSubClient mqtt_{wifi_};
+  char payload_[Driver::kPayloadMax];
+  uint32_t nowMs_ = 0;
+};
+
+template <class Driver>
+__attribute__((noinline)) uint32_t pila(Camino<Driver>& c) {
+  pintar();
+  c.tick();
+  return usada();
+}
+
+template <class Driver>
+Resultado medir(const char* nombre, const Config& cfg) {
+  Resultado res;
+  res.nodo = nombre;
+  Camino<Driver> c;
+  for (uint32_t i = 0; i < 1000; i++) c.tick(); // calentamiento (filtros llenos, cachés)
+
+  res.pilaBytes = pila(c);
+
+  reservas = 0;
+  contar = true;
+  uint64_t bytes = 0;
+  double mejor = 1e300;
+  for (uint32_t rep = 0; rep < cfg.repeticiones; rep++) {
+    const auto t0 = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < cfg.ticks; i++) bytes += c.tick();
+    const auto t1 = std::chrono::steady_clock::now();
+    mejor = std::min(mejor, std::chrono::duration<double, std::nano>(t1 - t0).count() / cfg.ticks);
+  }
+  contar = false;
+  const double total = double(cfg.ticks) * cfg.repeticiones;
+  res.nsTick = mejor;
+  res.bytesTick = uint32_t(double(bytes) / total + 0.5);
+  res.allocsTick = double(reservas) / total;
+  return res;
+}
+
+// --- INFORME ---
+// un nodo por línea, para poder leerlo de vuelta con sscanf sin un parser de JSON
+bool escribir(const std::string& path, const Config& cfg, const std::vector<Resultado>& rs) {
+  FILE* f = std::fopen(path.c_str(), "w");
+  if (!f) {
+    std::fprintf(stderr, "no se puede escribir %s\n", path.c_str());
+    return false;
+  }
+  std::fprintf(f, "{\"ticks\":%u,\"repeticiones\":%u,\"nodos\":[\n", cfg.ticks, cfg.repeticiones);
+  for (size_t i = 0; i < rs.size(); i++) {
+    const Resultado& r = rs[i];
+    std::fprintf(f, "{\"nodo\":\"%s\",\"ns_tick\":%.1f,\"bytes_tick\":%u,\"pila_bytes\":%u,\"allocs_tick\":%.3f}%s\n",
+                 r.nodo.c_str(), r.nsTick, r.bytesTick, r.pilaBytes, r.allocsTick, i + 1 < rs.size() ? "," : "");
+  }
+  std::fprintf(f, "]}\n");
+  return std::fclose(f) == 0;
+}
+
+bool leer(const std::string& path, std::vector<Resultado>& rs) {
+  FILE* f = std::fopen(path.c_str(), "r");
+  if (!f) {
+    std::fprintf(stderr, "no se puede leer %s\n", path.c_str());
+    return false;
+  }
+  char linea[256];
+  while (std::fgets(linea, sizeof(linea), f)) {
+    Resultado r;
+    char nodo[32];
+    if (std::sscanf(linea, "{\"nodo\":\"%31[^\"]\",\"ns_tick\":%lf,\"bytes_tick\":%u,\"pila_bytes\":%u,\"allocs_tick\":%lf",
+                    nodo, &r.nsTick, &r.bytesTick, &r.pilaBytes, &r.allocsTick) == 5) {
+      r.nodo = nodo;
+      rs.push_back(r);
+    }
+  }
+  std::fclose(f);
+  return !rs.empty();
+}
+
+// compara contra la base e imprime cada empeoramiento; devuelve cuántos hay
+int comparar(const Config& cfg, const std::vector<Resultado>& base, const std::vector<Resultado>& rs) {
+  int peores = 0;
+  for (const Resultado& r : rs) {
+    const auto b = std::find_if(base.begin(), base.end(), [&](const Resultado& x) { return x.nodo == r.nodo; });
+    if (b == base.end()) {
+      std::printf("  %-9s sin base\n", r.nodo.c_str());
+      continue;
+    }
+    auto peor = [&](const char* que, double antes, double ahora, double tol) {
+      if (ahora <= antes * (1 + tol) + 1e-9) return;
+      std::printf("  %-9s EMPEORA %s: %.1f -> %.1f (%+.0f %%, tolerancia %.0f %%)\n", r.nodo.c_str(), que, antes, ahora,
+                  antes > 0 ? (ahora / antes - 1) * 100 : 100.0, tol * 100);
+      peores++;
+    };
+    peor("ns_tick", b->nsTick, r.nsTick, cfg.tolNs);
+    peor("bytes_tick", b->bytesTick, r.bytesTick, 0);
+    peor("pila_bytes", b->pilaBytes, r.pilaBytes, cfg.tolPila);
+    peor("allocs_tick", b->allocsTick, r.allocsTick, 0);
+  }
+  return peores;
+}
+
+bool leerArgs(int argc, char** argv, Config& c) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string k = argv[i];
+    const char* v = argv[i + 1];
+    if (k == "--ticks") c.ticks = uint32_t(std::max(1, std::atoi(v)));
+    else if (k == "--repeticiones") c.repeticiones = uint32_t(std::max(1, std::atoi(v)));
+    else if (k == "--informe") c.informe = v;
+    else if (k == "--base") c.base = v;
+    else if (k == "--tol-ns") c.tolNs = std::atof(v);
+    else if (k == "--tol-pila") c.tolPila = std::atof(v);
+    else return false;
+  }
+  return (argc % 2) == 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Config cfg;
+  if (!leerArgs(argc, argv, cfg)) {
+    std::fprintf(stderr, "argumentos no válidos (ver el comentario de bench/src/nodos.cpp)\n");
+    return 2;
+  }
+  std::vector<Resultado> base;
+  if (!cfg.base.empty() && !leer(cfg.base, base)) return 2;
+
+  Serial.quiet = true;
+  mock::storePublishes = false;
+  // el A0 y el DHT cambian en cada lectura para que los filtros y la banda muerta trabajen como con datos reales
+  uint32_t x = 1;
+  mock::adcSource = [&x] {
+    x = x * 1103515245u + 12345u;
+    return int(400 + (x >> 16) % 200);
+  };
+
+  std::vector<Resultado> rs;
+  rs.push_back(medir<LdrDriver>("ldr", cfg));
+  rs.push_back(medir<SoilDriver>("soil", cfg));
+  rs.push_back(medir<Mq135Driver>("mq135", cfg));
+  mock::dhtTemp = 21.7f;
+  rs.push_back(medir<DhtDriver>("temp_hum", cfg));
+
+  std::printf("%-9s %10s %10s %10s %11s\n", "nodo", "ns/tick", "bytes", "pila", "allocs/tick");
+  for (const Resultado& r : rs) {
+    std::printf("%-9s %10.1f %10u %10u %11.3f\n", r.nodo.c_str(), r.nsTick, r.bytesTick, r.pilaBytes, r.allocsTick);
+  }
+  if (!cfg.informe.empty() && !escribir(cfg.informe, cfg, rs)) return 2;
+  if (base.empty()) return 0;
+  std::printf("comparación con %s\n", cfg.base.c_str());
+  const int peores = comparar(cfg, base, rs);
+  if (!peores) std::printf("  sin empeoramientos\n");
+  return peores ? 1 : 0;
+}
@@ -0,0 +1,160 @@
+// --- SIMULACIÓN DEL MODO DE BAJO CONSUMO ---
+// ejecuta el nodo de suelo compilado con -DNODE_DEEP_SLEEP despertar a despertar: cada despertar es un SensorNode
+//   nuevo (la RAM se pierde) sobre la misma memoria RTC simulada. El broker se cae al azar y a mitad de la simulación
+//   el AP cambia de canal, para que la asociación rápida falle una vez. Los cortes largos llenan la RTC y obligan a
+//   pasar lecturas a la flash. Comprueba que todas las lecturas llegan (o se
+//   cuentan como perdidas) y resume los tiempos despierto y el consumo estimado.
+//   Los tiempos despierto son los de millis(): en el mock leer el sensor no cuesta tiempo, solo la asociación WiFi.
+//   Uso: program [horas simuladas] [semilla]
+#include <BatchFormat.h>
+#include <SensorNode.h>
+#include <SoilDriver.h>
+#include <Ticker.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// consumos típicos de un NodeMCU (mA): con la radio encendida, despierto con la radio apagada y en deep sleep
+//   (el del regulador y el USB de la placa no cuentan: en una sonda a pilas se quitan)
+constexpr double kRadioMa = 75.0;
+constexpr double kCpuMa = 16.0;
+constexpr double kSleepMa = 0.02;
+constexpr double kBootMs = 60.0; // arranque de la ROM antes de setup(), no lo ve millis()
+constexpr double kBatteryMah = 2000.0;
+
+// saca un campo numérico de un payload JSON plano
+static long campo(const std::string& json, const char* key) {
+  const std::string k = std::string("\"") + key + "\":";
+  const size_t p = json.find(k);
+  return p == std::string::npos ? -1 : std::strtol(json.c_str() + p + k.size(), nullptr, 10);
+}
+
+static uint32_t percentil(std::vector<uint32_t> v, int p) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  return v[std::min(v.size() - 1, v.size() * size_t(p) / 100)];
+}
+
+int main(int argc, char** argv) {
+  const uint32_t horas = argc > 1 ? uint32_t(std::atoi(argv[1])) : 24;
+  std::mt19937 rng(argc > 2 ? uint32_t(std::atoi(argv[2])) : 1);
+  Serial.quiet = true;
+  mock::wifiAssocMs = 2500; // escaneo de canales + DHCP
+  mock::wifiFastAssocMs = 250;
+
+  std::uniform_int_distribution<int> adc(200, 900);
+  mock::adcSource = [&] { return adc(rng); };
+  std::uniform_real_distribution<double> u(0, 1);
+
+  const uint64_t totalMs = uint64_t(horas) * 3600 * 1000;
+  uint64_t reloj = 0, radioMs = 0, cpuMs = 0, sueloMs = 0;
+  uint32_t despertares = 0, conRadio = 0, cortes = 0;
+  uint64_t caidoHasta = 0;
+  bool canalCambiado = false;
+  std::vector<uint32_t> despiertoSinRadio, despiertoConRadio;
+
+  // tras el final dejamos el broker arriba hasta que un despertar con radio lo vacíe todo
+  bool vaciado = false;
+  uint32_t extra = 0;
+  while (reloj < totalMs || (!vaciado && extra++ < 100)) {
+    if (reloj < totalMs) {
+      // cortes: cada despertar hay un 1 % de probabilidad de que se caiga, entre 5 min y 3 h
+      if (mock::brokerUp && u(rng) < 0.01) {
+        mock::brokerUp = false;
+        caidoHasta = reloj + uint64_t(5 + rng() % 175) * 60000;
+        cortes++;
+      }
+      if (!mock::brokerUp && reloj >= caidoHasta) mock::brokerUp = true;
+      if (!canalCambiado && reloj >= totalMs / 2) {
+        mock::apChannel = 11;
+        canalCambiado = true;
+      }
+    } else {
+      mock::brokerUp = true;
+    }
+
+    // despertar: RAM nueva, millis() a 0, la RTC intacta
+    mock::reboot();
+    WiFi = MockWiFi();
+    const bool radio = mock::deepSleeps == 0 || mock::sleepMode == RF_DEFAULT;
+    const uint32_t antes = mock::deepSleeps;
+    const size_t publicadas = mock::publicaciones.size();
+    {
+      auto nodo = std::make_unique<SensorNode<SoilDriver>>();
+      nodo->begin();
+    }
+    if (mock::deepSleeps != antes + 1) {
+      std::printf("el nodo no se ha dormido en el despertar %u\n", despertares);
+      return 1;
+    }
+    despertares++;
+    const uint32_t despierto = millis();
+    (radio ? despiertoConRadio : despiertoSinRadio).push_back(despierto);
+    (radio ? radioMs : cpuMs) += uint64_t(despierto + kBootMs);
+    if (radio) conRadio++;
+    sueloMs += mock::sleepUs / 1000;
+    reloj += despierto + mock::sleepUs / 1000;
+
+    if (reloj >= totalMs && radio && mock::publicaciones.size() > publicadas) {
+      const std::string& stats = mock::publicaciones.back().payload;
+      vaciado = campo(stats, "pendientes") == 0 && campo(stats, "en_flash") == 0;
+    }
+  }
+
+  // decodificamos los lotes y repasamos los stats
+  size_t recibidas = 0, lotes = 0, errores = 0;
+  long perdidos = 0, rapidas = 0, normales = 0;
+  uint32_t anterior = 0;
+  std::vector<uint32_t> asociacionRapida, asociacionNormal, despertarPublicar;
+  for (const auto& p : mock::publicaciones) {
+    if (p.topic == "soil/bin") {
+      batch::Header h;
+      batch::Sample s[batch::kMaxSamples];
+      const size_t n = batch::decode(reinterpret_cast<const uint8_t*>(p.payload.data()), p.payload.size(), h, s,
+                                     batch::kMaxSamples);
+      if (!n) errores++;
+      // las marcas de tiempo del reloj de la RTC tienen que ir siempre hacia delante
+      for (size_t i = 0; i < n; i++) {
+        if (s[i].ts <= anterior && recibidas) errores++;
+        anterior = s[i].ts;
+      }
+      recibidas += n;
+      lotes++;
+    } else if (p.topic == "soil/stats") {
+      perdidos = campo(p.payload, "perdidos");
+      const uint32_t a = uint32_t(campo(p.payload, "asociacion_ms"));
+      if (campo(p.payload, "asociacion_rapida")) {
+        rapidas++;
+        asociacionRapida.push_back(a);
+      } else {
+        normales++;
+        asociacionNormal.push_back(a);
+      }
+      despertarPublicar.push_back(uint32_t(campo(p.payload, "despertar_a_publicar_ms")));
+    }
+  }
+
+  const double horasReales = double(reloj) / 3600000.0;
+  const double mah = (radioMs * kRadioMa + cpuMs * kCpuMa + sueloMs * kSleepMa) / 3600000.0;
+  const double mediaMa = mah / horasReales;
+
+  std::printf("horas simuladas        %.1f (%u cortes del broker)\n", horasReales, cortes);
+  std::printf("despertares            %u (%u con radio)\n", despertares, conRadio);
+  std::printf("lecturas recibidas     %zu en %zu lotes, perdidas %ld, errores %zu\n", recibidas, lotes, perdidos,
+              errores);
+  std::printf("despierto sin radio    p50 %u ms, max %u ms\n", percentil(despiertoSinRadio, 50),
+              percentil(despiertoSinRadio, 100));
+  std::printf("despierto con radio    p50 %u ms, max %u ms\n", percentil(despiertoConRadio, 50),
+              percentil(despiertoConRadio, 100));
+  std::printf("asociación rápida      %ld veces, p50 %u ms\n", rapidas, percentil(asociacionRapida, 50));
+  std::printf("asociación normal      %ld veces, p50 %u ms\n", normales, percentil(asociacionNormal, 50));
+  std::printf("despertar a publicar   p50 %u ms, p99 %u ms\n", percentil(despertarPublicar, 50),
+              percentil(despertarPublicar, 99));
+  std::printf("consumo medio          %.3f mA (siempre encendido: ~%.0f mA)\n", mediaMa, kRadioMa);
+  std::printf("autonomía estimada     %.0f días con %.0f mAh\n", kBatteryMah / mediaMa / 24, kBatteryMah);
+  return recibidas + size_t(perdidos) == despertares && !errores ? 0 : 1;
+}
@@ -0,0 +1,388 @@
+// --- CALIBRACIÓN DE LOS SENSORES ANALÓGICOS ---
+// el MQ135 publicaba un "porcentaje" que era el raw escalado a 0-100, y el suelo un map() de 1023-0 a 0-100 igual
+//   para todas las sondas. Aquí están las dos conversiones calibradas, en enteros y sin floats en la placa:
+//
+// MQ135 (ppm de CO2 equivalente): la curva del datasheet es una potencia,
+//   ppm = a · (Rs / (R0 · k(t, h)))^b        Rs/RL = (Vc - Vout) / Vout = (vc - raw) / raw
+//   con R0 la resistencia del sensor en aire limpio (la que se calibra), RL la de carga del módulo y k(t, h) la
+//   corrección por temperatura y humedad del datasheet (1 a 20 ºC y 33 %). En logaritmos es una recta:
+//   log2(ppm) = log2(a) + b · (log2(vc - raw) - log2(raw) + log2(RL / R0) - log2(k))
+//   así que por muestra son dos log2 y un 2^x por tabla con interpolación lineal, una multiplicación y
+//   desplazamientos. log2(a), b, log2(RL/R0) y log2(k) se precalculan al cambiar la calibración o la temperatura,
+//   por eso a, b, R0 y RL se pueden cambiar en marcha sin recalcular ninguna tabla.
+//
+// Suelo (% de humedad): la respuesta de cada sonda capacitiva depende de la sonda y del sustrato. La curva son de 2
+//   a 8 puntos (raw, %) medidos con esa sonda (como poco en seco y recién regada) y se interpola entre ellos con la
+//   pendiente de cada tramo ya calculada en Q24: una multiplicación y un desplazamiento, sin divisiones.
+//
+// Las tablas (log2 y 2^x de 65 entradas) y las curvas por defecto de los drivers se generan al compilar (constexpr):
+//   en el binario solo quedan los enteros. Es C++ puro: lo usan los drivers (mq135 y soil) y el banco del
+//   ordenador que mide el error y el coste frente a la fórmula en float (bench, entorno calibracion).
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <Comando.h>
+
+namespace calib {
+
+// --- MATEMÁTICA AL COMPILAR ---
+// solo para generar tablas y constantes: en la placa no se ejecuta nada de esto
+namespace cx {
+
+constexpr double kLn2 = 0.693147180559945309417;
+
+// ln(x) para x > 0: x = m·2^k con m en [1, 2) y ln(m) = 2·atanh((m - 1) / (m + 1))
+constexpr double ln(double x) {
+  int k = 0;
+  while (x >= 2) {
+    x /= 2;
+    k++;
+  }
+  while (x < 1) {
+    x *= 2;
+    k--;
+  }
+  const double z = (x - 1) / (x + 1);
+  double term = z, sum = 0;
+  for (int n = 1; n < 60; n += 2) {
+    sum += term / n;
+    term *= z * z;
+  }
+  return 2 * sum + k * kLn2;
+}
+
+constexpr double log2(double x) { return ln(x) / kLn2; }
+
+// 2^y: la parte entera duplicando y la fraccionaria por la serie de e^(f·ln2)
+constexpr double exp2(double y) {
+  int n = int(y);
+  if (n > y) n--;
+  const double f = (y - n) * kLn2;
+  double term = 1, sum = 1;
+  for (int i = 1; i < 30; i++) {
+    term *= f / i;
+    sum += term;
+  }
+  for (; n > 0; n--) sum *= 2;
+  for (; n < 0; n++) sum /= 2;
+  return sum;
+}
+
+constexpr int64_t redondear(double v) { return v < 0 ? int64_t(v - 0.5) : int64_t(v + 0.5); }
+
+// v en coma fija con bits decimales
+constexpr int64_t q(double v, uint8_t bits) { return redondear(v * double(1ull << bits)); }
+
+}  // namespace cx
+
+// --- TABLAS ---
+constexpr uint8_t kBitsTabla = 6; // 64 tramos: el error de la interpolación queda por debajo de 5e-5 en log2
+constexpr uint32_t kTabla = 1u << kBitsTabla;
+
+struct Tabla {
+  uint32_t v[kTabla + 1];
+};
+
+// log2(1 + i/64) en Q16
+constexpr Tabla tablaLog2() {
+  Tabla t{};
+  for (uint32_t i = 0; i <= kTabla; i++) t.v[i] = uint32_t(cx::q(cx::log2(1.0 + double(i) / kTabla), 16));
+  return t;
+}
+
+// 2^(i/64) en Q16
+constexpr Tabla tablaExp2() {
+  Tabla t{};
+  for (uint32_t i = 0; i <= kTabla; i++) t.v[i] = uint32_t(cx::q(cx::exp2(double(i) / kTabla), 16));
+  return t;
+}
+
+inline constexpr Tabla kLog2 = tablaLog2();
+inline constexpr Tabla kExp2 = tablaExp2();
+
+// --- COMA FIJA ---
+// log2(x) en Q16 (x > 0; para x = 0 devuelve el de 1): la parte entera es la posición del bit más alto y la
+//   fraccionaria sale de la tabla con los bits siguientes
+constexpr int32_t log2q(uint32_t x) {
+  if (!x) x = 1;
+  const int32_t msb = 31 - __builtin_clz(x);
+  const uint32_t m = (x << (31 - msb)) << 1; // mantisa sin el 1 de delante, alineada a la izquierda
+  const uint32_t i = m >> (32 - kBitsTabla);
+  const uint32_t w = (m >> (16 - kBitsTabla)) & 0xFFFF; // peso de la interpolación en Q16
+  const uint32_t a = kLog2.v[i], b = kLog2.v[i + 1];
+  return (msb << 16) + int32_t(a + (((b - a) * w) >> 16));
+}
+
+// 2^(y / 65536) redondeado a entero; satura en 0 y en UINT32_MAX
+constexpr uint32_t exp2q(int32_t y) {
+  const int32_t n = y >> 16; // desplazamiento aritmético: redondea hacia abajo también con y < 0
+  const uint32_t f = uint32_t(y) & 0xFFFF;
+  const uint32_t i = f >> (16 - kBitsTabla);
+  const uint32_t w = f & ((1u << (16 - kBitsTabla)) - 1);
+  const uint32_t a = kExp2.v[i], b = kExp2.v[i + 1];
+  const uint32_t m = a + (((b - a) * w) >> (16 - kBitsTabla)); // Q16 en [1, 2)
+  if (n >= 16) return n > 31 ? 0xFFFFFFFFu : m << (n - 16);
+  if (n < -1) return 0;
+  return (m + (1u << (15 - n))) >> (16 - n);
+}
+
+// --- ERRORES ---
+enum Error : uint8_t { Ok, Json, Rango, Aire };
+
+inline const char* nombreError(Error e) {
+  switch (e) {
+    case Ok: return "ok";
+    case Json: return "json";
+    case Rango: return "rango";
+    case Aire: return "aire";
+  }
+  return "?";
+}
+
+// --- MQ135 ---
+// lo que se guarda en la flash y se cambia por MQTT
+struct Mq135Param {
+  int32_t r0; // ohmios: resistencia del sensor en aire limpio
+  int32_t rl; // ohmios: resistencia de carga del módulo
+  int32_t a;  // milésimas
+  int32_t b;  // milésimas (negativo: más gas, menos resistencia)
+  int32_t vc; // lectura del ADC que correspondería a la tensión de alimentación del sensor
+};
+
+class Mq135 {
+ public:
+  static constexpr int32_t kPpmMax = 99999; // el payload reserva 5 cifras
+  static constexpr int16_t kTempRef = 2000; // centésimas: la curva del datasheet es a 20 ºC y 33 %
+  static constexpr int16_t kHumRef = 3300;
+
+  constexpr Mq135() = default;
+  constexpr explicit Mq135(const Mq135Param& p) {
+    configurar(p);
+    ambiente(kTempRef, kHumRef);
+  }
+
+  // valida la calibración y precalcula sus logaritmos; false (y se queda la anterior) si algo está fuera de rango
+  constexpr bool configurar(const Mq135Param& p) {
+    if (p.r0 < 1 || p.rl < 1 || p.a < 1 || p.b >= 0 || p.b < -20000 || p.vc < 2 || p.vc > 4095) return false;
+    p_ = p;
+    log2a_ = log2q(uint32_t(p.a)) - kLog2Mil;
+    b16_ = int32_t((int64_t(p.b) * 65536 - 500) / 1000);
+    lRlR0_ = log2q(uint32_t(p.rl)) - log2q(uint32_t(p.r0));
+    return true;
+  }
+
+  // temperatura y humedad en centésimas (las del DHT11). k(t, h) = A·t² - B·t + C - D·(h - 33), en Q40 y con t y h
+  //   en centésimas: cabe de sobra en 64 bits y solo se calcula cuando cambian
+  constexpr void ambiente(int16_t t, int16_t h) {
+    t_ = t;
+    h_ = h;
+    int64_t k = kCorA * t * t - kCorB * t + kCorC - kCorD * (h - kHumRef);
+    k >>= 24; // Q16
+    if (k < (1 << 14)) k = 1 << 14;
+    lK_ = log2q(uint32_t(k)) - (16 << 16);
+  }
+
+  // ppm a partir del raw del A0: raw >= vc es Rs = 0 (satura arriba) y raw <= 0 es Rs infinita (0 ppm)
+  constexpr int32_t ppm(int32_t raw) const {
+    if (raw <= 0) return 0;
+    if (raw >= p_.vc) return kPpmMax;
+    const int32_t l = log2q(uint32_t(p_.vc - raw)) - log2q(uint32_t(raw)) + lRlR0_ - lK_; // log2(Rs / (R0·k))
+    const int32_t y = log2a_ + int32_t((int64_t(b16_) * l) >> 16);
+    if (y >= kLog2PpmMax) return kPpmMax;
+    return int32_t(exp2q(y));
+  }
+
+  // la R0 con la que este raw daría esos ppm (calibración en aire limpio: unos 420 ppm de CO2 en exterior); 0 si no
+  //   se puede
+  constexpr int32_t r0Para(int32_t raw, int32_t ppm) const {
+    if (raw <= 0 || raw >= p_.vc || ppm < 1) return 0;
+    const int32_t rs = log2q(uint32_t(p_.vc - raw)) - log2q(uint32_t(raw)) + log2q(uint32_t(p_.rl));
+    const int64_t x = int64_t(log2q(uint32_t(ppm)) - log2a_) * 65536 / b16_; // log2(Rs / (R0·k))
+    const int64_t r0 = rs - lK_ - x;
+    if (r0 < 0 || r0 >= (31 << 16)) return 0;
+    return int32_t(exp2q(int32_t(r0)));
+  }
+
+  constexpr const Mq135Param& param() const { return p_; }
+  constexpr int16_t temperatura() const { return t_; }
+  constexpr int16_t humedad() const { return h_; }
+
+ private:
+  // corrección de temperatura y humedad del datasheet (ajuste de la librería MQ135 de G. Krocker)
+  static constexpr int64_t kCorA = cx::q(0.00035 / 1e4, 40);
+  static constexpr int64_t kCorB = cx::q(0.02718 / 1e2, 40);
+  static constexpr int64_t kCorC = cx::q(1.39538, 40);
+  static constexpr int64_t kCorD = cx::q(0.0018 / 1e2, 40);
+  static constexpr int32_t kLog2Mil = int32_t(cx::q(cx::log2(1000), 16));
+  static constexpr int32_t kLog2PpmMax = int32_t(cx::q(cx::log2(kPpmMax), 16));
+
+  Mq135Param p_{};
+  int32_t log2a_ = 0;
+  int32_t b16_ = -65536;
+  int32_t lRlR0_ = 0;
+  int32_t lK_ = 0; // log2(k) en Q16
+  int16_t t_ = kTempRef;
+  int16_t h_ = kHumRef;
+};
+
+// --- SUELO ---
+constexpr uint8_t kMaxPuntos = 8;
+
+struct Punto {
+  int16_t raw; // lectura del ADC filtrada
+  int16_t pct; // humedad en ese punto
+};
+
+// lo que se guarda en la flash y se cambia por MQTT
+struct SueloParam {
+  uint8_t n;
+  uint8_t reservado; // sin huecos: la calibración se compara y se guarda byte a byte
+  Punto p[kMaxPuntos];
+};
+
+class CurvaSuelo {
+ public:
+  constexpr CurvaSuelo() = default;
+  constexpr explicit CurvaSuelo(const SueloParam& p) { configurar(p); }
+
+  // ordena los puntos por raw y calcula la pendiente de cada tramo; false (y se queda la anterior) si hay menos de
+  //   dos, algún valor fuera de rango o dos con el mismo raw
+  constexpr bool configurar(SueloParam p) {
+    if (p.n < 2 || p.n > kMaxPuntos) return false;
+    for (uint8_t i = 0; i < p.n; i++) {
+      if (p.p[i].raw < 0 || p.p[i].raw > 4095 || p.p[i].pct < 0 || p.p[i].pct > 100) return false;
+    }
+    for (uint8_t i = 1; i < p.n; i++) {
+      const Punto x = p.p[i];
+      uint8_t j = i;
+      for (; j > 0 && p.p[j - 1].raw > x.raw; j--) p.p[j] = p.p[j - 1];
+      p.p[j] = x;
+    }
+    for (uint8_t i = 1; i < p.n; i++) {
+      if (p.p[i].raw == p.p[i - 1].raw) return false;
+    }
+    for (uint8_t i = p.n; i < kMaxPuntos; i++) p.p[i] = Punto{0, 0};
+    p_ = p;
+    for (uint8_t i = 0; i + 1 < p.n; i++) {
+      // redondeada: con 24 bits el error acumulado en un tramo de 4096 unidades no llega a 1/4000 de punto
+      const int64_t num = int64_t(p.p[i + 1].pct - p.p[i].pct) * (int64_t(1) << 24);
+      const int32_t den = p.p[i + 1].raw - p.p[i].raw;
+      pendiente_[i] = int32_t((num + (num < 0 ? -den / 2 : den / 2)) / den);
+    }
+    return true;
+  }
+
+  // humedad redondeada; fuera de la curva se queda en el extremo (0 sin curva configurada)
+  constexpr int16_t humedad(int32_t raw) const {
+    if (!p_.n || raw <= p_.p[0].raw) return p_.p[0].pct;
+    for (uint8_t i = 1; i < p_.n; i++) {
+      if (raw < p_.p[i].raw) {
+        return int16_t(p_.p[i - 1].pct + ((int64_t(raw - p_.p[i - 1].raw) * pendiente_[i - 1] + (1 << 23)) >> 24));
+      }
+    }
+    return p_.p[p_.n - 1].pct;
+  }
+
+  constexpr const SueloParam& param() const { return p_; }
+
+ private:
+  SueloParam p_{};
+  int32_t pendiente_[kMaxPuntos - 1] = {}; // % por unidad del ADC en Q24
+};
+
+// --- LECTURA DE LA CALIBRACIÓN POR MQTT ---
+// los campos que no vienen se quedan como estaban, y los que no conoce se ignoran
+namespace detail {
+
+inline bool es(const char* k, size_t n, const char* lit) { return cmd::detail::equalsNoCase(k, n, lit); }
+
+template <class F>
+Error campos(const char* json, size_t len, F&& campo) {
+  cmd::detail::Scanner s(json, len);
+  if (!s.eat('{')) return Json;
+  if (s.eat('}')) return s.done() ? Ok : Json;
+  do {
+    const char* k;
+    size_t kn;
+    if (!s.string(k, kn) || !s.eat(':')) return Json;
+    const Error e = campo(s, k, kn);
+    if (e != Ok) return e;
+  } while (s.eat(','));
+  return s.eat('}') && s.done() ? Ok : Json;
+}
+
+}  // namespace detail
+
+// {"r0": 76630, "rl": 10000, "a": 116.602, "b": -2.769, "vc": 1023, "aire": 420}
+//   aire: ppm de referencia del aire que respira ahora el sensor; lo resuelve el driver con r0Para() y la última
+//   lectura (aquí solo se devuelve, 0 si no viene)
+inline Error leer(const char* json, size_t len, Mq135Param& p, int32_t& aire) {
+  aire = 0;
+  return detail::campos(json, len, [&](cmd::detail::Scanner& s, const char* k, size_t n) {
+    int32_t* destino = nullptr;
+    uint8_t decimales = 0;
+    if (detail::es(k, n, "r0")) destino = &p.r0;
+    else if (detail::es(k, n, "rl")) destino = &p.rl;
+    else if (detail::es(k, n, "a")) destino = &p.a, decimales = 3;
+    else if (detail::es(k, n, "b")) destino = &p.b, decimales = 3;
+    else if (detail::es(k, n, "vc")) destino = &p.vc;
+    else if (detail::es(k, n, "aire")) destino = &aire;
+    else return s.skipValue() ? Ok : Json;
+    return s.decimal(*destino, decimales) ? Ok : Json;
+  });
+}
+
+// temperatura y humedad de una lectura del DHT11 ({"temperatura": 23.50, "humedad": 55.00, ...}) en centésimas;
+//   false si falta alguna de las dos o es una lectura atrasada que llega desde la flash del nodo ("age" o "previo")
+inline bool leerAmbiente(const char* json, size_t len, int16_t& t, int16_t& h) {
+  int32_t tt = INT32_MIN, hh = INT32_MIN;
+  bool atrasada = false;
+  const Error e = detail::campos(json, len, [&](cmd::detail::Scanner& s, const char* k, size_t n) {
+    if (detail::es(k, n, "temperatura")) return s.decimal(tt, 2) ? Ok : Json;
+    if (detail::es(k, n, "humedad")) return s.decimal(hh, 2) ? Ok : Json;
+    if (detail::es(k, n, "age") || detail::es(k, n, "previo")) atrasada = true;
+    return s.skipValue() ? Ok : Json;
+  });
+  if (e != Ok || atrasada || tt < -4000 || tt > 8000 || hh < 0 || hh > 10000) return false;
+  t = int16_t(tt);
+  h = int16_t(hh);
+  return true;
+}
+
+// {"puntos": [870, 0, 640, 35, 410, 100]} (pares raw, %) o solo los extremos: {"seco": 870, "mojado": 410}, que
+//   cambian el raw del punto de menor y de mayor humedad de la curva actual
+inline Error leer(const char* json, size_t len, SueloParam& p) {
+  return detail::campos(json, len, [&](cmd::detail::Scanner& s, const char* k, size_t n) {
+    if (detail::es(k, n, "puntos")) {
+      SueloParam nuevo{};
+      if (!s.eat('[')) return Json;
+      if (s.eat(']')) return Rango;
+      do {
+        if (nuevo.n == kMaxPuntos) return Rango;
+        int32_t raw, pct;
+        if (!s.decimal(raw, 0) || !s.eat(',') || !s.decimal(pct, 0)) return Json;
+        if (raw < 0 || raw > 4095 || pct < 0 || pct > 100) return Rango;
+        nuevo.p[nuevo.n++] = Punto{int16_t(raw), int16_t(pct)};
+      } while (s.eat(','));
+      if (!s.eat(']')) return Json;
+      p = nuevo;
+      return Ok;
+    }
+    const bool seco = detail::es(k, n, "seco");
+    if (!seco && !detail::es(k, n, "mojado")) return s.skipValue() ? Ok : Json;
+    int32_t raw;
+    if (!s.decimal(raw, 0)) return Json;
+    if (raw < 0 || raw > 4095 || p.n < 2) return Rango;
+    // el punto más seco o el más mojado de la curva actual
+    uint8_t x = 0;
+    for (uint8_t i = 1; i < p.n; i++) {
+      if (seco ? p.p[i].pct < p.p[x].pct : p.p[i].pct > p.p[x].pct) x = i;
+    }
+    p.p[x].raw = int16_t(raw);
+    return Ok;
+  });
+}
+
+}  // namespace calib
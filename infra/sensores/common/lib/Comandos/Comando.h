@@ -0,0 +1,319 @@
+// --- ÓRDENES A LOS ACTUADORES ---
+// lo que hace un nodo con un mensaje de invernadero/cmd/{nodo}/{dispositivo}, sin nada de Arduino ni de MQTT: leer la
+//   orden, descartar las repetidas y aplicar el encendido (temporizado o no) a la salida. Es C++ puro: lo usan los
+//   nodos (common/lib/NodeCore/Commands.h, que pone los pines y el MQTT) y el nodo simulado del banco de pruebas de
+//   infra/servicios (bench_comandos), para medir lo mismo que corre en la placa.
+//
+// Orden (payload de invernadero/cmd/...; los campos que no conoce, como "reason", se ignoran):
+//   {"cmd": "on", "seconds": 10, "level": 60, "id": "riego-1734390000"}
+//   - cmd: on | off | toggle (también vale el payload "on"/"off" a secas, en mayúsculas o minúsculas)
+//   - seconds: se apaga solo pasado ese tiempo (0 o sin campo: hasta la siguiente orden o el máximo del actuador)
+//   - level: 0-100 % para las salidas PWM (el ventilador); los relés lo ignoran
+//   - id: identificador de la orden (hasta 23 caracteres [A-Za-z0-9_.:-]). Las órdenes van con QoS 1, así que el broker
+//     puede entregarlas dos veces, y quien manda reintenta con el mismo id si no le llega el estado: un id ya visto no
+//     se vuelve a aplicar, solo se contesta con el estado actual y "dup": 1.
+//
+// Estado (payload de invernadero/act/{nodo}/{dispositivo}, con retain):
+//   {"state": "on", "remaining": 7, "level": 60, "id": "riego-1734390000"}
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace cmd {
+
+enum Verbo : uint8_t { Nada, On, Off, Toggle };
+
+constexpr uint8_t kIdMax = 24;          // con el '\0'
+constexpr uint32_t kMaxSeconds = 86400; // una orden temporizada dura como mucho un día
+
+struct Orden {
+  Verbo verbo = Nada;
+  uint32_t segundos = 0;
+  int16_t nivel = -1; // -1 = sin "level" (el 100 %)
+  char id[kIdMax] = {};
+  uint32_t idHash = 0; // 0 = sin id: la orden no se puede deduplicar
+};
+
+// FNV-1a; el 0 queda para "sin id"
+inline uint32_t hashId(const char* s, size_t n) {
+  uint32_t h = 2166136261u;
+  for (size_t i = 0; i < n; i++) h = (h ^ uint8_t(s[i])) * 16777619u;
+  return h ? h : 1;
+}
+
+// --- LECTURA DE LA ORDEN ---
+namespace detail {
+
+inline char lower(char c) { return c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c; }
+
+inline bool equalsNoCase(const char* s, size_t n, const char* lit) {
+  size_t i = 0;
+  for (; i < n && lit[i]; i++) {
+    if (lower(s[i]) != lit[i]) return false;
+  }
+  return i == n && !lit[i];
+}
+
+inline Verbo verbo(const char* s, size_t n) {
+  if (equalsNoCase(s, n, "on")) return On;
+  if (equalsNoCase(s, n, "off")) return Off;
+  if (equalsNoCase(s, n, "toggle")) return Toggle;
+  return Nada;
+}
+
+inline bool idChar(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-' ||
+         c == '.' || c == ':';
+}
+
+// recorre un JSON plano {"clave": valor, ...} sin copiar nada. Los valores anidados se saltan enteros.
+class Scanner {
+ public:
+  Scanner(const char* p, size_t n) : p_(p), end_(p + n) {}
+
+  void skipSpace() {
+    while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) p_++;
+  }
+  bool eat(char c) {
+    skipSpace();
+    if (p_ < end_ && *p_ == c) {
+      p_++;
+      return true;
+    }
+    return false;
+  }
+  bool done() {
+    skipSpace();
+    return p_ == end_;
+  }
+
+  // cadena entre comillas; s apunta al contenido (con los escapes sin procesar)
+  bool string(const char*& s, size_t& n) {
+    if (!eat('"')) return false;
+    s = p_;
+    while (p_ < end_ && *p_ != '"') p_ += *p_ == '\\' ? 2 : 1;
+    if (p_ >= end_) return false;
+    n = size_t(p_ - s);
+    p_++;
+    return true;
+  }
+
+  // entero no negativo (se ignora la parte decimal); false si no hay número o es negativo
+  bool number(uint32_t& v) {
+    skipSpace();
+    if (p_ >= end_ || *p_ < '0' || *p_ > '9') return false;
+    uint64_t acc = 0;
+    while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+      if (acc < 0xFFFFFFFFull) acc = acc * 10 + uint32_t(*p_ - '0');
+      p_++;
+    }
+    if (p_ < end_ && *p_ == '.') {
+      p_++;
+      while (p_ < end_ && *p_ >= '0' && *p_ <= '9') p_++;
+    }
+    v = acc > 0xFFFFFFFFull ? 0xFFFFFFFFu : uint32_t(acc);
+    return true;
+  }
+
+  // número con signo en coma fija: con decimales = 3, "-2.769" da -2769 (lo que sobra se redondea). false si no hay
+  //   número o no cabe en 32 bits
+  bool decimal(int32_t& v, uint8_t decimales) {
+    skipSpace();
+    const bool neg = p_ < end_ && *p_ == '-';
+    if (neg) p_++;
+    if (p_ >= end_ || *p_ < '0' || *p_ > '9') return false;
+    int64_t acc = 0;
+    while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+      acc = acc * 10 + (*p_ - '0');
+      if (acc > 0x7FFFFFFF) return false;
+      p_++;
+    }
+    uint8_t d = 0;
+    bool redondeo = false;
+    if (p_ < end_ && *p_ == '.') {
+      p_++;
+      while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+        if (d < decimales) {
+          acc = acc * 10 + (*p_ - '0');
+          d++;
+        } else if (d == decimales) {
+          redondeo = *p_ >= '5';
+          d++;
+        }
+        p_++;
+      }
+    }
+    for (; d < decimales; d++) acc *= 10;
+    if (redondeo) acc++;
+    if (acc > 0x7FFFFFFF) return false;
+    v = int32_t(neg ? -acc : acc);
+    return true;
+  }
+
+  // cualquier valor: cadena, número, literal u objeto/array anidado
+  bool skipValue() {
+    skipSpace();
+    if (p_ >= end_) return false;
+    if (*p_ == '"') {
+      const char* s;
+      size_t n;
+      return string(s, n);
+    }
+    if (*p_ == '{' || *p_ == '[') {
+      uint8_t depth = 0;
+      while (p_ < end_) {
+        const char c = *p_;
+        if (c == '"') {
+          const char* s;
+          size_t n;
+          if (!string(s, n)) return false;
+          continue;
+        }
+        p_++;
+        if (c == '{' || c == '[') depth++;
+        else if ((c == '}' || c == ']') && --depth == 0) return true;
+      }
+      return false;
+    }
+    while (p_ < end_ && *p_ != ',' && *p_ != '}' && *p_ != ' ') p_++;
+    return true;
+  }
+
+ private:
+  const char* p_;
+  const char* end_;
+};
+
+}  // namespace detail
+
+// lee una orden; false si no se entiende (no es JSON, no trae un cmd válido, el id es demasiado largo o tiene
+//   caracteres raros, o un número no lo es)
+inline bool parse(const char* json, size_t len, Orden& out) {
+  out = Orden{};
+  detail::Scanner s(json, len);
+  if (!s.eat('{')) {
+    // payload a secas: on / off / toggle
+    size_t a = 0, b = len;
+    while (a < b && (json[a] == ' ' || json[a] == '"')) a++;
+    while (b > a && (json[b - 1] == ' ' || json[b - 1] == '"' || json[b - 1] == '\n' || json[b - 1] == '\r')) b--;
+    out.verbo = detail::verbo(json + a, b - a);
+    return out.verbo != Nada;
+  }
+  if (!s.eat('}')) {
+    do {
+      const char* k;
+      size_t kn;
+      if (!s.string(k, kn) || !s.eat(':')) return false;
+      if (detail::equalsNoCase(k, kn, "cmd")) {
+        const char* v;
+        size_t vn;
+        if (!s.string(v, vn)) return false;
+        out.verbo = detail::verbo(v, vn);
+      } else if (detail::equalsNoCase(k, kn, "seconds")) {
+        uint32_t v;
+        if (!s.number(v)) return false;
+        out.segundos = v > kMaxSeconds ? kMaxSeconds : v;
+      } else if (detail::equalsNoCase(k, kn, "level")) {
+        uint32_t v;
+        if (!s.number(v)) return false;
+        out.nivel = int16_t(v > 100 ? 100 : v);
+      } else if (detail::equalsNoCase(k, kn, "id")) {
+        const char* v;
+        size_t vn;
+        if (!s.string(v, vn) || vn >= kIdMax) return false;
+        for (size_t i = 0; i < vn; i++) {
+          if (!detail::idChar(v[i])) return false;
+        }
+        memcpy(out.id, v, vn);
+        out.id[vn] = '\0';
+        out.idHash = vn ? hashId(v, vn) : 0;
+      } else if (!s.skipValue()) {
+        return false;
+      }
+    } while (s.eat(','));
+    if (!s.eat('}')) return false;
+  }
+  return s.done() && out.verbo != Nada;
+}
+
+// --- ÓRDENES YA VISTAS ---
+// los últimos N ids aplicados, en un anillo. Con QoS 1 las repeticiones llegan enseguida (reentrega del broker o
+//   reintento de quien manda), así que basta con recordar unos pocos.
+template <uint8_t N>
+class Vistos {
+ public:
+  // true si la orden hay que aplicarla: no trae id o no se ha visto; en ese caso la apunta
+  bool nueva(uint32_t idHash) {
+    if (!idHash) return true;
+    for (uint8_t i = 0; i < count_; i++) {
+      if (ids_[i] == idHash) return false;
+    }
+    ids_[next_] = idHash;
+    next_ = uint8_t((next_ + 1) % N);
+    if (count_ < N) count_++;
+    return true;
+  }
+
+ private:
+  uint32_t ids_[N] = {};
+  uint8_t next_ = 0;
+  uint8_t count_ = 0;
+};
+
+// --- ESTADO DE UNA SALIDA ---
+struct Salida {
+  bool on = false;
+  uint8_t nivel = 100;
+  bool temporizada = false;
+  uint32_t offAtMs = 0;
+
+  // aplica la orden. maxOnMs (0 = sin límite) acota cuánto puede estar encendida aunque la orden no diga "seconds":
+  //   así una orden de riego perdida a medias no deja la válvula abierta. Devuelve si cambia la salida física.
+  bool aplicar(const Orden& o, uint32_t nowMs, uint32_t maxOnMs) {
+    const bool antes = on;
+    const uint8_t nivelAntes = nivel;
+    Verbo v = o.verbo;
+    if (v == Toggle) v = on ? Off : On;
+    if (v == Off || (v == On && o.nivel == 0)) {
+      on = false;
+      temporizada = false;
+    } else if (v == On) {
+      on = true;
+      nivel = o.nivel > 0 ? uint8_t(o.nivel) : 100;
+      uint32_t ms = o.segundos * 1000;
+      if (maxOnMs && (!ms || ms > maxOnMs)) ms = maxOnMs;
+      temporizada = ms > 0;
+      offAtMs = nowMs + ms;
+    }
+    return on != antes || (on && nivel != nivelAntes);
+  }
+
+  // ¿toca apagarla?
+  bool vencida(uint32_t nowMs) const { return on && temporizada && int32_t(nowMs - offAtMs) >= 0; }
+
+  void apagar() {
+    on = false;
+    temporizada = false;
+  }
+
+  // segundos que le quedan encendida (redondeando hacia arriba); 0 si no está temporizada
+  uint32_t restante(uint32_t nowMs) const {
+    if (!on || !temporizada || int32_t(offAtMs - nowMs) <= 0) return 0;
+    return (offAtMs - nowMs + 999) / 1000;
+  }
+};
+
+// escribe el estado en un PayloadWriter (o cualquier escritor con field/text). pwm: la salida tiene nivel;
+//   id: el de la última orden aplicada ("" si no traía); dup: contestamos a una orden repetida
+template <class W>
+void estado(W& w, const Salida& s, uint32_t nowMs, bool pwm, const char* id, bool dup) {
+  w.text("state", s.on ? "on" : "off");
+  if (s.on && s.temporizada) w.field("remaining", int32_t(s.restante(nowMs)));
+  if (pwm) w.field("level", int32_t(s.on ? s.nivel : 0));
+  if (id && id[0]) w.text("id", id);
+  if (dup) w.field("dup", 1);
+}
+
+}  // namespace cmd
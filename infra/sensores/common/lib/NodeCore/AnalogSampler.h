@@ -0,0 +1,45 @@
+// --- SOBREMUESTREO DEL A0 ---
+// en lugar de una sola analogRead() por publicación, el nodo lee el A0 N veces repartidas a lo largo del periodo de
+//   publicación, guarda las muestras en un buffer circular y, al publicar, las reduce a un solo valor con el filtro
+//   elegido por el driver. Se publica igual de a menudo, pero cada mensaje resume N muestras.
+#pragma once
+
+#include <Arduino.h>
+
+#include "Filters.h"
+
+template <uint8_t N, class Filter>
+class AnalogSampler {
+  static_assert(N > 0 && N <= 64, "el buffer es de como mucho 64 muestras");
+
+ public:
+  explicit AnalogSampler(uint8_t pin) : pin_(pin) {}
+
+  // una muestra nueva (la llama SensorNode cada kSampleMs)
+  void sample() {
+    const int16_t x = analogRead(pin_);
+    ring_[head_] = x;
+    head_ = uint8_t((head_ + 1) % N);
+    if (count_ < N) count_++;
+    filter_.push(x);
+  }
+
+  // valor decimado de las muestras acumuladas; si todavía no hay ninguna, hacemos una lectura en el momento
+  int16_t reduce() {
+    if (!count_) sample();
+    // copiamos en orden cronológico para que los filtros vean la ventana tal cual
+    int16_t ordered[N];
+    const uint8_t start = uint8_t((head_ + N - count_) % N);
+    for (uint8_t i = 0; i < count_; i++) ordered[i] = ring_[(start + i) % N];
+    const int16_t v = filter_.reduce(ordered, count_);
+    count_ = 0; // la siguiente publicación empieza con una ventana nueva
+    return v;
+  }
+
+ private:
+  uint8_t pin_;
+  int16_t ring_[N];
+  uint8_t head_ = 0;
+  uint8_t count_ = 0;
+  Filter filter_;
+};
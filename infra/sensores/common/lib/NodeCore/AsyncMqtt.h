@@ -0,0 +1,513 @@
+// --- CLIENTE MQTT NO BLOQUEANTE (-DNODE_ASYNC_MQTT) ---
+// PubSubClient::publish() arma el paquete en su buffer (256 bytes por defecto, MQTT_MAX_PACKET_SIZE) y lo escribe en
+//   el WiFiClient esperando a que quepa: si la ventana TCP está llena porque la WiFi tarda en devolver los ACK, el
+//   loop() entero se queda parado en esa escritura (hasta tcpTimeoutMs). Además solo publica con QoS 0.
+//
+// AsyncMqtt tiene la misma interfaz que usan los nodos (connect, publish, subscribe, loop, setCallback...) y:
+//   - publish() no espera nunca. Si el socket tiene hueco y no hay nada en cola, escribe la cabecera y el topic y luego
+//     el payload directamente desde el buffer del que llama, sin pasar por un buffer del cliente. Si no, copia el
+//     paquete a una cola circular acotada (TxBytes) que loop() va vaciando a medida que el socket admite bytes. Con
+//     la cola llena devuelve false, como si no hubiera conexión, y el nodo guarda la lectura en la flash.
+//   - con qos = 1 el paquete se guarda en una de Window ranuras hasta que llega su PUBACK. Si no llega en
+//     mqttRetryMs desde que salió al socket, se reenvía con DUP, y también al reconectar. Ventana llena: false.
+//   - recibe en un buffer propio (PacketBytes), distinto de la cola de salida: el callback puede publicar sin pisar
+//     el topic ni el payload que está leyendo.
+//
+// Lo que sigue bloqueando, acotado igual que antes, es connect(): el connect() TCP (tcpTimeoutMs) y el CONNACK
+//   (setSocketTimeout()). Los mensajes QoS 0 que quedan en la cola cuando se cae la conexión se pierden, como los
+//   que estaban en el buffer TCP con PubSubClient; se cuentan en perdidosBytes.
+//
+// El cliente TCP (Tcp) tiene que ofrecer lo que tiene el WiFiClient del ESP8266: connect(host, port), write(buf, n),
+//   availableForWrite(), available(), read(buf, n), connected() y stop().
+#pragma once
+
+#include <Arduino.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <functional>
+
+#include "NodeConfig.h"
+
+struct MqttStats {
+  uint32_t directos = 0;     // publicaciones escritas en el socket sin pasar por la cola
+  uint32_t encolados = 0;    // publicaciones copiadas a la cola
+  uint32_t rechazados = 0;   // cola o ventana QoS 1 llena, o paquete más grande que la cola
+  uint32_t confirmados = 0;  // PUBACK recibidos
+  uint32_t reenvios = 0;     // QoS 1 reenviados con DUP
+  uint32_t grandes = 0;      // paquetes recibidos que no caben en el buffer de entrada (se descartan)
+  uint32_t perdidosBytes = 0; // bytes en cola al caerse la conexión
+  uint16_t colaMax = 0;      // máximo de bytes en la cola
+};
+
+template <class Tcp, uint16_t TxBytes = node_config::mqttTxBytes, uint16_t PacketBytes = node_config::mqttPacketBytes,
+          uint8_t Window = node_config::mqttInflight>
+class AsyncMqtt {
+ public:
+  using Callback = std::function<void(char*, uint8_t*, unsigned int)>;
+
+  // códigos de state(), los mismos que PubSubClient
+  static constexpr int kTimeout = -4;
+  static constexpr int kLost = -3;
+  static constexpr int kConnectFailed = -2;
+  static constexpr int kDisconnected = -1;
+  static constexpr int kConnected = 0;
+
+  explicit AsyncMqtt(Tcp& tcp) : tcp_(tcp) {}
+
+  AsyncMqtt& setServer(const char* host, uint16_t port) {
+    host_ = host;
+    port_ = port;
+    return *this;
+  }
+  AsyncMqtt& setSocketTimeout(uint16_t seconds) {
+    timeoutMs_ = uint32_t(seconds) * 1000;
+    return *this;
+  }
+  AsyncMqtt& setCallback(Callback cb) {
+    callback_ = std::move(cb);
+    return *this;
+  }
+  // lo que se publica solo está limitado por la cola; lo que se recibe, por PacketBytes (fijo al compilar)
+  bool setBufferSize(uint16_t size) { return size <= TxBytes; }
+  uint16_t getBufferSize() const { return PacketBytes; }
+
+  bool connect(const char* clientId) {
+    if (connected_) drop(kDisconnected);
+    if (!tcp_.connect(host_, port_)) {
+      state_ = kConnectFailed;
+      return false;
+    }
+    head_ = used_ = 0;
+    rxLen_ = 0;
+    skip_ = 0;
+    pingPending_ = false;
+
+    // CONNECT con clean session, como PubSubClient
+    const size_t idLen = strlen(clientId);
+    uint8_t pkt[16];
+    const uint32_t rem = 10 + 2 + uint32_t(idLen);
+    size_t n = fixedHeader(pkt, 0x10, rem);
+    static const uint8_t kVar[] = {0, 4, 'M', 'Q', 'T', 'T', 4, 0x02};
+    memcpy(pkt + n, kVar, sizeof(kVar));
+    n += sizeof(kVar);
+    pkt[n++] = uint8_t(node_config::mqttKeepAliveS >> 8);
+    pkt[n++] = uint8_t(node_config::mqttKeepAliveS);
+    pkt[n++] = uint8_t(idLen >> 8);
+    pkt[n++] = uint8_t(idLen);
+    if (tcp_.write(pkt, n) != n || tcp_.write(reinterpret_cast<const uint8_t*>(clientId), idLen) != idLen) {
+      tcp_.stop();
+      state_ = kConnectFailed;
+      return false;
+    }
+
+    // CONNACK: 20 02 00 rc
+    const uint32_t start = millis();
+    while (tcp_.available() < 4) {
+      if (!tcp_.connected() || millis() - start >= timeoutMs_) {
+        tcp_.stop();
+        state_ = kTimeout;
+        return false;
+      }
+      delay(1);
+    }
+    uint8_t ack[4] = {};
+    if (tcp_.read(ack, 4) != 4 || ack[0] != 0x20 || ack[3] != 0) {
+      tcp_.stop();
+      state_ = ack[0] == 0x20 ? int(ack[3]) : kConnectFailed;
+      return false;
+    }
+    connected_ = true;
+    state_ = kConnected;
+    lastTxMs_ = lastRxMs_ = millis();
+    // lo que quedó sin confirmar en la conexión anterior se reenvía con DUP
+    for (Slot& s : slots_) {
+      if (s.estado == Libre) continue;
+      if (s.estado != Pendiente) s.buf[0] |= 0x08;
+      s.estado = Pendiente;
+    }
+    return true;
+  }
+
+  bool connected() {
+    if (connected_ && !tcp_.connected()) drop(kLost);
+    return connected_;
+  }
+
+  int state() const { return state_; }
+
+  // vacía la cola (como mucho setSocketTimeout()) antes del DISCONNECT: el modo de bajo consumo publica y se va
+  void disconnect() {
+    if (connected_) {
+      const uint32_t start = millis();
+      while (used_ && tcp_.connected() && millis() - start < timeoutMs_) {
+        pump();
+        if (used_) delay(1);
+      }
+      static const uint8_t kDisconnect[] = {0xE0, 0};
+      tcp_.write(kDisconnect, sizeof(kDisconnect));
+    }
+    drop(kDisconnected);
+  }
+
+  bool subscribe(const char* filter, uint8_t qos = 0) {
+    if (!connected() || qos > 1) return false;
+    const size_t len = strlen(filter);
+    uint8_t head[8];
+    size_t n = fixedHeader(head, 0x82, uint32_t(2 + 2 + len + 1));
+    const uint16_t id = nextId();
+    head[n++] = uint8_t(id >> 8);
+    head[n++] = uint8_t(id);
+    head[n++] = uint8_t(len >> 8);
+    head[n++] = uint8_t(len);
+    if (space() < n + len + 1) return false;
+    push(head, n);
+    push(reinterpret_cast<const uint8_t*>(filter), len);
+    push(&qos, 1);
+    pump();
+    return true;
+  }
+
+  bool publish(const char* topic, const char* payload) {
+    return publish(topic, reinterpret_cast<const uint8_t*>(payload), unsigned(strlen(payload)));
+  }
+
+  bool publish(const char* topic, const uint8_t* payload, unsigned int len, bool retained = false, uint8_t qos = 0) {
+    if (!connected() || qos > 1) return false;
+    const size_t topicLen = strlen(topic);
+    uint8_t head[8];
+    const size_t n = fixedHeader(head, uint8_t(0x30 | qos << 1 | (retained ? 1 : 0)),
+                                 uint32_t(2 + topicLen + (qos ? 2 : 0) + len));
+    const size_t total = n + 2 + topicLen + (qos ? 2 : 0) + len;
+    if (qos) return publishQos1(head, n, topic, topicLen, payload, len, total);
+    if (total > TxBytes) {
+      stats_.rechazados++;
+      return false;
+    }
+    pump();
+
+    // sin nada delante y con hueco en el socket: directo desde el buffer del que llama
+    if (!used_ && size_t(tcp_.availableForWrite()) >= total && n + 2 + topicLen <= kDirectHead) {
+      uint8_t first[kDirectHead];
+      memcpy(first, head, n);
+      first[n] = uint8_t(topicLen >> 8);
+      first[n + 1] = uint8_t(topicLen);
+      memcpy(first + n + 2, topic, topicLen);
+      const size_t firstLen = n + 2 + topicLen;
+      // si el socket acepta menos de lo que dijo, el resto va a la cola (está vacía y el paquete cabe)
+      const size_t w = tcp_.write(first, firstLen);
+      if (w < firstLen) {
+        push(first + w, firstLen - w);
+        push(payload, len);
+      } else {
+        const size_t wp = tcp_.write(payload, len);
+        if (wp < len) push(payload + wp, len - wp);
+      }
+      lastTxMs_ = millis();
+      stats_.directos++;
+      noteQueue();
+      return true;
+    }
+
+    if (space() < total) {
+      stats_.rechazados++;
+      return false;
+    }
+    uint8_t tl[2] = {uint8_t(topicLen >> 8), uint8_t(topicLen)};
+    push(head, n);
+    push(tl, 2);
+    push(reinterpret_cast<const uint8_t*>(topic), topicLen);
+    push(payload, len);
+    stats_.encolados++;
+    noteQueue();
+    pump();
+    return true;
+  }
+
+  // vacía lo que se pueda de la cola, reenvía los QoS 1 vencidos, mantiene viva la conexión y entrega lo recibido.
+  //   false si la conexión se ha caído.
+  bool loop() {
+    if (!connected()) return false;
+    const uint32_t now = millis();
+    pump();
+
+    for (Slot& s : slots_) {
+      if (s.estado == EnCola && int32_t(sentTotal_ - s.mark) >= 0) {
+        s.estado = Enviado; // el último byte ya está en el socket: desde aquí cuenta el reintento
+        s.ms = now;
+      } else if (s.estado == Enviado && now - s.ms >= node_config::mqttRetryMs) {
+        s.buf[0] |= 0x08;
+        s.estado = Pendiente;
+        stats_.reenvios++;
+      }
+      if (s.estado == Pendiente && space() >= s.len) {
+        push(s.buf, s.len);
+        s.mark = queuedTotal_;
+        s.estado = EnCola;
+      }
+    }
+
+    const uint32_t keepAliveMs = uint32_t(node_config::mqttKeepAliveS) * 1000;
+    if (now - lastRxMs_ >= keepAliveMs + keepAliveMs / 2) {
+      drop(kTimeout); // ni PINGRESP ni nada en 1,5 veces el keep alive
+      return false;
+    }
+    if (!pingPending_ && (now - lastTxMs_ >= keepAliveMs || now - lastRxMs_ >= keepAliveMs) && space() >= 2) {
+      static const uint8_t kPing[] = {0xC0, 0};
+      push(kPing, sizeof(kPing));
+      pingPending_ = true;
+    }
+    pump();
+
+    if (!receive()) return false;
+    return connected();
+  }
+
+  const MqttStats& stats() const { return stats_; }
+  uint16_t queued() const { return used_; }
+  uint8_t inflight() const {
+    uint8_t n = 0;
+    for (const Slot& s : slots_) n += s.estado != Libre;
+    return n;
+  }
+
+ private:
+  enum Estado : uint8_t { Libre, Pendiente, EnCola, Enviado };
+  struct Slot {
+    uint8_t buf[PacketBytes];
+    uint16_t len = 0;
+    uint16_t id = 0;
+    Estado estado = Libre;
+    uint32_t ms = 0;   // cuándo salió al socket
+    uint32_t mark = 0; // queuedTotal_ tras encolarlo: ha salido cuando sentTotal_ llega aquí
+  };
+  static constexpr size_t kDirectHead = 80; // cabecera + topic del camino directo (los topics de los nodos son cortos)
+
+  static size_t fixedHeader(uint8_t* out, uint8_t type, uint32_t rem) {
+    size_t n = 0;
+    out[n++] = type;
+    do {
+      uint8_t b = rem & 0x7F;
+      rem >>= 7;
+      out[n++] = uint8_t(rem ? b | 0x80 : b);
+    } while (rem);
+    return n;
+  }
+
+  uint16_t nextId() {
+    if (++lastId_ == 0) lastId_ = 1;
+    return lastId_;
+  }
+
+  bool publishQos1(const uint8_t* head, size_t n, const char* topic, size_t topicLen, const uint8_t* payload,
+                   unsigned int len, size_t total) {
+    Slot* s = nullptr;
+    for (Slot& x : slots_) {
+      if (x.estado == Libre) {
+        s = &x;
+        break;
+      }
+    }
+    if (!s || total > PacketBytes) {
+      stats_.rechazados++;
+      return false;
+    }
+    const uint16_t id = nextId();
+    uint8_t* p = s->buf;
+    memcpy(p, head, n);
+    p += n;
+    *p++ = uint8_t(topicLen >> 8);
+    *p++ = uint8_t(topicLen);
+    memcpy(p, topic, topicLen);
+    p += topicLen;
+    *p++ = uint8_t(id >> 8);
+    *p++ = uint8_t(id);
+    memcpy(p, payload, len);
+    s->len = uint16_t(total);
+    s->id = id;
+    s->estado = Pendiente;
+    if (space() >= total) {
+      push(s->buf, total);
+      s->mark = queuedTotal_;
+      s->estado = EnCola;
+      stats_.encolados++;
+      noteQueue();
+      pump();
+    }
+    return true;
+  }
+
+  size_t space() const { return TxBytes - used_; }
+
+  void push(const uint8_t* p, size_t n) {
+    size_t tail = (head_ + used_) % TxBytes;
+    for (size_t done = 0; done < n;) {
+      const size_t chunk = n - done < TxBytes - tail ? n - done : TxBytes - tail;
+      memcpy(tx_ + tail, p + done, chunk);
+      done += chunk;
+      tail = (tail + chunk) % TxBytes;
+    }
+    used_ = uint16_t(used_ + n);
+    queuedTotal_ += uint32_t(n);
+  }
+
+  void noteQueue() {
+    if (used_ > stats_.colaMax) stats_.colaMax = used_;
+  }
+
+  // escribe lo que admita el socket, sin esperar
+  void pump() {
+    while (used_) {
+      const int room = tcp_.availableForWrite();
+      if (room <= 0) return;
+      size_t chunk = TxBytes - head_;
+      if (chunk > used_) chunk = used_;
+      if (chunk > size_t(room)) chunk = size_t(room);
+      const size_t w = tcp_.write(tx_ + head_, chunk);
+      if (!w) return;
+      head_ = uint16_t((head_ + w) % TxBytes);
+      used_ = uint16_t(used_ - w);
+      sentTotal_ += uint32_t(w);
+      lastTxMs_ = millis();
+    }
+  }
+
+  void drop(int state) {
+    stats_.perdidosBytes += used_;
+    head_ = used_ = 0;
+    sentTotal_ = queuedTotal_;
+    connected_ = false;
+    state_ = state;
+    tcp_.stop();
+  }
+
+  // lee lo disponible y trata los paquetes completos; los que no caben en rx_ se saltan enteros
+  bool receive() {
+    while (tcp_.available() > 0) {
+      if (skip_) {
+        uint8_t sink[32];
+        const int r = tcp_.read(sink, skip_ < sizeof(sink) ? skip_ : sizeof(sink));
+        if (r <= 0) break;
+        skip_ -= uint32_t(r);
+        lastRxMs_ = millis();
+        continue;
+      }
+      const int r = tcp_.read(rx_ + rxLen_, PacketBytes - rxLen_);
+      if (r <= 0) break;
+      rxLen_ = uint16_t(rxLen_ + r);
+      lastRxMs_ = millis();
+      if (!parse()) return false;
+    }
+    return true;
+  }
+
+  bool parse() {
+    size_t off = 0;
+    while (rxLen_ - off >= 2) {
+      // longitud restante: hasta 4 bytes
+      uint32_t rem = 0;
+      size_t i = 1;
+      uint8_t shift = 0;
+      bool complete = false;
+      while (off + i < rxLen_ && i <= 4) {
+        const uint8_t b = rx_[off + i++];
+        rem |= uint32_t(b & 0x7F) << shift;
+        shift += 7;
+        if (!(b & 0x80)) {
+          complete = true;
+          break;
+        }
+      }
+      if (!complete) {
+        if (i > 4) {
+          drop(kLost); // longitud no válida: el flujo está roto
+          return false;
+        }
+        break;
+      }
+      const size_t total = i + rem;
+      if (total > PacketBytes) {
+        // no cabe: lo saltamos entero
+        stats_.grandes++;
+        const size_t have = rxLen_ - off;
+        skip_ = uint32_t(total - have);
+        off = rxLen_;
+        break;
+      }
+      if (rxLen_ - off < total) break;
+      handle(rx_ + off, i, rem);
+      if (!connected_) return false;
+      off += total;
+    }
+    if (off) {
+      memmove(rx_, rx_ + off, rxLen_ - off);
+      rxLen_ = uint16_t(rxLen_ - off);
+    }
+    return true;
+  }
+
+  void handle(uint8_t* p, size_t headLen, uint32_t rem) {
+    const uint8_t type = p[0] & 0xF0;
+    uint8_t* body = p + headLen;
+    if (type == 0x40 && rem >= 2) {
+      // PUBACK: libera su ranura
+      const uint16_t id = uint16_t(body[0] << 8 | body[1]);
+      for (Slot& s : slots_) {
+        if (s.estado != Libre && s.id == id) {
+          s.estado = Libre;
+          stats_.confirmados++;
+        }
+      }
+    } else if (type == 0xD0) {
+      pingPending_ = false;
+    } else if (type == 0x30 && rem >= 2) {
+      const uint8_t qos = (p[0] >> 1) & 3;
+      const uint16_t topicLen = uint16_t(body[0] << 8 | body[1]);
+      const size_t idLen = qos ? 2 : 0;
+      if (2u + topicLen + idLen > rem) return;
+      const uint16_t id = qos ? uint16_t(body[2 + topicLen] << 8 | body[3 + topicLen]) : 0;
+      uint8_t* payload = body + 2 + topicLen + idLen;
+      const unsigned int payloadLen = unsigned(rem - 2 - topicLen - idLen);
+      // el topic se corre un byte hacia atrás para terminarlo en '\0' sin tocar el payload (como hace PubSubClient)
+      char* topic = reinterpret_cast<char*>(body + 1);
+      memmove(topic, body + 2, topicLen);
+      topic[topicLen] = '\0';
+      if (callback_) callback_(topic, payload, payloadLen);
+      if (qos == 1 && space() >= 4) {
+        const uint8_t ack[] = {0x40, 2, uint8_t(id >> 8), uint8_t(id)};
+        push(ack, sizeof(ack));
+      }
+    }
+    // CONNACK fuera de connect(), SUBACK y el resto: nada que hacer
+  }
+
+  Tcp& tcp_;
+  const char* host_ = nullptr;
+  uint16_t port_ = 1883;
+  uint32_t timeoutMs_ = 15000;
+  Callback callback_;
+
+  bool connected_ = false;
+  int state_ = kDisconnected;
+  uint16_t lastId_ = 0;
+  uint32_t lastTxMs_ = 0;
+  uint32_t lastRxMs_ = 0;
+  bool pingPending_ = false;
+
+  // cola de salida circular
+  uint8_t tx_[TxBytes];
+  uint16_t head_ = 0;
+  uint16_t used_ = 0;
+  uint32_t queuedTotal_ = 0; // bytes encolados desde el arranque
+  uint32_t sentTotal_ = 0;   // bytes escritos en el socket desde el arranque
+
+  Slot slots_[Window];
+
+  uint8_t rx_[PacketBytes];
+  uint16_t rxLen_ = 0;
+  uint32_t skip_ = 0; // bytes que quedan de un paquete recibido demasiado grande
+
+  MqttStats stats_;
+};
@@ -0,0 +1,187 @@
+// --- CALIBRACIÓN DEL NODO POR MQTT ---
+// los drivers analógicos (mq135 y soil) convierten el raw con una calibración (formato y cálculo en
+//   common/lib/Calibracion/Calibracion.h) que tiene un valor por defecto fijado al compilar y se puede cambiar en
+//   marcha por invernadero/calib/<topic>, con retain y QoS 1. Como las reglas (Rules.h): el nodo la valida, la
+//   aplica, la guarda en un sector de la flash si ha cambiado y contesta con retain en
+//   invernadero/calib/<topic>/estado con la calibración en uso (y "error" si la última recibida no valía):
+//   {"r0": 76630, "rl": 10000, "a": 116.602, "b": -2.769, "vc": 1023, "t": 23.5, "h": 55}
+//   Una calibración que no es válida no sustituye a la anterior; un payload vacío vuelve a la de compilación.
+//
+// Algunos campos son órdenes de una sola vez, no valores ("aire" del MQ135 recalcula R0 con la lectura de ese
+//   momento). Si se quedaran retenidos, el broker los repetiría en cada reconexión. Por eso, tras una orden, el nodo
+//   publica con retain en invernadero/calib/<topic> la calibración resuelta (o la que sigue, si la orden no valía):
+//   sustituye al mensaje con la orden, y el eco que devuelve el broker no cambia nada ni toca la flash.
+//
+// El driver tiene que definir:
+//   using Calib = ...;                             struct sin huecos: lo que se guarda en la flash
+//   static constexpr Calib kCalib;                 calibración de compilación
+//   const Calib& calibration() const;
+//   bool setCalibration(const Calib&);             false si no es válida
+//   calib::Error calibrate(const char*, size_t, bool& orden);
+//                                                  aplica un JSON recibido sobre la calibración actual; orden a true
+//                                                  si traía una orden de una sola vez
+//   void writeCalibration(PayloadWriter&) const;   campos del estado (que también se leen como calibración)
+//   static constexpr char kAmbientTopic[];         opcional: topic de otro nodo que el driver necesita oír (el MQ135
+//   void ambient(const char*, size_t);             compensa con la temperatura y la humedad del DHT11)
+#pragma once
+
+#include <Arduino.h>
+
+#include <Calibracion.h>
+
+#include "EspFlash.h"
+#include "MqttTransport.h"
+#include "NodeConfig.h"
+#include "PayloadWriter.h"
+
+#include <type_traits>
+
+// ¿el driver tiene calibración? (ver arriba)
+template <class D, class = void>
+struct HasCalibration : std::false_type {};
+template <class D>
+struct HasCalibration<D, std::void_t<typename D::Calib>> : std::true_type {};
+
+template <class D, class = void>
+struct HasAmbient : std::false_type {};
+template <class D>
+struct HasAmbient<D, std::void_t<decltype(D::kAmbientTopic)>> : std::true_type {};
+
+// sin calibración no hay suscripción
+template <class Driver, bool = HasCalibration<Driver>::value>
+class Calibration {
+ public:
+  Calibration(NodeMqtt&, Driver&, EspFlash&) {}
+  void begin(bool) {}
+  void online() {}
+  bool matches(const char*) const { return false; }
+  void onMessage(const char*, const uint8_t*, unsigned int) {}
+};
+
+template <class Driver>
+class Calibration<Driver, true> {
+ public:
+  using Calib = typename Driver::Calib;
+  static_assert(node_config::calibSector != node_config::rulesSector &&
+                    node_config::calibSector >= node_config::storeSectors,
+                "la calibración pisaría la cola o las reglas en la flash");
+
+  Calibration(NodeMqtt& mqtt, Driver& driver, EspFlash& flash) : mqtt_(mqtt), driver_(driver), flash_(flash) {}
+
+  // recupera la última calibración guardada (también en deep sleep: cada despertar convierte con ella)
+  void begin(bool flashOk) {
+    strcpy(topic_, "invernadero/calib/");
+    strcat(topic_, Driver::kTopic);
+    strcpy(statusTopic_, topic_);
+    strcat(statusTopic_, "/estado");
+    flashOk_ = flashOk;
+    if (!flashOk_) return;
+    uint32_t head[2];
+    uint32_t words[kWords];
+    if (!flash_.read(kOffset, head, sizeof(head)) || head[0] != kMagic || head[1] != sizeof(Calib)) return;
+    if (!flash_.read(kOffset + sizeof(head), words, sizeof(words))) return;
+    Calib c;
+    memcpy(&c, words, sizeof(c));
+    if (!driver_.setCalibration(c)) {
+      Serial.println("Calibración de la flash no válida");
+      return;
+    }
+    Serial.println("Calibración cargada de la flash");
+  }
+
+  // recién conectado: el broker nos reenvía la calibración retenida
+  void online() {
+    if (!mqtt_.subscribe(topic_, 1)) Serial.println("Error suscribiendo a la calibración");
+    if constexpr (HasAmbient<Driver>::value) {
+      if (!mqtt_.subscribe(Driver::kAmbientTopic, 0)) Serial.println("Error suscribiendo al ambiente");
+    }
+    publish(statusTopic_, true);
+  }
+
+  bool matches(const char* topic) const {
+    if constexpr (HasAmbient<Driver>::value) {
+      if (strcmp(topic, Driver::kAmbientTopic) == 0) return true;
+    }
+    return strcmp(topic, topic_) == 0;
+  }
+
+  // el payload está en el buffer del cliente: se lee entero antes de publicar el estado
+  void onMessage(const char* topic, const uint8_t* payload, unsigned int len) {
+    const char* json = reinterpret_cast<const char*>(payload);
+    if constexpr (HasAmbient<Driver>::value) {
+      if (strcmp(topic, Driver::kAmbientTopic) == 0) {
+        driver_.ambient(json, len);
+        return;
+      }
+    }
+    const Calib antes = driver_.calibration();
+    const bool eco = eco_;
+    eco_ = false;
+    if (!len) {
+      error_ = calib::Ok;
+      driver_.setCalibration(Driver::kCalib);
+      erase();
+      Serial.println("Calibración de compilación");
+    } else {
+      bool orden = false;
+      const calib::Error e = driver_.calibrate(json, len, orden);
+      const bool cambia = memcmp(&antes, &driver_.calibration(), sizeof(Calib)) != 0;
+      // el eco de la calibración resuelta no borra el error de la orden que la produjo
+      if (!eco || e != calib::Ok || cambia) error_ = e;
+      if (e != calib::Ok) {
+        Serial.print("Calibración no válida: ");
+        Serial.println(calib::nombreError(e));
+      } else if (cambia) {
+        save();
+        Serial.println("Calibración nueva");
+      }
+      // la orden no puede quedarse retenida: la sustituye la calibración en uso
+      if (orden) eco_ = publish(topic_, false);
+    }
+    publish(statusTopic_, true);
+  }
+
+ private:
+  static constexpr uint32_t kMagic = 0x314C4143; // "CAL1"
+  static constexpr uint32_t kOffset = uint32_t(node_config::calibSector) * EspFlash::kSectorSize;
+  static constexpr size_t kWords = (sizeof(Calib) + 3) / 4;
+
+  // la misma calibración recibida otra vez no toca la flash (eso lo decide onMessage)
+  void save() {
+    if (!flashOk_) return;
+    uint32_t head[2] = {kMagic, sizeof(Calib)};
+    uint32_t words[kWords] = {};
+    memcpy(words, &driver_.calibration(), sizeof(Calib));
+    if (!flash_.erase(node_config::calibSector) || !flash_.write(kOffset, head, sizeof(head)) ||
+        !flash_.write(kOffset + sizeof(head), words, sizeof(words))) {
+      Serial.println("Error guardando la calibración en flash");
+    }
+  }
+
+  void erase() {
+    if (flashOk_ && !flash_.erase(node_config::calibSector)) {
+      Serial.println("Error borrando la calibración de la flash");
+    }
+  }
+
+  // la calibración en uso con retain: el estado (con el error, si lo hay) o la que sustituye a una orden
+  bool publish(const char* topic, bool estado) {
+    char buf[160];
+    PayloadWriter w(buf, sizeof(buf));
+    w.begin();
+    driver_.writeCalibration(w);
+    if (estado && error_ != calib::Ok) w.text("error", calib::nombreError(error_));
+    const size_t len = w.end();
+    return len && publishConfirmed(mqtt_, topic, reinterpret_cast<const uint8_t*>(buf), len, true);
+  }
+
+  NodeMqtt& mqtt_;
+  Driver& driver_;
+  EspFlash& flash_;
+  bool flashOk_ = false;
+  calib::Error error_ = calib::Ok;
+  bool eco_ = false; // lo siguiente que llegue a topic_ debería ser la calibración que acabamos de publicar
+
+  char topic_[18 + sizeof(Driver::kTopic)];
+  char statusTopic_[18 + sizeof(Driver::kTopic) + 7];
+};
@@ -0,0 +1,203 @@
+// --- ÓRDENES A LOS ACTUADORES DEL NODO ---
+// hasta ahora los nodos solo publicaban. Si el driver declara una tabla de actuadores, el nodo se suscribe con QoS 1 a
+//   invernadero/cmd/<topic>/+ (p. ej. invernadero/cmd/soil/riego), aplica cada orden a su salida en el mismo callback
+//   de PubSubClient en que llega (sin esperar a ninguna tarea) y contesta con el estado de la salida, con retain, en
+//   invernadero/act/<topic>/<dispositivo>. La orden, los ids repetidos y el temporizado están en
+//   common/lib/Comandos/Comando.h, que comparten los nodos y el banco de pruebas de infra/servicios.
+//
+// La tabla es constante y se resuelve al compilar; cada entrada es un dispositivo del topic:
+//   static constexpr ActuatorDef kActuators[] = {{"riego", 5, true, false, 600000}};
+//
+// La conexión es con clean session: una orden que llega con el nodo desconectado se pierde, y quien la manda la repite
+//   (con el mismo id) si no ve el estado. Las órdenes no deben publicarse con retain: se volverían a aplicar en cada
+//   reconexión si no traen id.
+#pragma once
+
+#include <Arduino.h>
+
+#include <Comando.h>
+
+#include "MqttTransport.h"
+#include "PayloadWriter.h"
+
+#include <type_traits>
+
+struct ActuatorDef {
+  const char* name;  // dispositivo en el topic (hasta kNameMax caracteres)
+  uint8_t pin;
+  bool activeLow;    // los módulos de relé suelen activarse con el pin a LOW
+  bool pwm;          // salida analogWrite 0-100 % (el ventilador) en lugar de todo o nada
+  uint32_t maxOnMs;  // 0 = sin límite; si no, se apaga sola pasado ese tiempo aunque la orden no diga "seconds"
+};
+
+struct CommandStats {
+  uint32_t ordenes = 0;    // mensajes recibidos en invernadero/cmd/...
+  uint32_t duplicadas = 0; // con un id ya aplicado: solo se contesta el estado
+  uint32_t rechazadas = 0; // dispositivo desconocido u orden que no se entiende
+};
+
+// ¿el driver tiene actuadores?
+template <class D, class = void>
+struct HasActuators : std::false_type {};
+template <class D>
+struct HasActuators<D, std::void_t<decltype(D::kActuators)>> : std::true_type {};
+
+// sin actuadores no hay suscripción ni callback: todo queda en llamadas vacías
+template <class Driver, bool = HasActuators<Driver>::value>
+class Commands {
+ public:
+  explicit Commands(NodeMqtt&) {}
+  void begin() {}
+  void online(uint32_t) {}
+  void poll(uint32_t, bool) {}
+  bool matches(const char*) const { return false; }
+  void onMessage(char*, uint8_t*, unsigned int) {}
+};
+
+template <class Driver>
+class Commands<Driver, true> {
+ public:
+  static constexpr uint8_t kCount = sizeof(Driver::kActuators) / sizeof(Driver::kActuators[0]);
+  static constexpr uint8_t kNameMax = 15;
+  static constexpr uint8_t kSeen = 16; // ids recordados para descartar repeticiones
+  static_assert(kCount <= 8, "como mucho 8 actuadores por nodo (máscara de estados pendientes)");
+
+  explicit Commands(NodeMqtt& mqtt) : mqtt_(mqtt) {}
+
+  // salidas apagadas (el callback de PubSubClient lo pone SensorNode, que reparte los mensajes)
+  void begin() {
+    strcpy(filter_, "invernadero/cmd/");
+    strcat(filter_, Driver::kTopic);
+    strcat(filter_, "/");
+    prefixLen_ = uint8_t(strlen(filter_));
+    strcat(filter_, "+");
+    strcpy(actTopic_, "invernadero/act/");
+    strcat(actTopic_, Driver::kTopic);
+    strcat(actTopic_, "/");
+    actLen_ = uint8_t(strlen(actTopic_));
+
+    for (uint8_t i = 0; i < kCount; i++) {
+      if (Driver::kActuators[i].pwm) analogWriteRange(100); // level va de 0 a 100 %
+      pinMode(Driver::kActuators[i].pin, OUTPUT);
+      write(i);
+    }
+  }
+
+  // recién conectado: con clean session hay que suscribirse en cada conexión, y publicamos el estado de todas las
+  //   salidas (puede haber vencido alguna temporizada mientras no había conexión)
+  void online(uint32_t nowMs) {
+    if (!mqtt_.subscribe(filter_, 1)) Serial.println("Error suscribiendo a las órdenes");
+    pending_ = uint8_t((1u << kCount) - 1);
+    flush(nowMs);
+  }
+
+  // apaga las salidas temporizadas que han vencido y reintenta los estados que no se pudieron publicar
+  void poll(uint32_t nowMs, bool online) {
+    for (uint8_t i = 0; i < kCount; i++) {
+      if (!out_[i].vencida(nowMs)) continue;
+      out_[i].apagar();
+      write(i);
+      changedMs_[i] = nowMs;
+      pending_ |= uint8_t(1u << i);
+    }
+    if (pending_ && online) flush(nowMs);
+  }
+
+  // enciende o apaga una salida desde el propio nodo (las reglas de Rules.h); el estado sale con ese id
+  void set(uint8_t i, bool on, uint32_t nowMs, const char* id) {
+    cmd::Orden o;
+    o.verbo = on ? cmd::On : cmd::Off;
+    if (out_[i].aplicar(o, nowMs, Driver::kActuators[i].maxOnMs)) {
+      write(i);
+      changedMs_[i] = nowMs;
+    }
+    strncpy(lastId_[i], id, cmd::kIdMax - 1);
+    if (!publish(i, nowMs, false)) pending_ |= uint8_t(1u << i);
+  }
+
+  const cmd::Salida& output(uint8_t i) const { return out_[i]; }
+  // ms desde el último cambio de la salida (desde el arranque si no ha cambiado)
+  uint32_t sinceMs(uint8_t i, uint32_t nowMs) const { return nowMs - changedMs_[i]; }
+  const CommandStats& stats() const { return stats_; }
+
+  bool matches(const char* topic) const { return strncmp(topic, filter_, prefixLen_) == 0; }
+
+  // topic y payload apuntan al buffer de PubSubClient: hay que haberlos leído antes de publicar nada (con AsyncMqtt
+  //   el buffer de entrada es otro, pero el código vale para los dos)
+  void onMessage(char* topic, uint8_t* payload, unsigned int len) {
+    const uint32_t now = millis();
+    stats_.ordenes++;
+    const int8_t i = find(topic);
+    cmd::Orden o;
+    if (i < 0 || !cmd::parse(reinterpret_cast<const char*>(payload), len, o)) {
+      stats_.rechazadas++;
+      Serial.print("Orden no válida en ");
+      Serial.println(topic);
+      return;
+    }
+    const bool nueva = seen_.nueva(o.idHash);
+    if (nueva) {
+      if (out_[i].aplicar(o, now, Driver::kActuators[i].maxOnMs)) {
+        write(uint8_t(i));
+        changedMs_[i] = now;
+      }
+      strcpy(lastId_[i], o.id);
+    } else {
+      stats_.duplicadas++;
+    }
+    // el estado es el acuse de la orden: sale ya, no en la siguiente tarea
+    if (!publish(uint8_t(i), now, !nueva)) pending_ |= uint8_t(1u << i);
+  }
+
+
+ private:
+  int8_t find(const char* topic) const {
+    if (strncmp(topic, filter_, prefixLen_) != 0) return -1;
+    const char* dev = topic + prefixLen_;
+    for (uint8_t i = 0; i < kCount; i++) {
+      if (strcmp(dev, Driver::kActuators[i].name) == 0) return int8_t(i);
+    }
+    return -1;
+  }
+
+  void write(uint8_t i) {
+    const ActuatorDef& a = Driver::kActuators[i];
+    if (a.pwm) {
+      analogWrite(a.pin, out_[i].on ? out_[i].nivel : 0);
+    } else {
+      digitalWrite(a.pin, out_[i].on != a.activeLow ? HIGH : LOW);
+    }
+  }
+
+  bool publish(uint8_t i, uint32_t nowMs, bool dup) {
+    const char* name = Driver::kActuators[i].name;
+    const size_t n = strlen(name);
+    if (n > kNameMax) return true; // no cabe en el topic: no lo reintentamos
+    memcpy(actTopic_ + actLen_, name, n + 1);
+    PayloadWriter w(buf_, sizeof(buf_));
+    w.begin();
+    cmd::estado(w, out_[i], nowMs, Driver::kActuators[i].pwm, lastId_[i], dup);
+    const size_t len = w.end();
+    return len && publishConfirmed(mqtt_, actTopic_, reinterpret_cast<const uint8_t*>(buf_), len, true);
+  }
+
+  void flush(uint32_t nowMs) {
+    for (uint8_t i = 0; i < kCount; i++) {
+      if ((pending_ & (1u << i)) && publish(i, nowMs, false)) pending_ &= uint8_t(~(1u << i));
+    }
+  }
+
+  NodeMqtt& mqtt_;
+  cmd::Salida out_[kCount];
+  char lastId_[kCount][cmd::kIdMax] = {};
+  uint32_t changedMs_[kCount] = {};
+  cmd::Vistos<kSeen> seen_;
+  CommandStats stats_;
+  uint8_t pending_ = 0; // estados sin publicar (uno por bit)
+
+  char filter_[16 + sizeof(Driver::kTopic) + 2];
+  char actTopic_[16 + sizeof(Driver::kTopic) + 1 + kNameMax + 1];
+  uint8_t prefixLen_ = 0;
+  uint8_t actLen_ = 0;
+  char buf_[96]; // {"state":"on","remaining":86400,"level":100,"id":"<23>","dup":1} ocupa 84
+};
@@ -0,0 +1,111 @@
+// --- MÁQUINA DE ESTADOS DE LA CONEXIÓN WIFI/MQTT ---
+// sustituye a setup_wifi() y reconnect(), que se quedaban en un while hasta conectar. poll() se llama
+//   periódicamente desde el planificador, hace como mucho un paso y vuelve:
+//
+//   SinWifi --(WiFi conectada)--> Espera --(vence el backoff)--> intento de connect() --ok--> Conectado
+//                                   ^                                   |fallo                   |
+//                                   +------ backoff x2 + jitter <-------+<------ conexión perdida-+
+//
+// El único paso que bloquea es client.connect(), y está acotado: el timeout TCP del WiFiClient (tcpTimeoutMs) y el
+//   del cliente MQTT para el CONNACK (1 s). Entre intentos la espera crece exponencialmente (hasta backoffMaxMs) con
+//   una parte aleatoria, para que todos los nodos no reintenten a la vez cuando vuelve el broker.
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+#include "MqttTransport.h"
+#include "NodeConfig.h"
+
+class Connection {
+ public:
+  enum State : uint8_t { SinWifi, Espera, Conectado };
+  enum Event : uint8_t { Nada, Conecta, Pierde };
+
+  Connection(WiFiClient& tcp, NodeMqtt& mqtt, const char* clientId) : tcp_(tcp), mqtt_(mqtt), clientId_(clientId) {}
+
+  void begin() {
+    Serial.print("Conectando a ");
+    Serial.println(node_config::ssid);
+    WiFi.mode(WIFI_STA); // configuramos el ESP8266 en modo estación
+    WiFi.begin(node_config::ssid, node_config::password);
+    tcp_.setTimeout(node_config::tcpTimeoutMs);
+    mqtt_.setServer(node_config::mqttServer, node_config::mqttPort);
+    mqtt_.setSocketTimeout(1);
+  }
+
+  // un paso de la máquina de estados; devuelve si la conexión MQTT acaba de establecerse o de perderse
+  Event poll(uint32_t nowMs) {
+    if (WiFi.status() != WL_CONNECTED) {
+      const bool wasOnline = state_ == Conectado;
+      state_ = SinWifi;
+      if (nowMs - lastDotMs_ >= node_config::wifiCheckMs) {
+        lastDotMs_ = nowMs;
+        Serial.print("."); // indicamos visualmente que seguimos intentando conectar
+      }
+      return wasOnline ? Pierde : Nada;
+    }
+
+    switch (state_) {
+      case SinWifi:
+        Serial.println("\nWiFi conectado");
+        Serial.print("IP: ");
+        Serial.println(WiFi.localIP());
+        state_ = Espera;
+        nextAttemptMs_ = nowMs; // primer intento inmediato
+        return Nada;
+
+      case Espera:
+        if (int32_t(nowMs - nextAttemptMs_) < 0) return Nada;
+        Serial.print("Conectando MQTT...");
+        if (mqtt_.connect(clientId_)) {
+          Serial.println(" conectado");
+          state_ = Conectado;
+          backoffMs_ = node_config::backoffMinMs;
+          return Conecta;
+        }
+        Serial.print(" fallo rc=");
+        Serial.println(mqtt_.state()); // si falla en conectar, aquí nos da el código de error
+        scheduleRetry(nowMs);
+        return Nada;
+
+      case Conectado:
+        if (mqtt_.connected()) return Nada;
+        Serial.println("MQTT desconectado");
+        reconnects_++;
+        state_ = Espera;
+        scheduleRetry(nowMs);
+        return Pierde;
+    }
+    return Nada;
+  }
+
+  bool online() const { return state_ == Conectado; }
+  State state() const { return state_; }
+  uint32_t reconnects() const { return reconnects_; }
+
+  // la conexión se ha caído fuera de poll() (por ejemplo, client.loop() ha devuelto false)
+  void lost(uint32_t nowMs) {
+    if (state_ != Conectado) return;
+    reconnects_++;
+    state_ = Espera;
+    scheduleRetry(nowMs);
+  }
+
+ private:
+  // espera = la mitad del backoff + una parte aleatoria de la otra mitad ("equal jitter"); luego se dobla
+  void scheduleRetry(uint32_t nowMs) {
+    nextAttemptMs_ = nowMs + backoffMs_ / 2 + uint32_t(random(backoffMs_ / 2 + 1));
+    backoffMs_ = backoffMs_ * 2 > node_config::backoffMaxMs ? node_config::backoffMaxMs : backoffMs_ * 2;
+  }
+
+  WiFiClient& tcp_;
+  NodeMqtt& mqtt_;
+  const char* clientId_;
+
+  State state_ = SinWifi;
+  uint32_t nextAttemptMs_ = 0;
+  uint32_t backoffMs_ = node_config::backoffMinMs;
+  uint32_t lastDotMs_ = 0;
+  uint32_t reconnects_ = 0;
+};
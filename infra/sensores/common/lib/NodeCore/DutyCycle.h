@@ -0,0 +1,292 @@
+// --- MODO DE BAJO CONSUMO (DEEP SLEEP) ---
+// para las sondas a pilas de los bancales del fondo: con -DNODE_DEEP_SLEEP el nodo no está encendido todo el rato.
+//   Despierta cada sleepPeriodMs, toma una lectura, la apunta en la memoria RTC (RtcStore) y vuelve a dormir con la
+//   radio apagada. Uno de cada wakesPerPublish despertares enciende la WiFi y publica todas las lecturas acumuladas en
+//   lotes binarios (BatchFormat) en <topic>/bin, y sus contadores en <topic>/stats.
+//
+// Si el broker está caído mucho tiempo y la RTC se llena, la mitad más antigua pasa a la cola de la flash (FlashLog)
+//   ya codificada en lotes binarios, que se publican tal cual en el siguiente despertar con radio.
+//
+// Para que el despertar con radio dure poco se guardan en la RTC el BSSID, el canal y la IP de la última asociación:
+//   WiFi.config() con esa IP se salta el DHCP y WiFi.begin() con canal y BSSID se salta el escaneo (de unos segundos a
+//   unos cientos de ms). Si la asociación rápida no conecta (el AP ha cambiado de canal, por ejemplo), se borra la
+//   caché y se hace la normal.
+//
+// Aquí sí hay esperas en un while (la asociación WiFi): mientras el nodo está despierto no tiene nada más que hacer,
+//   y cada espera está acotada por su timeout.
+//
+// En la placa ESP.deepSleep() no vuelve: el siguiente despertar es un reinicio y empieza otra vez en setup(). En el
+//   entorno native sí vuelve, y el mock apunta la duración pedida (ver bench/src/sueno.cpp).
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+#include "EspFlash.h"
+#include "FlashLog.h"
+#include "MqttTransport.h"
+#include "NodeConfig.h"
+#include "PayloadWriter.h"
+#include "RtcStore.h"
+
+#include <BatchFormat.h>
+
+// contadores y caché de la WiFi que sobreviven al deep sleep
+struct SleepHeader {
+  uint32_t clockMs;     // reloj del nodo: millis() se reinicia en cada despertar, este no (ms desde el primer arranque)
+  uint32_t wakes;       // despertares desde el primer arranque
+  uint32_t awakeSumMs;  // tiempo despierto acumulado desde los últimos stats publicados
+  uint32_t awakeMaxMs;
+  uint32_t ip;          // caché de la última asociación
+  uint32_t gateway;
+  uint32_t mask;
+  uint16_t statWakes;   // despertares sumados en awakeSumMs
+  uint16_t seq;         // número del siguiente lote binario
+  uint16_t lost;        // lecturas descartadas porque la RTC estaba llena y no se pudieron pasar a la flash
+  uint16_t lostFrames;  // lotes de la flash pisados porque la cola se llenó
+  uint8_t count;        // lecturas pendientes de publicar
+  uint8_t radioNext;    // el siguiente despertar tiene la radio encendida
+  uint8_t spilled;      // hay lotes pendientes en la flash
+  uint8_t channel;      // 0 = no hay caché
+  uint8_t bssid[6];
+  uint8_t pad[2];
+};
+
+template <uint8_t Fields>
+struct SleepSample {
+  uint32_t ts; // reloj del nodo (SleepHeader::clockMs) al tomar la lectura
+  int32_t value[Fields];
+};
+
+// lecturas que caben en la RTC después de los contadores: 41 del suelo o la luz, 27 del DHT11
+template <uint8_t Fields>
+constexpr uint8_t sleepCapacity() {
+  return uint8_t((RtcStore<SleepHeader>::kDataMax - sizeof(SleepHeader)) / sizeof(SleepSample<Fields>));
+}
+
+template <uint8_t Fields>
+struct SleepState {
+  SleepHeader h;
+  SleepSample<Fields> samples[sleepCapacity<Fields>()];
+};
+
+template <class Driver>
+class DutyCycle {
+ public:
+  static constexpr uint8_t kCapacity = sleepCapacity<Driver::kFields>();
+  static_assert(node_config::wakesPerPublish <= kCapacity, "las lecturas entre publicaciones no caben en la RTC");
+
+  using Log = FlashLog<EspFlash, node_config::storeSectors>;
+
+  DutyCycle(Driver& driver, WiFiClient& tcp, NodeMqtt& mqtt, Log& log)
+      : driver_(driver), tcp_(tcp), mqtt_(mqtt), log_(log) {}
+
+  // un despertar completo: lectura, publicación si toca y a dormir
+  void run() {
+    // en el primer arranque (o tras un corte) la radio está encendida: publicamos ya, y así se rellena la caché
+    const bool warm = store_.load(st_);
+    if (!warm) {
+      memset(&st_, 0, sizeof(st_));
+      Serial.println("Memoria RTC vacía: primer arranque");
+    }
+    const bool radio = !warm || st_.h.radioNext;
+    st_.h.wakes++;
+
+    sample();
+    if (radio) publish();
+    sleep();
+  }
+
+ private:
+  // los nodos analógicos toman su ráfaga de muestras seguidas (unos ms) en lugar de repartirlas en el periodo
+  void sample() {
+    if (Driver::kSampleMs) {
+      for (uint32_t i = 0; i < Driver::kPeriodMs / Driver::kSampleMs; i++) driver_.sample();
+    }
+    typename Driver::Reading r;
+    if (!driver_.read(r)) {
+      return; // el driver ya informa del error por el Serial
+    }
+    Driver::log(r);
+    // si la RTC está llena (el broker lleva mucho caído) la mitad más antigua pasa a la flash; si ni así hay sitio,
+    //   se pierde la más antigua
+    if (st_.h.count == kCapacity) spill();
+    if (st_.h.count == kCapacity) {
+      memmove(st_.samples, st_.samples + 1, sizeof(st_.samples[0]) * (kCapacity - 1));
+      st_.h.count--;
+      st_.h.lost++;
+    }
+    SleepSample<Driver::kFields>& s = st_.samples[st_.h.count++];
+    s.ts = st_.h.clockMs + millis();
+    Driver::values(r, s.value);
+  }
+
+  // la cola de la flash solo se recorre en los despertares que la usan: son unos ms que no queremos en cada lectura
+  bool openLog() {
+    if (!logOpen_ && EspFlash::fits(node_config::storeSectors)) {
+      log_.begin();
+      logOpen_ = true;
+    }
+    return logOpen_;
+  }
+
+  // codifica la mitad más antigua de la RTC en lotes de como mucho FlashRecord::kMaxPayload bytes y los guarda
+  void spill() {
+    if (!openLog()) return;
+    const uint32_t lostBefore = log_.stats().perdidos;
+    const uint8_t half = kCapacity / 2;
+    uint8_t moved = 0;
+    while (moved < half) {
+      batch::Encoder enc(buf_, FlashRecord::kMaxPayload);
+      enc.begin(Driver::kBinaryType, Driver::kFields, ESP.getChipId(), st_.h.seq, st_.samples[moved].ts);
+      uint8_t n = 0;
+      while (moved + n < half && enc.add(st_.samples[moved + n].ts, st_.samples[moved + n].value)) n++;
+      if (!n || !log_.push(st_.samples[moved].ts, reinterpret_cast<const char*>(buf_), uint8_t(enc.length()))) break;
+      st_.h.seq++;
+      moved += n;
+    }
+    memmove(st_.samples, st_.samples + moved, sizeof(st_.samples[0]) * (st_.h.count - moved));
+    st_.h.count -= moved;
+    st_.h.lostFrames += uint16_t(log_.stats().perdidos - lostBefore);
+    st_.h.spilled = log_.pending() != 0;
+  }
+
+  void publish() {
+    const uint32_t t0 = millis();
+    if (!associate()) {
+      Serial.println("Sin WiFi: las lecturas siguen en la RTC");
+      return;
+    }
+    assocMs_ = millis() - t0;
+
+    tcp_.setTimeout(node_config::tcpTimeoutMs);
+    mqtt_.setServer(node_config::mqttServer, node_config::mqttPort);
+    mqtt_.setSocketTimeout(1);
+    if (kPacketMax > 256) mqtt_.setBufferSize(uint16_t(kPacketMax)); // un lote o los stats con el topic no caben
+    if (!mqtt_.connect(Driver::kClientId)) {
+      Serial.print("Fallo MQTT rc=");
+      Serial.println(mqtt_.state());
+      return;
+    }
+
+    char topic[sizeof(Driver::kTopic) + 6];
+    strcpy(topic, Driver::kTopic);
+    strcat(topic, "/bin");
+    // primero los lotes de la flash, que son los más antiguos
+    if (st_.h.spilled && openLog()) {
+      FlashRecord rec;
+      while (log_.front(rec) && mqtt_.publish(topic, reinterpret_cast<const uint8_t*>(rec.payload), rec.len)) {
+        log_.pop();
+      }
+      st_.h.spilled = log_.pending() != 0;
+    }
+    uint8_t sent = 0;
+    while (!st_.h.spilled && sent < st_.h.count) {
+      batch::Encoder enc(buf_, sizeof(buf_));
+      enc.begin(Driver::kBinaryType, Driver::kFields, ESP.getChipId(), st_.h.seq, st_.samples[sent].ts);
+      uint8_t n = 0;
+      while (sent + n < st_.h.count && n < node_config::batchSamples &&
+             enc.add(st_.samples[sent + n].ts, st_.samples[sent + n].value)) {
+        n++;
+      }
+      if (!mqtt_.publish(topic, buf_, enc.length())) break;
+      st_.h.seq++;
+      sent += n;
+    }
+    // lo publicado sale de la RTC; lo que no, se reintenta en el siguiente despertar con radio
+    memmove(st_.samples, st_.samples + sent, sizeof(st_.samples[0]) * (st_.h.count - sent));
+    st_.h.count -= sent;
+
+    // despertar_a_publicar_ms no incluye el arranque de la ROM (unos 60 ms antes de que empiece millis())
+    const uint32_t wakeToPublishMs = millis();
+    strcpy(topic, Driver::kTopic);
+    strcat(topic, "/stats");
+    PayloadWriter w(reinterpret_cast<char*>(buf_), sizeof(buf_));
+    w.begin();
+    // los tiempos despierto son de los despertares anteriores: el de este se sabrá al dormir
+    w.field("despertares", int32_t(st_.h.statWakes));
+    w.field("despierto_medio_ms", int32_t(st_.h.statWakes ? st_.h.awakeSumMs / st_.h.statWakes : 0));
+    w.field("despierto_max_ms", int32_t(st_.h.awakeMaxMs));
+    w.field("asociacion_ms", int32_t(assocMs_));
+    w.field("asociacion_rapida", int32_t(fast_));
+    w.field("despertar_a_publicar_ms", int32_t(wakeToPublishMs));
+    w.field("pendientes", int32_t(st_.h.count));
+    w.field("en_flash", int32_t(logOpen_ ? log_.pending() : 0));
+    w.field("perdidos", int32_t(st_.h.lost));
+    w.field("lotes_perdidos", int32_t(st_.h.lostFrames));
+    const size_t len = w.end();
+    if (len && mqtt_.publish(topic, buf_, len)) {
+      st_.h.statWakes = 0;
+      st_.h.awakeSumMs = 0;
+      st_.h.awakeMaxMs = 0;
+    }
+    // disconnect() cierra el TCP y espera a que salga lo publicado antes de apagar la radio
+    mqtt_.disconnect();
+  }
+
+  bool associate() {
+    WiFi.persistent(false); // que no escriba la configuración en la flash en cada despertar
+    WiFi.mode(WIFI_STA);
+    fast_ = st_.h.channel != 0;
+    if (fast_) {
+      WiFi.config(IPAddress(st_.h.ip), IPAddress(st_.h.gateway), IPAddress(st_.h.mask));
+      WiFi.begin(node_config::ssid, node_config::password, st_.h.channel, st_.h.bssid);
+      if (waitWifi(node_config::fastAssocTimeoutMs)) return true;
+      Serial.println("Asociación rápida fallida: borramos la caché");
+      st_.h.channel = 0;
+      fast_ = false;
+      WiFi.disconnect();
+      WiFi.config(IPAddress(), IPAddress(), IPAddress()); // vuelta al DHCP
+    }
+    WiFi.begin(node_config::ssid, node_config::password);
+    if (!waitWifi(node_config::fullAssocTimeoutMs)) return false;
+
+    // guardamos lo necesario para que la siguiente sea rápida
+    memcpy(st_.h.bssid, WiFi.BSSID(), sizeof(st_.h.bssid));
+    st_.h.channel = uint8_t(WiFi.channel());
+    st_.h.ip = WiFi.localIP().v4();
+    st_.h.gateway = WiFi.gatewayIP().v4();
+    st_.h.mask = WiFi.subnetMask().v4();
+    return true;
+  }
+
+  static bool waitWifi(uint32_t timeoutMs) {
+    const uint32_t t0 = millis();
+    while (WiFi.status() != WL_CONNECTED) {
+      if (millis() - t0 >= timeoutMs) return false;
+      delay(10);
+    }
+    return true;
+  }
+
+  // el tiempo dormido descuenta lo que hemos estado despiertos, para mantener el periodo. El reloj del RTC del
+  //   ESP8266 se desvía unos puntos porcentuales; el backend recoloca los lotes con la hora de llegada.
+  void sleep() {
+    const uint32_t awakeMs = millis();
+    st_.h.statWakes++;
+    st_.h.awakeSumMs += awakeMs;
+    if (awakeMs > st_.h.awakeMaxMs) st_.h.awakeMaxMs = awakeMs;
+    const uint32_t sleepMs = awakeMs + node_config::minSleepMs < node_config::sleepPeriodMs
+                                 ? node_config::sleepPeriodMs - awakeMs
+                                 : node_config::minSleepMs;
+    st_.h.clockMs += awakeMs + sleepMs;
+    st_.h.radioNext = (st_.h.wakes + 1) % node_config::wakesPerPublish == 0;
+    store_.save(st_);
+    ESP.deepSleep(uint64_t(sleepMs) * 1000, st_.h.radioNext ? WAKE_RF_DEFAULT : WAKE_RF_DISABLED);
+  }
+
+  Driver& driver_;
+  WiFiClient& tcp_;
+  NodeMqtt& mqtt_;
+  Log& log_;
+  bool logOpen_ = false;
+
+  RtcStore<SleepState<Driver::kFields>> store_;
+  SleepState<Driver::kFields> st_;
+  bool fast_ = false;
+  uint32_t assocMs_ = 0;
+  uint8_t buf_[256];
+  // el PUBLISH más grande que sale de buf_ (el topic más largo es <topic>/stats)
+  static constexpr size_t kPacketMax = publishPacketSize(sizeof(Driver::kTopic) - 1 + 6, sizeof(buf_));
+  static_assert(batch::maxFrameSize(1, Driver::kFields) <= sizeof(buf_), "el lote no cabe en el buffer");
+};
@@ -0,0 +1,22 @@
+// --- BACKEND DE FLASH DEL ESP8266 PARA FlashLog ---
+// usa el principio de la zona reservada al sistema de ficheros (FS_PHYS_ADDR): los nodos no montan LittleFS,
+//   así que esa zona está libre. Con el ldscript por defecto de la nodemcuv2 (4m2m) hay 2 MB disponibles.
+#pragma once
+
+#include <Arduino.h>
+#include <flash_hal.h>
+
+struct EspFlash {
+  static constexpr uint32_t kSectorSize = FLASH_SECTOR_SIZE;
+
+  bool erase(uint32_t sector) { return ESP.flashEraseSector(FS_PHYS_ADDR / kSectorSize + sector); }
+
+  bool write(uint32_t offset, const uint32_t* data, uint32_t len) {
+    return ESP.flashWrite(FS_PHYS_ADDR + offset, const_cast<uint32_t*>(data), len);
+  }
+
+  bool read(uint32_t offset, uint32_t* data, uint32_t len) { return ESP.flashRead(FS_PHYS_ADDR + offset, data, len); }
+
+  // comprueba que la zona del FS es lo bastante grande para el log
+  static bool fits(uint32_t sectors) { return FS_PHYS_SIZE >= sectors * kSectorSize; }
+};
@@ -0,0 +1,90 @@
+// --- FILTROS ENTEROS PARA LAS LECTURAS DEL ADC ---
+// el ESP8266 no tiene FPU (los float se emulan por software), así que los filtros trabajan solo con enteros.
+//   Todos tienen la misma interfaz para poder elegir el filtro de cada sensor al compilar:
+//     void push(int16_t x);                            se llama con cada muestra nueva
+//     int16_t reduce(const int16_t* s, uint8_t n);     valor decimado a partir de las n últimas muestras
+//   Los filtros de bloque (mediana, media recortada) solo usan reduce(); el EMA solo usa push().
+#pragma once
+
+#include <stdint.h>
+
+namespace filters {
+
+// ordena in situ; para los tamaños que usamos (<= 64 muestras) la inserción es rápida y no necesita memoria extra
+inline void insertionSort(int16_t* v, uint8_t n) {
+  for (uint8_t i = 1; i < n; i++) {
+    const int16_t x = v[i];
+    uint8_t j = i;
+    while (j && v[j - 1] > x) {
+      v[j] = v[j - 1];
+      j--;
+    }
+    v[j] = x;
+  }
+}
+
+}  // namespace filters
+
+// --- SIN FILTRO ---
+// devuelve la última muestra, como hacían los nodos antes de sobremuestrear
+struct LastSample {
+  void push(int16_t) {}
+  int16_t reduce(const int16_t* s, uint8_t n) const { return n ? s[n - 1] : 0; }
+};
+
+// --- MEDIANA ---
+// descarta picos aislados del ADC sin desplazar el valor (útil para el suelo, que decide el riego)
+template <uint8_t MaxN>
+struct MedianFilter {
+  void push(int16_t) {}
+  int16_t reduce(const int16_t* s, uint8_t n) const {
+    if (!n) return 0;
+    int16_t tmp[MaxN];
+    if (n > MaxN) n = MaxN;
+    for (uint8_t i = 0; i < n; i++) tmp[i] = s[i];
+    filters::insertionSort(tmp, n);
+    // con n par hacemos la media de los dos centrales redondeando
+    return (n & 1) ? tmp[n / 2] : int16_t((tmp[n / 2 - 1] + tmp[n / 2] + 1) / 2);
+  }
+};
+
+// --- MEDIA RECORTADA ---
+// ordena la ventana, quita TrimPct % de cada extremo y hace la media del resto
+template <uint8_t MaxN, uint8_t TrimPct = 25>
+struct TrimmedMeanFilter {
+  static_assert(TrimPct < 50, "hay que dejar al menos una muestra");
+  void push(int16_t) {}
+  int16_t reduce(const int16_t* s, uint8_t n) const {
+    if (!n) return 0;
+    int16_t tmp[MaxN];
+    if (n > MaxN) n = MaxN;
+    for (uint8_t i = 0; i < n; i++) tmp[i] = s[i];
+    filters::insertionSort(tmp, n);
+    const uint8_t trim = uint8_t(uint16_t(n) * TrimPct / 100);
+    int32_t sum = 0;
+    for (uint8_t i = trim; i < n - trim; i++) sum += tmp[i];
+    const uint8_t kept = n - 2 * trim;
+    return int16_t((sum + kept / 2) / kept);
+  }
+};
+
+// --- MEDIA MÓVIL EXPONENCIAL ---
+// alpha = 1 / 2^Shift. El acumulador va en Q8 (8 bits de fracción) para no perder resolución al dividir.
+template <uint8_t Shift>
+struct EmaFilter {
+  static_assert(Shift > 0 && Shift < 16, "Shift fuera de rango");
+  void push(int16_t x) {
+    const int32_t xq = int32_t(x) << 8;
+    if (!primed_) {
+      acc_ = xq; // arrancamos en la primera muestra en lugar de en 0
+      primed_ = true;
+      return;
+    }
+    acc_ += (xq - acc_) >> Shift;
+  }
+  int16_t reduce(const int16_t*, uint8_t) const { return int16_t((acc_ + 128) >> 8); }
+
+ private:
+  int32_t acc_ = 0;
+  bool primed_ = false;
+};
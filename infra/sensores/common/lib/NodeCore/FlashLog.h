@@ -0,0 +1,200 @@
+// --- COLA PERSISTENTE EN FLASH (STORE-AND-FORWARD) ---
+// cuando se cae la WiFi o el broker, las lecturas se guardan en un log circular en sectores crudos de la flash y se
+//   reenvían cuando vuelve la conexión. No usamos LittleFS: el log es más simple, más rápido y gasta los sectores de
+//   forma uniforme (cada sector se borra una vez por vuelta completa del log).
+//
+// Formato: cada sector de 4 KB guarda 64 registros de 64 bytes. Un registro vacío tiene seq = 0xFFFFFFFF (flash
+//   borrada). Al reenviarlo se escribe state = 0 encima: en la flash solo se pueden pasar bits de 1 a 0, así que marcar
+//   un registro como enviado no necesita borrar el sector.
+//
+// El backend de la flash (Flash) tiene que ofrecer:
+//   static constexpr uint32_t kSectorSize;
+//   bool erase(uint32_t sector);                                 sector relativo al inicio de la zona del log
+//   bool write(uint32_t offset, const uint32_t* data, uint32_t len);
+//   bool read(uint32_t offset, uint32_t* data, uint32_t len);
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+struct FlashRecord {
+  static constexpr uint8_t kMaxPayload = 48;
+
+  uint32_t seq;   // número de registro, creciente; 0xFFFFFFFF = hueco
+  uint32_t ts;    // millis() cuando se tomó la lectura
+  uint32_t state; // 0xFFFFFFFF = pendiente, 0 = ya reenviado
+  uint16_t boot;  // arranque en el que se tomó (millis() vuelve a 0 en cada arranque)
+  uint8_t len;
+  uint8_t crc;
+  char payload[kMaxPayload];
+};
+static_assert(sizeof(FlashRecord) == 64, "el registro tiene que ocupar 64 bytes");
+
+struct FlashLogStats {
+  uint32_t guardados = 0;   // lecturas guardadas durante un corte
+  uint32_t reenviados = 0;  // lecturas reenviadas al volver la conexión
+  uint32_t perdidos = 0;    // pendientes pisados porque el log se llenó
+};
+
+template <class Flash, uint16_t Sectors>
+class FlashLog {
+  static_assert(Sectors >= 2, "hacen falta al menos 2 sectores para rotar");
+  static constexpr uint32_t kPerSector = Flash::kSectorSize / sizeof(FlashRecord);
+  static constexpr uint32_t kSlots = kPerSector * Sectors;
+  static constexpr uint32_t kEmpty = 0xFFFFFFFF;
+
+ public:
+  explicit FlashLog(Flash& flash) : flash_(flash) {}
+
+  // recorre el log para recuperar el estado tras un reinicio; devuelve el número de pendientes.
+  //   Los registros con CRC incorrecto (restos de otro firmware en la zona del FS) se ignoran.
+  uint32_t begin() {
+    uint32_t maxSeq = 0, maxSlot = 0, minPendSeq = kEmpty, minPendSlot = 0;
+    uint16_t maxBoot = 0;
+    bool any = false;
+    pending_ = 0;
+    for (uint32_t slot = 0; slot < kSlots; slot++) {
+      FlashRecord r;
+      if (!readValid(slot, r)) continue;
+      if (!any || r.seq > maxSeq) {
+        maxSeq = r.seq;
+        maxSlot = slot;
+      }
+      any = true;
+      if (r.boot > maxBoot) maxBoot = r.boot;
+      if (r.state == kEmpty) {
+        pending_++;
+        if (r.seq < minPendSeq) {
+          minPendSeq = r.seq;
+          minPendSlot = slot;
+        }
+      }
+    }
+    boot_ = uint16_t(maxBoot + 1);
+    if (!any) {
+      // log vacío (o flash nueva): preparamos el primer sector
+      head_ = tail_ = 0;
+      nextSeq_ = 0;
+      flash_.erase(0);
+      return 0;
+    }
+    nextSeq_ = maxSeq + 1;
+    head_ = (maxSlot + 1) % kSlots;
+    // un corte de corriente a mitad de push() deja un registro que no vale pero ya no está borrado: escribir encima lo
+    //   corrompería (solo se pueden pasar bits de 1 a 0). Se salta hasta un hueco borrado o hasta el sector siguiente
+    while (head_ % kPerSector != 0 && !erased(head_)) head_ = (head_ + 1) % kSlots;
+    tail_ = pending_ ? minPendSlot : head_;
+    // si el siguiente hueco abre sector, hay que borrarlo antes de escribir
+    if (head_ % kPerSector == 0) openSector(head_ / kPerSector);
+    return pending_;
+  }
+
+  // guarda una lectura; si el log está lleno pisa la más antigua (y la cuenta como perdida)
+  bool push(uint32_t ts, const char* payload, uint8_t len) {
+    if (len > FlashRecord::kMaxPayload) return false;
+    FlashRecord r;
+    memset(&r, 0xFF, sizeof(r));
+    r.seq = nextSeq_++;
+    r.ts = ts;
+    r.boot = boot_;
+    r.len = len;
+    memcpy(r.payload, payload, len);
+    r.crc = crc8(r);
+    if (!flash_.write(head_ * sizeof(FlashRecord), reinterpret_cast<const uint32_t*>(&r), sizeof(r))) return false;
+    pending_++;
+    stats_.guardados++;
+    head_ = (head_ + 1) % kSlots;
+    if (head_ % kPerSector == 0) openSector(head_ / kPerSector);
+    return true;
+  }
+
+  // primer registro pendiente (el más antiguo); false si no hay ninguno
+  bool front(FlashRecord& r) {
+    while (pending_) {
+      const bool valid = readValid(tail_, r);
+      if (valid && r.state == kEmpty) return true;
+      // hueco, ya enviado o corrupto: lo saltamos. Los corruptos no se descuentan: begin() no los cuenta (un registro
+      //   a medio escribir o restos de otro firmware), y si alguno contado se hubiera estropeado, la cuenta se pone a
+      //   0 al llegar a head_
+      tail_ = (tail_ + 1) % kSlots;
+      if (tail_ == head_) pending_ = 0;
+    }
+    return false;
+  }
+
+  // marca como enviado el registro devuelto por front()
+  void pop() {
+    if (!pending_) return;
+    const uint32_t sent = 0;
+    flash_.write(tail_ * sizeof(FlashRecord) + offsetof(FlashRecord, state), &sent, sizeof(sent));
+    pending_--;
+    stats_.reenviados++;
+    tail_ = (tail_ + 1) % kSlots;
+  }
+
+  uint32_t pending() const { return pending_; }
+  uint16_t boot() const { return boot_; }
+  const FlashLogStats& stats() const { return stats_; }
+
+ private:
+  // borra un sector antes de reutilizarlo; si la cola tenía pendientes ahí, se pierden (los más antiguos)
+  void openSector(uint32_t sector) {
+    const uint32_t first = sector * kPerSector;
+    if (pending_ && tail_ >= first && tail_ < first + kPerSector) {
+      uint32_t lost = 0;
+      for (uint32_t slot = tail_; slot < first + kPerSector; slot++) {
+        uint32_t hdr[3];
+        if (flash_.read(slot * sizeof(FlashRecord), hdr, sizeof(hdr)) && hdr[0] != kEmpty && hdr[2] == kEmpty) lost++;
+      }
+      pending_ -= lost < pending_ ? lost : pending_;
+      stats_.perdidos += lost;
+      tail_ = (first + kPerSector) % kSlots;
+    }
+    flash_.erase(sector);
+  }
+
+  bool readValid(uint32_t slot, FlashRecord& r) {
+    if (!flash_.read(slot * sizeof(FlashRecord), reinterpret_cast<uint32_t*>(&r), sizeof(r))) {
+      r.seq = kEmpty;
+      return false;
+    }
+    return r.seq != kEmpty && r.len <= FlashRecord::kMaxPayload && r.crc == crc8(r);
+  }
+
+  // ¿el hueco está entero a 0xFF?
+  bool erased(uint32_t slot) {
+    uint32_t words[sizeof(FlashRecord) / 4];
+    if (!flash_.read(slot * sizeof(FlashRecord), words, sizeof(words))) return false;
+    for (uint32_t w : words) {
+      if (w != kEmpty) return false;
+    }
+    return true;
+  }
+
+  static uint8_t crc8(const FlashRecord& r) {
+    // CRC-8 (polinomio 0x07) de ts, boot, len y payload; state queda fuera porque cambia al reenviar
+    uint8_t crc = 0;
+    auto feed = [&crc](const void* p, size_t n) {
+      const uint8_t* b = static_cast<const uint8_t*>(p);
+      for (size_t i = 0; i < n; i++) {
+        crc ^= b[i];
+        for (uint8_t k = 0; k < 8; k++) crc = uint8_t(crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1);
+      }
+    };
+    feed(&r.seq, sizeof(r.seq));
+    feed(&r.ts, sizeof(r.ts));
+    feed(&r.boot, sizeof(r.boot));
+    feed(&r.len, sizeof(r.len));
+    feed(r.payload, r.len);
+    return crc;
+  }
+
+  Flash& flash_;
+  uint32_t head_ = 0;    // siguiente hueco donde escribir
+  uint32_t tail_ = 0;    // registro pendiente más antiguo
+  uint32_t pending_ = 0;
+  uint32_t nextSeq_ = 0;
+  uint16_t boot_ = 0;
+  FlashLogStats stats_;
+};
@@ -0,0 +1,50 @@
+// --- HISTOGRAMA LOGARÍTMICO ---
+// histograma de tamaño fijo (sin memoria dinámica) para tiempos en microsegundos. El cubo i cuenta los valores en
+//   [2^(i-1), 2^i); el último recoge todo lo que no cabe. Los percentiles devuelven el límite superior del cubo, así
+//   que son una cota por arriba con error de como mucho x2, suficiente para ver jitter y bloqueos.
+#pragma once
+
+#include <stdint.h>
+
+class Log2Histogram {
+ public:
+  static constexpr uint8_t kBuckets = 22; // hasta ~2 s; por encima va todo al último
+
+  void add(uint32_t v) {
+    uint8_t b = 0;
+    while (v >> b && b < kBuckets - 1) b++;
+    buckets_[b]++;
+    count_++;
+    if (v > max_) max_ = v;
+  }
+
+  // cota superior del percentil pct (0-100); 0 si no hay muestras
+  uint32_t percentile(uint8_t pct) const {
+    if (!count_) return 0;
+    const uint32_t target = uint32_t((uint64_t(count_) * pct + 99) / 100);
+    uint32_t acc = 0;
+    for (uint8_t b = 0; b < kBuckets; b++) {
+      acc += buckets_[b];
+      if (acc >= target) {
+        const uint32_t upper = b ? (uint32_t(1) << b) - 1 : 0;
+        return b == kBuckets - 1 || upper > max_ ? max_ : upper;
+      }
+    }
+    return max_;
+  }
+
+  uint32_t count() const { return count_; }
+  uint32_t max() const { return max_; }
+  uint32_t bucket(uint8_t b) const { return buckets_[b]; }
+
+  void reset() {
+    for (uint8_t b = 0; b < kBuckets; b++) buckets_[b] = 0;
+    count_ = 0;
+    max_ = 0;
+  }
+
+ private:
+  uint32_t buckets_[kBuckets] = {};
+  uint32_t count_ = 0;
+  uint32_t max_ = 0;
+};
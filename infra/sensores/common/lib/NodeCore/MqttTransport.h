@@ -0,0 +1,31 @@
+// --- CLIENTE MQTT DEL NODO ---
+// por defecto los nodos usan PubSubClient. Con -DNODE_ASYNC_MQTT usan AsyncMqtt (ver AsyncMqtt.h), que tiene la misma
+//   interfaz, así que el resto del núcleo solo ve NodeMqtt.
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+#ifdef NODE_ASYNC_MQTT
+#include "AsyncMqtt.h"
+using NodeMqtt = AsyncMqtt<WiFiClient>;
+#else
+#include <PubSubClient.h>
+using NodeMqtt = PubSubClient;
+#endif
+
+// bytes del PUBLISH con un topic y un payload de esos tamaños, como los cuenta PubSubClient: cabecera fija (5 como
+//   mucho), longitud del topic (2), topic y payload. Lo que no cabe en su buffer (256 por defecto, setBufferSize())
+//   lo descarta publish() sin avisar.
+constexpr size_t publishPacketSize(size_t topic, size_t payload) { return 5 + 2 + topic + payload; }
+
+// para lo que el broker tiene que confirmar (el estado de los actuadores y de las reglas): QoS 1 con AsyncMqtt;
+//   PubSubClient solo publica con QoS 0
+inline bool publishConfirmed(NodeMqtt& mqtt, const char* topic, const uint8_t* payload, unsigned int len,
+                             bool retained) {
+#ifdef NODE_ASYNC_MQTT
+  return mqtt.publish(topic, payload, len, retained, 1);
+#else
+  return mqtt.publish(topic, payload, len, retained);
+#endif
+}
@@ -0,0 +1,75 @@
+// --- CONFIGURACIÓN COMÚN DE LOS NODOS ---
+// todos los nodos tienen que estar conectados a la misma red y al mismo broker, así que la configuración
+//   se define una sola vez aquí. Se puede sobrescribir desde platformio.ini con build_flags (-DNODE_WIFI_SSID=\"...\").
+#pragma once
+
+#include <stdint.h>
+
+#ifndef NODE_WIFI_SSID
+#define NODE_WIFI_SSID "wifi" // cambiar por el nombre de la red WiFi
+#endif
+
+#ifndef NODE_WIFI_PASSWORD
+#define NODE_WIFI_PASSWORD "wifiwifi" // cambiar por la contraseña de la red WiFi
+#endif
+
+#ifndef NODE_MQTT_SERVER
+#define NODE_MQTT_SERVER "10.228.245.75" // la IP de donde esté levantado el broker
+#endif
+
+#ifndef NODE_MQTT_PORT
+#define NODE_MQTT_PORT 1884 // puerto publicado por docker-compose para Mosquitto
+#endif
+
+#ifndef NODE_NTP_SERVER
+#define NODE_NTP_SERVER "pool.ntp.org"
+#endif
+
+#ifndef NODE_TZ
+#define NODE_TZ "CET-1CEST,M3.5.0,M10.5.0/3" // hora peninsular, con el cambio de horario (formato POSIX TZ)
+#endif
+
+namespace node_config {
+constexpr const char* ssid = NODE_WIFI_SSID;
+constexpr const char* password = NODE_WIFI_PASSWORD;
+constexpr const char* mqttServer = NODE_MQTT_SERVER;
+constexpr uint16_t mqttPort = NODE_MQTT_PORT;
+constexpr const char* ntpServer = NODE_NTP_SERVER;
+constexpr const char* timeZone = NODE_TZ;
+
+// --- CONEXIÓN ---
+constexpr uint32_t connPollMs = 100;     // cada cuánto avanza la máquina de estados de la conexión
+constexpr uint32_t wifiCheckMs = 500;    // cada cuánto imprimimos un punto mientras no hay WiFi
+constexpr uint32_t backoffMinMs = 1000;  // primera espera entre intentos de conexión MQTT
+constexpr uint32_t backoffMaxMs = 60000; // espera máxima entre intentos
+constexpr uint16_t tcpTimeoutMs = 300;   // timeout del connect() TCP, para acotar lo que bloquea un intento
+constexpr uint32_t statsMs = 60000;    // cada cuánto publicamos los contadores en <topic>/stats
+constexpr uint32_t diagMs = 60000;     // cada cuánto publicamos los tiempos en <topic>/diag (-DNODE_PROFILE)
+constexpr uint32_t actuatorPollMs = 100; // resolución del apagado de las salidas temporizadas (ver Commands.h)
+constexpr uint16_t rulesSector = 16;     // sector de la flash con las reglas, justo detrás de la cola (storeSectors)
+constexpr uint16_t calibSector = 17;     // sector con la calibración del sensor (Calibration.h), tras las reglas
+
+// --- FORMATO BINARIO POR LOTES (-DNODE_BINARY_BATCH) ---
+constexpr uint8_t batchSamples = 10;       // lecturas por mensaje
+constexpr uint32_t batchMaxAgeMs = 30000;  // como mucho 30 s de retraso para la lectura más antigua del lote
+
+// --- MODO DE BAJO CONSUMO (-DNODE_DEEP_SLEEP) ---
+constexpr uint32_t sleepPeriodMs = 60000;       // una lectura por minuto
+constexpr uint8_t wakesPerPublish = 10;         // uno de cada 10 despertares enciende la WiFi y publica
+constexpr uint32_t fastAssocTimeoutMs = 1500;   // asociación con canal, BSSID e IP guardados en la RTC
+constexpr uint32_t fullAssocTimeoutMs = 10000;  // asociación normal (escaneo + DHCP)
+constexpr uint32_t minSleepMs = 100;            // si el despertar se alarga más que el periodo
+
+// --- CLIENTE MQTT NO BLOQUEANTE (-DNODE_ASYNC_MQTT, ver AsyncMqtt.h) ---
+constexpr uint16_t mqttTxBytes = 2048;     // cola de salida: lo que no cabe en el socket espera aquí
+constexpr uint16_t mqttPacketBytes = 384;  // paquete más grande que se recibe, y tamaño de cada ranura QoS 1
+constexpr uint8_t mqttInflight = 4;        // QoS 1 sin confirmar a la vez
+constexpr uint32_t mqttRetryMs = 5000;     // reenvío de un QoS 1 sin PUBACK
+constexpr uint16_t mqttKeepAliveS = 15;    // el mismo keep alive que PubSubClient (MQTT_KEEPALIVE)
+
+// --- COLA EN FLASH (STORE-AND-FORWARD) ---
+constexpr uint16_t storeSectors = 16;     // 16 sectores de 4 KB = 1024 lecturas guardadas durante un corte
+constexpr uint32_t replayMs = 250;        // cada cuánto reenviamos un lote de lecturas guardadas
+constexpr uint8_t replayBatch = 5;        // lecturas por lote (como mucho 20 mensajes/s por nodo)
+constexpr uint32_t replayJitterMs = 5000; // espera aleatoria tras reconectar, para que no reenvíen todos a la vez
+}  // namespace node_config
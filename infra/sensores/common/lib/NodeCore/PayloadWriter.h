@@ -0,0 +1,165 @@
+// --- ESCRITOR DE PAYLOADS JSON SIN MEMORIA DINÁMICA ---
+// sustituye a StaticJsonDocument + serializeJson: en lugar de construir un documento en la pila en cada tick y luego
+//   serializarlo, escribimos el JSON directamente en un buffer reservado por el nodo. Los nombres de los campos son
+//   literales, así que su longitud se conoce al compilar y la copia se reduce a un memcpy de tamaño fijo.
+//
+// Uso:
+//   PayloadWriter w(buffer, sizeof(buffer));
+//   w.begin();
+//   w.field("luz", 42);
+//   w.field("raw", 430);
+//   size_t len = w.end(); // 0 si no cabía en el buffer
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+class PayloadWriter {
+ public:
+  PayloadWriter(char* buf, size_t cap) : buf_(buf), cap_(cap) {}
+
+  void begin() {
+    len_ = 0;
+    overflow_ = false;
+    first_ = true;
+    put('{');
+  }
+
+  // campo entero: "clave":valor
+  template <size_t K>
+  void field(const char (&key)[K], int32_t value) {
+    this->key(key);
+    putInt(value);
+  }
+
+  // campo entero de 64 bits (la hora en ms desde 1970 no cabe en 32)
+  template <size_t K>
+  void field64(const char (&key)[K], uint64_t value) {
+    this->key(key);
+    putUInt64(value);
+  }
+
+  // campo en coma fija: value = 2345 con decimals = 2 se escribe como 23.45 (sin ceros sobrantes: 23.5, 23)
+  template <size_t K>
+  void fixed(const char (&key)[K], int32_t value, uint8_t decimals) {
+    this->key(key);
+    putFixed(value, decimals);
+  }
+
+  // campo de texto (sin escapar: solo para valores internos del nodo)
+  template <size_t K>
+  void text(const char (&key)[K], const char* value) {
+    this->key(key);
+    put('"');
+    putRaw(value, strlen(value));
+    put('"');
+  }
+
+  // fragmento JSON ya formado (por ejemplo un array construido aparte)
+  template <size_t K>
+  void raw(const char (&key)[K], const char* json, size_t len) {
+    this->key(key);
+    putRaw(json, len);
+  }
+
+  // campos ya formados ("a":1,"b":2), por ejemplo los de un payload guardado al que queremos añadir otro campo
+  void fields(const char* json, size_t len) {
+    if (!len) return;
+    if (!first_) put(',');
+    first_ = false;
+    putRaw(json, len);
+  }
+
+  // cierra el objeto y añade el '\0'; devuelve la longitud sin el terminador o 0 si no cabía
+  size_t end() {
+    put('}');
+    if (overflow_ || len_ >= cap_) {
+      if (cap_) buf_[0] = '\0';
+      return 0;
+    }
+    buf_[len_] = '\0';
+    return len_;
+  }
+
+  size_t length() const { return len_; }
+  bool overflow() const { return overflow_; }
+
+  // --- PRIMITIVAS ---
+  // públicas para que otros formatos (arrays de muestras, diagnósticos) reutilicen el mismo buffer
+  template <size_t K>
+  void key(const char (&key)[K]) {
+    if (!first_) put(',');
+    first_ = false;
+    put('"');
+    putRaw(key, K - 1); // K - 1 es constante: el compilador lo deja en un memcpy de tamaño fijo
+    put('"');
+    put(':');
+  }
+
+  void put(char c) {
+    if (len_ < cap_) buf_[len_] = c;
+    else overflow_ = true;
+    len_++;
+  }
+
+  void putRaw(const char* s, size_t n) {
+    if (len_ + n <= cap_) memcpy(buf_ + len_, s, n);
+    else overflow_ = true;
+    len_ += n;
+  }
+
+  void putInt(int32_t v) {
+    char tmp[11];
+    uint8_t n = 0;
+    uint32_t u = v < 0 ? uint32_t(-(int64_t)v) : uint32_t(v);
+    do {
+      tmp[n++] = char('0' + u % 10);
+      u /= 10;
+    } while (u);
+    if (v < 0) put('-');
+    while (n) put(tmp[--n]);
+  }
+
+  void putUInt64(uint64_t v) {
+    if (v <= 0x7FFFFFFF) {
+      putInt(int32_t(v)); // sin la división de 64 bits, que el ESP8266 hace por software
+      return;
+    }
+    char tmp[20];
+    uint8_t n = 0;
+    do {
+      tmp[n++] = char('0' + v % 10);
+      v /= 10;
+    } while (v);
+    while (n) put(tmp[--n]);
+  }
+
+  void putFixed(int32_t v, uint8_t decimals) {
+    if (!decimals) {
+      putInt(v);
+      return;
+    }
+    uint32_t scale = 1;
+    for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+    uint32_t u = v < 0 ? uint32_t(-(int64_t)v) : uint32_t(v);
+    uint32_t frac = u % scale;
+    if (v < 0) put('-');
+    putInt(int32_t(u / scale));
+    if (!frac) return;
+    // quitamos los ceros finales para que 23.50 salga como 23.5, igual que hacía ArduinoJson
+    while (frac % 10 == 0) {
+      frac /= 10;
+      scale /= 10;
+    }
+    put('.');
+    for (uint32_t div = scale / 10; div; div /= 10) put(char('0' + (frac / div) % 10));
+  }
+
+ private:
+  char* buf_;
+  size_t cap_;
+  size_t len_ = 0;
+  bool overflow_ = false;
+  bool first_ = true;
+};
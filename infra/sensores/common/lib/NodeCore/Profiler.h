@@ -0,0 +1,96 @@
+// --- PERFILADOR DEL CAMINO CALIENTE (-DNODE_PROFILE) ---
+// mide con el contador de ciclos de la CPU (ESP.getCycleCount(), una instrucción) cuánto tardan las secciones del
+//   nodo que se ejecutan en cada tick: la muestra del A0 o el paso de la conversión del DHT11 (sample), la lectura del
+//   driver (read), la escritura del payload (write), la publicación (publish) y la pasada entera por loop() (loop).
+//   Cada sección tiene su histograma logarítmico de tamaño fijo; SensorNode los publica en <topic>/diag junto con el
+//   heap, el RSSI y las reconexiones (ver SensorNode::sendDiag()).
+//
+// Sin -DNODE_PROFILE las macros NODE_PROF no generan código y el nodo no tiene ni los histogramas ni la tarea de
+//   diagnóstico: es lo que se compila para producción.
+//
+// Uso:
+//   {
+//     NODE_PROF(prof_, Read); // mide hasta el final del bloque
+//     ok = driver_.read(r);
+//   }
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#include "Histogram.h"
+
+class Profiler {
+ public:
+  enum Section : uint8_t { Sample, Read, Write, Publish, Loop, kSections };
+
+  // los histogramas guardan ciclos / 16: a 80 MHz son 0,2 us de resolución y el último cubo empieza en 2^20 * 16
+  //   ciclos, ~210 ms. Un bloqueo más largo (un connect()) cae en ese cubo, pero el máximo se guarda exacto y es lo que
+  //   dan los percentiles que caen ahí. Pasamos a us solo al publicar, para no dividir en el camino caliente (el lx106
+  //   no tiene división por hardware).
+  static constexpr uint8_t kShift = 4;
+
+  static const char* name(uint8_t s) {
+    static const char* const kNames[kSections] = {"sample", "read", "write", "publish", "loop"};
+    return kNames[s];
+  }
+
+  // mide lo que cuesta medir (dos lecturas del contador y un add), para restarlo a ojo al leer los tiempos pequeños
+  void begin() {
+    Log2Histogram scratch;
+    uint32_t best = UINT32_MAX;
+    for (uint8_t i = 0; i < 8; i++) {
+      const uint32_t t0 = ESP.getCycleCount();
+      scratch.add((ESP.getCycleCount() - t0) >> kShift);
+      const uint32_t d = ESP.getCycleCount() - t0;
+      if (d < best) best = d;
+    }
+    overheadCycles_ = best;
+    mhz_ = ESP.getCpuFreqMHz();
+    if (!mhz_) mhz_ = 80;
+  }
+
+  void add(Section s, uint32_t cycles) { hist_[s].add(cycles >> kShift); }
+
+  // percentil (0-100) y máximo de una sección en us
+  uint32_t percentileUs(uint8_t s, uint8_t pct) const { return toUs(hist_[s].percentile(pct)); }
+  uint32_t maxUs(uint8_t s) const { return toUs(hist_[s].max()); }
+  uint32_t count(uint8_t s) const { return hist_[s].count(); }
+  const Log2Histogram& histogram(uint8_t s) const { return hist_[s]; }
+  uint32_t overheadCycles() const { return overheadCycles_; }
+
+  void reset() {
+    for (uint8_t s = 0; s < kSections; s++) hist_[s].reset();
+  }
+
+ private:
+  uint32_t toUs(uint32_t units) const { return uint32_t((uint64_t(units) << kShift) / mhz_); }
+
+  Log2Histogram hist_[kSections];
+  uint32_t overheadCycles_ = 0;
+  uint32_t mhz_ = 80;
+};
+
+// apunta en el perfilador los ciclos que pasan entre su construcción y el final del bloque
+class ProfileScope {
+ public:
+  ProfileScope(Profiler& p, Profiler::Section s) : p_(p), s_(s), t0_(ESP.getCycleCount()) {}
+  ~ProfileScope() { p_.add(s_, ESP.getCycleCount() - t0_); }
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+ private:
+  Profiler& p_;
+  Profiler::Section s_;
+  uint32_t t0_;
+};
+
+#define NODE_PROF_CAT2(a, b) a##b
+#define NODE_PROF_CAT(a, b) NODE_PROF_CAT2(a, b)
+#ifdef NODE_PROFILE
+#define NODE_PROF(prof, section) ProfileScope NODE_PROF_CAT(profScope_, __LINE__)(prof, Profiler::section)
+#else
+#define NODE_PROF(prof, section) \
+  do {                           \
+  } while (0)
+#endif
@@ -0,0 +1,75 @@
+// --- PUBLICACIÓN POR EXCEPCIÓN ---
+// en un invernadero la mayoría de lecturas son iguales a la anterior. En lugar de publicar cada 3 s, el nodo solo
+//   publica cuando algún campo se aleja del último valor publicado más que su banda muerta, o cuando lleva
+//   kHeartbeatMs sin publicar (latido), para que Node-RED y las APIs /api/greenhouse/* no se queden sin dato.
+//
+// El driver define:
+//   static constexpr uint8_t kFields;                  número de campos publicados
+//   static void values(const Reading&, int32_t* out);  valor de cada campo (en las unidades del Reading)
+//   static constexpr Deadband kDeadband[kFields];      banda de cada campo
+//   static constexpr uint32_t kHeartbeatMs;            silencio máximo
+#pragma once
+
+#include <stdint.h>
+
+// banda muerta de un campo: se publica si |v - último| >= abs, o si |v - último| >= relPct % de |último|.
+//   Con las dos a 0 se publica siempre (equivale al comportamiento anterior).
+struct Deadband {
+  int32_t abs;
+  uint8_t relPct;
+};
+
+// contadores de lo que ha hecho la política, para comprobar la reducción de mensajes
+struct PublishStats {
+  uint32_t enviados = 0;   // publicados por cambio de valor (incluye el primero)
+  uint32_t latidos = 0;    // publicados por el latido sin haber cambio
+  uint32_t suprimidos = 0; // lecturas que no se han publicado
+};
+
+template <class Driver>
+class PublishPolicy {
+  static constexpr uint8_t N = Driver::kFields;
+
+ public:
+  enum Decision : uint8_t { Suprimir, Cambio, Latido };
+
+  // decide si la lectura se publica; no cambia el estado hasta que se confirme con sent()
+  Decision decide(const typename Driver::Reading& r, uint32_t nowMs) {
+    if (!hasLast_) return Cambio;
+    int32_t v[N];
+    Driver::values(r, v);
+    for (uint8_t i = 0; i < N; i++) {
+      if (crosses(v[i], last_[i], Driver::kDeadband[i])) return Cambio;
+    }
+    if (nowMs - lastSentMs_ >= Driver::kHeartbeatMs) return Latido;
+    return Suprimir;
+  }
+
+  // la lectura se ha publicado: pasa a ser la referencia de la banda muerta
+  void sent(const typename Driver::Reading& r, uint32_t nowMs, Decision d) {
+    Driver::values(r, last_);
+    hasLast_ = true;
+    lastSentMs_ = nowMs;
+    if (d == Latido) stats_.latidos++;
+    else stats_.enviados++;
+  }
+
+  void suppressed() { stats_.suprimidos++; }
+
+  const PublishStats& stats() const { return stats_; }
+
+ private:
+  static bool crosses(int32_t v, int32_t last, const Deadband& db) {
+    if (!db.abs && !db.relPct) return true; // sin banda: siempre se publica
+    const int32_t diff = v > last ? v - last : last - v;
+    if (!diff) return false;
+    if (db.abs && diff >= db.abs) return true;
+    const int32_t ref = last < 0 ? -last : last;
+    return db.relPct && int64_t(diff) * 100 >= int64_t(ref) * db.relPct;
+  }
+
+  int32_t last_[N] = {};
+  bool hasLast_ = false;
+  uint32_t lastSentMs_ = 0;
+  PublishStats stats_;
+};
@@ -0,0 +1,54 @@
+// --- ESTADO EN LA MEMORIA RTC ---
+// la memoria RTC de usuario (512 bytes) es la única RAM que conserva el deep sleep. RtcStore<T> guarda en ella un
+//   struct con un número mágico y un CRC-32: tras conectar la batería (o un corte) la RTC tiene basura y load()
+//   devuelve false. Los primeros 128 bytes los usa eboot para las actualizaciones OTA, así que empezamos en el
+//   bloque 32 y quedan 384 bytes.
+#pragma once
+
+#include <Arduino.h>
+
+template <class T>
+class RtcStore {
+ public:
+  static constexpr uint32_t kOffsetBlocks = 32; // bloques de 4 bytes
+  static constexpr size_t kSize = 512 - kOffsetBlocks * 4;
+  static constexpr size_t kDataMax = kSize - 8; // lo que queda tras el mágico y el CRC
+
+  static_assert(sizeof(T) % 4 == 0, "la memoria RTC se lee y escribe en bloques de 4 bytes");
+  static_assert(sizeof(T) <= kDataMax, "el estado no cabe en la memoria RTC");
+
+  bool load(T& out) {
+    if (!ESP.rtcUserMemoryRead(kOffsetBlocks, reinterpret_cast<uint32_t*>(&image_), sizeof(image_))) return false;
+    if (image_.magic != kMagic || image_.crc != crc32(&image_.data, sizeof(T))) return false;
+    memcpy(&out, &image_.data, sizeof(T));
+    return true;
+  }
+
+  bool save(const T& in) {
+    image_.magic = kMagic;
+    memcpy(&image_.data, &in, sizeof(T));
+    image_.crc = crc32(&image_.data, sizeof(T));
+    return ESP.rtcUserMemoryWrite(kOffsetBlocks, reinterpret_cast<uint32_t*>(&image_), sizeof(image_));
+  }
+
+ private:
+  static constexpr uint32_t kMagic = 0x52544331; // "RTC1"; cambiarlo si cambia el formato de T
+
+  // CRC-32 (polinomio 0xEDB88320) bit a bit: son unos cientos de bytes una vez por despertar, no merece una tabla
+  static uint32_t crc32(const void* p, size_t n) {
+    const uint8_t* b = static_cast<const uint8_t*>(p);
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < n; i++) {
+      crc ^= b[i];
+      for (uint8_t k = 0; k < 8; k++) crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+    }
+    return ~crc;
+  }
+
+  struct Image {
+    uint32_t magic;
+    uint32_t crc;
+    T data;
+  };
+  Image image_;
+};
@@ -0,0 +1,200 @@
+// --- REGLAS LOCALES DEL NODO ---
+// el backend manda al nodo un programa de reglas (formato e intérprete en common/lib/Reglas/Reglas.h) por
+//   invernadero/rules/<topic>, con retain y QoS 1. El nodo lo valida, lo guarda en un sector de la flash (sobrevive a
+//   los reinicios y a los cortes del backend) y lo evalúa tras cada lectura del driver: si una regla decide encender o
+//   apagar un actuador, lo hace Commands::set() en el momento, con el id "regla-<n>" en el estado publicado. La reacción
+//   pasa a ser el periodo de lectura (3 s) en lugar de la vuelta por Node-RED, y sigue funcionando sin backend.
+//
+// El backend sigue mandando: el programa retenido en el broker se vuelve a recibir en cada conexión (si no ha
+//   cambiado no se reescribe la flash) y un payload vacío borra las reglas. Tras cada programa recibido el nodo
+//   publica, con retain, en invernadero/rules/<topic>/estado:
+//   {"crc": "9f3a01c2", "reglas": 1, "evaluaciones": 1200, "cambios": 4}    o    {..., "error": "crc"}
+// y un programa que no es válido no sustituye al anterior.
+//
+// Las órdenes por MQTT (Commands.h) siguen funcionando: mueven la misma salida, y los tiempos mínimos de las reglas
+//   cuentan desde el último cambio, sea de una regla o de una orden.
+#pragma once
+
+#include <Arduino.h>
+
+#include <Reglas.h>
+
+#include "Commands.h"
+#include "EspFlash.h"
+#include "MqttTransport.h"
+#include "NodeConfig.h"
+#include "PayloadWriter.h"
+#include "WallClock.h"
+
+struct RulesStats {
+  uint32_t evaluaciones = 0; // lecturas evaluadas con un programa cargado
+  uint32_t cambios = 0;      // salidas encendidas o apagadas por una regla
+};
+
+// sin actuadores no hay reglas
+template <class Driver, bool = HasActuators<Driver>::value>
+class Rules {
+ public:
+  Rules(NodeMqtt&, Commands<Driver>&, EspFlash&) {}
+  void begin(bool) {}
+  void online() {}
+  bool matches(const char*) const { return false; }
+  void onMessage(const uint8_t*, unsigned int) {}
+  void evaluate(const typename Driver::Reading&, uint32_t) {}
+};
+
+template <class Driver>
+class Rules<Driver, true> {
+ public:
+  static constexpr uint8_t kDevices = Commands<Driver>::kCount;
+  static_assert(node_config::rulesSector >= node_config::storeSectors, "las reglas pisarían la cola en flash");
+
+  Rules(NodeMqtt& mqtt, Commands<Driver>& cmds, EspFlash& flash) : mqtt_(mqtt), cmds_(cmds), flash_(flash) {}
+
+  // recupera el último programa guardado (si la zona de la flash da para él)
+  void begin(bool flashOk) {
+    strcpy(topic_, "invernadero/rules/");
+    strcat(topic_, Driver::kTopic);
+    strcpy(statusTopic_, topic_);
+    strcat(statusTopic_, "/estado");
+    flashOk_ = flashOk;
+    if (!flashOk_) return;
+    uint32_t head[2];
+    if (!flash_.read(kOffset, head, sizeof(head)) || head[0] != kMagic || head[1] > reglas::kMaxProgram) return;
+    if (!head[1]) return;  // las reglas se borraron con un payload vacío: no hay programa, no es un error
+    if (!flash_.read(kOffset + sizeof(head), program_, (head[1] + 3) & ~3u)) return;
+    len_ = uint8_t(head[1]);
+    const reglas::Error e = prog_.cargar(bytes(), len_, Driver::kFields, kDevices);
+    if (e != reglas::Ok) {
+      len_ = 0;
+      Serial.print("Reglas de la flash no válidas: ");
+      Serial.println(reglas::nombreError(e));
+      return;
+    }
+    Serial.print("Reglas cargadas de la flash: ");
+    Serial.println(prog_.reglas());
+  }
+
+  // recién conectado: con clean session hay que suscribirse cada vez; el broker nos reenvía el programa retenido
+  void online() {
+    if (!mqtt_.subscribe(topic_, 1)) Serial.println("Error suscribiendo a las reglas");
+    publishStatus();
+  }
+
+  bool matches(const char* topic) const { return strcmp(topic, topic_) == 0; }
+
+  // programa nuevo (el payload está en el buffer de PubSubClient: lo copiamos antes de publicar nada)
+  void onMessage(const uint8_t* payload, unsigned int len) {
+    error_ = reglas::Ok;
+    if (!len) {
+      // sin payload: se borran las reglas (y el retenido del broker)
+      prog_.cargar(nullptr, 0, 0, 0);
+      len_ = 0;
+      save();
+      publishStatus();
+      return;
+    }
+    if (len > reglas::kMaxProgram) {
+      error_ = reglas::Tamano;
+      publishStatus();
+      return;
+    }
+    uint32_t scratch[kWords];
+    memcpy(scratch, payload, len);
+    reglas::Programa nuevo;
+    error_ = nuevo.cargar(reinterpret_cast<const uint8_t*>(scratch), len, Driver::kFields, kDevices);
+    if (error_ != reglas::Ok) {
+      Serial.print("Reglas no válidas: ");
+      Serial.println(reglas::nombreError(error_));
+    } else if (!len_ || nuevo.crc() != prog_.crc()) {
+      // el programa apunta a los bytes: lo cargamos otra vez sobre la copia definitiva
+      memcpy(program_, scratch, len);
+      len_ = uint8_t(len);
+      prog_.cargar(bytes(), len_, Driver::kFields, kDevices);
+      save();
+      Serial.print("Reglas nuevas: ");
+      Serial.println(prog_.reglas());
+    }
+    publishStatus();
+  }
+
+  // tras cada lectura válida
+  void evaluate(const typename Driver::Reading& r, uint32_t nowMs) {
+    if (!prog_.reglas()) return;
+    int32_t campos[Driver::kFields];
+    Driver::values(r, campos);
+    uint32_t desde[kDevices];
+    uint8_t encendidos = 0;
+    for (uint8_t d = 0; d < kDevices; d++) {
+      desde[d] = cmds_.sinceMs(d, nowMs) / 1000;
+      if (cmds_.output(d).on) encendidos |= uint8_t(1u << d);
+    }
+    reglas::Entorno e{campos, wall_clock::minuteOfDay(), encendidos, desde};
+    stats_.evaluaciones++;
+    for (uint8_t k = 0; k < prog_.reglas(); k++) {
+      const reglas::Regla& regla = prog_.regla(k);
+      const int8_t accion = reglas::decidir(regla, e);
+      if (accion < 0) continue;
+      char id[12] = "regla-";
+      id[6] = char('0' + k);
+      id[7] = '\0';
+      cmds_.set(regla.dispositivo, accion == 1, nowMs, id);
+      stats_.cambios++;
+      // las reglas siguientes ven el cambio
+      const uint8_t d = regla.dispositivo;
+      e.encendidos = uint8_t(cmds_.output(d).on ? e.encendidos | (1u << d) : e.encendidos & ~(1u << d));
+      desde[d] = cmds_.sinceMs(d, nowMs) / 1000;
+    }
+  }
+
+  const reglas::Programa& program() const { return prog_; }
+  const RulesStats& stats() const { return stats_; }
+
+ private:
+  static constexpr uint32_t kMagic = 0x314C4752; // "RGL1"
+  static constexpr uint32_t kOffset = uint32_t(node_config::rulesSector) * EspFlash::kSectorSize;
+  static constexpr size_t kWords = (reglas::kMaxProgram + 3) / 4;
+
+  const uint8_t* bytes() const { return reinterpret_cast<const uint8_t*>(program_); }
+
+  // un programa nuevo borra el sector y lo escribe entero; el mismo programa recibido otra vez no toca la flash
+  void save() {
+    if (!flashOk_) return;
+    uint32_t head[2] = {kMagic, len_};
+    if (!flash_.erase(node_config::rulesSector) || !flash_.write(kOffset, head, sizeof(head)) ||
+        (len_ && !flash_.write(kOffset + sizeof(head), program_, (uint32_t(len_) + 3) & ~3u))) {
+      Serial.println("Error guardando las reglas en flash");
+    }
+  }
+
+  void publishStatus() {
+    char buf[128];
+    char crc[9];
+    static const char kHex[] = "0123456789abcdef";
+    for (uint8_t i = 0; i < 8; i++) crc[i] = kHex[(prog_.crc() >> (28 - 4 * i)) & 0xF];
+    crc[8] = '\0';
+    PayloadWriter w(buf, sizeof(buf));
+    w.begin();
+    w.text("crc", crc);
+    w.field("reglas", prog_.reglas());
+    w.field("evaluaciones", int32_t(stats_.evaluaciones));
+    w.field("cambios", int32_t(stats_.cambios));
+    if (error_ != reglas::Ok) w.text("error", reglas::nombreError(error_));
+    const size_t len = w.end();
+    if (len) publishConfirmed(mqtt_, statusTopic_, reinterpret_cast<const uint8_t*>(buf), len, true);
+  }
+
+  NodeMqtt& mqtt_;
+  Commands<Driver>& cmds_;
+  EspFlash& flash_;
+  bool flashOk_ = false;
+
+  uint32_t program_[kWords]; // alineado a 4 bytes para leer y escribir la flash
+  uint8_t len_ = 0;
+  reglas::Programa prog_;
+  reglas::Error error_ = reglas::Ok;
+  RulesStats stats_;
+
+  char topic_[18 + sizeof(Driver::kTopic)];
+  char statusTopic_[18 + sizeof(Driver::kTopic) + 7];
+};
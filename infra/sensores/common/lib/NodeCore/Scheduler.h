@@ -0,0 +1,109 @@
+// --- PLANIFICADOR COOPERATIVO ---
+// sustituye a los Tickers: en lugar de callbacks en el contexto del timer que activan flags, las tareas se guardan en
+//   una cola ordenada por su próximo vencimiento (un montículo binario de tamaño fijo) y se ejecutan desde loop().
+//   Así ningún trabajo (ni de red ni de lectura) corre dentro de un timer, y se puede medir cuánto se retrasa cada
+//   tarea respecto a su vencimiento (jitter).
+//
+// Las tareas periódicas se reprograman a partir de su vencimiento anterior (no de cuándo se ejecutaron), así que un
+//   retraso puntual no desplaza las siguientes ejecuciones.
+#pragma once
+
+#include <stdint.h>
+
+#include "Histogram.h"
+
+template <uint8_t MaxTasks>
+class Scheduler {
+ public:
+  using Callback = void (*)(void* ctx);
+
+  // instante de referencia para las tareas que se registren antes del primer run()
+  void begin(uint32_t nowUs) { nowUs_ = nowUs; }
+
+  // tarea periódica; si jitter no es nulo se apunta ahí el retraso de cada ejecución (us)
+  bool every(uint32_t periodUs, Callback cb, void* ctx, Log2Histogram* jitter = nullptr, uint32_t firstDelayUs = 0) {
+    return push({nowUs_ + firstDelayUs, periodUs, cb, ctx, jitter});
+  }
+
+  // tarea de una sola ejecución
+  bool after(uint32_t delayUs, Callback cb, void* ctx) { return push({nowUs_ + delayUs, 0, cb, ctx, nullptr}); }
+
+  // ejecuta las tareas vencidas; devuelve cuántas ha ejecutado
+  uint8_t run(uint32_t nowUs) {
+    nowUs_ = nowUs;
+    uint8_t ran = 0;
+    // limitamos las ejecuciones por llamada para que una tarea con periodo 0 no bloquee el loop
+    while (size_ && due(heap_[0].deadline, nowUs) && ran < MaxTasks) {
+      Task t = heap_[0];
+      popTop();
+      if (t.jitter) t.jitter->add(nowUs - t.deadline);
+      if (t.period) {
+        Task next = t;
+        next.deadline += t.period;
+        // si vamos más de un periodo tarde (loop bloqueado), saltamos los vencimientos perdidos en vez de encadenarlos
+        if (due(next.deadline, nowUs)) next.deadline = nowUs + t.period;
+        push(next);
+      }
+      t.cb(t.ctx);
+      ran++;
+    }
+    return ran;
+  }
+
+  // microsegundos hasta el próximo vencimiento (0 si ya hay alguno vencido)
+  uint32_t idleUs(uint32_t nowUs) const {
+    if (!size_) return UINT32_MAX;
+    const int32_t d = int32_t(heap_[0].deadline - nowUs);
+    return d > 0 ? uint32_t(d) : 0;
+  }
+
+  uint8_t size() const { return size_; }
+
+ private:
+  struct Task {
+    uint32_t deadline;
+    uint32_t period;
+    Callback cb;
+    void* ctx;
+    Log2Histogram* jitter;
+  };
+
+  // comparación segura frente al desbordamiento de micros() (cada ~71 min)
+  static bool due(uint32_t deadline, uint32_t now) { return int32_t(now - deadline) >= 0; }
+  static bool before(const Task& a, const Task& b) { return int32_t(a.deadline - b.deadline) < 0; }
+
+  bool push(const Task& t) {
+    if (size_ >= MaxTasks) return false;
+    uint8_t i = size_++;
+    heap_[i] = t;
+    while (i && before(heap_[i], heap_[(i - 1) / 2])) {
+      swap(i, (i - 1) / 2);
+      i = (i - 1) / 2;
+    }
+    return true;
+  }
+
+  void popTop() {
+    heap_[0] = heap_[--size_];
+    uint8_t i = 0;
+    for (;;) {
+      const uint8_t l = 2 * i + 1, r = l + 1;
+      uint8_t m = i;
+      if (l < size_ && before(heap_[l], heap_[m])) m = l;
+      if (r < size_ && before(heap_[r], heap_[m])) m = r;
+      if (m == i) return;
+      swap(i, m);
+      i = m;
+    }
+  }
+
+  void swap(uint8_t a, uint8_t b) {
+    const Task t = heap_[a];
+    heap_[a] = heap_[b];
+    heap_[b] = t;
+  }
+
+  Task heap_[MaxTasks];
+  uint8_t size_ = 0;
+  uint32_t nowUs_ = 0;
+};
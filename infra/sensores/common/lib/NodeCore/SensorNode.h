@@ -0,0 +1,496 @@
+// --- NÚCLEO COMÚN DE LOS NODOS SENSORES ---
+// antes cada nodo (ldr, soil, mq135, temp_hum) tenía su propia copia de setup_wifi(), reconnect(), los tickers y la
+//   creación del JSON. SensorNode<Driver> junta todo eso en un solo sitio; cada nodo solo aporta un "driver" que sabe
+//   leer su sensor y escribir su payload.
+//
+// El driver tiene que definir (todo se resuelve al compilar, sin funciones virtuales):
+//   static constexpr char kTopic[];            topic donde se publica ("ldr", "soil", ...)
+//   static constexpr char kClientId[];         id del cliente MQTT
+//   static constexpr uint32_t kPeriodMs;       periodo de publicación
+//   static constexpr uint32_t kSampleMs;       periodo de sobremuestreo (0 = el driver lee solo al publicar)
+//   static constexpr size_t kPayloadMax;       tamaño del buffer del payload
+//   struct Reading;                            una lectura del sensor
+//   void begin();                              inicialización del sensor
+//   void sample();                             una muestra intermedia (solo si kSampleMs > 0)
+//   bool read(Reading&);                       lectura; false si la lectura no es válida
+//   static void write(PayloadWriter&, const Reading&);  campos del JSON
+//   static void log(const Reading&);           traza por el Serial Monitor
+//   void stats(PayloadWriter&) y statsSent();  opcional: contadores propios del sensor, que se publican junto a los
+//                                              stats en <topic>/sensor (statsSent() se llama si se han publicado)
+//   static constexpr ActuatorDef kActuators[]; opcional: relés y PWM que se mandan por invernadero/cmd/<topic>/...
+//                                              (ver Commands.h); con actuadores el nodo también ejecuta las
+//                                              reglas que le manda el backend (ver Rules.h)
+//   using Calib y compañía;                    opcional: calibración del sensor que se cambia por
+//                                              invernadero/calib/<topic> (ver Calibration.h)
+//   y los campos y la banda muerta de la publicación por excepción (ver PublishPolicy.h)
+//
+// Cada lectura JSON lleva "seq" (empieza en 0 en cada arranque y crece con cada lectura que pasa la publicación por
+//   excepción, se publique en el momento o desde la flash) y "ts" (ms desde 1970 por SNTP, ver WallClock.h), para
+//   medir pérdidas y latencias de extremo a extremo (herramienta latencias de infra/servicios).
+//
+// Con -DNODE_BINARY_BATCH las lecturas no se publican una a una en JSON: se acumulan y se envían en lotes binarios
+//   (ver common/lib/Telemetria/BatchFormat.h) al topic <topic>/bin.
+//
+// Con -DNODE_DEEP_SLEEP el nodo no se queda encendido: cada despertar toma una lectura y vuelve a dormir, y solo
+//   uno de cada varios enciende la WiFi para publicar (ver DutyCycle.h). En este modo no se atienden órdenes a los
+//   actuadores ni llegan calibraciones nuevas (se usa la guardada en la flash): el nodo no está escuchando.
+//
+// Con -DNODE_PROFILE se mide en ciclos lo que tarda cada sección del camino caliente y se publica en <topic>/diag
+//   (ver Profiler.h). Sin la macro no queda nada del perfilador en el binario.
+//
+// Con -DNODE_ASYNC_MQTT el cliente MQTT es AsyncMqtt en lugar de PubSubClient: publish() no espera nunca a que la
+//   WiFi devuelva los ACK, y el estado de los actuadores y de las reglas va con QoS 1 (ver AsyncMqtt.h).
+//
+// Todo el trabajo (lecturas, publicación, conexión) lo ejecuta un planificador cooperativo desde loop(); no hay
+//   callbacks en contexto de timer. La conexión es una máquina de estados que nunca se queda esperando en un while,
+//   así que las lecturas mantienen su periodo aunque el broker esté caído.
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+#include "Calibration.h"
+#include "Commands.h"
+#include "Connection.h"
+#include "DutyCycle.h"
+#include "EspFlash.h"
+#include "FlashLog.h"
+#include "Histogram.h"
+#include "MqttTransport.h"
+#include "NodeConfig.h"
+#include "PayloadWriter.h"
+#include "Profiler.h"
+#include "PublishPolicy.h"
+#include "Rules.h"
+#include "Scheduler.h"
+#include "WallClock.h"
+
+#include <BatchFormat.h>
+
+#include <type_traits>
+#include <utility>
+
+// ¿el driver publica contadores propios? (ver stats() en el comentario de arriba)
+template <class D, class = void>
+struct HasDriverStats : std::false_type {};
+template <class D>
+struct HasDriverStats<D, std::void_t<decltype(std::declval<const D&>().stats(std::declval<PayloadWriter&>()))>>
+    : std::true_type {};
+
+template <class Driver>
+class SensorNode {
+ public:
+  void begin() {
+    // inicializamos la comunicación serial y el sensor
+    Serial.begin(115200);
+    driver_.begin();
+    // la calibración va en el sector siguiente a las reglas; se carga antes de la primera lectura
+    calib_.begin(EspFlash::fits(node_config::calibSector + 1));
+#ifdef NODE_DEEP_SLEEP
+    // en la placa no vuelve de aquí: el siguiente despertar empieza otra vez en setup()
+    DutyCycle<Driver>(driver_, wifi_, mqtt_, log_).run();
+    return;
+#endif
+    conn_.begin();
+    cmds_.begin(); // salidas de los actuadores apagadas hasta la primera orden
+    wall_clock::begin(); // hora por SNTP para el "ts" de las lecturas y las ventanas horarias de las reglas
+    if constexpr (HasActuators<Driver>::value || HasCalibration<Driver>::value) {
+      // un solo callback para todo lo que llega: calibración, reglas nuevas u órdenes a los actuadores
+      mqtt_.setCallback([this](char* topic, uint8_t* payload, unsigned int len) {
+        if (calib_.matches(topic)) {
+          calib_.onMessage(topic, payload, len);
+        } else if (rules_.matches(topic)) {
+          rules_.onMessage(payload, len);
+        } else if (cmds_.matches(topic)) {
+          cmds_.onMessage(topic, payload, len);
+        }
+      });
+    }
+
+    // los contadores de la publicación por excepción van a <topic>/stats (p. ej. "soil/stats")
+    strcpy(statsTopic_, Driver::kTopic);
+    strcat(statsTopic_, "/stats");
+    strcpy(sensorTopic_, Driver::kTopic);
+    strcat(sensorTopic_, "/sensor");
+    // los stats con los contadores de las órdenes (o el diagnóstico) no caben en los 256 bytes por defecto de
+    //   PubSubClient: publish() los descartaría sin avisar
+    if (kPacketMax > 256) mqtt_.setBufferSize(uint16_t(kPacketMax));
+#ifdef NODE_BINARY_BATCH
+    strcpy(binTopic_, Driver::kTopic);
+    strcat(binTopic_, "/bin");
+#endif
+#ifdef NODE_PROFILE
+    strcpy(diagTopic_, Driver::kTopic);
+    strcat(diagTopic_, "/diag");
+    prof_.begin();
+    diagSinceMs_ = millis();
+#endif
+
+    // recuperamos las lecturas que quedaron sin enviar antes del último reinicio
+    logOk_ = EspFlash::fits(node_config::storeSectors);
+    if (logOk_) {
+      Serial.print("Lecturas pendientes en flash: ");
+      Serial.println(log_.begin());
+    }
+    // las reglas van en el sector siguiente a la cola
+    rules_.begin(EspFlash::fits(node_config::rulesSector + 1));
+
+    // --- TAREAS ---
+    // las lecturas (sample/publish) apuntan su retraso en tickJitter_ para medir el jitter
+    sched_.begin(micros());
+    sched_.every(ms(node_config::connPollMs), task<&SensorNode::pollConnection>, this);
+    sched_.every(ms(Driver::kPeriodMs), task<&SensorNode::readAndPublish>, this, &tickJitter_, ms(Driver::kPeriodMs));
+    if (Driver::kSampleMs) {
+      sched_.every(ms(Driver::kSampleMs), task<&SensorNode::sample>, this, &tickJitter_);
+    }
+    sched_.every(ms(node_config::replayMs), task<&SensorNode::replay>, this);
+    sched_.every(ms(node_config::statsMs), task<&SensorNode::sendStats>, this, nullptr, ms(node_config::statsMs));
+    if constexpr (HasActuators<Driver>::value) {
+      sched_.every(ms(node_config::actuatorPollMs), task<&SensorNode::pollCommands>, this);
+    }
+#ifdef NODE_PROFILE
+    sched_.every(ms(node_config::diagMs), task<&SensorNode::sendDiag>, this, nullptr, ms(node_config::diagMs));
+#endif
+  }
+
+  void loop() {
+#ifdef NODE_DEEP_SLEEP
+    return; // todo el trabajo se hace en begin()
+#endif
+    NODE_PROF(prof_, Loop);
+    // latencia del loop: tiempo entre dos pasadas (si algo bloquea, aquí se ve)
+    const uint32_t now = micros();
+    if (lastLoopUs_) loopLatency_.add(now - lastLoopUs_);
+    lastLoopUs_ = now;
+
+    sched_.run(now);
+    if (conn_.online() && !mqtt_.loop()) {
+      conn_.lost(millis()); // mantenemos viva la conexión MQTT; si se ha caído, la máquina de estados reintenta
+    }
+    yield(); // recomendado para el ESP8266, evita reinicios por watchdog
+  }
+
+  NodeMqtt& mqtt() { return mqtt_; }
+  Driver& driver() { return driver_; }
+  bool mqttConnected() const { return conn_.online(); }
+  const Connection& connection() const { return conn_; }
+  const Commands<Driver>& commands() const { return cmds_; }
+  const Rules<Driver>& rules() const { return rules_; }
+  const PublishStats& publishStats() const { return policy_.stats(); }
+  const FlashLogStats& storeStats() const { return log_.stats(); }
+  uint32_t storePending() const { return log_.pending(); }
+  const Log2Histogram& tickJitter() const { return tickJitter_; }
+  const Log2Histogram& loopLatency() const { return loopLatency_; }
+#ifdef NODE_PROFILE
+  const Profiler& profiler() const { return prof_; }
+#endif
+
+ private:
+  static constexpr uint32_t ms(uint32_t v) { return v * 1000; }
+
+  // adaptador de un método del nodo a la firma de callback del planificador
+  template <void (SensorNode::*Method)()>
+  static void task(void* self) {
+    (static_cast<SensorNode*>(self)->*Method)();
+  }
+
+  void pollConnection() {
+    if (conn_.poll(millis()) == Connection::Conecta) {
+      cmds_.online(millis()); // suscripción a las órdenes y estado de los actuadores
+      rules_.online();        // suscripción a las reglas (el broker reenvía el programa retenido)
+      calib_.online();        // y a la calibración
+      // si hay lecturas guardadas, esperamos un tiempo aleatorio antes de reenviarlas: si se cae el broker, todos
+      //   los nodos reconectan a la vez y no queremos que le lleguen todos los reenvíos juntos
+      replayAfterMs_ = millis() + uint32_t(random(node_config::replayJitterMs));
+    }
+  }
+
+  // apaga las salidas temporizadas vencidas (las órdenes en sí se aplican al llegar, desde mqtt_.loop())
+  void pollCommands() { cmds_.poll(millis(), conn_.online()); }
+
+  void sample() {
+    NODE_PROF(prof_, Sample);
+    driver_.sample(); // muestra intermedia para el filtro del driver
+  }
+
+  void readAndPublish() {
+    const uint32_t now = millis();
+#ifdef NODE_BINARY_BATCH
+    // un lote no puede esperar más de batchMaxAgeMs aunque no se llene
+    if (batchCount_ && now - batchTs_[0] >= node_config::batchMaxAgeMs) {
+      flushBatch();
+    }
+#endif
+    typename Driver::Reading r;
+    bool ok;
+    {
+      NODE_PROF(prof_, Read);
+      ok = driver_.read(r);
+    }
+    if (!ok) {
+      return; // el driver ya informa del error por el Serial
+    }
+    Driver::log(r);
+    // las reglas deciden con cada lectura, antes de la publicación por excepción y aunque no haya conexión
+    rules_.evaluate(r, now);
+
+    // publicación por excepción: si no ha cambiado lo suficiente y no toca latido, no publicamos
+    const auto decision = policy_.decide(r, now);
+    if (decision == PublishPolicy<Driver>::Suprimir) {
+      policy_.suppressed();
+      return;
+    }
+#ifdef NODE_BINARY_BATCH
+    batch_[batchCount_] = r;
+    batchTs_[batchCount_] = now;
+    batchCount_++;
+    policy_.sent(r, now, decision);
+    if (batchCount_ == node_config::batchSamples) {
+      flushBatch();
+    }
+    return;
+#endif
+
+    // detrás de los campos del driver van "seq" (número de lectura de este arranque, para que el backend vea las
+    //   perdidas y las desordenadas) y "ts" (hora de la lectura en ms desde 1970, en cuanto hay hora por SNTP)
+    const uint32_t seq = seq_++;
+    size_t len, driverLen, seqLen;
+    {
+      NODE_PROF(prof_, Write);
+      PayloadWriter w(payload_, sizeof(payload_));
+      w.begin();
+      Driver::write(w, r);
+      driverLen = w.length();
+      w.field("seq", int32_t(seq));
+      seqLen = w.length();
+      if (const uint64_t ts = wall_clock::epochMs()) w.field64("ts", ts);
+      len = w.end();
+    }
+    if (!len) {
+      return;
+    }
+    bool published = false;
+    if (conn_.online()) {
+      NODE_PROF(prof_, Publish);
+      published = mqtt_.publish(Driver::kTopic, reinterpret_cast<const uint8_t*>(payload_), len);
+    }
+    if (published) {
+      policy_.sent(r, now, decision);
+      return;
+    }
+    // sin conexión (o si falla la publicación) guardamos la lectura en flash para reenviarla después. El registro solo
+    //   tiene 48 bytes: se guarda sin "ts" (replay() lo vuelve a calcular con la edad) y, si tampoco cabe, sin "seq"
+    len = seqLen + 1 <= FlashRecord::kMaxPayload ? seqLen : driverLen;
+    payload_[len++] = '}';
+    if (logOk_ && log_.push(now, payload_, uint8_t(len))) {
+      policy_.sent(r, now, decision);
+    } else {
+      Serial.println("Error publicando");
+    }
+  }
+
+#ifdef NODE_BINARY_BATCH
+  // publica el lote en binario; si no hay conexión o falla, guarda cada lectura en la flash como JSON (el reenvío
+  //   va por el camino normal, uno a uno)
+  void flushBatch() {
+    if (conn_.online()) {
+      batch::Encoder enc(reinterpret_cast<uint8_t*>(payload_), sizeof(payload_));
+      enc.begin(Driver::kBinaryType, Driver::kFields, ESP.getChipId(), batchSeq_, batchTs_[0]);
+      for (uint8_t i = 0; i < batchCount_; i++) {
+        int32_t v[Driver::kFields];
+        Driver::values(batch_[i], v);
+        enc.add(batchTs_[i], v);
+      }
+      bool published;
+      {
+        NODE_PROF(prof_, Publish);
+        published = mqtt_.publish(binTopic_, reinterpret_cast<const uint8_t*>(payload_), enc.length());
+      }
+      if (published) {
+        batchSeq_++;
+        batchCount_ = 0;
+        return;
+      }
+    }
+    for (uint8_t i = 0; i < batchCount_; i++) {
+      PayloadWriter w(payload_, sizeof(payload_));
+      w.begin();
+      Driver::write(w, batch_[i]);
+      const size_t len = w.end();
+      if (!len || !logOk_ || !log_.push(batchTs_[i], payload_, uint8_t(len))) {
+        Serial.println("Error publicando");
+      }
+    }
+    batchCount_ = 0;
+  }
+#endif
+
+  // reenvía un lote de lecturas guardadas. Si la lectura es de este arranque le añadimos "age" (ms desde que se
+  //   tomó) para que el backend pueda recolocarla en el tiempo, y "ts" si ya hay hora. De arranques anteriores no
+  //   sabemos la edad: llevan "previo":1, porque su "seq" es de la numeración de aquel arranque.
+  void replay() {
+    if (!conn_.online() || !logOk_ || !log_.pending() || int32_t(millis() - replayAfterMs_) < 0) {
+      return;
+    }
+    char buf[FlashRecord::kMaxPayload + 48];
+    for (uint8_t i = 0; i < node_config::replayBatch; i++) {
+      FlashRecord rec;
+      if (!log_.front(rec)) {
+        return;
+      }
+      size_t len = rec.len;
+      memcpy(buf, rec.payload, len);
+      if (len > 2 && buf[len - 1] == '}') {
+        PayloadWriter w(buf, sizeof(buf));
+        w.begin();
+        w.fields(rec.payload + 1, rec.len - 2); // campos originales sin las llaves
+        if (rec.boot == log_.boot()) {
+          const uint32_t age = millis() - rec.ts;
+          w.field("age", int32_t(age));
+          if (const uint64_t ts = wall_clock::epochMs()) w.field64("ts", ts - age);
+        } else {
+          w.field("previo", 1);
+        }
+        len = w.end();
+        if (!len) {
+          len = rec.len;
+          memcpy(buf, rec.payload, len);
+        }
+      }
+      if (!mqtt_.publish(Driver::kTopic, reinterpret_cast<const uint8_t*>(buf), len)) {
+        return; // lo reintentaremos en el siguiente lote
+      }
+      log_.pop();
+    }
+  }
+
+  // contadores de enviados/latidos/suprimidos, de la cola en flash y de la conexión, y el jitter de las lecturas y la
+  //   latencia del loop del último intervalo (p99 y máximo, en us). Los histogramas se reinician tras publicarlos.
+  void sendStats() {
+    if (!conn_.online()) return;
+    const PublishStats& s = policy_.stats();
+    PayloadWriter w(payload_, sizeof(payload_));
+    w.begin();
+    w.field("enviados", int32_t(s.enviados));
+    w.field("latidos", int32_t(s.latidos));
+    w.field("suprimidos", int32_t(s.suprimidos));
+    const FlashLogStats& f = log_.stats();
+    w.field("guardados", int32_t(f.guardados));
+    w.field("reenviados", int32_t(f.reenviados));
+    w.field("perdidos", int32_t(f.perdidos));
+    w.field("pendientes", int32_t(log_.pending()));
+    w.field("reconexiones", int32_t(conn_.reconnects()));
+    w.field("jitter_p99_us", int32_t(tickJitter_.percentile(99)));
+    w.field("jitter_max_us", int32_t(tickJitter_.max()));
+    w.field("loop_p99_us", int32_t(loopLatency_.percentile(99)));
+    w.field("loop_max_us", int32_t(loopLatency_.max()));
+    if constexpr (HasActuators<Driver>::value) {
+      const CommandStats& c = cmds_.stats();
+      w.field("ordenes", int32_t(c.ordenes));
+      w.field("duplicadas", int32_t(c.duplicadas));
+      w.field("rechazadas", int32_t(c.rechazadas));
+    }
+    const size_t len = w.end();
+    if (len && mqtt_.publish(statsTopic_, reinterpret_cast<const uint8_t*>(payload_), len)) {
+      tickJitter_.reset();
+      loopLatency_.reset();
+    }
+    if constexpr (HasDriverStats<Driver>::value) {
+      PayloadWriter d(payload_, sizeof(payload_));
+      d.begin();
+      driver_.stats(d);
+      const size_t n = d.end();
+      if (n && mqtt_.publish(sensorTopic_, reinterpret_cast<const uint8_t*>(payload_), n)) driver_.statsSent();
+    }
+  }
+
+#ifdef NODE_PROFILE
+  // tiempos de cada sección en el último intervalo ("us": {"read": [p50, p99, max], ...}), pasadas por loop() por
+  //   segundo, heap libre y su mayor bloque, fragmentación, RSSI y reconexiones. El perfilador se reinicia al
+  //   publicar; si no hay conexión sigue acumulando hasta el siguiente intento.
+  void sendDiag() {
+    if (!conn_.online()) return;
+    const uint32_t now = millis();
+    const uint32_t elapsed = now - diagSinceMs_;
+    PayloadWriter w(payload_, sizeof(payload_));
+    w.begin();
+    w.field("loop_hz", int32_t(elapsed ? uint64_t(prof_.count(Profiler::Loop)) * 1000 / elapsed : 0));
+    w.field("heap", int32_t(ESP.getFreeHeap()));
+    w.field("heap_bloque", int32_t(ESP.getMaxFreeBlockSize()));
+    w.field("frag", int32_t(ESP.getHeapFragmentation()));
+    w.field("rssi", int32_t(WiFi.RSSI()));
+    w.field("reconexiones", int32_t(conn_.reconnects()));
+    w.field("sobrecoste_ciclos", int32_t(prof_.overheadCycles()));
+    w.key("us");
+    w.put('{');
+    for (uint8_t s = 0; s < Profiler::kSections; s++) {
+      if (s) w.put(',');
+      const char* name = Profiler::name(s);
+      w.put('"');
+      w.putRaw(name, strlen(name));
+      w.putRaw("\":[", 3);
+      w.putInt(int32_t(prof_.percentileUs(s, 50)));
+      w.put(',');
+      w.putInt(int32_t(prof_.percentileUs(s, 99)));
+      w.put(',');
+      w.putInt(int32_t(prof_.maxUs(s)));
+      w.put(']');
+    }
+    w.put('}');
+    const size_t len = w.end();
+    if (len && mqtt_.publish(diagTopic_, reinterpret_cast<const uint8_t*>(payload_), len)) {
+      prof_.reset();
+      diagSinceMs_ = now;
+    }
+  }
+#endif
+
+  WiFiClient wifi_;
+  NodeMqtt mqtt_{wifi_};
+  Connection conn_{wifi_, mqtt_, Driver::kClientId};
+  Driver driver_;
+  Commands<Driver> cmds_{mqtt_};
+
+  Scheduler<7> sched_;
+  Log2Histogram tickJitter_;   // retraso de las lecturas respecto a su vencimiento (us)
+  Log2Histogram loopLatency_;  // tiempo entre dos pasadas por loop() (us)
+  uint32_t lastLoopUs_ = 0;
+
+  PublishPolicy<Driver> policy_;
+  char statsTopic_[sizeof(Driver::kTopic) + 6];
+  char sensorTopic_[sizeof(Driver::kTopic) + 7];
+
+  EspFlash flash_;
+  FlashLog<EspFlash, node_config::storeSectors> log_{flash_};
+  Rules<Driver> rules_{mqtt_, cmds_, flash_};
+  Calibration<Driver> calib_{mqtt_, driver_, flash_};
+  bool logOk_ = false;
+  uint32_t replayAfterMs_ = 0;
+  uint32_t seq_ = 0; // "seq" de la próxima lectura que pase la publicación por excepción
+  static_assert(Driver::kPayloadMax <= FlashRecord::kMaxPayload + 1, "el payload no cabe en un registro de la flash");
+
+#ifdef NODE_BINARY_BATCH
+  typename Driver::Reading batch_[node_config::batchSamples];
+  uint32_t batchTs_[node_config::batchSamples];
+  uint8_t batchCount_ = 0;
+  uint16_t batchSeq_ = 0;
+  char binTopic_[sizeof(Driver::kTopic) + 4];
+  static_assert(batch::maxFrameSize(node_config::batchSamples, Driver::kFields) <= 256, "el lote no cabe en el buffer");
+#endif
+
+#ifdef NODE_PROFILE
+  Profiler prof_;
+  uint32_t diagSinceMs_ = 0;
+  char diagTopic_[sizeof(Driver::kTopic) + 5];
+  static constexpr size_t kPayloadMin = 384; // el mensaje de diagnóstico
+#else
+  // los stats con los contadores de las órdenes pueden pasar de 256
+  static constexpr size_t kPayloadMin = HasActuators<Driver>::value ? 320 : 256;
+#endif
+
+  // buffer reservado una sola vez, no en la pila de cada tick; tiene que caber también el mensaje de stats (y el lote
+  //   binario o el diagnóstico, si están activados)
+  char payload_[Driver::kPayloadMax > kPayloadMin ? Driver::kPayloadMax : kPayloadMin];
+  // el PUBLISH más grande que sale de payload_ (el topic más largo es <topic>/sensor)
+  static constexpr size_t kPacketMax = publishPacketSize(sizeof(sensorTopic_) - 1, sizeof(payload_));
+};
@@ -0,0 +1,40 @@
+// --- HORA REAL (SNTP) ---
+// millis() solo cuenta desde el arranque. Para lo que depende de la hora del día (las ventanas de las reglas, ver
+//   Rules.h) usamos el cliente SNTP del core: configTime() lo arranca y, cuando contesta el servidor, time() da la hora
+//   real con la zona horaria de NodeConfig.h. Hasta entonces minuteOfDay() devuelve -1.
+// También sirve para marcar cada lectura con la hora a la que se tomó (epochMs(), ver SensorNode.h): así el backend
+//   puede medir cuánto tarda en llegar sin depender de la hora de recepción de Node-RED.
+#pragma once
+
+#include <Arduino.h>
+#include <sys/time.h>
+#include <time.h>
+
+#include "NodeConfig.h"
+
+namespace wall_clock {
+
+constexpr time_t kMinEpoch = 1700000000; // antes de esto el SNTP aún no ha contestado (time() cuenta desde 1970)
+
+inline void begin() { configTime(node_config::timeZone, node_config::ntpServer); }
+
+inline bool synced() { return time(nullptr) > kMinEpoch; }
+
+// minuto del día en hora local (0-1439), o -1 sin hora
+inline int16_t minuteOfDay() {
+  const time_t now = time(nullptr);
+  if (now <= kMinEpoch) return -1;
+  tm t;
+  localtime_r(&now, &t);
+  return int16_t(t.tm_hour * 60 + t.tm_min);
+}
+
+// ms desde 1970 (UTC), o 0 sin hora
+inline uint64_t epochMs() {
+  timeval tv;
+  gettimeofday(&tv, nullptr);
+  if (tv.tv_sec <= kMinEpoch) return 0;
+  return uint64_t(tv.tv_sec) * 1000 + uint32_t(tv.tv_usec) / 1000;
+}
+
+}  // namespace wall_clock
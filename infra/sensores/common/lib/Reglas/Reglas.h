@@ -0,0 +1,268 @@
+// --- REGLAS DE CONTROL EN EL NODO ---
+// las reglas de "Reglas Auto" (riego si el suelo está seco, luz si está oscuro) se deciden en Node-RED: cada decisión
+//   da la vuelta nodo -> broker -> Node-RED -> broker -> nodo, y si el backend se cae no se decide nada. Aquí las reglas
+//   van compiladas a un programa pequeño que el backend manda al nodo por MQTT; el nodo lo guarda en la flash y lo
+//   evalúa tras cada lectura. Es C++ puro: lo usan el firmware (common/lib/NodeCore/Rules.h) y la herramienta del
+//   ordenador que compila y simula las reglas (infra/servicios, entorno reglas).
+//
+// Programa (little-endian), versión 1:
+//   off  tam  campo
+//   0    1    magic 0xE7
+//   1    1    versión (1)
+//   2    1    número de reglas (R, hasta kMaxRules)
+//   3    1    reservado (0)
+//   4    ...  R reglas:
+//              0  1  dispositivo (índice en kActuators del driver)
+//              1  1  reservado (0)
+//              2  2  tiempo mínimo encendido (s)
+//              4  2  tiempo mínimo apagado (s)
+//              6  2  tiempo máximo encendido (s, 0 = sin límite)
+//              8  1  bytes de la condición de encendido (A)
+//              9  1  bytes de la condición de apagado (B)
+//              10 A  condición de encendido
+//              .. B  condición de apagado
+//   ...  4    CRC-32 de todo lo anterior
+//
+// Cada condición es una expresión en notación postfija para una pila de enteros de 32 bits (ver Op). La histéresis son
+//   dos condiciones: se enciende con una (suelo < 30) y se apaga con la otra (suelo >= 50). Los tiempos mínimos evitan
+//   que el relé oscile y el máximo acota el riego aunque el sensor se estropee.
+//
+// Al cargar, Programa::cargar() recorre todo el programa (opcodes, operandos, campos y dispositivos que existen, profundidad de
+//   la pila): un programa validado no puede fallar al evaluarse, así que evaluar() no comprueba nada.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace reglas {
+
+constexpr uint8_t kMagic = 0xE7;
+constexpr uint8_t kVersion = 1;
+constexpr size_t kHeaderSize = 4;
+constexpr size_t kRuleHeader = 10;
+constexpr size_t kMaxProgram = 192; // cabe con el topic en el buffer de 256 bytes de PubSubClient
+constexpr uint8_t kMaxRules = 8;
+constexpr uint8_t kStack = 8;
+
+// --- INSTRUCCIONES ---
+enum Op : uint8_t {
+  Campo = 0x01,   // i (1 byte): mete el campo i de la lectura (las unidades de Driver::values())
+  Const16 = 0x02, // v (2 bytes, con signo)
+  Const32 = 0x03, // v (4 bytes, con signo)
+  Lt = 0x10,      // a b -> a < b
+  Le = 0x11,
+  Gt = 0x12,
+  Ge = 0x13,
+  Eq = 0x14,
+  Ne = 0x15,
+  And = 0x20,     // a b -> a && b
+  Or = 0x21,
+  Not = 0x22,     // a -> !a
+  Hora = 0x30,    // mete el minuto del día (0-1439) o -1 si el nodo aún no tiene hora
+  Ventana = 0x31, // desde hasta (2 + 2 bytes, minutos del día): 1 si la hora está en [desde, hasta); puede cruzar la
+                  //   medianoche (22:00-06:00). Sin hora, 0: una regla con ventana no actúa hasta tener hora
+  Estado = 0x32,  // d (1 byte): 1 si el dispositivo d está encendido
+  Desde = 0x33,   // d (1 byte): segundos desde el último cambio del dispositivo d
+};
+
+enum Error : uint8_t { Ok, Formato, Version, Crc, Opcode, Pila, CampoMal, DispositivoMal, Tamano };
+
+inline const char* nombreError(Error e) {
+  static const char* const kNombres[] = {"ok",   "formato", "versión",     "crc",   "opcode",
+                                         "pila", "campo",   "dispositivo", "tamaño"};
+  return kNombres[e];
+}
+
+// CRC-32 (polinomio 0xEDB88320) bit a bit: se calcula al recibir o cargar un programa, no en cada evaluación
+inline uint32_t crc32(const uint8_t* p, size_t n) {
+  uint32_t crc = 0xFFFFFFFF;
+  for (size_t i = 0; i < n; i++) {
+    crc ^= p[i];
+    for (uint8_t k = 0; k < 8; k++) crc = crc & 1 ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+  }
+  return ~crc;
+}
+
+inline uint16_t rd16(const uint8_t* p) { return uint16_t(p[0] | p[1] << 8); }
+inline uint32_t rd32(const uint8_t* p) {
+  return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+struct Regla {
+  uint8_t dispositivo;
+  uint16_t minOnS;
+  uint16_t minOffS;
+  uint16_t maxOnS;
+  const uint8_t* on;
+  uint8_t onLen;
+  const uint8_t* off;
+  uint8_t offLen;
+};
+
+// lo que pueden consultar las condiciones
+struct Entorno {
+  const int32_t* campos;
+  int16_t minutoDia;      // -1 = sin hora
+  uint8_t encendidos;     // bit d: el dispositivo d está encendido
+  const uint32_t* desdeS; // segundos desde el último cambio de cada dispositivo
+};
+
+// recorre una condición comprobando opcodes, operandos y pila; termina con un único valor
+inline Error validarExpr(const uint8_t* c, size_t n, uint8_t campos, uint8_t dispositivos) {
+  uint8_t depth = 0;
+  size_t i = 0;
+  while (i < n) {
+    const uint8_t op = c[i++];
+    size_t operandos = 0;
+    int8_t delta = 0;
+    switch (op) {
+      case Campo:
+        if (i >= n) return Formato;
+        if (c[i] >= campos) return CampoMal;
+        operandos = 1;
+        delta = 1;
+        break;
+      case Const16: operandos = 2; delta = 1; break;
+      case Const32: operandos = 4; delta = 1; break;
+      case Lt: case Le: case Gt: case Ge: case Eq: case Ne: case And: case Or: delta = -1; break;
+      case Not: delta = 0; break;
+      case Hora: delta = 1; break;
+      case Ventana:
+        if (i + 4 > n) return Formato;
+        if (rd16(c + i) >= 1440 || rd16(c + i + 2) >= 1440) return Formato;
+        operandos = 4;
+        delta = 1;
+        break;
+      case Estado:
+      case Desde:
+        if (i >= n) return Formato;
+        if (c[i] >= dispositivos) return DispositivoMal;
+        operandos = 1;
+        delta = 1;
+        break;
+      default: return Opcode;
+    }
+    if (i + operandos > n) return Formato;
+    // los binarios necesitan dos valores y Not uno
+    const uint8_t necesita = delta < 0 ? 2 : (op == Not ? 1 : 0);
+    if (depth < necesita) return Pila;
+    depth = uint8_t(depth + delta);
+    if (depth > kStack) return Pila;
+    i += operandos;
+  }
+  return depth == 1 ? Ok : Pila;
+}
+
+// evalúa una condición ya validada
+inline int32_t evaluar(const uint8_t* c, uint8_t n, const Entorno& e) {
+  int32_t st[kStack];
+  uint8_t sp = 0;
+  uint8_t i = 0;
+  while (i < n) {
+    const uint8_t op = c[i++];
+    switch (op) {
+      case Campo: st[sp++] = e.campos[c[i++]]; break;
+      case Const16:
+        st[sp++] = int16_t(rd16(c + i));
+        i += 2;
+        break;
+      case Const32:
+        st[sp++] = int32_t(rd32(c + i));
+        i += 4;
+        break;
+      case Hora: st[sp++] = e.minutoDia; break;
+      case Ventana: {
+        const int32_t desde = rd16(c + i), hasta = rd16(c + i + 2), m = e.minutoDia;
+        i += 4;
+        st[sp++] = m >= 0 && (desde <= hasta ? (m >= desde && m < hasta) : (m >= desde || m < hasta));
+        break;
+      }
+      case Estado: st[sp++] = (e.encendidos >> c[i++]) & 1; break;
+      case Desde: {
+        const uint32_t d = e.desdeS[c[i++]];
+        st[sp++] = int32_t(d > 0x7FFFFFFF ? 0x7FFFFFFF : d);
+        break;
+      }
+      case Not: st[sp - 1] = !st[sp - 1]; break;
+      default: {
+        const int32_t b = st[--sp], a = st[sp - 1];
+        int32_t r = 0;
+        switch (op) {
+          case Lt: r = a < b; break;
+          case Le: r = a <= b; break;
+          case Gt: r = a > b; break;
+          case Ge: r = a >= b; break;
+          case Eq: r = a == b; break;
+          case Ne: r = a != b; break;
+          case And: r = a && b; break;
+          case Or: r = a || b; break;
+        }
+        st[sp - 1] = r;
+      }
+    }
+  }
+  return st[0];
+}
+
+// qué hace una regla con su dispositivo: 1 encender, 0 apagar, -1 nada. Los tiempos mínimos cuentan desde el último
+//   cambio de la salida, lo haya hecho una regla o una orden por MQTT.
+inline int8_t decidir(const Regla& r, const Entorno& e) {
+  const bool on = (e.encendidos >> r.dispositivo) & 1;
+  const uint32_t desde = e.desdeS[r.dispositivo];
+  if (!on) return desde >= r.minOffS && evaluar(r.on, r.onLen, e) ? 1 : -1;
+  if (r.maxOnS && desde >= r.maxOnS) return 0;
+  return desde >= r.minOnS && evaluar(r.off, r.offLen, e) ? 0 : -1;
+}
+
+// --- PROGRAMA ---
+// no copia los bytes: el que llama los mantiene mientras use el programa
+class Programa {
+ public:
+  // valida el programa para un nodo con esos campos y dispositivos; si no es válido, el programa queda vacío
+  Error cargar(const uint8_t* p, size_t n, uint8_t campos, uint8_t dispositivos) {
+    count_ = 0;
+    crc_ = 0;
+    if (n > kMaxProgram) return Tamano;
+    if (n < kHeaderSize + 4 || p[0] != kMagic) return Formato;
+    if (p[1] != kVersion) return Version;
+    if (rd32(p + n - 4) != crc32(p, n - 4)) return Crc;
+    const uint8_t r = p[2];
+    if (r > kMaxRules) return Tamano;
+    size_t off = kHeaderSize;
+    for (uint8_t k = 0; k < r; k++) {
+      if (off + kRuleHeader > n - 4) return Formato;
+      Regla& x = reglas_[k];
+      x.dispositivo = p[off];
+      if (x.dispositivo >= dispositivos) return DispositivoMal;
+      x.minOnS = rd16(p + off + 2);
+      x.minOffS = rd16(p + off + 4);
+      x.maxOnS = rd16(p + off + 6);
+      x.onLen = p[off + 8];
+      x.offLen = p[off + 9];
+      off += kRuleHeader;
+      if (off + x.onLen + x.offLen > n - 4) return Formato;
+      x.on = p + off;
+      x.off = p + off + x.onLen;
+      Error e = validarExpr(x.on, x.onLen, campos, dispositivos);
+      if (e == Ok) e = validarExpr(x.off, x.offLen, campos, dispositivos);
+      if (e != Ok) return e;
+      off += x.onLen + x.offLen;
+    }
+    if (off != n - 4) return Formato;
+    count_ = r;
+    crc_ = rd32(p + n - 4);
+    return Ok;
+  }
+
+  uint8_t reglas() const { return count_; }
+  const Regla& regla(uint8_t i) const { return reglas_[i]; }
+  // identifica la versión del programa (el backend la ve en el estado de las reglas)
+  uint32_t crc() const { return crc_; }
+
+ private:
+  Regla reglas_[kMaxRules];
+  uint8_t count_ = 0;
+  uint32_t crc_ = 0;
+};
+
+}  // namespace reglas
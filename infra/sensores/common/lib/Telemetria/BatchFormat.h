@@ -0,0 +1,200 @@
+// --- FORMATO BINARIO DE TELEMETRÍA POR LOTES ---
+// formato opcional (se activa con -DNODE_BINARY_BATCH) que empaqueta varias lecturas en un solo mensaje MQTT en
+//   lugar de un JSON de ~30 bytes por lectura. Es C++ puro (sin Arduino): lo compilan tanto los nodos, que codifican,
+//   como los servicios del ordenador (infra/servicios), que decodifican.
+//
+// Trama (little-endian), versión 1:
+//   off  tam  campo
+//   0    1    magic 0xB7
+//   1    1    versión (1)
+//   2    1    tipo de sensor (SensorType)
+//   3    1    campos por muestra (F)
+//   4    1    número de muestras (N)
+//   5    4    id del nodo (ESP.getChipId())
+//   9    2    número de lote (crece en cada envío; sirve para detectar lotes perdidos)
+//   11   4    ts base: millis() del nodo en la primera muestra
+//   15   ...  N muestras: varint(delta de ts en ms respecto a la anterior; la primera respecto a la base)
+//                         y F x varint(zigzag(delta del campo respecto a la muestra anterior; la primera respecto a 0))
+//
+// Los valores van en las unidades enteras del driver (centésimas en el DHT11; ver kSensorInfo para la escala). Como
+//   entre lecturas seguidas los valores y los intervalos apenas cambian, la mayoría de deltas ocupan un solo byte.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum class SensorType : uint8_t { Dht11 = 1, Soil = 2, Ldr = 3, Mq135 = 4 };
+
+namespace batch {
+
+constexpr uint8_t kMagic = 0xB7;
+constexpr uint8_t kVersion = 1;
+constexpr size_t kHeaderSize = 15;
+constexpr uint8_t kMaxFields = 4;
+constexpr uint8_t kMaxSamples = 64;
+
+// tamaño máximo de una trama: cabecera + N x (ts + F campos), con varints de hasta 5 bytes
+constexpr size_t maxFrameSize(uint8_t samples, uint8_t fields) { return kHeaderSize + size_t(samples) * (1 + fields) * 5; }
+
+// --- DESCRIPCIÓN DE CADA SENSOR ---
+// cómo se traduce cada campo a la telemetría normalizada greenhouse/<nodo>/telemetry que generan hoy las funciones
+//   *_to_telemetry de Node-RED
+struct FieldInfo {
+  const char* type;  // "temp", "hum", "soil", "light", "aire"
+  uint16_t scale;    // valor publicado = valor entero / scale
+};
+
+struct SensorInfo {
+  SensorType id;
+  const char* rawTopic;        // topic del JSON original ("dht11", "soil", ...)
+  const char* telemetryTopic;  // topic normalizado
+  uint8_t fields;
+  FieldInfo field[kMaxFields];
+};
+
+constexpr SensorInfo kSensorInfo[] = {
+    {SensorType::Dht11, "dht11", "greenhouse/node1/telemetry", 2, {{"temp", 100}, {"hum", 100}}},
+    {SensorType::Soil, "soil", "greenhouse/node2/telemetry", 1, {{"soil", 1}}},
+    {SensorType::Ldr, "ldr", "greenhouse/node3/telemetry", 1, {{"light", 1}}},
+    {SensorType::Mq135, "mq135", "greenhouse/node4/telemetry", 1, {{"aire", 1}}},
+};
+
+inline const SensorInfo* sensorInfo(uint8_t id) {
+  for (const SensorInfo& s : kSensorInfo) {
+    if (uint8_t(s.id) == id) return &s;
+  }
+  return nullptr;
+}
+
+// --- VARINTS ---
+inline uint32_t zigzag(int32_t v) { return (uint32_t(v) << 1) ^ uint32_t(v >> 31); }
+inline int32_t unzigzag(uint32_t v) { return int32_t(v >> 1) ^ -int32_t(v & 1); }
+
+inline size_t putVarint(uint8_t* out, uint32_t v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    out[n++] = uint8_t(v | 0x80);
+    v >>= 7;
+  }
+  out[n++] = uint8_t(v);
+  return n;
+}
+
+// devuelve los bytes leídos o 0 si el varint está cortado o es demasiado largo
+inline size_t getVarint(const uint8_t* in, size_t avail, uint32_t& v) {
+  v = 0;
+  for (size_t i = 0; i < avail && i < 5; i++) {
+    v |= uint32_t(in[i] & 0x7F) << (7 * i);
+    if (!(in[i] & 0x80)) return i + 1;
+  }
+  return 0;
+}
+
+inline void putU16(uint8_t* p, uint16_t v) {
+  p[0] = uint8_t(v);
+  p[1] = uint8_t(v >> 8);
+}
+inline void putU32(uint8_t* p, uint32_t v) {
+  for (uint8_t i = 0; i < 4; i++) p[i] = uint8_t(v >> (8 * i));
+}
+inline uint16_t getU16(const uint8_t* p) { return uint16_t(p[0] | p[1] << 8); }
+inline uint32_t getU32(const uint8_t* p) {
+  return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+struct Header {
+  SensorType type;
+  uint8_t fields;
+  uint8_t samples;
+  uint32_t nodeId;
+  uint16_t seq;
+  uint32_t baseTs;
+};
+
+struct Sample {
+  uint32_t ts; // millis() del nodo
+  int32_t value[kMaxFields];
+};
+
+// --- CODIFICADOR ---
+// escribe la trama directamente en el buffer del llamante, muestra a muestra
+class Encoder {
+ public:
+  Encoder(uint8_t* buf, size_t cap) : buf_(buf), cap_(cap) {}
+
+  bool begin(SensorType type, uint8_t fields, uint32_t nodeId, uint16_t seq, uint32_t baseTs) {
+    if (cap_ < kHeaderSize || fields > kMaxFields) return false;
+    buf_[0] = kMagic;
+    buf_[1] = kVersion;
+    buf_[2] = uint8_t(type);
+    buf_[3] = fields;
+    buf_[4] = 0;
+    putU32(buf_ + 5, nodeId);
+    putU16(buf_ + 9, seq);
+    putU32(buf_ + 11, baseTs);
+    fields_ = fields;
+    len_ = kHeaderSize;
+    lastTs_ = baseTs;
+    for (uint8_t f = 0; f < kMaxFields; f++) last_[f] = 0;
+    return true;
+  }
+
+  // añade una muestra; false si no cabe (la trama sigue siendo válida con las anteriores)
+  bool add(uint32_t ts, const int32_t* values) {
+    if (buf_[4] >= kMaxSamples || len_ + size_t(1 + fields_) * 5 > cap_) return false;
+    len_ += putVarint(buf_ + len_, ts - lastTs_);
+    lastTs_ = ts;
+    for (uint8_t f = 0; f < fields_; f++) {
+      len_ += putVarint(buf_ + len_, zigzag(values[f] - last_[f]));
+      last_[f] = values[f];
+    }
+    buf_[4]++;
+    return true;
+  }
+
+  size_t length() const { return len_; }
+  uint8_t samples() const { return buf_[4]; }
+
+ private:
+  uint8_t* buf_;
+  size_t cap_;
+  size_t len_ = 0;
+  uint8_t fields_ = 0;
+  uint32_t lastTs_ = 0;
+  int32_t last_[kMaxFields] = {};
+};
+
+// --- DECODIFICADOR ---
+// valida la cabecera y expande las muestras; devuelve cuántas ha escrito en out (0 si la trama no es válida)
+inline size_t decode(const uint8_t* in, size_t len, Header& h, Sample* out, size_t maxOut) {
+  if (len < kHeaderSize || in[0] != kMagic || in[1] != kVersion) return 0;
+  h.type = SensorType(in[2]);
+  h.fields = in[3];
+  h.samples = in[4];
+  h.nodeId = getU32(in + 5);
+  h.seq = getU16(in + 9);
+  h.baseTs = getU32(in + 11);
+  if (h.fields > kMaxFields || h.samples > maxOut) return 0;
+
+  size_t pos = kHeaderSize;
+  uint32_t ts = h.baseTs;
+  int32_t last[kMaxFields] = {};
+  for (uint8_t i = 0; i < h.samples; i++) {
+    uint32_t v;
+    size_t n = getVarint(in + pos, len - pos, v);
+    if (!n) return 0;
+    pos += n;
+    ts += v;
+    out[i].ts = ts;
+    for (uint8_t f = 0; f < h.fields; f++) {
+      n = getVarint(in + pos, len - pos, v);
+      if (!n) return 0;
+      pos += n;
+      last[f] += unzigzag(v);
+      out[i].value[f] = last[f];
+    }
+  }
+  return pos == len ? h.samples : 0;
+}
+
+}  // namespace batch
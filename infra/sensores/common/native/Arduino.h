@@ -0,0 +1,333 @@
+// --- MOCK DE ARDUINO (ENTORNO NATIVE) ---
+// este fichero sustituye al core de Arduino del ESP8266 cuando compilamos los nodos en el ordenador (env:native).
+//   Solo implementa lo que usan los nodos: tiempo simulado, analogRead(), Serial y algunas macros del core.
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <sys/time.h>
+#include <functional>
+#include <thread>
+
+#define IRAM_ATTR
+#define ICACHE_RAM_ATTR
+#define A0 17
+
+using std::isnan;
+
+namespace mock {
+// --- TIEMPO SIMULADO ---
+// el tiempo no avanza solo: lo avanza arduino_main.cpp (o quien use el mock) con mock::advance()
+inline uint32_t nowMs = 0;
+inline uint32_t nowUs = 0;
+// hora de pared: también sigue al tiempo simulado. Empieza en la hora del sistema al arrancar el programa y avanza
+//   con advance() y con los deep sleep (reboot()); time() y gettimeofday() la dan una vez llamado configTime().
+inline uint64_t relojMs = 0;
+inline const uint64_t epochInicioMs = [] {
+  timespec t;
+  clock_gettime(CLOCK_REALTIME, &t);
+  return uint64_t(t.tv_sec) * 1000 + uint64_t(t.tv_nsec) / 1000000;
+}();
+inline bool sntp = false;
+inline uint64_t epochMs() { return epochInicioMs + relojMs; }
+
+// --- ADC ---
+// valor fijo del A0 o, si se define, una función que devuelve la muestra (para reproducir trazas)
+inline int adcValue = 512;
+inline std::function<int()> adcSource;
+
+// dispara los tickers registrados; Ticker.h lo engancha al crear el primero (sin Ticker.h no hay nada que disparar)
+inline void (*tickHook)() = nullptr;
+
+// con un broker de verdad al otro lado (-DNODE_ASYNC_MQTT, ver ESP8266WiFi.h) delay() también espera de verdad
+inline bool realTime = false;
+
+inline void advance(uint32_t ms) {
+  for (uint32_t i = 0; i < ms; i++) {
+    nowMs++;
+    nowUs += 1000;
+    relojMs++;
+    if (tickHook) tickHook();
+  }
+}
+}  // namespace mock
+
+inline uint32_t millis() { return mock::nowMs; }
+inline uint32_t micros() { return mock::nowUs; }
+inline void delay(uint32_t ms) {
+  mock::advance(ms);
+  if (mock::realTime) std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+inline void yield() {}
+
+inline int analogRead(uint8_t) {
+  return mock::adcSource ? mock::adcSource() : mock::adcValue;
+}
+
+// --- GPIO E INTERRUPCIONES ---
+// solo lo que hace falta para simular un DHT11 en el bus: un pin que el programa tiene a LOW al menos 18 ms y luego
+//   suelta (INPUT/INPUT_PULLUP) con una interrupción enganchada recibe la respuesta del sensor. Los flancos se
+//   entregan todos en el momento de soltar, cada uno con micros() puesto a su instante (y luego se restaura).
+//   La respuesta sale de mock::dhtTemp/dhtHum (NAN = el sensor no contesta) o, si se define, de mock::dhtTrain
+//   (instantes de los flancos de bajada en us desde que se suelta la línea, para reproducir capturas).
+#define INPUT 0x00
+#define OUTPUT 0x01
+#define INPUT_PULLUP 0x02
+#define LOW 0x0
+#define HIGH 0x1
+#define RISING 0x01
+#define FALLING 0x02
+#define CHANGE 0x03
+
+namespace mock {
+constexpr uint8_t kPins = 18;
+inline void (*isr[kPins])() = {};
+inline uint8_t isrMode[kPins] = {};
+inline uint8_t pinLevels[kPins];
+inline uint8_t pinModes[kPins] = {};
+inline bool pinsInit = [] { std::memset(pinLevels, HIGH, sizeof(pinLevels)); return true; }();
+inline uint32_t lowSinceUs[kPins] = {};
+
+inline float dhtTemp = 23.5f;
+inline float dhtHum = 55.0f;
+inline std::function<size_t(uint32_t* edgesUs, size_t max)> dhtTrain;
+inline uint32_t dhtRequests = 0;
+
+// flancos de bajada de una respuesta del DHT11 sin errores: inicio de la respuesta (80 us a LOW + 80 a HIGH), 40 bits
+//   (50 us a LOW + 26 us a HIGH un 0, 70 us un 1) y el LOW final
+inline size_t dhtNominal(uint32_t* edgesUs, size_t max) {
+  if (std::isnan(dhtTemp) || std::isnan(dhtHum) || max < 42) return 0;
+  const float t = std::fabs(dhtTemp);
+  const uint8_t d[4] = {uint8_t(dhtHum), uint8_t(std::lround((dhtHum - std::floor(dhtHum)) * 10)), uint8_t(t),
+                        uint8_t(std::lround((t - std::floor(t)) * 10) | (dhtTemp < 0 ? 0x80 : 0))};
+  const uint8_t bytes[5] = {d[0], d[1], d[2], d[3], uint8_t(d[0] + d[1] + d[2] + d[3])};
+  uint32_t at = 30; // la línea sube con el pull-up y el sensor tarda 20-40 us en contestar
+  size_t n = 0;
+  edgesUs[n++] = at;
+  at += 160;
+  for (uint8_t i = 0; i < 40; i++) {
+    edgesUs[n++] = at;
+    at += (bytes[i / 8] >> (7 - i % 8) & 1) ? 120 : 76;
+  }
+  edgesUs[n++] = at;
+  return n;
+}
+
+inline void release(uint8_t pin) {
+  const bool wasLow = pinModes[pin] == OUTPUT && pinLevels[pin] == LOW;
+  if (!wasLow || nowUs - lowSinceUs[pin] < 18000 || !isr[pin] || !(isrMode[pin] & FALLING)) return;
+  dhtRequests++;
+  uint32_t edges[96];
+  const size_t n = dhtTrain ? dhtTrain(edges, 96) : dhtNominal(edges, 96);
+  const uint32_t base = nowUs;
+  for (size_t i = 0; i < n && isr[pin]; i++) {
+    nowUs = base + edges[i];
+    isr[pin]();
+  }
+  nowUs = base;
+}
+}  // namespace mock
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+  if (pin >= mock::kPins) return;
+  if (mode != OUTPUT) {
+    mock::release(pin);
+    mock::pinLevels[pin] = HIGH; // la línea la sube el pull-up
+  }
+  mock::pinModes[pin] = mode;
+}
+inline void digitalWrite(uint8_t pin, uint8_t v) {
+  if (pin >= mock::kPins) return;
+  if (v == LOW && mock::pinLevels[pin] != LOW) mock::lowSinceUs[pin] = mock::nowUs;
+  mock::pinLevels[pin] = v;
+}
+// PWM: solo se apunta el valor por pin (en el rango de analogWriteRange(), 1023 por defecto como en el core)
+namespace mock {
+inline uint16_t pwmValues[kPins] = {};
+inline uint32_t pwmRange = 1023;
+}  // namespace mock
+inline void analogWriteRange(uint32_t range) { mock::pwmRange = range; }
+inline void analogWrite(uint8_t pin, int v) {
+  if (pin >= mock::kPins) return;
+  const uint32_t u = v < 0 ? 0 : uint32_t(v);
+  mock::pwmValues[pin] = uint16_t(u > mock::pwmRange ? mock::pwmRange : u);
+}
+inline int digitalRead(uint8_t pin) { return pin < mock::kPins ? mock::pinLevels[pin] : HIGH; }
+inline uint8_t digitalPinToInterrupt(uint8_t pin) { return pin; }
+inline void attachInterrupt(uint8_t irq, void (*fn)(), int mode) {
+  if (irq >= mock::kPins) return;
+  mock::isr[irq] = fn;
+  mock::isrMode[irq] = uint8_t(mode);
+}
+inline void detachInterrupt(uint8_t irq) {
+  if (irq < mock::kPins) mock::isr[irq] = nullptr;
+}
+
+// SNTP: contesta al momento. Aplica la zona horaria y, desde entonces, time() y gettimeofday() dan mock::epochMs();
+//   antes, como en el core, cuentan desde el arranque. Sustituyen a los de la libc en todo el programa.
+inline void configTime(const char* tz, const char*) {
+  setenv("TZ", tz, 1);
+  tzset();
+  mock::sntp = true;
+}
+extern "C" inline time_t time(time_t* t) noexcept {
+  const time_t s = mock::sntp ? time_t(mock::epochMs() / 1000) : time_t(mock::nowMs / 1000);
+  if (t) *t = s;
+  return s;
+}
+extern "C" inline int gettimeofday(timeval* __restrict tv, void* __restrict) noexcept {
+  const uint64_t ms = mock::sntp ? mock::epochMs() : mock::nowMs;
+  tv->tv_sec = time_t(ms / 1000);
+  tv->tv_usec = suseconds_t(ms % 1000 * 1000);
+  return 0;
+}
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// random() del core usa el generador hardware del ESP8266; aquí basta con uno determinista
+inline uint32_t mockRandState = 12345;
+inline long random(long max) {
+  mockRandState = mockRandState * 1103515245u + 12345u;
+  return max > 0 ? long((mockRandState >> 8) % uint32_t(max)) : 0;
+}
+inline long random(long min, long max) { return min + random(max - min); }
+inline void randomSeed(uint32_t seed) { mockRandState = seed; }
+
+template <typename T, typename L, typename H>
+inline T constrain(T x, L lo, H hi) {
+  return x < lo ? lo : (x > hi ? hi : x);
+}
+
+// --- IPAddress ---
+class IPAddress {
+ public:
+  IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : b_{a, b, c, d} {}
+  IPAddress(uint32_t v) : b_{uint8_t(v), uint8_t(v >> 8), uint8_t(v >> 16), uint8_t(v >> 24)} {}
+  uint8_t operator[](int i) const { return b_[i]; }
+  uint32_t v4() const { return uint32_t(b_[0]) | uint32_t(b_[1]) << 8 | uint32_t(b_[2]) << 16 | uint32_t(b_[3]) << 24; }
+ private:
+  uint8_t b_[4];
+};
+
+// --- ESP ---
+// modos de la radio al despertar del deep sleep (como en el core)
+enum RFMode { RF_DEFAULT = 0, RF_CAL = 1, RF_NO_CAL = 2, RF_DISABLED = 4 };
+#define WAKE_RF_DEFAULT RF_DEFAULT
+#define WAKE_RF_DISABLED RF_DISABLED
+
+// memoria RTC de usuario (512 bytes): sobrevive al deep sleep. Empieza con basura, como tras conectar la batería.
+//   ESP.deepSleep() no reinicia nada: apunta lo pedido en mock::sleepUs/sleepMode y vuelve. Quien simule los
+//   despertares llama a mock::reboot() y crea el nodo de nuevo (la RAM del programa se pierde al despertar).
+namespace mock {
+constexpr size_t kRtcUserSize = 512;
+inline uint8_t rtcMemory[kRtcUserSize];
+inline bool rtcInit = [] { for (size_t i = 0; i < kRtcUserSize; i++) rtcMemory[i] = uint8_t(i * 37 + 11); return true; }();
+inline uint64_t sleepUs = 0;
+inline RFMode sleepMode = RF_DEFAULT;
+inline uint32_t deepSleeps = 0;
+
+inline void reboot() {
+  nowMs = 0;
+  nowUs = 0;
+  relojMs += sleepUs / 1000;
+  sntp = false;  // la hora del SNTP no sobrevive al deep sleep
+}
+}  // namespace mock
+
+// flash simulada: se comporta como la real (al escribir solo se pueden pasar bits de 1 a 0, hay que borrar sectores
+//   de 4 KB) y cuenta los borrados de cada sector para poder comprobar el desgaste. mock::flashFail simula fallos.
+namespace mock {
+constexpr uint32_t kFlashSize = 256 * 1024;
+inline uint8_t flash[kFlashSize];
+inline uint32_t flashErases[kFlashSize / 0x1000];
+inline bool flashFail = false;
+inline bool flashInit = [] { std::memset(flash, 0xFF, sizeof(flash)); return true; }();
+
+// heap que devuelven ESP.getFreeHeap() y compañía (lo que suele quedar libre en un nodo con WiFi y MQTT)
+inline uint32_t freeHeap = 41000;
+inline uint32_t maxFreeBlock = 38000;
+inline uint8_t heapFragmentation = 7;
+}  // namespace mock
+
+class EspClass {
+ public:
+  uint32_t getChipId() { return 0x00C0FFEE; }
+
+  // el contador de ciclos no sigue el tiempo simulado sino el real del ordenador, como si fuera un ESP8266 a 80 MHz:
+  //   así el perfilador mide lo que cuesta de verdad el código (en esta CPU)
+  uint32_t getCycleCount() {
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    return uint32_t(uint64_t(ns) * 80 / 1000);
+  }
+  uint8_t getCpuFreqMHz() { return 80; }
+  uint32_t getFreeHeap() { return mock::freeHeap; }
+  uint32_t getMaxFreeBlockSize() { return mock::maxFreeBlock; }
+  uint8_t getHeapFragmentation() { return mock::heapFragmentation; }
+
+  bool flashEraseSector(uint32_t sector) {
+    if (mock::flashFail || sector >= mock::kFlashSize / 0x1000) return false;
+    std::memset(mock::flash + sector * 0x1000, 0xFF, 0x1000);
+    mock::flashErases[sector]++;
+    return true;
+  }
+  bool flashWrite(uint32_t addr, const uint32_t* data, size_t size) {
+    if (mock::flashFail || (addr & 3) || (size & 3) || addr + size > mock::kFlashSize) return false;
+    const uint8_t* src = reinterpret_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) mock::flash[addr + i] &= src[i];
+    return true;
+  }
+  bool flashRead(uint32_t addr, uint32_t* data, size_t size) {
+    if ((addr & 3) || addr + size > mock::kFlashSize) return false;
+    std::memcpy(data, mock::flash + addr, size);
+    return true;
+  }
+
+  // offset en bloques de 4 bytes, como en el core
+  bool rtcUserMemoryRead(uint32_t offset, uint32_t* data, size_t size) {
+    if (offset * 4 + size > mock::kRtcUserSize || !size) return false;
+    std::memcpy(data, mock::rtcMemory + offset * 4, size);
+    return true;
+  }
+  bool rtcUserMemoryWrite(uint32_t offset, uint32_t* data, size_t size) {
+    if (offset * 4 + size > mock::kRtcUserSize || !size) return false;
+    std::memcpy(mock::rtcMemory + offset * 4, data, size);
+    return true;
+  }
+
+  void deepSleep(uint64_t timeUs, RFMode mode = RF_DEFAULT) {
+    mock::sleepUs = timeUs;
+    mock::sleepMode = mode;
+    mock::deepSleeps++;
+  }
+};
+inline EspClass ESP;
+
+// --- SERIAL ---
+// imprime por stdout; se puede silenciar con Serial.quiet = true para que no moleste en los benchmarks
+class MockSerial {
+ public:
+  bool quiet = false;
+  void begin(unsigned long) {}
+  void print(const char* s) { if (!quiet) std::fputs(s, stdout); }
+  void print(char c) { if (!quiet) std::fputc(c, stdout); }
+  void print(int v) { if (!quiet) std::printf("%d", v); }
+  void print(unsigned v) { if (!quiet) std::printf("%u", v); }
+  void print(long v) { if (!quiet) std::printf("%ld", v); }
+  void print(unsigned long v) { if (!quiet) std::printf("%lu", v); }
+  void print(double v) { if (!quiet) std::printf("%.2f", v); }
+  void print(const IPAddress& ip) {
+    if (!quiet) std::printf("%d.%d.%d.%d", ip[0], ip[1], ip[2], ip[3]);
+  }
+  template <typename T>
+  void println(T v) { print(v); print('\n'); }
+  void println() { print('\n'); }
+};
+inline MockSerial Serial;
@@ -0,0 +1,183 @@
+// --- MOCK DE ESP8266WiFi ---
+// la WiFi del mock está "conectada" salvo que el ejecutable la tire con mock::wifiUp = false.
+//   Para simular el deep sleep, mock::wifiAssocMs y mock::wifiFastAssocMs dan lo que tarda la asociación normal
+//   (escaneo + DHCP) y la rápida (con canal y BSSID); por defecto 0. Si el canal o el BSSID que se pasan a begin() no
+//   son los del punto de acceso (mock::apChannel, mock::apBssid), la asociación rápida no llega a conectar.
+#pragma once
+
+#include <Arduino.h>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+
+#define WL_CONNECTED 3
+#define WL_DISCONNECTED 6
+#define WIFI_OFF 0
+#define WIFI_STA 1
+
+namespace mock {
+inline bool wifiUp = true;
+inline uint32_t wifiAssocMs = 0;
+inline uint32_t wifiFastAssocMs = 0;
+inline int32_t apChannel = 6;
+inline uint8_t apBssid[6] = {0x24, 0x0A, 0xC4, 0x12, 0x34, 0x56};
+inline int32_t rssi = -62;
+}  // namespace mock
+
+class MockWiFi {
+ public:
+  void mode(int) {}
+  void persistent(bool) {}
+
+  void begin(const char*, const char*) { start(mock::wifiAssocMs, true); }
+  void begin(const char*, const char*, int32_t channel, const uint8_t* bssid) {
+    const bool match = channel == mock::apChannel && bssid && std::memcmp(bssid, mock::apBssid, 6) == 0;
+    start(mock::wifiFastAssocMs, match);
+  }
+  bool config(IPAddress local, IPAddress gateway, IPAddress subnet) {
+    staticIp_ = local.v4() != 0;
+    ip_ = local;
+    gateway_ = gateway;
+    subnet_ = subnet;
+    return true;
+  }
+  bool disconnect(bool = false) {
+    begun_ = false;
+    return true;
+  }
+
+  int status() const {
+    const bool associated = begun_ && reachable_ && millis() - beginMs_ >= assocMs_;
+    return mock::wifiUp && associated ? WL_CONNECTED : WL_DISCONNECTED;
+  }
+  IPAddress localIP() const { return staticIp_ ? ip_ : IPAddress(192, 168, 1, 57); }
+  IPAddress gatewayIP() const { return staticIp_ ? gateway_ : IPAddress(192, 168, 1, 1); }
+  IPAddress subnetMask() const { return staticIp_ ? subnet_ : IPAddress(255, 255, 255, 0); }
+  const uint8_t* BSSID() const { return mock::apBssid; }
+  int32_t channel() const { return mock::apChannel; }
+  int32_t RSSI() const { return status() == WL_CONNECTED ? mock::rssi : 31; } // 31: sin conexión, como en el core
+
+ private:
+  void start(uint32_t assocMs, bool reachable) {
+    begun_ = true;
+    reachable_ = reachable;
+    beginMs_ = millis();
+    assocMs_ = assocMs;
+  }
+
+  bool begun_ = false;
+  bool reachable_ = false;
+  uint32_t beginMs_ = 0;
+  uint32_t assocMs_ = 0;
+  bool staticIp_ = false;
+  IPAddress ip_, gateway_, subnet_;
+};
+inline MockWiFi WiFi;
+
+// --- CLIENTE TCP ---
+// PubSubClient se simula entero y no lo usa. AsyncMqtt (-DNODE_ASYNC_MQTT) sí, y aquí es un socket de verdad, no
+//   bloqueante como el de lwIP, así que el nodo native puede hablar con un broker real (o con el de bench/src/mqtt.cpp).
+//   mock::tcpSendBuffer fija el SO_SNDBUF del socket (0 = el del sistema) para parecerse a los ~3 KB del ESP8266.
+namespace mock {
+inline int tcpSendBuffer = 0;
+}  // namespace mock
+
+class WiFiClient {
+ public:
+  WiFiClient() = default;
+  WiFiClient(const WiFiClient&) = delete;
+  WiFiClient& operator=(const WiFiClient&) = delete;
+  ~WiFiClient() { stop(); }
+
+  void setTimeout(unsigned long ms) { timeoutMs_ = ms; }
+
+  int connect(const char* host, uint16_t port) {
+    stop();
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* res = nullptr;
+    char service[8];
+    std::snprintf(service, sizeof(service), "%u", port);
+    if (!host || getaddrinfo(host, service, &hints, &res) != 0) return 0;
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd_ >= 0 && mock::tcpSendBuffer > 0) {
+      setsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &mock::tcpSendBuffer, sizeof(mock::tcpSendBuffer));
+    }
+    // el connect() espera como mucho setTimeout(), como el del core
+    timeval tv{long(timeoutMs_ / 1000), long(timeoutMs_ % 1000) * 1000};
+    if (fd_ >= 0) setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    const bool ok = fd_ >= 0 && ::connect(fd_, res->ai_addr, res->ai_addrlen) == 0;
+    freeaddrinfo(res);
+    if (!ok) {
+      stop();
+      return 0;
+    }
+    fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+    closed_ = false;
+    return 1;
+  }
+
+  // bytes que caben ahora en el buffer de envío
+  int availableForWrite() {
+    if (fd_ < 0 || closed_) return 0;
+    int sndbuf = 0, queued = 0;
+    socklen_t len = sizeof(sndbuf);
+    getsockopt(fd_, SOL_SOCKET, SO_SNDBUF, &sndbuf, &len);
+    ioctl(fd_, TIOCOUTQ, &queued);
+    // Linux reserva la mitad de SO_SNDBUF para sus estructuras
+    const int room = sndbuf / 2 - queued;
+    return room > 0 ? room : 0;
+  }
+
+  size_t write(const uint8_t* p, size_t n) {
+    if (fd_ < 0 || closed_) return 0;
+    const ssize_t w = send(fd_, p, n, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (w < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) closed_ = true;
+      return 0;
+    }
+    return size_t(w);
+  }
+
+  int available() {
+    if (fd_ < 0) return 0;
+    int n = 0;
+    ioctl(fd_, FIONREAD, &n);
+    if (!n && !closed_) {
+      // 0 bytes y el otro extremo ha cerrado: recv() lo dice sin consumir nada
+      char c;
+      const ssize_t r = recv(fd_, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+      if (r == 0 || (r < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) closed_ = true;
+    }
+    return n;
+  }
+
+  int read(uint8_t* p, size_t n) {
+    if (fd_ < 0) return -1;
+    const ssize_t r = recv(fd_, p, n, MSG_DONTWAIT);
+    if (r == 0) closed_ = true;
+    return r > 0 ? int(r) : -1;
+  }
+
+  // como en el core: sigue "conectado" mientras quede algo por leer
+  uint8_t connected() { return fd_ >= 0 && (!closed_ || available() > 0); }
+
+  void stop() {
+    if (fd_ >= 0) close(fd_);
+    fd_ = -1;
+    closed_ = true;
+  }
+
+ private:
+  int fd_ = -1;
+  bool closed_ = true;
+  unsigned long timeoutMs_ = 5000;
+};
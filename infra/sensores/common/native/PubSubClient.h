@@ -0,0 +1,160 @@
+// --- MOCK DE PubSubClient ---
+// guarda las publicaciones en memoria en lugar de mandarlas a un broker, para poder revisarlas desde el ordenador.
+//   mock::brokerUp permite simular que el broker se cae. mock::inject() deja un mensaje como si lo mandara el broker:
+//   se entrega al callback en el siguiente loop() si el cliente está suscrito a su topic.
+#pragma once
+
+#include <Arduino.h>
+#include <ESP8266WiFi.h>
+
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+#define MQTT_MAX_PACKET_SIZE 256
+#define MQTT_MAX_HEADER_SIZE 5
+#define MQTT_CONNECTION_LOST -3
+#define MQTT_CONNECT_FAILED -2
+#define MQTT_DISCONNECTED -1
+#define MQTT_CONNECTED 0
+
+namespace mock {
+struct Publicacion {
+  std::string topic;
+  std::string payload;
+  uint32_t ms;
+  bool retained;
+};
+inline bool brokerUp = true;
+inline std::vector<Publicacion> publicaciones;
+inline bool printPublishes = true;
+// sin guardar: solo se cuentan, para que los benchmarks no midan las reservas de memoria del propio mock
+inline bool storePublishes = true;
+inline uint64_t publishedBytes = 0;
+// publicaciones que no cabían en el buffer del cliente (la librería las descarta sin avisar)
+inline uint32_t rechazadas = 0;
+
+// mensajes del broker hacia el nodo (se entregan en PubSubClient::loop())
+struct Entrante {
+  std::string topic;
+  std::string payload;
+};
+inline std::deque<Entrante> entrantes;
+inline void inject(const std::string& topic, const std::string& payload) { entrantes.push_back({topic, payload}); }
+
+// ¿el topic encaja en el filtro? (comodines + y # de MQTT)
+inline bool topicMatches(const std::string& filter, const std::string& topic) {
+  size_t f = 0, t = 0;
+  while (f < filter.size()) {
+    if (filter[f] == '#') return true;
+    if (filter[f] == '+') {
+      while (t < topic.size() && topic[t] != '/') t++;
+      f++;
+      continue;
+    }
+    if (t >= topic.size() || filter[f] != topic[t]) return false;
+    f++;
+    t++;
+  }
+  return t == topic.size();
+}
+}  // namespace mock
+
+class PubSubClient {
+ public:
+  using Callback = std::function<void(char*, uint8_t*, unsigned int)>; // MQTT_CALLBACK_SIGNATURE del ESP8266
+
+  explicit PubSubClient(WiFiClient&) {}
+
+  PubSubClient& setServer(const char*, uint16_t) { return *this; }
+  PubSubClient& setSocketTimeout(uint16_t) { return *this; }
+  bool setBufferSize(uint16_t size) {
+    bufferSize_ = size;
+    return true;
+  }
+  uint16_t getBufferSize() const { return bufferSize_; }
+  PubSubClient& setCallback(Callback cb) {
+    callback_ = std::move(cb);
+    return *this;
+  }
+
+  bool connect(const char*) {
+    connected_ = mock::brokerUp && mock::wifiUp;
+    subscriptions_.clear(); // clean session: el broker olvida las suscripciones
+    state_ = connected_ ? MQTT_CONNECTED : MQTT_CONNECT_FAILED;
+    return connected_;
+  }
+
+  bool connected() {
+    if (connected_ && !(mock::brokerUp && mock::wifiUp)) {
+      connected_ = false;
+      state_ = MQTT_CONNECTION_LOST;
+    }
+    return connected_;
+  }
+
+  int state() const { return state_; }
+
+  void disconnect() {
+    connected_ = false;
+    state_ = MQTT_DISCONNECTED;
+  }
+
+  bool subscribe(const char* filter, uint8_t qos = 0) {
+    if (!connected() || qos > 1) return false;
+    subscriptions_.push_back(filter);
+    return true;
+  }
+
+  bool publish(const char* topic, const char* payload) {
+    return publish(topic, reinterpret_cast<const uint8_t*>(payload), std::strlen(payload));
+  }
+
+  // como la librería, rechaza sin más el paquete que no cabe en el buffer (setBufferSize(), 256 por defecto)
+  bool publish(const char* topic, const uint8_t* payload, unsigned int len, bool retained = false) {
+    if (!connected()) return false;
+    if (MQTT_MAX_HEADER_SIZE + 2 + std::strlen(topic) + len > bufferSize_) {
+      mock::rechazadas++;
+      return false;
+    }
+    mock::publishedBytes += len;
+    if (!mock::storePublishes) return true;
+    mock::publicaciones.push_back(
+        {topic, std::string(reinterpret_cast<const char*>(payload), len), millis(), retained});
+    if (mock::printPublishes && !Serial.quiet) {
+      bool texto = true;
+      for (unsigned i = 0; i < len; i++) texto = texto && payload[i] >= 0x20 && payload[i] < 0x7F;
+      if (texto) std::printf("[mqtt] %s %.*s\n", topic, int(len), payload);
+      else std::printf("[mqtt] %s <%u bytes binarios>\n", topic, len);
+    }
+    return true;
+  }
+
+  // como en la librería, el topic y el payload que recibe el callback están en el buffer del cliente
+  bool loop() {
+    if (!connected()) return false;
+    while (!mock::entrantes.empty()) {
+      mock::Entrante m = std::move(mock::entrantes.front());
+      mock::entrantes.pop_front();
+      bool suscrito = false;
+      for (const auto& f : subscriptions_) suscrito = suscrito || mock::topicMatches(f, m.topic);
+      if (!suscrito || !callback_) continue;
+      rx_.assign(m.topic.begin(), m.topic.end());
+      rx_.push_back('\0');
+      const size_t off = rx_.size();
+      rx_.insert(rx_.end(), m.payload.begin(), m.payload.end());
+      callback_(rx_.data(), reinterpret_cast<uint8_t*>(rx_.data() + off), unsigned(m.payload.size()));
+    }
+    return true;
+  }
+
+ private:
+  bool connected_ = false;
+  int state_ = MQTT_DISCONNECTED;
+  uint16_t bufferSize_ = MQTT_MAX_PACKET_SIZE;
+  Callback callback_;
+  std::vector<std::string> subscriptions_;
+  std::vector<char> rx_;
+};
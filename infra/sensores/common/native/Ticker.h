@@ -0,0 +1,67 @@
+// --- MOCK DE TICKER ---
+// los tickers se disparan desde mock::advance(), igual que en el ESP8266 se dispararían desde el timer del sistema
+#pragma once
+
+#include <Arduino.h>
+
+#include <algorithm>
+#include <vector>
+
+class Ticker;
+
+namespace mock {
+inline std::vector<Ticker*> tickers;
+inline void fireTickers();
+}
+
+class Ticker {
+ public:
+  Ticker() {
+    mock::tickers.push_back(this);
+    mock::tickHook = mock::fireTickers;
+  }
+  ~Ticker() {
+    auto& v = mock::tickers;
+    v.erase(std::remove(v.begin(), v.end(), this), v.end());
+  }
+
+  void attach(float seconds, std::function<void()> cb) { arm(uint32_t(seconds * 1000), std::move(cb), true); }
+  void attach_ms(uint32_t ms, std::function<void()> cb) { arm(ms, std::move(cb), true); }
+  void once_ms(uint32_t ms, std::function<void()> cb) { arm(ms, std::move(cb), false); }
+
+  template <typename TArg>
+  void attach_ms(uint32_t ms, void (*cb)(TArg), TArg arg) {
+    arm(ms, [cb, arg]() { cb(arg); }, true);
+  }
+
+  void detach() { period_ = 0; cb_ = nullptr; }
+  bool active() const { return period_ != 0; }
+
+  // llamado por mock::fireTickers() una vez por milisegundo simulado
+  void tick() {
+    if (!period_ || --remaining_) return;
+    auto cb = cb_;
+    if (repeat_) remaining_ = period_;
+    else detach();
+    if (cb) cb();
+  }
+
+ private:
+  void arm(uint32_t ms, std::function<void()> cb, bool repeat) {
+    period_ = ms ? ms : 1;
+    remaining_ = period_;
+    repeat_ = repeat;
+    cb_ = std::move(cb);
+  }
+
+  uint32_t period_ = 0;
+  uint32_t remaining_ = 0;
+  bool repeat_ = false;
+  std::function<void()> cb_;
+};
+
+inline void mock::fireTickers() {
+  // copiamos la lista porque un callback puede crear o destruir tickers
+  auto list = tickers;
+  for (Ticker* t : list) t->tick();
+}
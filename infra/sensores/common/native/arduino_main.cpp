@@ -0,0 +1,30 @@
+// --- MAIN DEL ENTORNO NATIVE ---
+// ejecuta setup() y loop() del nodo con tiempo simulado: un loop() por milisegundo simulado.
+//   Uso: .pio/build/native/program [segundos]  (por defecto 30 s simulados)
+// Con -DNODE_ASYNC_MQTT el nodo habla con un broker de verdad (ver ESP8266WiFi.h), así que el tiempo simulado va al
+//   ritmo del reloj: si no, los keep alive y los plazos del CONNACK vencerían antes de que el broker pudiera contestar.
+#include <Arduino.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+void setup();
+void loop();
+
+int main(int argc, char** argv) {
+  const uint32_t segundos = argc > 1 ? uint32_t(std::atoi(argv[1])) : 30;
+#ifdef NODE_ASYNC_MQTT
+  mock::realTime = true;
+  const auto inicio = std::chrono::steady_clock::now();
+#endif
+  setup();
+  for (uint32_t ms = 0; ms < segundos * 1000; ms++) {
+    loop();
+    mock::advance(1);
+#ifdef NODE_ASYNC_MQTT
+    std::this_thread::sleep_until(inicio + std::chrono::milliseconds(ms + 1));
+#endif
+  }
+  return 0;
+}
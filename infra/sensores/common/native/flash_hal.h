@@ -0,0 +1,9 @@
+// --- MOCK DE flash_hal.h ---
+// la "flash" del mock empieza en 0 y tiene el tamaño de mock::kFlashSize (ver Arduino.h)
+#pragma once
+
+#include <Arduino.h>
+
+#define FLASH_SECTOR_SIZE 0x1000
+#define FS_PHYS_ADDR 0
+#define FS_PHYS_SIZE mock::kFlashSize
@@ -0,0 +1,69 @@
+// --- DRIVER DEL LDR ---
+// lectura del LDR por el A0 y payload {"luz":..,"raw":..} (el mismo que publicaba el nodo antes de usar SensorNode)
+#pragma once
+
+#include <AnalogSampler.h>
+#include <Arduino.h>
+#include <BatchFormat.h>
+#include <Commands.h>
+#include <PayloadWriter.h>
+#include <PublishPolicy.h>
+
+struct LdrDriver {
+  static constexpr char kTopic[] = "ldr"; // el topic es donde se publican los datos del sensor
+  static constexpr char kClientId[] = "ESP8266_LDR";
+  static constexpr uint32_t kPeriodMs = 3000; // publicación cada 3 s
+  static constexpr uint8_t kOversample = 32; // muestras del A0 por publicación
+  static constexpr uint32_t kSampleMs = kPeriodMs / kOversample;
+  static constexpr size_t kPayloadMax = 32; // {"luz":100,"raw":1023} ocupa 22 bytes
+
+  static constexpr uint8_t kPin = A0; // pin analógico conectado al LDR (el LDR lee entre 0 y 1023)
+
+  // --- ACTUADORES ---
+  // relé de la iluminación en el GPIO5 (D1), activo a LOW; sin límite de tiempo (las luces pueden estar horas)
+  static constexpr ActuatorDef kActuators[] = {{"luz", 5, true, false, 0}};
+
+  struct Reading {
+    int16_t luz; // porcentaje: 0% = oscuro, 100% = luz máxima
+    int16_t raw; // lectura del ADC ya filtrada, entre 0 y 1023
+  };
+
+  void begin() {}
+  void sample() { sampler_.sample(); }
+
+  bool read(Reading& r) {
+    r.raw = sampler_.reduce();
+    // a mayor raw, mayor porcentaje de luz; constrain limita que el valor se mantenga en rango
+    r.luz = constrain(map(r.raw, 0, 1023, 0, 100), 0, 100);
+    return true;
+  }
+
+  // --- CAMPOS ---
+  // valor publicado de cada campo (lo usan la banda muerta y el formato binario)
+  static constexpr uint8_t kFields = 1;
+  static void values(const Reading& r, int32_t* out) { out[0] = r.luz; }
+  static constexpr SensorType kBinaryType = SensorType::Ldr;
+
+  // --- PUBLICACIÓN POR EXCEPCIÓN ---
+  // publicamos si la luz cambia 2 puntos o más; si no, un latido por minuto
+  static constexpr Deadband kDeadband[kFields] = {{2, 0}};
+  static constexpr uint32_t kHeartbeatMs = 60000;
+
+  static void write(PayloadWriter& w, const Reading& r) {
+    w.field("luz", r.luz);
+    w.field("raw", r.raw);
+  }
+
+  // imprimimos la luz (el porcentaje convertido del valor raw) y el raw (el valor leido, entre 0 y 1023)
+  static void log(const Reading& r) {
+    Serial.print("Luz: ");
+    Serial.print(r.luz);
+    Serial.print("%  (raw: ");
+    Serial.print(r.raw);
+    Serial.println(")");
+  }
+
+ private:
+  // la luz cambia de forma continua (nubes, sombras): un EMA con alpha = 1/8 suaviza el ruido sin retrasar mucho
+  AnalogSampler<kOversample, EmaFilter<3>> sampler_{kPin};
+};
@@ -0,0 +1,145 @@
+// --- DRIVER DEL MQ135 ---
+// lectura del MQ135 por el A0 y payload {"raw":..,"percentage":..,"ppm":..}. Ver la explicación del porcentaje en
+//   main.cpp; los ppm salen de la curva calibrada de common/lib/Calibracion/Calibracion.h.
+#pragma once
+
+#include <AnalogSampler.h>
+#include <Arduino.h>
+#include <BatchFormat.h>
+#include <Calibracion.h>
+#include <PayloadWriter.h>
+#include <PublishPolicy.h>
+
+// calibración de compilación (se cambia por MQTT, ver common/lib/NodeCore/Calibration.h). La curva es la de CO2 del
+//   datasheet; R0 es de cada sensor: medirlo en aire limpio tras 24 h de precalentamiento, o mandar {"aire": 420}
+#ifndef MQ135_R0
+#define MQ135_R0 76630 // ohmios
+#endif
+
+#ifndef MQ135_RL
+#define MQ135_RL 10000 // ohmios: la resistencia de carga del módulo (la mayoría llevan 10 k, algunos 1 k)
+#endif
+
+struct Mq135Driver {
+  static constexpr char kTopic[] = "mq135"; // el topic es donde se publican los datos del sensor
+  static constexpr char kClientId[] = "ESP8266_MQ135";
+  static constexpr uint32_t kPeriodMs = 3000; // publicación cada 3 s
+  static constexpr uint8_t kOversample = 32; // muestras del A0 por publicación
+  static constexpr uint32_t kSampleMs = kPeriodMs / kOversample;
+  static constexpr size_t kPayloadMax = 48; // {"raw":1023,"percentage":100,"ppm":99999} ocupa 41 bytes
+
+  static constexpr uint8_t kPin = A0; // pin analógico conectado al MQ135 (el MQ135 lee entre 0 y 1023)
+
+  struct Reading {
+    int16_t raw;
+    int16_t percentage; // indicador 0-100, no es una concentración real
+    int32_t ppm;        // CO2 equivalente según la calibración y la temperatura y humedad del invernadero
+  };
+
+  void begin() {}
+  void sample() { sampler_.sample(); }
+
+  bool read(Reading& r) {
+    r.raw = sampler_.reduce();
+    r.percentage = constrain(map(r.raw, 0, 1023, 0, 100), 0, 100);
+    // sin lecturas del DHT11 recientes volvemos a la temperatura y humedad de la curva
+    if (ambientOk_ && millis() - ambientMs_ > kAmbientMaxAgeMs) {
+      curve_.ambiente(calib::Mq135::kTempRef, calib::Mq135::kHumRef);
+      ambientOk_ = false;
+    }
+    r.ppm = curve_.ppm(r.raw);
+    lastRaw_ = r.raw;
+    return true;
+  }
+
+  // --- CAMPOS ---
+  // valor publicado de cada campo (lo usan la banda muerta y el formato binario)
+  static constexpr uint8_t kFields = 1;
+  static void values(const Reading& r, int32_t* out) { out[0] = r.percentage; }
+  static constexpr SensorType kBinaryType = SensorType::Mq135;
+
+  // --- PUBLICACIÓN POR EXCEPCIÓN ---
+  // publicamos si el indicador cambia 2 puntos o más; si no, un latido por minuto
+  static constexpr Deadband kDeadband[kFields] = {{2, 0}};
+  static constexpr uint32_t kHeartbeatMs = 60000;
+
+  static void write(PayloadWriter& w, const Reading& r) {
+    w.field("raw", r.raw);
+    w.field("percentage", r.percentage);
+    w.field("ppm", r.ppm);
+  }
+
+  // imprimimos el raw (el valor leido del sensor, entre 0 y 1023) y la conversión al porcentaje y a ppm
+  static void log(const Reading& r) {
+    Serial.print("MQ135 raw: ");
+    Serial.print(r.raw);
+    Serial.print(" V | Concentración aprox: ");
+    Serial.print(r.percentage);
+    Serial.print(" % | ");
+    Serial.print(r.ppm);
+    Serial.println(" ppm");
+  }
+
+  // --- CALIBRACIÓN ---
+  // a y b en milésimas: la curva de CO2 del datasheet (a = 116.602, b = -2.769). vc = 1023: el módulo se alimenta a
+  //   la misma tensión que el fondo de escala del A0
+  using Calib = calib::Mq135Param;
+  static constexpr Calib kCalib = {MQ135_R0, MQ135_RL, 116602, -2769, 1023};
+  static constexpr calib::Mq135 kCurve{kCalib}; // logaritmos precalculados al compilar
+  static_assert(kCurve.param().r0 == MQ135_R0, "calibración de compilación del MQ135 fuera de rango");
+
+  // la temperatura y la humedad las publica el nodo temp_hum, sin retain: con -DNODE_DEEP_SLEEP el nodo no escucha y
+  //   convierte siempre con las de la curva (20 ºC y 33 %)
+  static constexpr char kAmbientTopic[] = "dht11";
+  static constexpr uint32_t kAmbientMaxAgeMs = 600000;
+
+  const Calib& calibration() const { return curve_.param(); }
+  bool setCalibration(const Calib& c) { return curve_.configurar(c); }
+
+  // "aire" recalcula R0 con la última lectura (después de aplicar el resto de campos). Es una orden: Calibration.h
+  //   publica con retain la R0 resultante en su lugar para que no se repita al reconectar. Recién arrancado todavía
+  //   no hay lectura y no se puede (error "aire").
+  calib::Error calibrate(const char* json, size_t len, bool& orden) {
+    Calib c = curve_.param();
+    int32_t aire;
+    const calib::Error e = calib::leer(json, len, c, aire);
+    orden = e == calib::Ok && aire != 0;
+    if (e != calib::Ok) return e;
+    calib::Mq135 nueva = curve_;
+    if (!nueva.configurar(c)) return calib::Rango;
+    if (aire) {
+      c.r0 = nueva.r0Para(lastRaw_, aire);
+      if (!c.r0 || !nueva.configurar(c)) return calib::Aire;
+    }
+    curve_ = nueva;
+    return calib::Ok;
+  }
+
+  void writeCalibration(PayloadWriter& w) const {
+    const Calib& c = curve_.param();
+    w.field("r0", c.r0);
+    w.field("rl", c.rl);
+    w.fixed("a", c.a, 3);
+    w.fixed("b", c.b, 3);
+    w.field("vc", c.vc);
+    w.fixed("t", curve_.temperatura(), 2);
+    w.fixed("h", curve_.humedad(), 2);
+  }
+
+  void ambient(const char* json, size_t len) {
+    int16_t t, h;
+    if (!calib::leerAmbiente(json, len, t, h)) return;
+    if (t != curve_.temperatura() || h != curve_.humedad()) curve_.ambiente(t, h);
+    ambientOk_ = true;
+    ambientMs_ = millis();
+  }
+
+ private:
+  // el calentador del MQ135 mete ruido en ambos sentidos: la media recortada (25 % por cada lado) lo compensa
+  AnalogSampler<kOversample, TrimmedMeanFilter<kOversample, 25>> sampler_{kPin};
+
+  calib::Mq135 curve_ = kCurve;
+  int16_t lastRaw_ = 0;
+  bool ambientOk_ = false;
+  uint32_t ambientMs_ = 0;
+};
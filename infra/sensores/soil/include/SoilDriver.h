@@ -0,0 +1,115 @@
+// --- DRIVER DEL SENSOR DE HUMEDAD DE SUELO ---
+// lectura del sensor capacitivo por el A0 y payload {"humedad":..,"raw":..}. La humedad sale de la curva de la sonda
+//   (common/lib/Calibracion/Calibracion.h), que se puede calibrar por MQTT (ver common/lib/NodeCore/Calibration.h).
+#pragma once
+
+#include <AnalogSampler.h>
+#include <Arduino.h>
+#include <BatchFormat.h>
+#include <Calibracion.h>
+#include <Commands.h>
+#include <PayloadWriter.h>
+#include <PublishPolicy.h>
+
+// raw de la sonda en seco y en agua, si se conocen al compilar (-DSOIL_SECO=870 -DSOIL_MOJADO=410). Por defecto el
+//   rango entero del ADC, que es lo que hacía el map()
+#ifndef SOIL_SECO
+#define SOIL_SECO 1023
+#endif
+
+#ifndef SOIL_MOJADO
+#define SOIL_MOJADO 0
+#endif
+
+struct SoilDriver {
+  static constexpr char kTopic[] = "soil"; // el topic es donde se publican los datos del sensor
+  static constexpr char kClientId[] = "ESP8266_SUELO";
+  static constexpr uint32_t kPeriodMs = 3000; // publicación cada 3 s
+  static constexpr uint8_t kOversample = 32; // muestras del A0 por publicación
+  static constexpr uint32_t kSampleMs = kPeriodMs / kOversample;
+  static constexpr size_t kPayloadMax = 32; // {"humedad":100,"raw":1023} ocupa 26 bytes
+
+  static constexpr uint8_t kPin = A0;
+
+  // --- ACTUADORES ---
+  // relé de la bomba de riego en el GPIO5 (D1), activo a LOW. Nunca más de 10 minutos seguidos: si se pierde la
+  //   orden de apagado, el invernadero no se inunda
+  static constexpr ActuatorDef kActuators[] = {{"riego", 5, true, false, 600000}};
+
+  struct Reading {
+    int16_t humedad; // porcentaje de humedad del suelo
+    int16_t raw;     // lectura del ADC ya filtrada: 1023 = seco, 0 = encharcado
+  };
+
+  void begin() {}
+  void sample() { sampler_.sample(); }
+
+  bool read(Reading& r) {
+    r.raw = sampler_.reduce();
+    // el sensor da más tensión cuanto más seco está: la curva baja de 100 % en SOIL_MOJADO a 0 % en SOIL_SECO
+    r.humedad = curve_.humedad(r.raw);
+    return true;
+  }
+
+  // --- CAMPOS ---
+  // valor publicado de cada campo (lo usan la banda muerta y el formato binario)
+  static constexpr uint8_t kFields = 1;
+  static void values(const Reading& r, int32_t* out) { out[0] = r.humedad; }
+  static constexpr SensorType kBinaryType = SensorType::Soil;
+
+  // --- PUBLICACIÓN POR EXCEPCIÓN ---
+  // cualquier cambio de 1 punto de humedad se publica (el riego se decide con ella); si no, un latido por minuto
+  static constexpr Deadband kDeadband[kFields] = {{1, 0}};
+  static constexpr uint32_t kHeartbeatMs = 60000;
+
+  static void write(PayloadWriter& w, const Reading& r) {
+    w.field("humedad", r.humedad);
+    w.field("raw", r.raw);
+  }
+
+  // imprimimos la humedad (el porcentaje convertido del valor raw) y el raw (el valor leido)
+  static void log(const Reading& r) {
+    Serial.print("Humedad suelo: ");
+    Serial.print(r.humedad);
+    Serial.print("%  (raw: ");
+    Serial.print(r.raw);
+    Serial.println(")");
+  }
+
+  // --- CALIBRACIÓN ---
+  using Calib = calib::SueloParam;
+  static constexpr Calib kCalib = {2, 0, {{SOIL_SECO, 0}, {SOIL_MOJADO, 100}}};
+  static constexpr calib::CurvaSuelo kCurve{kCalib}; // tramos y pendientes calculados al compilar
+  static_assert(kCurve.param().n == 2, "SOIL_SECO y SOIL_MOJADO tienen que ser distintos y estar entre 0 y 4095");
+
+  const Calib& calibration() const { return curve_.param(); }
+  bool setCalibration(const Calib& c) { return curve_.configurar(c); }
+
+  calib::Error calibrate(const char* json, size_t len, bool& orden) {
+    orden = false;
+    Calib c = curve_.param();
+    const calib::Error e = calib::leer(json, len, c);
+    if (e != calib::Ok) return e;
+    return curve_.configurar(c) ? calib::Ok : calib::Rango;
+  }
+
+  // {"puntos": [raw, %, raw, %, ...]} ordenados por raw
+  void writeCalibration(PayloadWriter& w) const {
+    const Calib& c = curve_.param();
+    w.key("puntos");
+    w.put('[');
+    for (uint8_t i = 0; i < c.n; i++) {
+      if (i) w.put(',');
+      w.putInt(c.p[i].raw);
+      w.put(',');
+      w.putInt(c.p[i].pct);
+    }
+    w.put(']');
+  }
+
+ private:
+  // la humedad del suelo decide el riego en Node-RED: la mediana evita que un pico aislado del ADC lo dispare
+  AnalogSampler<kOversample, MedianFilter<kOversample>> sampler_{kPin};
+
+  calib::CurvaSuelo curve_ = kCurve;
+};
@@ -0,0 +1,186 @@
+// --- LECTURA ASÍNCRONA DEL DHT11 ---
+// la librería de Adafruit lee el DHT11 esperando cada bit en un bucle con las interrupciones desactivadas (unos 5 ms
+//   de trama más los 18-20 ms de la señal de inicio con delay()): en cada lectura se paraban la WiFi y el MQTT. Aquí la
+//   conversión es una máquina de estados que avanza desde poll() sin esperar nunca:
+//   1. Reposo: cuando toca, ponemos la línea a LOW (señal de inicio).
+//   2. Inicio: a los kStartMs enganchamos la interrupción de flanco de bajada y soltamos la línea (pull-up).
+//   3. Captura: la interrupción solo apunta micros() de cada flanco en un buffer fijo. Con los 42 flancos de la
+//      trama (o pasado kCaptureUs) soltamos la interrupción, decodificamos y comprobamos el checksum fuera de ella.
+//   Con una lectura válida la siguiente conversión va a los kIntervalMs; si falla, se reintenta a los kRetryMs (el
+//   DHT11 necesita 1 s entre lecturas).
+//
+// La trama del DHT11 entre flancos de bajada: 160 us de respuesta (80 LOW + 80 HIGH) y cada bit 50 us a LOW más
+//   26-28 us (un 0) o 70 us (un 1) a HIGH, así que un 0 son ~76 us entre flancos y un 1 ~120 us. El último flanco es el
+//   LOW final tras el bit 39. decode() es independiente del hardware, para poder pasarle trenes de pulsos capturados
+//   (ver bench/src/dht.cpp).
+#pragma once
+
+#include <Arduino.h>
+#include <Histogram.h>
+#include <stdint.h>
+
+namespace dht11 {
+
+constexpr uint8_t kEdges = 42;      // flancos de bajada de una trama completa
+constexpr uint8_t kMaxEdges = 48;   // margen para algún flanco espurio
+constexpr uint32_t kBitSplitUs = 100; // entre flancos: menos es un 0, más un 1
+constexpr uint32_t kBitMinUs = 60;
+constexpr uint32_t kBitMaxUs = 160;
+
+enum Error : uint8_t { Ok, Timeout, Pulse, Checksum };
+
+struct Sample {
+  int16_t temperatura; // centésimas de grado
+  int16_t humedad;     // centésimas de %
+};
+
+// decodifica los instantes (us) de los flancos de bajada de una trama. Se usan los 41 últimos: si al soltar la línea
+//   se ha colado algún flanco de más, queda al principio.
+inline Error decode(const uint32_t* edges, uint8_t n, Sample& out) {
+  if (n < kEdges) return Timeout;
+  const uint32_t* e = edges + (n - (kEdges - 1));
+  uint8_t b[5] = {};
+  for (uint8_t i = 0; i < 40; i++) {
+    const uint32_t d = e[i + 1] - e[i];
+    if (d < kBitMinUs || d > kBitMaxUs) return Pulse;
+    b[i / 8] = uint8_t(b[i / 8] << 1 | (d > kBitSplitUs));
+  }
+  if (uint8_t(b[0] + b[1] + b[2] + b[3]) != b[4]) return Checksum;
+  // el checksum es una suma: dos bits cambiados pueden cuadrarla. Lo que el DHT11 no puede dar (décimas de más de 9,
+  //   humedad de más del 100 %, más de 60 ºC) también cuenta como checksum mal.
+  if (b[0] > 100 || b[1] > 9 || b[2] > 60 || (b[3] & 0x7F) > 9) return Checksum;
+  // parte entera y décimas; el bit 7 de las décimas de temperatura es el signo (DHT11 de las últimas series)
+  out.humedad = int16_t(b[0] * 100 + (b[1] % 10) * 10);
+  const int16_t t = int16_t(b[2] * 100 + (b[3] & 0x0F) * 10);
+  out.temperatura = (b[3] & 0x80) ? int16_t(-t) : t;
+  return Ok;
+}
+
+struct Stats {
+  uint32_t conversiones = 0;
+  uint32_t validas = 0;
+  uint32_t timeouts = 0;  // trama incompleta (sensor sin conectar o sin responder)
+  uint32_t pulsos = 0;    // algún bit con una duración imposible (ruido en la línea)
+  uint32_t checksums = 0; // trama completa pero con el checksum mal (o un valor imposible)
+  uint32_t reintentos = 0;
+};
+
+class Reader {
+ public:
+  static constexpr uint32_t kStartMs = 20;      // LOW de la señal de inicio (al menos 18 ms)
+  static constexpr uint32_t kCaptureUs = 8000;  // la trama dura unos 4,5 ms
+  static constexpr uint32_t kIntervalMs = 2000; // entre lecturas válidas
+  static constexpr uint32_t kRetryMs = 1100;    // tras un fallo
+
+  explicit Reader(uint8_t pin) : pin_(pin) {}
+
+  // el sensor necesita 1 s tras encenderse antes de la primera lectura
+  void begin(uint32_t nowMs) {
+    pinMode(pin_, INPUT_PULLUP);
+    nextMs_ = nowMs + 1000;
+  }
+
+  // avanza la conversión; true si acaba de terminar una (válida o no)
+  bool poll(uint32_t nowMs) {
+    switch (state_) {
+      case Reposo:
+        if (int32_t(nowMs - nextMs_) < 0) return false;
+        startUs_ = micros();
+        startMs_ = nowMs;
+        pinMode(pin_, OUTPUT);
+        digitalWrite(pin_, LOW);
+        state_ = Inicio;
+        stats_.conversiones++;
+        if (!lastOk_) stats_.reintentos++;
+        return false;
+      case Inicio:
+        if (nowMs - startMs_ < kStartMs) return false;
+        count_ = 0;
+        attachInterrupt(digitalPinToInterrupt(pin_), onFall, FALLING);
+        releaseUs_ = micros();
+        pinMode(pin_, INPUT_PULLUP); // al soltar la línea el sensor contesta
+        state_ = Captura;
+        return false;
+      case Captura:
+        if (count_ < kEdges && micros() - releaseUs_ < kCaptureUs) return false;
+        detachInterrupt(digitalPinToInterrupt(pin_));
+        finish(nowMs);
+        state_ = Reposo;
+        return true;
+    }
+    return false;
+  }
+
+  // conversión de principio a fin esperando (para el modo deep sleep, que no tiene nada más que hacer). Como mucho
+  //   kStartMs + kCaptureUs + unos ms, con las interrupciones activas.
+  bool convert() {
+    nextMs_ = millis();
+    while (!poll(millis())) delay(1);
+    return lastOk_;
+  }
+
+  // última lectura válida y cuándo se tomó; false si todavía no hay ninguna
+  bool last(Sample& s, uint32_t& atMs) const {
+    if (!hasValue_) return false;
+    s = value_;
+    atMs = valueMs_;
+    return true;
+  }
+
+  bool converting() const { return state_ != Reposo; }
+  Error lastError() const { return lastError_; }
+  const Stats& stats() const { return stats_; }
+  // del inicio de la conversión a tener la lectura (us)
+  const Log2Histogram& latency() const { return latency_; }
+  void resetLatency() { latency_.reset(); }
+
+ private:
+  enum State : uint8_t { Reposo, Inicio, Captura };
+
+  // la interrupción solo apunta el instante: nada de decodificar aquí
+  static void IRAM_ATTR onFall() {
+    const uint8_t n = count_;
+    if (n < kMaxEdges) {
+      edges_[n] = micros();
+      count_ = uint8_t(n + 1);
+    }
+  }
+
+  void finish(uint32_t nowMs) {
+    uint32_t edges[kMaxEdges];
+    const uint8_t n = count_;
+    for (uint8_t i = 0; i < n; i++) edges[i] = edges_[i];
+    Sample s;
+    lastError_ = decode(edges, n, s);
+    lastOk_ = lastError_ == Ok;
+    switch (lastError_) {
+      case Ok:
+        value_ = s;
+        valueMs_ = nowMs;
+        hasValue_ = true;
+        stats_.validas++;
+        latency_.add(micros() - startUs_);
+        break;
+      case Timeout: stats_.timeouts++; break;
+      case Pulse: stats_.pulsos++; break;
+      case Checksum: stats_.checksums++; break;
+    }
+    nextMs_ = nowMs + (lastOk_ ? kIntervalMs : kRetryMs);
+  }
+
+  static inline volatile uint32_t edges_[kMaxEdges];
+  static inline volatile uint8_t count_ = 0;
+
+  uint8_t pin_;
+  State state_ = Reposo;
+  uint32_t nextMs_ = 0, startMs_ = 0, startUs_ = 0, releaseUs_ = 0;
+  bool lastOk_ = true;
+  Error lastError_ = Ok;
+  bool hasValue_ = false;
+  Sample value_{};
+  uint32_t valueMs_ = 0;
+  Stats stats_;
+  Log2Histogram latency_;
+};
+
+}  // namespace dht11
@@ -0,0 +1,100 @@
+// --- DRIVER DEL DHT11 ---
+// lectura de temperatura y humedad ambiental y payload {"temperatura":..,"humedad":..}. La conversión es asíncrona
+//   (Dht11Async.h): sample() la hace avanzar sin bloquear y read() publica la última lectura válida.
+#pragma once
+
+#include <Arduino.h>
+#include <BatchFormat.h>
+#include <Commands.h>
+#include <PayloadWriter.h>
+#include <PublishPolicy.h>
+
+#include "Dht11Async.h"
+
+struct DhtDriver {
+  static constexpr char kTopic[] = "dht11"; // el topic es donde se publican los datos del sensor
+  static constexpr char kClientId[] = "NodeMCU_DHT11";
+  static constexpr uint32_t kPeriodMs = 3000; // lectura y publicación cada 3 s
+  // no son muestras: cada cuánto avanza la conversión del DHT11 (que no admite más de una lectura por segundo)
+  static constexpr uint32_t kSampleMs = 5;
+  static constexpr uint32_t kMaxAgeMs = 10000; // una lectura más antigua (el sensor lleva un rato fallando) no se publica
+  static constexpr size_t kPayloadMax = 48; // {"temperatura":-12.34,"humedad":100} ocupa 36 bytes
+
+  // pin digital donde se conecta el sensor DHT11 a nuestro nodo (GPIO2 del ESP8266)
+  static constexpr uint8_t kPin = 2;
+
+  // --- ACTUADORES ---
+  // ventilador por PWM en el GPIO5 (D1, a través de un MOSFET): "level" es la velocidad en %
+  static constexpr ActuatorDef kActuators[] = {{"ventilador", 5, false, true, 0}};
+
+  struct Reading {
+    int16_t temperatura; // centésimas de grado (2350 = 23.5 ºC)
+    int16_t humedad;     // centésimas de % (5500 = 55 %)
+  };
+
+  void begin() { dht_.begin(millis()); }
+  void sample() { dht_.poll(millis()); }
+
+  bool read(Reading& r) {
+#ifdef NODE_DEEP_SLEEP
+    dht_.convert(); // recién despertados no hay lectura anterior: esperamos a una (unos 25 ms)
+#endif
+    dht11::Sample s;
+    uint32_t at;
+    // comprobamos que haya una lectura válida reciente
+    if (!dht_.last(s, at) || millis() - at > kMaxAgeMs) {
+      Serial.println("Error leyendo DHT11");
+      return false;
+    }
+    // el sensor ya da enteros y décimas: los guardamos en centésimas para escribir el JSON sin floats
+    r.temperatura = s.temperatura;
+    r.humedad = s.humedad;
+    return true;
+  }
+
+  // contadores de la conversión y su latencia (del inicio a tener la lectura) en <topic>/sensor
+  void stats(PayloadWriter& w) const {
+    const dht11::Stats& s = dht_.stats();
+    w.field("conversiones", int32_t(s.conversiones));
+    w.field("validas", int32_t(s.validas));
+    w.field("timeouts", int32_t(s.timeouts));
+    w.field("pulsos", int32_t(s.pulsos));
+    w.field("checksums", int32_t(s.checksums));
+    w.field("reintentos", int32_t(s.reintentos));
+    w.field("latencia_p99_us", int32_t(dht_.latency().percentile(99)));
+    w.field("latencia_max_us", int32_t(dht_.latency().max()));
+  }
+  void statsSent() { dht_.resetLatency(); }
+  const dht11::Reader& reader() const { return dht_; }
+
+  // --- CAMPOS ---
+  // valor publicado de cada campo (lo usan la banda muerta y el formato binario), en centésimas
+  static constexpr uint8_t kFields = 2;
+  static void values(const Reading& r, int32_t* out) {
+    out[0] = r.temperatura;
+    out[1] = r.humedad;
+  }
+  static constexpr SensorType kBinaryType = SensorType::Dht11;
+
+  // --- PUBLICACIÓN POR EXCEPCIÓN ---
+  // 0.5 ºC de temperatura o 2 % de humedad (la resolución del DHT11 es de 1 ºC / 1 %)
+  static constexpr Deadband kDeadband[kFields] = {{50, 0}, {200, 0}};
+  static constexpr uint32_t kHeartbeatMs = 60000;
+
+  static void write(PayloadWriter& w, const Reading& r) {
+    w.fixed("temperatura", r.temperatura, 2);
+    w.fixed("humedad", r.humedad, 2);
+  }
+
+  // mostramos los valores de humedad y temperatura por el Serial Monitor
+  static void log(const Reading& r) {
+    Serial.print("Humedad: ");
+    Serial.print(r.humedad / 100.0f);
+    Serial.print(" %  |  Temp: ");
+    Serial.print(r.temperatura / 100.0f);
+    Serial.println(" C");
+  }
+
+ private:
+  dht11::Reader dht_{kPin};
+};
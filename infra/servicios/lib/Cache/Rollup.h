@@ -0,0 +1,91 @@
+// --- RESÚMENES MÓVILES (min/max/media) ---
+// cada ventana es un anillo de cubos de ancho fijo: añadir una muestra toca un cubo y resumir la ventana junta como
+//   mucho los N cubos, sin guardar las muestras. La ventana va del cubo actual (a medias) a los N-1 anteriores
+//   completos, así que cubre entre (N-1) y N anchos de cubo; con cubos pequeños frente a la ventana da igual.
+//
+//   1 min: 12 cubos de 5 s | 1 h: 60 de 1 min | 24 h: 96 de 15 min
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cache {
+
+struct Resumen {
+  uint64_t n = 0;
+  double min = 0, max = 0, sum = 0;
+
+  void add(double v) {
+    if (!n || v < min) min = v;
+    if (!n || v > max) max = v;
+    sum += v;
+    n++;
+  }
+  void unir(const Resumen& o) {
+    if (!o.n) return;
+    if (!n || o.min < min) min = o.min;
+    if (!n || o.max > max) max = o.max;
+    sum += o.sum;
+    n += o.n;
+  }
+  double avg() const { return n ? sum / double(n) : 0; }
+};
+
+class Ventana {
+ public:
+  Ventana(int64_t anchoCuboMs, uint32_t cubos) : ancho_(anchoCuboMs), cubos_(cubos) {}
+
+  // ts en ms. Una muestra más antigua que lo que ya guarda su cubo (ha dado la vuelta al anillo) se ignora.
+  void add(int64_t ts, double v) {
+    const int64_t inicio = inicioDe(ts);
+    Cubo& c = cubos_[size_t(uint64_t(inicio / ancho_) % cubos_.size())];
+    if (c.inicio > inicio) return;
+    if (c.inicio < inicio) {
+      c.inicio = inicio;
+      c.r = Resumen{};
+    }
+    c.r.add(v);
+  }
+
+  // las muestras de la ventana que acaba en ahora (ms)
+  Resumen resumen(int64_t ahora) const {
+    const int64_t actual = inicioDe(ahora);
+    const int64_t primero = actual - int64_t(cubos_.size() - 1) * ancho_;
+    Resumen r;
+    for (const Cubo& c : cubos_) {
+      if (c.inicio >= primero && c.inicio <= actual) r.unir(c.r);
+    }
+    return r;
+  }
+
+  int64_t duracionMs() const { return ancho_ * int64_t(cubos_.size()); }
+
+ private:
+  struct Cubo {
+    int64_t inicio = INT64_MIN;
+    Resumen r;
+  };
+
+  int64_t inicioDe(int64_t ts) const {
+    const int64_t q = ts / ancho_;
+    return (q - (ts % ancho_ < 0 ? 1 : 0)) * ancho_;
+  }
+
+  int64_t ancho_;
+  std::vector<Cubo> cubos_;
+};
+
+// las tres ventanas que sirven las consultas
+struct Rollups {
+  static constexpr size_t kN = 3;
+  static constexpr const char* kNombres[kN] = {"1m", "1h", "24h"};
+
+  Ventana ventanas[kN] = {{5000, 12}, {60000, 60}, {900000, 96}};
+
+  void add(int64_t ts, double v) {
+    for (Ventana& w : ventanas) w.add(ts, v);
+  }
+};
+
+}  // namespace cache
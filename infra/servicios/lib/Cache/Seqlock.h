@@ -0,0 +1,57 @@
+// --- SEQLOCK DE UN ESCRITOR ---
+// para datos pequeños que escribe un solo hilo y leen muchos: el lector nunca bloquea al escritor ni a otros lectores,
+//   solo repite la copia si le ha pillado a medias una escritura. El contador es impar mientras se escribe.
+//
+// Los datos se guardan como palabras atómicas (con orden relaxed, que en x86 y ARM son loads y stores normales) para
+//   que la lectura concurrente no sea una carrera de datos según el modelo de memoria de C++.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+template <class T>
+class Seqlock {
+  static_assert(std::is_trivially_copyable_v<T>, "Seqlock solo copia tipos trivialmente copiables");
+  static constexpr size_t kPalabras = (sizeof(T) + 7) / 8;
+
+ public:
+  Seqlock() = default;
+  explicit Seqlock(const T& v) { store(v); }
+
+  // solo desde el hilo escritor
+  void store(const T& v) {
+    uint64_t w[kPalabras] = {};
+    std::memcpy(w, &v, sizeof(T));
+    const uint64_t s = seq_.load(std::memory_order_relaxed);
+    seq_.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kPalabras; i++) datos_[i].store(w[i], std::memory_order_relaxed);
+    seq_.store(s + 2, std::memory_order_release);
+  }
+
+  // desde cualquier hilo; como mucho reintenta lo que dura un store()
+  T load() const {
+    uint64_t w[kPalabras];
+    for (;;) {
+      const uint64_t s = seq_.load(std::memory_order_acquire);
+      if (s & 1) continue;
+      for (size_t i = 0; i < kPalabras; i++) w[i] = datos_[i].load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq_.load(std::memory_order_relaxed) == s) break;
+    }
+    T v;
+    std::memcpy(&v, w, sizeof(T));
+    return v;
+  }
+
+  // cuántas veces se ha escrito
+  uint64_t version() const { return seq_.load(std::memory_order_acquire) / 2; }
+
+ private:
+  // en su propia línea de caché: los lectores no se pelean con lo que haya al lado
+  alignas(64) std::atomic<uint64_t> seq_{0};
+  std::atomic<uint64_t> datos_[kPalabras] = {};
+};
@@ -0,0 +1,23 @@
+// --- PERCENTILES DE UNA MUESTRA ---
+// lo que usan los benchmarks y las herramientas para resumir latencias: el valor de orden p/100 * n con
+//   nth_element (O(n), sin ordenar todo). Reordena el vector que recibe; si es const, trabaja sobre una copia.
+//   p = 100 da el máximo; con el vector vacío devuelve 0.
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+template <class T>
+T percentil(std::vector<T>& v, double p) {
+  if (v.empty()) return 0;
+  const size_t k = std::min(v.size() - 1, size_t(p / 100.0 * double(v.size())));
+  std::nth_element(v.begin(), v.begin() + long(k), v.end());
+  return v[k];
+}
+
+template <class T>
+T percentil(const std::vector<T>& v, double p) {
+  std::vector<T> copia(v);
+  return percentil(copia, p);
+}
@@ -0,0 +1,382 @@
+// --- GRABACIÓN DEL TRÁFICO MQTT ---
+// fichero de solo añadir con los mensajes tal y como llegan del broker, para reproducirlos después con los mismos
+//   huecos entre mensajes (herramienta grabador):
+//
+//   cabecera  "TRZ1" | versión u32 | creado u64 (us desde 1970)
+//   registro  us u64 | payload u16 | topic u8 | flags u8 | crc u32 | topic | payload
+//     us: hora de llegada en us desde 1970, que nunca baja dentro del fichero (si el reloj del sistema va hacia atrás
+//     se repite la anterior). flags: bit 0 retain, bits 1-2 QoS. crc: CRC-32 de los 12 bytes de antes, el topic y el
+//     payload. 16 bytes por mensaje además del topic y el payload, que van tal cual (también los lotes binarios).
+//
+// Al lado va <fichero>.idx, el índice por tiempo: entradas de 16 bytes (us u64 | offset u64) del primer registro de
+//   cada segundo grabado. Para empezar a leer en una hora se busca en el índice y se recorre como mucho un segundo de
+//   registros. El índice se puede perder: se rehace recorriendo el fichero.
+//
+// Escritor añade registros con un buffer; al abrir un fichero que ya existe sigue al final, después de quitar un
+//   registro a medias (una escritura cortada) igual que el WAL de lib/Tsdb. Lector lo abre con mmap y lee los
+//   registros directamente del mapa, aunque el grabador siga escribiendo (ve lo que había al abrirlo). Los enteros van
+//   en el orden de bytes de la máquina, como los segmentos de lib/Tsdb.
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace grab {
+
+constexpr uint32_t kMagic = 0x315A5254; // "TRZ1"
+constexpr uint32_t kVersion = 1;
+constexpr size_t kCabecera = 16;
+constexpr size_t kRegistro = 16;          // cabecera de cada registro
+constexpr uint64_t kPasoIndiceUs = 1000000; // una entrada del índice por segundo grabado
+constexpr size_t kMaxPayload = 0xFFFF;
+constexpr size_t kMaxTopic = 0xFF;
+
+// CRC-32 (polinomio 0xEDB88320) con tabla, el mismo que el de lib/Tsdb
+inline uint32_t crc32(const void* p, size_t n, uint32_t crc = 0) {
+  static const auto tabla = [] {
+    std::array<uint32_t, 256> t{};
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++) c = c & 1 ? (c >> 1) ^ 0xEDB88320 : c >> 1;
+      t[i] = c;
+    }
+    return t;
+  }();
+  const uint8_t* b = static_cast<const uint8_t*>(p);
+  crc = ~crc;
+  for (size_t i = 0; i < n; i++) crc = tabla[(crc ^ b[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+struct Registro {
+  uint64_t us;
+  uint8_t qos;
+  bool retain;
+  std::string_view topic;
+  std::string_view payload;
+};
+
+struct EntradaIndice {
+  uint64_t us;
+  uint64_t offset;
+};
+
+namespace detail {
+
+// registro en p (quedan n bytes): su tamaño total, o 0 si está a medias o el CRC no cuadra
+inline size_t leerRegistro(const uint8_t* p, size_t n, Registro& r) {
+  if (n < kRegistro) return 0;
+  uint16_t lenPayload;
+  uint32_t crc;
+  std::memcpy(&r.us, p, 8);
+  std::memcpy(&lenPayload, p + 8, 2);
+  const uint8_t lenTopic = p[10];
+  const uint8_t flags = p[11];
+  std::memcpy(&crc, p + 12, 4);
+  const size_t total = kRegistro + lenTopic + lenPayload;
+  if (total > n || crc32(p + kRegistro, lenTopic + lenPayload, crc32(p, 12)) != crc) return 0;
+  r.retain = flags & 1;
+  r.qos = (flags >> 1) & 3;
+  r.topic = std::string_view(reinterpret_cast<const char*>(p + kRegistro), lenTopic);
+  r.payload = std::string_view(reinterpret_cast<const char*>(p + kRegistro + lenTopic), lenPayload);
+  return total;
+}
+
+inline bool escribirTodo(int fd, const void* p, size_t n) {
+  const auto* b = static_cast<const uint8_t*>(p);
+  while (n) {
+    const ssize_t w = ::write(fd, b, n);
+    if (w < 0 && errno == EINTR) continue;
+    if (w <= 0) return false;
+    b += w;
+    n -= size_t(w);
+  }
+  return true;
+}
+
+inline std::string rutaIndice(const std::string& path) { return path + ".idx"; }
+
+}  // namespace detail
+
+// --- ESCRITURA ---
+class Escritor {
+ public:
+  ~Escritor() { close(); }
+
+  // crea el fichero o sigue al final del que hay (quitando un registro a medias y rehaciendo el final del índice)
+  bool open(const std::string& path, uint64_t ahoraUs) {
+    close();
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    idx_ = ::open(detail::rutaIndice(path).c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0 || idx_ < 0) {
+      std::fprintf(stderr, "grabación: no se puede abrir %s: %s\n", path.c_str(), std::strerror(errno));
+      return false;
+    }
+    struct stat st;
+    if (::fstat(fd_, &st) != 0) return false;
+    if (st.st_size == 0) {
+      uint32_t cab[2] = {kMagic, kVersion};
+      char buf[kCabecera];
+      std::memcpy(buf, cab, 8);
+      std::memcpy(buf + 8, &ahoraUs, 8);
+      if (::ftruncate(idx_, 0) != 0 || !detail::escribirTodo(fd_, buf, sizeof(buf))) return false;
+      bytes_ = kCabecera;
+      return true;
+    }
+    return retomar(path, uint64_t(st.st_size));
+  }
+
+  // false si el mensaje no cabe en el formato (topic de más de 255 bytes o payload de más de 64 KB)
+  bool append(uint64_t us, std::string_view topic, std::string_view payload, uint8_t qos, bool retain) {
+    if (topic.size() > kMaxTopic || payload.size() > kMaxPayload) return false;
+    us = std::max(us, ultimoUs_);
+    if (us >= siguienteIndiceUs_) {
+      const EntradaIndice e{us, bytes_};
+      indice_.append(reinterpret_cast<const char*>(&e), sizeof(e));
+      siguienteIndiceUs_ = us - us % kPasoIndiceUs + kPasoIndiceUs;
+    }
+    char cab[kRegistro];
+    const uint16_t lenPayload = uint16_t(payload.size());
+    std::memcpy(cab, &us, 8);
+    std::memcpy(cab + 8, &lenPayload, 2);
+    cab[10] = char(topic.size());
+    cab[11] = char((retain ? 1 : 0) | (qos & 3) << 1);
+    uint32_t crc = crc32(cab, 12);
+    crc = crc32(topic.data(), topic.size(), crc);
+    crc = crc32(payload.data(), payload.size(), crc);
+    std::memcpy(cab + 12, &crc, 4);
+    buf_.append(cab, sizeof(cab));
+    buf_.append(topic.data(), topic.size());
+    buf_.append(payload.data(), payload.size());
+    bytes_ += kRegistro + topic.size() + payload.size();
+    ultimoUs_ = us;
+    registros_++;
+    if (buf_.size() >= kFlushBytes) return escribir();
+    return true;
+  }
+
+  // escribe lo pendiente (primero los datos y luego el índice, para que el índice nunca apunte más allá)
+  bool escribir() {
+    if (fd_ < 0) return false;
+    const bool ok = detail::escribirTodo(fd_, buf_.data(), buf_.size()) &&
+                    detail::escribirTodo(idx_, indice_.data(), indice_.size());
+    buf_.clear();
+    indice_.clear();
+    return ok;
+  }
+
+  // y lo lleva al disco
+  bool sync() { return escribir() && ::fdatasync(fd_) == 0 && ::fdatasync(idx_) == 0; }
+
+  void close() {
+    if (fd_ >= 0) {
+      sync();
+      ::close(fd_);
+    }
+    if (idx_ >= 0) ::close(idx_);
+    fd_ = idx_ = -1;
+    buf_.clear();
+    indice_.clear();
+    registros_ = bytes_ = ultimoUs_ = siguienteIndiceUs_ = 0;
+  }
+
+  uint64_t registros() const { return registros_; } // los añadidos desde open()
+  uint64_t bytes() const { return bytes_; }
+
+ private:
+  static constexpr size_t kFlushBytes = 256 * 1024;
+
+  // el índice vale hasta su última entrada que apunta dentro del fichero; desde ella se recorre lo que queda (como
+  //   mucho un segundo de registros más lo escrito después del último índice) y se corta en el primero roto
+  bool retomar(const std::string& path, uint64_t tam) {
+    uint32_t cab[2] = {};
+    if (tam < kCabecera || ::pread(fd_, cab, sizeof(cab), 0) != ssize_t(sizeof(cab)) || cab[0] != kMagic ||
+        cab[1] != kVersion) {
+      std::fprintf(stderr, "grabación: %s no es una grabación\n", path.c_str());
+      return false;
+    }
+    std::vector<EntradaIndice> indice;
+    struct stat st;
+    if (::fstat(idx_, &st) != 0) return false;
+    indice.resize(size_t(st.st_size) / sizeof(EntradaIndice));
+    if (!indice.empty() && ::pread(idx_, indice.data(), indice.size() * sizeof(EntradaIndice), 0) < 0) return false;
+    while (!indice.empty() && (indice.back().offset >= tam || indice.back().offset < kCabecera)) indice.pop_back();
+
+    uint64_t pos = kCabecera;
+    if (!indice.empty()) {
+      pos = indice.back().offset;
+      indice.pop_back(); // se vuelve a poner al recorrer su registro
+    }
+    std::vector<uint8_t> cola(size_t(tam - pos));
+    if (::pread(fd_, cola.data(), cola.size(), off_t(pos)) != ssize_t(cola.size())) return false;
+    size_t i = 0;
+    Registro r;
+    for (size_t n; (n = detail::leerRegistro(cola.data() + i, cola.size() - i, r)) != 0; i += n) {
+      if (r.us >= siguienteIndiceUs_) {
+        indice.push_back({r.us, pos + i});
+        siguienteIndiceUs_ = r.us - r.us % kPasoIndiceUs + kPasoIndiceUs;
+      }
+      ultimoUs_ = r.us;
+    }
+    pos += i;
+    if (pos != tam) {
+      std::fprintf(stderr, "grabación: %s cortado a %llu bytes (%llu descartados)\n", path.c_str(),
+                   (unsigned long long)pos, (unsigned long long)(tam - pos));
+      if (::ftruncate(fd_, off_t(pos)) != 0) return false;
+    }
+    if (::ftruncate(idx_, 0) != 0 ||
+        !detail::escribirTodo(idx_, indice.data(), indice.size() * sizeof(EntradaIndice))) {
+      return false;
+    }
+    bytes_ = pos;
+    return ::lseek(fd_, off_t(pos), SEEK_SET) == off_t(pos);
+  }
+
+  int fd_ = -1;
+  int idx_ = -1;
+  std::string buf_;
+  std::string indice_; // entradas pendientes de escribir
+  uint64_t registros_ = 0;
+  uint64_t bytes_ = 0;
+  uint64_t ultimoUs_ = 0;
+  uint64_t siguienteIndiceUs_ = 0;
+};
+
+// --- LECTURA ---
+class Lector {
+ public:
+  Lector() = default;
+  Lector(const Lector&) = delete;
+  Lector& operator=(const Lector&) = delete;
+  ~Lector() { close(); }
+
+  // mapea el fichero y carga el índice (si falta o no cuadra, lo rehace en memoria recorriendo los registros)
+  bool open(const std::string& path) {
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      std::fprintf(stderr, "grabación: no se puede abrir %s: %s\n", path.c_str(), std::strerror(errno));
+      return false;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || size_t(st.st_size) < kCabecera) {
+      ::close(fd);
+      std::fprintf(stderr, "grabación: %s no es una grabación\n", path.c_str());
+      return false;
+    }
+    void* m = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) return false;
+    map_ = static_cast<const uint8_t*>(m);
+    size_ = size_t(st.st_size);
+    uint32_t cab[2];
+    std::memcpy(cab, map_, sizeof(cab));
+    std::memcpy(&creado_, map_ + 8, 8);
+    if (cab[0] != kMagic || cab[1] != kVersion) {
+      std::fprintf(stderr, "grabación: %s no es una grabación\n", path.c_str());
+      close();
+      return false;
+    }
+    ::madvise(m, size_, MADV_SEQUENTIAL); // la reproducción lo lee de principio a fin
+    cargarIndice(path);
+    fin_ = indice_.empty() ? kCabecera : indice_.back().offset;
+    Registro r;
+    for (size_t n; (n = detail::leerRegistro(map_ + fin_, size_ - fin_, r)) != 0; fin_ += n) ultimoUs_ = r.us;
+    return true;
+  }
+
+  // registros con us en [desdeUs, hastaUs), en orden; fn(const Registro&) devuelve false para parar
+  template <class Fn>
+  void forEach(uint64_t desdeUs, uint64_t hastaUs, Fn&& fn) const {
+    // la última entrada del índice anterior o igual a desde: sus registros pueden ser todos anteriores, pero como
+    //   mucho un segundo
+    auto it = std::upper_bound(indice_.begin(), indice_.end(), desdeUs,
+                               [](uint64_t us, const EntradaIndice& e) { return us < e.us; });
+    size_t pos = it == indice_.begin() ? kCabecera : size_t((it - 1)->offset);
+    Registro r;
+    for (size_t n; pos < fin_ && (n = detail::leerRegistro(map_ + pos, fin_ - pos, r)) != 0; pos += n) {
+      if (r.us < desdeUs) continue;
+      if (r.us >= hastaUs || !fn(r)) return;
+    }
+  }
+
+  template <class Fn>
+  void forEach(Fn&& fn) const {
+    forEach(0, UINT64_MAX, fn);
+  }
+
+  bool vacio() const { return indice_.empty(); }
+  uint64_t primeroUs() const { return indice_.empty() ? 0 : indice_.front().us; }
+  uint64_t ultimoUs() const { return ultimoUs_; }
+  uint64_t creadoUs() const { return creado_; }
+  size_t bytes() const { return fin_; }            // hasta el último registro entero
+  size_t entradasIndice() const { return indice_.size(); }
+  bool indiceRehecho() const { return rehecho_; }
+
+  void close() {
+    if (map_) ::munmap(const_cast<uint8_t*>(map_), size_);
+    map_ = nullptr;
+    size_ = fin_ = 0;
+    indice_.clear();
+    ultimoUs_ = creado_ = 0;
+    rehecho_ = false;
+  }
+
+ private:
+  // entradas crecientes que apuntan a registros enteros de este fichero; si no, se rehace todo
+  void cargarIndice(const std::string& path) {
+    indice_.clear();
+    rehecho_ = false;
+    const int fd = ::open(detail::rutaIndice(path).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+      struct stat st;
+      if (::fstat(fd, &st) == 0) {
+        indice_.resize(size_t(st.st_size) / sizeof(EntradaIndice));
+        if (::pread(fd, indice_.data(), indice_.size() * sizeof(EntradaIndice), 0) < 0) indice_.clear();
+      }
+      ::close(fd);
+    }
+    // el grabador escribe los datos antes que el índice: alguna entrada final puede faltar, pero no sobrar
+    while (!indice_.empty() && indice_.back().offset >= size_) indice_.pop_back();
+    // crecientes, y la primera y la última apuntan a su registro (leer todos tocaría todas las páginas del fichero)
+    Registro r;
+    const auto apunta = [&](const EntradaIndice& e) {
+      return e.offset >= kCabecera && detail::leerRegistro(map_ + e.offset, size_ - e.offset, r) && r.us == e.us;
+    };
+    bool ok = indice_.empty() ? size_ == kCabecera : apunta(indice_.front()) && apunta(indice_.back());
+    for (size_t i = 1; ok && i < indice_.size(); i++) ok = indice_[i].us > indice_[i - 1].us;
+    if (ok) return;
+    rehecho_ = true;
+    indice_.clear();
+    uint64_t siguiente = 0;
+    size_t pos = kCabecera;
+    for (size_t n; (n = detail::leerRegistro(map_ + pos, size_ - pos, r)) != 0; pos += n) {
+      if (indice_.empty() || r.us >= siguiente) {
+        indice_.push_back({r.us, pos});
+        siguiente = r.us - r.us % kPasoIndiceUs + kPasoIndiceUs;
+      }
+    }
+  }
+
+  const uint8_t* map_ = nullptr;
+  size_t size_ = 0;
+  size_t fin_ = 0;
+  uint64_t creado_ = 0;
+  uint64_t ultimoUs_ = 0;
+  std::vector<EntradaIndice> indice_;
+  bool rehecho_ = false;
+};
+
+}  // namespace grab
@@ -0,0 +1,127 @@
+// --- CLIENTE HTTP/1.1 MÍNIMO ---
+// una petición por conexión (Connection: close), bloqueante y con plazo total: para subidas poco frecuentes como las de
+//   ThingSpeak, desde un hilo que puede esperar. Sin TLS: habla HTTP en claro.
+#pragma once
+
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace http {
+
+struct Resultado {
+  int status = 0; // 0 = no hubo respuesta (conexión, plazo o respuesta que no se entiende)
+  std::string cuerpo;
+};
+
+namespace detail {
+
+inline int64_t restanteMs(std::chrono::steady_clock::time_point limite) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(limite - std::chrono::steady_clock::now()).count();
+}
+
+// espera a que fd esté listo para events sin pasarse del límite
+inline bool esperar(int fd, short events, std::chrono::steady_clock::time_point limite) {
+  for (;;) {
+    const int64_t ms = restanteMs(limite);
+    if (ms <= 0) return false;
+    pollfd p{fd, events, 0};
+    const int r = ::poll(&p, 1, int(ms));
+    if (r > 0) return true;
+    if (r == 0 || errno != EINTR) return false;
+  }
+}
+
+}  // namespace detail
+
+// manda metodo ruta a host:port con el cuerpo dado y lee la respuesta entera, todo en plazoMs
+inline Resultado peticion(const std::string& host, uint16_t port, std::string_view metodo, std::string_view ruta,
+                          std::string_view tipo, std::string_view cuerpo, int plazoMs) {
+  Resultado res;
+  const auto limite = std::chrono::steady_clock::now() + std::chrono::milliseconds(plazoMs);
+  addrinfo hints{};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* ai = nullptr;
+  char puerto[8];
+  std::snprintf(puerto, sizeof(puerto), "%u", port);
+  if (getaddrinfo(host.c_str(), puerto, &hints, &ai) != 0 || !ai) return res;
+  const int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) {
+    freeaddrinfo(ai);
+    return res;
+  }
+  const int r = connect(fd, ai->ai_addr, ai->ai_addrlen);
+  freeaddrinfo(ai);
+  int err = 0;
+  socklen_t len = sizeof(err);
+  if ((r < 0 && errno != EINPROGRESS) || !detail::esperar(fd, POLLOUT, limite) ||
+      getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0 || err) {
+    ::close(fd);
+    return res;
+  }
+
+  std::string req;
+  req.reserve(256 + cuerpo.size());
+  req.append(metodo).append(" ").append(ruta).append(" HTTP/1.1\r\nHost: ").append(host);
+  req.append("\r\nConnection: close\r\nContent-Type: ").append(tipo);
+  req.append("\r\nContent-Length: ").append(std::to_string(cuerpo.size())).append("\r\n\r\n").append(cuerpo);
+  for (size_t off = 0; off < req.size();) {
+    const ssize_t n = send(fd, req.data() + off, req.size() - off, MSG_NOSIGNAL);
+    if (n > 0) {
+      off += size_t(n);
+    } else if (n < 0 && (errno == EAGAIN || errno == EINTR)) {
+      if (!detail::esperar(fd, POLLOUT, limite)) return ::close(fd), res;
+    } else {
+      return ::close(fd), res;
+    }
+  }
+
+  // hasta que el servidor cierre o hayamos leído Content-Length
+  std::string resp;
+  char buf[4096];
+  size_t finCab = std::string::npos, total = std::string::npos;
+  while (total == std::string::npos || resp.size() < total) {
+    const ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n > 0) {
+      resp.append(buf, size_t(n));
+    } else if (n == 0) {
+      break;
+    } else if (errno == EAGAIN || errno == EINTR) {
+      if (!detail::esperar(fd, POLLIN, limite)) return ::close(fd), res;
+      continue;
+    } else {
+      return ::close(fd), res;
+    }
+    if (finCab == std::string::npos && (finCab = resp.find("\r\n\r\n")) != std::string::npos) {
+      // Content-Length en cualquier combinación de mayúsculas
+      for (size_t i = 0; i < finCab; i++) {
+        if (strncasecmp(resp.c_str() + i, "\r\ncontent-length:", 17) == 0) {
+          total = finCab + 4 + size_t(std::strtoull(resp.c_str() + i + 17, nullptr, 10));
+          break;
+        }
+      }
+    }
+  }
+  ::close(fd);
+  if (finCab == std::string::npos || resp.compare(0, 5, "HTTP/") != 0) return res;
+  const size_t sp = resp.find(' ');
+  res.status = std::atoi(resp.c_str() + sp + 1);
+  res.cuerpo = resp.substr(finCab + 4, total == std::string::npos ? std::string::npos : total - finCab - 4);
+  return res;
+}
+
+}  // namespace http
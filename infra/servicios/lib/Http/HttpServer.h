@@ -0,0 +1,309 @@
+// --- SERVIDOR HTTP/1.1 MÍNIMO ---
+// para servicios que contestan JSON pequeño a muchos clientes que preguntan a menudo (Home Assistant, Alexa, los
+//   dashboards). Cada hilo tiene su propio socket de escucha (SO_REUSEPORT: el kernel reparte las conexiones) y su
+//   epoll, así que los hilos no comparten nada salvo lo que comparta el manejador.
+//
+//   - keep-alive por defecto (HTTP/1.1) y peticiones encadenadas en la misma conexión
+//   - cuerpo solo con Content-Length (sin chunked); cabeceras hasta 16 KB y cuerpo hasta 1 MB
+//   - el manejador rellena una Respuesta que se reutiliza entre peticiones del mismo hilo: no reserva memoria por
+//     petición una vez que los buffers han crecido
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace http {
+
+struct Peticion {
+  std::string_view metodo, ruta, query, cuerpo; // ruta sin la query (lo que va tras '?')
+};
+
+struct Respuesta {
+  int status = 200;
+  const char* tipo = "application/json; charset=utf-8";
+  std::string cuerpo;
+};
+
+inline const char* textoStatus(int s) {
+  switch (s) {
+    case 200: return "OK";
+    case 202: return "Accepted";
+    case 204: return "No Content";
+    case 400: return "Bad Request";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 413: return "Payload Too Large";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 503: return "Service Unavailable";
+    default: return "";
+  }
+}
+
+class Servidor {
+ public:
+  using Manejador = std::function<void(const Peticion&, Respuesta&)>;
+
+  ~Servidor() {
+    for (int fd : escucha_) ::close(fd);
+  }
+
+  // un socket de escucha por hilo en host:port (port 0 = uno libre, ver port())
+  bool listen(const char* host, uint16_t port, uint32_t hilos) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) return false;
+    for (uint32_t i = 0; i < hilos; i++) {
+      const int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      if (fd < 0) return false;
+      escucha_.push_back(fd);
+      const int one = 1;
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+      setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+      if (bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, 1024) < 0) {
+        std::fprintf(stderr, "http: no se puede escuchar en %s:%u: %s\n", host, port, std::strerror(errno));
+        return false;
+      }
+      // con port 0 el primero elige y los demás se unen a ese
+      socklen_t len = sizeof(addr);
+      getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    }
+    port_ = ntohs(addr.sin_port);
+    return true;
+  }
+
+  uint16_t port() const { return port_; }
+
+  // atiende en un hilo por socket de escucha hasta que fin sea true (lo mira cada 200 ms)
+  void run(const Manejador& manejador, const std::atomic<bool>& fin) {
+    std::vector<std::thread> hilos;
+    for (int fd : escucha_) hilos.emplace_back([&, fd] { Bucle(fd, manejador, fin)(); });
+    for (std::thread& h : hilos) h.join();
+  }
+
+ private:
+  struct Conexion {
+    int fd;
+    std::string entrada, salida;
+    bool cerrar = false;    // tras mandar lo que queda
+    bool esperaOut = false; // registrada con EPOLLOUT
+  };
+
+  class Bucle {
+   public:
+    Bucle(int escucha, const Manejador& m, const std::atomic<bool>& fin)
+        : escucha_(escucha), manejador_(m), fin_(fin), ep_(epoll_create1(EPOLL_CLOEXEC)) {}
+    ~Bucle() { ::close(ep_); }
+
+    void operator()() {
+      epoll_event ev{};
+      ev.events = EPOLLIN;
+      ev.data.ptr = nullptr; // nullptr = el socket de escucha
+      epoll_ctl(ep_, EPOLL_CTL_ADD, escucha_, &ev);
+      epoll_event evs[128];
+      while (!fin_.load(std::memory_order_relaxed)) {
+        const int n = epoll_wait(ep_, evs, 128, 200);
+        for (int i = 0; i < n; i++) {
+          if (!evs[i].data.ptr) {
+            aceptar();
+            continue;
+          }
+          Conexion* c = static_cast<Conexion*>(evs[i].data.ptr);
+          const bool viva = (evs[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) ? leer(*c) : escribir(*c);
+          if (!viva) cerrar(c);
+        }
+      }
+      for (auto& [fd, c] : conexiones_) ::close(fd);
+    }
+
+   private:
+    void aceptar() {
+      for (;;) {
+        const int fd = accept4(escucha_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        const int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        auto c = std::make_unique<Conexion>();
+        c->fd = fd;
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.ptr = c.get();
+        epoll_ctl(ep_, EPOLL_CTL_ADD, fd, &ev);
+        conexiones_.emplace_back(fd, std::move(c));
+      }
+    }
+
+    void cerrar(Conexion* c) {
+      epoll_ctl(ep_, EPOLL_CTL_DEL, c->fd, nullptr);
+      ::close(c->fd);
+      for (size_t i = 0; i < conexiones_.size(); i++) {
+        if (conexiones_[i].second.get() == c) {
+          conexiones_[i] = std::move(conexiones_.back());
+          conexiones_.pop_back();
+          break;
+        }
+      }
+    }
+
+    // false si hay que cerrar la conexión
+    bool leer(Conexion& c) {
+      char buf[16 * 1024];
+      for (;;) {
+        const ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+          c.entrada.append(buf, size_t(n));
+          if (size_t(n) < sizeof(buf)) break;
+          continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        return false; // cerrada por el cliente o error
+      }
+      if (!c.cerrar) atender(c);
+      return escribir(c);
+    }
+
+    bool escribir(Conexion& c) {
+      size_t off = 0;
+      while (off < c.salida.size()) {
+        const ssize_t n = send(c.fd, c.salida.data() + off, c.salida.size() - off, MSG_NOSIGNAL);
+        if (n > 0) {
+          off += size_t(n);
+          continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        return false;
+      }
+      c.salida.erase(0, off);
+      const bool quiereOut = !c.salida.empty();
+      if (quiereOut != c.esperaOut) {
+        epoll_event ev{};
+        ev.events = quiereOut ? EPOLLOUT : EPOLLIN;
+        ev.data.ptr = &c;
+        epoll_ctl(ep_, EPOLL_CTL_MOD, c.fd, &ev);
+        c.esperaOut = quiereOut;
+      }
+      return quiereOut || !c.cerrar;
+    }
+
+    // procesa todas las peticiones completas que haya en la entrada
+    void atender(Conexion& c) {
+      size_t pos = 0;
+      while (!c.cerrar) {
+        const std::string_view resto(c.entrada.data() + pos, c.entrada.size() - pos);
+        const size_t finCab = resto.find("\r\n\r\n");
+        if (finCab == std::string_view::npos) {
+          if (resto.size() > 16 * 1024) error(c, 431);
+          break;
+        }
+        Peticion p;
+        bool cerrar = false;
+        size_t largo = 0;
+        if (!cabeceras(resto.substr(0, finCab), p, cerrar, largo)) {
+          error(c, 400);
+          break;
+        }
+        if (largo > 1024 * 1024) {
+          error(c, 413);
+          break;
+        }
+        if (resto.size() < finCab + 4 + largo) break; // falta cuerpo
+        p.cuerpo = resto.substr(finCab + 4, largo);
+        resp_.status = 200;
+        resp_.tipo = "application/json; charset=utf-8";
+        resp_.cuerpo.clear();
+        manejador_(p, resp_);
+        c.cerrar = cerrar;
+        responder(c);
+        pos += finCab + 4 + largo;
+      }
+      c.entrada.erase(0, pos);
+    }
+
+    static bool cabeceras(std::string_view cab, Peticion& p, bool& cerrar, size_t& largo) {
+      size_t eol = cab.find("\r\n");
+      const std::string_view linea = cab.substr(0, eol);
+      const size_t a = linea.find(' '), b = linea.rfind(' ');
+      if (a == std::string_view::npos || b <= a) return false;
+      p.metodo = linea.substr(0, a);
+      std::string_view uri = linea.substr(a + 1, b - a - 1);
+      const std::string_view version = linea.substr(b + 1);
+      cerrar = version == "HTTP/1.0";
+      const size_t q = uri.find('?');
+      if (q != std::string_view::npos) {
+        p.query = uri.substr(q + 1);
+        uri = uri.substr(0, q);
+      }
+      p.ruta = uri;
+      while (eol != std::string_view::npos) {
+        const size_t ini = eol + 2;
+        eol = cab.find("\r\n", ini);
+        const std::string_view h = cab.substr(ini, eol == std::string_view::npos ? std::string_view::npos : eol - ini);
+        const size_t dos = h.find(':');
+        if (dos == std::string_view::npos) continue;
+        const std::string_view k = h.substr(0, dos);
+        std::string_view v = h.substr(dos + 1);
+        while (!v.empty() && v.front() == ' ') v.remove_prefix(1);
+        if (k.size() == 14 && strncasecmp(k.data(), "Content-Length", 14) == 0) {
+          largo = size_t(std::strtoull(std::string(v).c_str(), nullptr, 10));
+        } else if (k.size() == 10 && strncasecmp(k.data(), "Connection", 10) == 0) {
+          if (v.size() == 5 && strncasecmp(v.data(), "close", 5) == 0) cerrar = true;
+          if (v.size() == 10 && strncasecmp(v.data(), "keep-alive", 10) == 0) cerrar = false;
+        }
+      }
+      return true;
+    }
+
+    void error(Conexion& c, int status) {
+      resp_.status = status;
+      resp_.tipo = "application/json; charset=utf-8";
+      resp_.cuerpo = "{\"error\":\"";
+      resp_.cuerpo += textoStatus(status);
+      resp_.cuerpo += "\"}";
+      c.cerrar = true;
+      responder(c);
+    }
+
+    void responder(Conexion& c) {
+      char cab[256];
+      const int n = std::snprintf(cab, sizeof(cab), "HTTP/1.1 %d %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n%s\r\n",
+                                  resp_.status, textoStatus(resp_.status), resp_.tipo, resp_.cuerpo.size(),
+                                  c.cerrar ? "Connection: close\r\n" : "");
+      c.salida.append(cab, size_t(n));
+      c.salida += resp_.cuerpo;
+    }
+
+    const int escucha_;
+    const Manejador& manejador_;
+    const std::atomic<bool>& fin_;
+    const int ep_;
+    std::vector<std::pair<int, std::unique_ptr<Conexion>>> conexiones_;
+    Respuesta resp_;
+  };
+
+  std::vector<int> escucha_;
+  uint16_t port_ = 0;
+};
+
+}  // namespace http
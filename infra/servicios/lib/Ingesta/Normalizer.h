@@ -0,0 +1,179 @@
+// --- NORMALIZACIÓN DE LOS TOPICS CRUDOS A TELEMETRÍA ---
+// hace lo mismo que las funciones DH11_to_telemetry, soil_to_telemetry, ldr_to_telemetry, mq135_to_telemetry y
+//   agua_to_telemetry de Node-RED: del payload crudo de un nodo saca el valor (con los mismos nombres de campo
+//   alternativos) y genera {"ts":..,"type":"..","value":..} en greenhouse/<nodo>/telemetry. Además:
+//   - valida el rango de cada valor (Node-RED solo comprobaba que fuese un número)
+//   - acepta los lotes binarios de <topic>/bin (ver BatchFormat.h) y los expande con TelemetryJson.h
+//   - si la lectura trae "seq" (número de lectura del nodo, ver SensorNode.h) lo copia a la telemetría, para que la
+//     herramienta latencias pueda emparejar cada mensaje normalizado con el crudo
+//   - no reserva memoria: el payload se recorre con JsonScan sobre el buffer recibido y el JSON de salida se escribe en
+//     un buffer de la pila
+#pragma once
+
+#include <JsonScan.h>
+#include <TelemetryJson.h>
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+
+namespace ingesta {
+
+enum class Resultado : uint8_t { Ok, Desconocido, Invalido, FueraDeRango };
+
+struct Rango {
+  const char* type;
+  double min, max;
+};
+
+// rangos admitidos (los del sensor con algo de margen); fuera de ellos la lectura se descarta
+constexpr Rango kRangos[] = {
+    {"temp", -20, 60},   // DHT11: 0-50 ºC
+    {"hum", 0, 100},
+    {"soil", 0, 100},
+    {"light", 0, 100},
+    {"aire", 0, 100},
+    {"tank", 0, 100},
+};
+
+inline bool enRango(const char* type, double v) {
+  for (const Rango& r : kRangos) {
+    if (std::string_view(type) == r.type) return v >= r.min && v <= r.max;
+  }
+  return false;
+}
+
+// {"ts":..,"type":"..","value":..} con el número como lo escribe JSON.stringify (sin ceros de sobra), y "seq" al final
+//   si la lectura lo traía (seq >= 0)
+inline size_t formatValue(char* buf, size_t cap, uint64_t ts, const char* type, double value, int64_t seq = -1) {
+  const int n =
+      seq < 0 ? std::snprintf(buf, cap, "{\"ts\":%llu,\"type\":\"%s\",\"value\":%.15g}", (unsigned long long)ts, type,
+                              value)
+              : std::snprintf(buf, cap, "{\"ts\":%llu,\"type\":\"%s\",\"value\":%.15g,\"seq\":%lld}",
+                              (unsigned long long)ts, type, value, (long long)seq);
+  return n > 0 && size_t(n) < cap ? size_t(n) : 0;
+}
+
+namespace detail {
+
+// primer campo presente de la lista, en el orden de prioridad de la función de Node-RED. En la misma pasada deja en
+//   *seq el "seq" de la lectura (-1 si no lo trae)
+template <size_t N>
+bool campo(std::string_view payload, const char* const (&nombres)[N], double& out, int64_t* seq = nullptr) {
+  std::string_view hallado[N];
+  std::string_view s;
+  if (!json::forEachField(payload, [&](std::string_view k, std::string_view v) {
+        for (size_t i = 0; i < N; i++) {
+          if (k == nombres[i]) hallado[i] = v;
+        }
+        if (k == "seq") s = v;
+      })) {
+    // las funciones de Node-RED también aceptaban un número suelto como payload
+    return json::toDouble(payload, out);
+  }
+  if (seq) {
+    double d;
+    *seq = s.data() && json::toDouble(s, d) && d >= 0 ? int64_t(d) : -1;
+  }
+  for (size_t i = 0; i < N; i++) {
+    if (hallado[i].data()) return json::toDouble(hallado[i], out);
+  }
+  return false;
+}
+
+template <class Emit>
+Resultado emitir(const char* topic, const char* type, double v, uint64_t ts, int64_t seq, Emit& emit) {
+  if (!std::isfinite(v)) return Resultado::Invalido;
+  if (!enRango(type, v)) return Resultado::FueraDeRango;
+  char json[112];
+  const size_t len = formatValue(json, sizeof(json), ts, type, v, seq);
+  if (!len) return Resultado::Invalido;
+  emit(std::string_view(topic), std::string_view(json, len));
+  return Resultado::Ok;
+}
+
+// los nodos ya publican el porcentaje; si solo llega el raw del ADC lo convertimos como los drivers
+inline double porcentajeRaw(double raw, bool invertido) {
+  const double p = std::floor(raw * 100 / 1023);
+  return invertido ? 100 - p : p;
+}
+
+}  // namespace detail
+
+// normaliza un mensaje de un topic crudo y llama a emit(topic, json) por cada mensaje de telemetría.
+//   ts es la hora de recepción en el servidor (ms desde 1970), como el Date.now() de Node-RED.
+template <class Emit>
+Resultado normalize(std::string_view topic, std::string_view payload, uint64_t ts, Emit&& emit) {
+  using detail::emitir;
+  if (topic == "dht11") {
+    static const char* const kTemp[] = {"temperatura", "temp", "temperature", "t"};
+    static const char* const kHum[] = {"humedad", "hum", "humidity", "h"};
+    double t, h;
+    int64_t seq = -1;
+    if (!detail::campo(payload, kTemp, t, &seq) || !detail::campo(payload, kHum, h)) return Resultado::Invalido;
+    // Node-RED trunca a 2 decimales, sin redondear
+    t = std::trunc(t * 100) / 100;
+    h = std::trunc(h * 100) / 100;
+    if (!std::isfinite(t) || !std::isfinite(h)) return Resultado::Invalido;
+    if (!enRango("temp", t) || !enRango("hum", h)) return Resultado::FueraDeRango;
+    emitir("greenhouse/node1/telemetry", "temp", t, ts, seq, emit);
+    return emitir("greenhouse/node1/telemetry", "hum", h, ts, seq, emit);
+  }
+  if (topic == "soil") {
+    static const char* const kSoil[] = {"humedad", "moisture", "soil", "value"};
+    static const char* const kRaw[] = {"raw"};
+    double v;
+    int64_t seq = -1;
+    if (!detail::campo(payload, kSoil, v, &seq)) {
+      if (!detail::campo(payload, kRaw, v)) return Resultado::Invalido;
+      v = detail::porcentajeRaw(v, true);
+    }
+    return emitir("greenhouse/node2/telemetry", "soil", v, ts, seq, emit);
+  }
+  if (topic == "ldr") {
+    static const char* const kLuz[] = {"luz", "light", "ldr", "value"};
+    static const char* const kRaw[] = {"raw"};
+    double v;
+    int64_t seq = -1;
+    if (!detail::campo(payload, kLuz, v, &seq)) {
+      if (!detail::campo(payload, kRaw, v)) return Resultado::Invalido;
+      v = detail::porcentajeRaw(v, false);
+    }
+    return emitir("greenhouse/node3/telemetry", "light", v, ts, seq, emit);
+  }
+  if (topic == "mq135") {
+    static const char* const kPct[] = {"percentage"};
+    double v;
+    int64_t seq = -1;
+    if (!detail::campo(payload, kPct, v, &seq)) return Resultado::Invalido;
+    return emitir("greenhouse/node4/telemetry", "aire", v, ts, seq, emit);
+  }
+  if (topic == "nivel_agua") {
+    static const char* const kNivel[] = {"nivel", "level", "value"};
+    double v;
+    int64_t seq = -1;
+    if (!detail::campo(payload, kNivel, v, &seq)) return Resultado::Invalido;
+    return emitir("greenhouse/node4/telemetry", "tank", std::round(v), ts, seq, emit);
+  }
+  if (topic.size() > 4 && topic.substr(topic.size() - 4) == "/bin") {
+    const int n = telemetry::expand(reinterpret_cast<const uint8_t*>(payload.data()), payload.size(), ts, emit);
+    return n < 0 ? Resultado::Invalido : Resultado::Ok;
+  }
+  return Resultado::Desconocido;
+}
+
+// clave de reparto entre los hilos de la pasarela: todo lo que acaba en el mismo topic de telemetría (o viene del mismo
+//   nodo en binario) va al mismo hilo, y así conserva el orden
+inline uint32_t claveNodo(std::string_view topic, std::string_view payload) {
+  if (topic.size() > 4 && topic.substr(topic.size() - 4) == "/bin" && payload.size() >= batch::kHeaderSize) {
+    const auto* p = reinterpret_cast<const uint8_t*>(payload.data());
+    return uint32_t(p[5]) | uint32_t(p[6]) << 8 | uint32_t(p[7]) << 16 | uint32_t(p[8]) << 24; // nodeId
+  }
+  if (topic == "dht11") return 1;
+  if (topic == "soil") return 2;
+  if (topic == "ldr") return 3;
+  return 4; // mq135 y nivel_agua comparten greenhouse/node4/telemetry
+}
+
+}  // namespace ingesta
@@ -0,0 +1,48 @@
+// --- COLA CIRCULAR DE UN PRODUCTOR Y UN CONSUMIDOR ---
+// sin locks: el productor solo escribe head_ y el consumidor solo tail_. Los huecos están reservados desde el principio
+//   (N potencia de 2), así que pasar un mensaje de un hilo a otro no reserva memoria.
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+template <class T, size_t N>
+class SpscRing {
+  static_assert(N && (N & (N - 1)) == 0, "N tiene que ser potencia de 2");
+
+ public:
+  SpscRing() : slots_(new T[N]) {}
+
+  // hueco donde escribir el siguiente elemento (o nullptr si está llena); se publica con push()
+  T* prepare() {
+    const size_t h = head_.load(std::memory_order_relaxed);
+    if (h - tailCache_ == N) {
+      tailCache_ = tail_.load(std::memory_order_acquire);
+      if (h - tailCache_ == N) return nullptr;
+    }
+    return &slots_[h & (N - 1)];
+  }
+  void push() { head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  // elemento más antiguo (o nullptr si está vacía); se libera con pop()
+  T* front() {
+    const size_t t = tail_.load(std::memory_order_relaxed);
+    if (t == headCache_) {
+      headCache_ = head_.load(std::memory_order_acquire);
+      if (t == headCache_) return nullptr;
+    }
+    return &slots_[t & (N - 1)];
+  }
+  void pop() { tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+
+  size_t size() const { return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire); }
+
+ private:
+  std::unique_ptr<T[]> slots_;
+  // cada índice en su línea de caché, con la copia que el otro hilo lee sin tocar la del contrario
+  alignas(64) std::atomic<size_t> head_{0};
+  size_t tailCache_ = 0;
+  alignas(64) std::atomic<size_t> tail_{0};
+  size_t headCache_ = 0;
+};
@@ -0,0 +1,72 @@
+// --- LECTOR DE JSON PLANO SIN COPIAS ---
+// los payloads de los nodos son objetos JSON planos ({"luz":50,"raw":512}). En lugar de construir un árbol, este lector
+//   recorre el texto una vez y devuelve cada par clave/valor como string_view sobre el buffer original, sin reservar
+//   memoria. No admite objetos anidados ni escapes en las claves (los nodos no los generan).
+#pragma once
+
+#include <cstdlib>
+#include <string_view>
+
+namespace json {
+
+// recorre los pares del objeto y llama a fn(clave, valor) con el valor en crudo (número, true/false/null o "texto"
+//   sin comillas). Devuelve false si el texto no es un objeto plano bien formado.
+template <class Fn>
+bool forEachField(std::string_view s, Fn&& fn) {
+  size_t i = 0;
+  auto isWs = [](char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; };
+  auto skipWs = [&] {
+    while (i < s.size() && isWs(s[i])) i++;
+  };
+  skipWs();
+  if (i >= s.size() || s[i] != '{') return false;
+  i++;
+  skipWs();
+  if (i < s.size() && s[i] == '}') return true;
+  while (i < s.size()) {
+    skipWs();
+    if (i >= s.size() || s[i] != '"') return false;
+    const size_t k0 = ++i;
+    while (i < s.size() && s[i] != '"') i++;
+    if (i >= s.size()) return false;
+    const std::string_view key = s.substr(k0, i - k0);
+    i++;
+    skipWs();
+    if (i >= s.size() || s[i] != ':') return false;
+    i++;
+    skipWs();
+    std::string_view value;
+    if (i < s.size() && s[i] == '"') {
+      const size_t v0 = ++i;
+      while (i < s.size() && s[i] != '"') i += s[i] == '\\' ? 2 : 1;
+      if (i >= s.size()) return false;
+      value = s.substr(v0, i - v0);
+      i++;
+    } else {
+      const size_t v0 = i;
+      while (i < s.size() && s[i] != ',' && s[i] != '}' && !isWs(s[i])) i++;
+      value = s.substr(v0, i - v0);
+      if (value.empty() || s[v0] == '{' || s[v0] == '[') return false;
+    }
+    fn(key, value);
+    skipWs();
+    if (i >= s.size()) return false;
+    if (s[i] == '}') return true;
+    if (s[i] != ',') return false;
+    i++;
+  }
+  return false;
+}
+
+// convierte un valor numérico; false si no es un número completo
+inline bool toDouble(std::string_view v, double& out) {
+  if (v.empty() || v.size() > 31) return false;
+  char tmp[32];
+  v.copy(tmp, v.size());
+  tmp[v.size()] = '\0';
+  char* end;
+  out = std::strtod(tmp, &end);
+  return end == tmp + v.size();
+}
+
+}  // namespace json
@@ -0,0 +1,204 @@
+// --- CLIENTE MQTT SOBRE SOCKETS POSIX ---
+// net:: abre las conexiones TCP (bloqueantes o no) al broker. MqttClient es un cliente sencillo de un solo hilo, con
+//   el socket bloqueante y poll() para esperar: vale para suscriptores y servicios con una conexión. Las herramientas
+//   con miles de conexiones (carga) usan net:: y MqttCodec.h directamente con epoll.
+#pragma once
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "MqttCodec.h"
+
+namespace net {
+
+inline bool resolve(const char* host, uint16_t port, sockaddr_in& out) {
+  std::memset(&out, 0, sizeof(out));
+  out.sin_family = AF_INET;
+  out.sin_port = htons(port);
+  if (inet_pton(AF_INET, host, &out.sin_addr) == 1) return true;
+  addrinfo hints{};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  addrinfo* res = nullptr;
+  if (getaddrinfo(host, nullptr, &hints, &res) != 0 || !res) return false;
+  out.sin_addr = reinterpret_cast<sockaddr_in*>(res->ai_addr)->sin_addr;
+  freeaddrinfo(res);
+  return true;
+}
+
+// crea el socket y empieza a conectar. Con nonBlocking el connect() vuelve enseguida (EINPROGRESS) y hay que esperar
+//   a que el socket sea escribible. -1 si falla.
+inline int connectTcp(const sockaddr_in& addr, bool nonBlocking) {
+  const int fd = socket(AF_INET, SOCK_STREAM | (nonBlocking ? SOCK_NONBLOCK : 0) | SOCK_CLOEXEC, 0);
+  if (fd < 0) return -1;
+  const int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); // los mensajes son pequeños: sin Nagle
+  if (connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) < 0 && errno != EINPROGRESS) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// escribe lo que se pueda del buffer sin bloquear y quita lo escrito; false si la conexión se ha roto
+inline bool flushSome(int fd, std::string& out) {
+  while (!out.empty()) {
+    const ssize_t n = send(fd, out.data(), out.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (n > 0) {
+      out.erase(0, size_t(n));
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return true;
+    if (n < 0 && errno == EINTR) continue;
+    return false;
+  }
+  return true;
+}
+
+inline uint64_t nowMs() {
+  using namespace std::chrono;
+  return uint64_t(duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+}  // namespace net
+
+class MqttClient {
+ public:
+  ~MqttClient() { close(); }
+
+  // conecta y espera el CONNACK como mucho timeoutMs
+  bool connect(const char* host, uint16_t port, std::string_view clientId, uint16_t keepAliveS = 30,
+               uint32_t timeoutMs = 3000) {
+    close();
+    sockaddr_in addr;
+    if (!net::resolve(host, port, addr)) return false;
+    fd_ = net::connectTcp(addr, false);
+    if (fd_ < 0) return false;
+    keepAliveMs_ = uint64_t(keepAliveS) * 1000;
+    mqtt::putConnect(out_, clientId, keepAliveS);
+    if (!flush()) return false;
+    const uint64_t limit = net::nowMs() + timeoutMs;
+    while (net::nowMs() < limit) {
+      if (!readSome(int(limit - net::nowMs()))) break;
+      mqtt::Packet p;
+      if (in_.next(p)) {
+        connected_ = mqtt::connackCode(p) == 0;
+        return connected_;
+      }
+    }
+    close();
+    return false;
+  }
+
+  bool subscribe(std::string_view filter, uint8_t qos = 0) {
+    mqtt::putSubscribe(out_, nextId(), filter, qos);
+    return flush();
+  }
+
+  // se queda en el buffer de salida hasta el siguiente flush() (o poll()); así se pueden juntar varios en un send()
+  void publish(std::string_view topic, std::string_view payload, uint8_t qos = 0, bool retain = false) {
+    mqtt::putPublish(out_, topic, payload, qos, qos ? nextId() : 0, retain);
+  }
+
+  bool flush() {
+    while (!out_.empty()) {
+      if (!net::flushSome(fd_, out_)) return fail();
+      if (!out_.empty() && !waitFd(POLLOUT, 1000)) return fail();
+    }
+    lastSendMs_ = net::nowMs();
+    return true;
+  }
+
+  // espera hasta timeoutMs a que llegue algo y llama a onPublish(const mqtt::PublishView&) por cada PUBLISH.
+  //   Responde los PUBACK de QoS 1 y manda PINGREQ si toca. false si la conexión se ha caído.
+  template <class Fn>
+  bool poll(int timeoutMs, Fn&& onPublish) {
+    if (fd_ < 0) return false;
+    if (!out_.empty() && !flush()) return false;
+    if (keepAliveMs_ && net::nowMs() - lastSendMs_ >= keepAliveMs_ / 2) {
+      mqtt::putPingreq(out_);
+      if (!flush()) return false;
+    }
+    if (!readSome(timeoutMs)) return fd_ >= 0;
+    mqtt::Packet p;
+    while (in_.next(p)) {
+      mqtt::PublishView pub;
+      if (mqtt::parsePublish(p, pub)) {
+        if (pub.qos == 1) mqtt::putPuback(out_, pub.id);
+        onPublish(pub);
+      }
+    }
+    if (in_.error()) return fail();
+    return out_.empty() || flush();
+  }
+
+  void disconnect() {
+    if (fd_ < 0) return;
+    mqtt::putDisconnect(out_);
+    flush();
+    close();
+  }
+
+  void close() {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+    connected_ = false;
+    out_.clear();
+    in_.clear();
+  }
+
+  bool connected() const { return connected_; }
+  int fd() const { return fd_; }
+
+ private:
+  uint16_t nextId() {
+    if (++id_ == 0) id_ = 1;
+    return id_;
+  }
+
+  bool waitFd(short events, int timeoutMs) {
+    pollfd pfd{fd_, events, 0};
+    return ::poll(&pfd, 1, timeoutMs) > 0 && !(pfd.revents & (POLLERR | POLLHUP | POLLNVAL));
+  }
+
+  // false si no ha llegado nada en timeoutMs o si se ha cerrado la conexión (entonces fd_ queda a -1)
+  bool readSome(int timeoutMs) {
+    pollfd pfd{fd_, POLLIN, 0};
+    const int r = ::poll(&pfd, 1, timeoutMs);
+    if (r <= 0) return false;
+    const ssize_t n = recv(fd_, in_.space(64 * 1024), 64 * 1024, MSG_DONTWAIT);
+    if (n <= 0) {
+      if (n < 0 && (errno == EAGAIN || errno == EINTR)) return false;
+      fail();
+      return false;
+    }
+    in_.commit(size_t(n));
+    return true;
+  }
+
+  bool fail() {
+    close();
+    return false;
+  }
+
+  int fd_ = -1;
+  bool connected_ = false;
+  uint16_t id_ = 0;
+  uint64_t keepAliveMs_ = 0;
+  uint64_t lastSendMs_ = 0;
+  std::string out_;
+  mqtt::Reader in_;
+};
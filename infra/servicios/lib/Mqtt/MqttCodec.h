@@ -0,0 +1,220 @@
+// --- CODIFICACIÓN DE PAQUETES MQTT 3.1.1 ---
+// lo justo para hablar con Mosquitto desde las herramientas del backend sin depender de libmosquitto: escribir los
+//   paquetes que manda un cliente (CONNECT, PUBLISH, SUBSCRIBE, PUBACK, PINGREQ, DISCONNECT) y trocear lo que llega
+//   del socket en paquetes completos. No hace E/S: quien lo usa decide si el socket es bloqueante, con epoll, etc.
+//
+// Los paquetes se escriben al final de un std::string (el buffer de salida de la conexión), y Reader devuelve
+//   string_view sobre su propio buffer: leer un PUBLISH no copia ni el topic ni el payload.
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace mqtt {
+
+enum Type : uint8_t {
+  Connect = 1,
+  Connack = 2,
+  Publish = 3,
+  Puback = 4,
+  Subscribe = 8,
+  Suback = 9,
+  Pingreq = 12,
+  Pingresp = 13,
+  Disconnect = 14,
+};
+
+// --- ESCRITURA ---
+namespace detail {
+inline void putLength(std::string& out, size_t n) {
+  do {
+    uint8_t b = uint8_t(n & 0x7F);
+    n >>= 7;
+    if (n) b |= 0x80;
+    out.push_back(char(b));
+  } while (n);
+}
+inline void putU16(std::string& out, uint16_t v) {
+  out.push_back(char(v >> 8));
+  out.push_back(char(v & 0xFF));
+}
+inline void putStr(std::string& out, std::string_view s) {
+  putU16(out, uint16_t(s.size()));
+  out.append(s.data(), s.size());
+}
+}  // namespace detail
+
+inline void putConnect(std::string& out, std::string_view clientId, uint16_t keepAliveS, bool cleanSession = true) {
+  out.push_back(char(Connect << 4));
+  detail::putLength(out, 10 + 2 + clientId.size());
+  detail::putStr(out, "MQTT");
+  out.push_back(4); // nivel de protocolo 3.1.1
+  out.push_back(cleanSession ? 0x02 : 0x00);
+  detail::putU16(out, keepAliveS);
+  detail::putStr(out, clientId);
+}
+
+inline void putPublish(std::string& out, std::string_view topic, std::string_view payload, uint8_t qos = 0,
+                       uint16_t id = 0, bool retain = false) {
+  out.push_back(char(Publish << 4 | qos << 1 | (retain ? 1 : 0)));
+  detail::putLength(out, 2 + topic.size() + (qos ? 2 : 0) + payload.size());
+  detail::putStr(out, topic);
+  if (qos) detail::putU16(out, id);
+  out.append(payload.data(), payload.size());
+}
+
+inline void putSubscribe(std::string& out, uint16_t id, std::string_view filter, uint8_t qos) {
+  out.push_back(char(Subscribe << 4 | 0x02));
+  detail::putLength(out, 2 + 2 + filter.size() + 1);
+  detail::putU16(out, id);
+  detail::putStr(out, filter);
+  out.push_back(char(qos));
+}
+
+inline void putPuback(std::string& out, uint16_t id) {
+  out.push_back(char(Puback << 4));
+  out.push_back(2);
+  detail::putU16(out, id);
+}
+
+inline void putPingreq(std::string& out) {
+  out.push_back(char(Pingreq << 4));
+  out.push_back(0);
+}
+
+inline void putDisconnect(std::string& out) {
+  out.push_back(char(Disconnect << 4));
+  out.push_back(0);
+}
+
+// tamaño en bytes de un PUBLISH sin escribirlo (para las cuentas de los benchmarks)
+inline size_t publishSize(size_t topic, size_t payload, uint8_t qos = 0) {
+  const size_t remaining = 2 + topic + (qos ? 2 : 0) + payload;
+  size_t lenBytes = 1;
+  for (size_t n = remaining >> 7; n; n >>= 7) lenBytes++;
+  return 1 + lenBytes + remaining;
+}
+
+// --- LECTURA ---
+struct Packet {
+  uint8_t type;
+  uint8_t flags;         // los 4 bits bajos de la cabecera fija
+  std::string_view body; // cabecera variable + payload
+};
+
+struct PublishView {
+  std::string_view topic;
+  std::string_view payload;
+  uint8_t qos;
+  bool retain;
+  uint16_t id; // solo con qos > 0
+};
+
+inline bool parsePublish(const Packet& p, PublishView& out) {
+  if (p.type != Publish || p.body.size() < 2) return false;
+  const auto* b = reinterpret_cast<const uint8_t*>(p.body.data());
+  const size_t tlen = size_t(b[0]) << 8 | b[1];
+  out.qos = (p.flags >> 1) & 3;
+  out.retain = p.flags & 1;
+  size_t pos = 2 + tlen;
+  if (pos + (out.qos ? 2 : 0) > p.body.size()) return false;
+  out.topic = p.body.substr(2, tlen);
+  out.id = 0;
+  if (out.qos) {
+    out.id = uint16_t(b[pos] << 8 | b[pos + 1]);
+    pos += 2;
+  }
+  out.payload = p.body.substr(pos);
+  return true;
+}
+
+// código de retorno de un CONNACK (0 = aceptada); -1 si el paquete está mal
+inline int connackCode(const Packet& p) {
+  return p.type == Connack && p.body.size() == 2 ? uint8_t(p.body[1]) : -1;
+}
+
+// id del PUBACK/SUBACK
+inline uint16_t packetId(const Packet& p) {
+  return p.body.size() >= 2 ? uint16_t(uint8_t(p.body[0]) << 8 | uint8_t(p.body[1])) : 0;
+}
+
+// ¿el topic entra en el filtro de suscripción? (+ un nivel, # el resto; como el broker, "a/#" también coge "a")
+inline bool topicMatches(std::string_view filter, std::string_view topic) {
+  while (true) {
+    const size_t f = filter.find('/'), t = topic.find('/');
+    const std::string_view nivel = filter.substr(0, f);
+    if (nivel == "#") return true;
+    if (nivel != "+" && nivel != topic.substr(0, t)) return false;
+    if (f == std::string_view::npos || t == std::string_view::npos) {
+      return f == t || (t == std::string_view::npos && filter.substr(f + 1) == "#");
+    }
+    filter.remove_prefix(f + 1);
+    topic.remove_prefix(t + 1);
+  }
+}
+
+// trocea el flujo de bytes del socket en paquetes. Los string_view de next() apuntan al buffer interno: valen hasta
+//   la siguiente llamada a append() o space().
+class Reader {
+ public:
+  // zona libre donde leer directamente del socket (read(fd, r.space(n), n) y luego r.commit(leídos))
+  char* space(size_t n) {
+    compact();
+    if (buf_.size() < end_ + n) buf_.resize(end_ + n);
+    return buf_.data() + end_;
+  }
+  void commit(size_t n) { end_ += n; }
+
+  void append(const char* data, size_t n) {
+    std::memcpy(space(n), data, n);
+    commit(n);
+  }
+
+  // siguiente paquete completo; false si falta por llegar. Un paquete mal formado deja error() a true.
+  bool next(Packet& p) {
+    if (error_ || end_ - pos_ < 2) return false;
+    const auto* b = reinterpret_cast<const uint8_t*>(buf_.data() + pos_);
+    const size_t avail = end_ - pos_;
+    size_t len = 0, i = 1;
+    for (int shift = 0;; shift += 7, i++) {
+      if (i >= avail) return false;
+      if (i > 4) {
+        error_ = true;
+        return false;
+      }
+      len |= size_t(b[i] & 0x7F) << shift;
+      if (!(b[i] & 0x80)) break;
+    }
+    i++;
+    if (avail < i + len) return false;
+    p.type = b[0] >> 4;
+    p.flags = b[0] & 0x0F;
+    p.body = std::string_view(buf_.data() + pos_ + i, len);
+    pos_ += i + len;
+    return true;
+  }
+
+  bool error() const { return error_; }
+  void clear() {
+    pos_ = end_ = 0;
+    error_ = false;
+  }
+
+ private:
+  // descarta lo ya leído (solo al pedir sitio: mientras tanto los string_view siguen valiendo)
+  void compact() {
+    if (!pos_) return;
+    if (pos_ < end_) std::memmove(buf_.data(), buf_.data() + pos_, end_ - pos_);
+    end_ -= pos_;
+    pos_ = 0;
+  }
+
+  std::string buf_;
+  size_t pos_ = 0;
+  size_t end_ = 0;
+  bool error_ = false;
+};
+
+}  // namespace mqtt
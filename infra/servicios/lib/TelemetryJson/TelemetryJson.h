@@ -0,0 +1,55 @@
+// --- EXPANSIÓN DE LOTES BINARIOS A TELEMETRÍA JSON ---
+// convierte una trama de <topic>/bin (ver BatchFormat.h) en los mismos mensajes que generan hoy las funciones
+//   *_to_telemetry de Node-RED: topic greenhouse/<nodo>/telemetry y payload {"ts":..,"type":"..","value":..}.
+//
+// El ts de cada muestra se calcula con la hora de recepción: la última muestra del lote se toma como recibida en
+//   recvMs y las demás se colocan hacia atrás según sus diferencias de millis() en el nodo.
+#pragma once
+
+#include <BatchFormat.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string_view>
+
+namespace telemetry {
+
+// escribe {"ts":..,"type":"..","value":..} en buf; value = entero / scale, con los decimales justos
+inline size_t formatJson(char* buf, size_t cap, uint64_t ts, const char* type, int32_t value, uint16_t scale) {
+  int n;
+  if (scale == 1) {
+    n = std::snprintf(buf, cap, "{\"ts\":%llu,\"type\":\"%s\",\"value\":%ld}", (unsigned long long)ts, type,
+                      long(value));
+  } else {
+    n = std::snprintf(buf, cap, "{\"ts\":%llu,\"type\":\"%s\",\"value\":%g}", (unsigned long long)ts, type,
+                      double(value) / scale);
+  }
+  return n > 0 && size_t(n) < cap ? size_t(n) : 0;
+}
+
+// llama a emit(topic, json) por cada campo de cada muestra; devuelve el número de mensajes o -1 si la trama no es válida
+template <class Emit>
+int expand(const uint8_t* frame, size_t len, uint64_t recvMs, Emit&& emit) {
+  batch::Header h;
+  batch::Sample samples[batch::kMaxSamples];
+  const size_t n = batch::decode(frame, len, h, samples, batch::kMaxSamples);
+  if (!n) return -1;
+  const batch::SensorInfo* info = batch::sensorInfo(uint8_t(h.type));
+  if (!info || info->fields != h.fields) return -1;
+
+  const uint32_t lastTs = samples[n - 1].ts;
+  char json[96];
+  int out = 0;
+  for (size_t i = 0; i < n; i++) {
+    const uint64_t ts = recvMs - (lastTs - samples[i].ts);
+    for (uint8_t f = 0; f < h.fields; f++) {
+      const size_t jl = formatJson(json, sizeof(json), ts, info->field[f].type, samples[i].value[f], info->field[f].scale);
+      if (!jl) continue;
+      emit(std::string_view(info->telemetryTopic), std::string_view(json, jl));
+      out++;
+    }
+  }
+  return out;
+}
+
+}  // namespace telemetry
@@ -0,0 +1,102 @@
+// --- ESCRITURA Y LECTURA BIT A BIT ---
+// los chunks de la base de series temporales guardan cada muestra en un número variable de bits. Los bits se
+//   escriben del más significativo al menos significativo, byte a byte, así que el resultado no depende del endianness.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tsdb {
+
+class BitWriter {
+ public:
+  // escribe los n bits bajos de v (n <= 64)
+  void write(uint64_t v, unsigned n) {
+    if (n < 64) v &= (uint64_t(1) << n) - 1;
+    while (n) {
+      if (!libres_) {
+        buf_.push_back(0);
+        libres_ = 8;
+      }
+      const unsigned k = n < libres_ ? n : libres_;
+      const uint8_t trozo = uint8_t((v >> (n - k)) & ((1u << k) - 1));
+      buf_.back() |= uint8_t(trozo << (libres_ - k));
+      libres_ -= k;
+      n -= k;
+    }
+  }
+  void bit(bool b) { write(b ? 1 : 0, 1); }
+
+  const std::vector<uint8_t>& bytes() const { return buf_; }
+  size_t bits() const { return buf_.size() * 8 - libres_; }
+  void clear() {
+    buf_.clear();
+    libres_ = 0;
+  }
+
+ private:
+  std::vector<uint8_t> buf_;
+  unsigned libres_ = 0; // bits sin usar del último byte
+};
+
+class BitReader {
+ public:
+  BitReader(const uint8_t* p, size_t len) : p_(p), len_(len) {}
+
+  // lee n bits (n <= 64) del acumulador, que se rellena byte a byte solo cuando se queda corto
+  uint64_t read(unsigned n) {
+    if (n > 56) {
+      const uint64_t alto = read(n - 32);
+      return alto << 32 | read(32);
+    }
+    if (n > disp_) rellenar();
+    if (n > disp_) {
+      error_ = true;
+      return 0;
+    }
+    if (!n) return 0;
+    const uint64_t v = acc_ >> (64 - n);
+    acc_ <<= n;
+    disp_ -= n;
+    return v;
+  }
+
+  bool bit() {
+    if (!disp_) rellenar();
+    if (!disp_) {
+      error_ = true;
+      return false;
+    }
+    const bool b = acc_ >> 63;
+    acc_ <<= 1;
+    disp_--;
+    return b;
+  }
+
+  // cuenta unos seguidos hasta un cero, como mucho max (para los prefijos 0, 10, 110...)
+  unsigned unos(unsigned max) {
+    unsigned n = 0;
+    while (n < max && bit()) n++;
+    return n;
+  }
+
+  bool error() const { return error_; }
+
+ private:
+  void rellenar() {
+    while (disp_ <= 56 && pos_ < len_) {
+      acc_ |= uint64_t(p_[pos_++]) << (56 - disp_);
+      disp_ += 8;
+    }
+  }
+
+  const uint8_t* p_;
+  size_t len_;
+  size_t pos_ = 0;
+  uint64_t acc_ = 0;  // bits pendientes, alineados a la izquierda
+  unsigned disp_ = 0; // cuántos son válidos
+  bool error_ = false;
+};
+
+}  // namespace tsdb
@@ -0,0 +1,202 @@
+// --- CHUNKS COMPRIMIDOS DE UNA SERIE ---
+// un chunk guarda las muestras (ts en ms, valor double) de una serie en una ventana de tiempo, con la codificación de
+//   Gorilla (Facebook, VLDB 2015):
+//   - ts: la primera entera y luego la diferencia de la diferencia ("delta of delta"). Con un periodo fijo y poco
+//     jitter casi siempre cabe en 0 o 9 bits
+//   - valor: el primero entero y luego el XOR con el anterior; si es 0 (valor repetido, lo normal en un sensor que
+//     cambia despacio) es 1 bit, y si no, solo los bits con significado entre los ceros de delante y de detrás
+//   Cada chunk lleva también su resumen (ChunkMeta: rango de ts, min, max y suma) para agregar sin descomprimir.
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "BitStream.h"
+
+namespace tsdb {
+
+// CRC-32 (polinomio 0xEDB88320) con tabla: se calcula por cada registro del WAL
+inline uint32_t crc32(const void* p, size_t n, uint32_t crc = 0) {
+  static const auto tabla = [] {
+    std::array<uint32_t, 256> t{};
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t c = i;
+      for (int k = 0; k < 8; k++) c = c & 1 ? (c >> 1) ^ 0xEDB88320 : c >> 1;
+      t[i] = c;
+    }
+    return t;
+  }();
+  const uint8_t* b = static_cast<const uint8_t*>(p);
+  crc = ~crc;
+  for (size_t i = 0; i < n; i++) crc = tabla[(crc ^ b[i]) & 0xFF] ^ (crc >> 8);
+  return ~crc;
+}
+
+// resumen de un chunk; es también la entrada del índice de los segmentos (64 bytes, sin huecos)
+struct ChunkMeta {
+  uint32_t series;
+  uint32_t count;
+  int64_t minTs, maxTs;
+  double min, max, sum;
+  uint64_t offset; // dentro del segmento
+  uint32_t len;    // bytes
+  uint32_t crc;    // de los bytes del chunk
+};
+static_assert(sizeof(ChunkMeta) == 64, "ChunkMeta es parte del formato de los segmentos");
+
+namespace detail {
+inline uint64_t bitsDe(double v) {
+  uint64_t b;
+  std::memcpy(&b, &v, sizeof(b));
+  return b;
+}
+inline double deBits(uint64_t b) {
+  double v;
+  std::memcpy(&v, &b, sizeof(v));
+  return v;
+}
+inline bool cabe(int64_t v, unsigned bits) {
+  return v >= -(int64_t(1) << (bits - 1)) && v < (int64_t(1) << (bits - 1));
+}
+inline int64_t conSigno(uint64_t v, unsigned bits) {
+  return int64_t(v << (64 - bits)) >> (64 - bits);
+}
+
+// prefijos del delta of delta: 0 | 10 + 7 bits | 110 + 9 | 1110 + 12 | 1111 + 64
+constexpr unsigned kDodBits[] = {7, 9, 12};
+}  // namespace detail
+
+class ChunkEncoder {
+ public:
+  explicit ChunkEncoder(uint32_t series = 0) { reset(series); }
+
+  void reset(uint32_t series) {
+    bits_.clear();
+    meta_ = ChunkMeta{};
+    meta_.series = series;
+    meta_.min = std::numeric_limits<double>::infinity();
+    meta_.max = -std::numeric_limits<double>::infinity();
+    prevDelta_ = 0;
+    lead_ = 0xFF;
+  }
+
+  // las muestras tienen que llegar en orden de ts (lo comprueba Db)
+  void append(int64_t ts, double v) {
+    const uint64_t vb = detail::bitsDe(v);
+    if (!meta_.count) {
+      bits_.write(uint64_t(ts), 64);
+      bits_.write(vb, 64);
+      meta_.minTs = ts;
+    } else {
+      const int64_t delta = ts - meta_.maxTs;
+      const int64_t dod = delta - prevDelta_;
+      prevDelta_ = delta;
+      if (dod == 0) {
+        bits_.bit(false);
+      } else {
+        unsigned i = 0;
+        while (i < 3 && !detail::cabe(dod, detail::kDodBits[i])) i++;
+        if (i < 3) {
+          bits_.write((uint64_t(1) << (i + 2)) - 2, i + 2); // 10, 110, 1110
+          bits_.write(uint64_t(dod), detail::kDodBits[i]);
+        } else {
+          bits_.write(0xF, 4);
+          bits_.write(uint64_t(dod), 64);
+        }
+      }
+      putValue(vb ^ prevValue_);
+    }
+    prevValue_ = vb;
+    meta_.maxTs = ts;
+    meta_.count++;
+    meta_.sum += v;
+    if (v < meta_.min) meta_.min = v;
+    if (v > meta_.max) meta_.max = v;
+  }
+
+  const ChunkMeta& meta() const { return meta_; }
+  const std::vector<uint8_t>& bytes() const { return bits_.bytes(); }
+  uint32_t count() const { return meta_.count; }
+  bool empty() const { return meta_.count == 0; }
+
+ private:
+  void putValue(uint64_t x) {
+    if (!x) {
+      bits_.bit(false);
+      return;
+    }
+    bits_.bit(true);
+    unsigned lead = unsigned(__builtin_clzll(x));
+    const unsigned trail = unsigned(__builtin_ctzll(x));
+    if (lead > 31) lead = 31;
+    if (lead_ != 0xFF && lead >= lead_ && trail >= trail_) {
+      // cabe en la ventana de bits del anterior
+      bits_.bit(false);
+      bits_.write(x >> trail_, 64 - lead_ - trail_);
+      return;
+    }
+    bits_.bit(true);
+    const unsigned len = 64 - lead - trail;
+    bits_.write(lead, 5);
+    bits_.write(len - 1, 6);
+    bits_.write(x >> trail, len);
+    lead_ = uint8_t(lead);
+    trail_ = uint8_t(trail);
+  }
+
+  BitWriter bits_;
+  ChunkMeta meta_;
+  int64_t prevDelta_;
+  uint64_t prevValue_ = 0;
+  uint8_t lead_, trail_ = 0;
+};
+
+class ChunkDecoder {
+ public:
+  ChunkDecoder(const uint8_t* p, size_t len, uint32_t count) : in_(p, len), restantes_(count) {}
+
+  bool next(int64_t& ts, double& v) {
+    if (!restantes_ || in_.error()) return false;
+    if (!leidas_) {
+      ts_ = int64_t(in_.read(64));
+      value_ = in_.read(64);
+    } else {
+      const unsigned prefijo = in_.unos(4);
+      if (prefijo) {
+        const unsigned bits = prefijo < 4 ? detail::kDodBits[prefijo - 1] : 64;
+        delta_ += detail::conSigno(in_.read(bits), bits);
+      }
+      ts_ += delta_;
+      if (in_.bit()) {
+        if (in_.bit()) {
+          lead_ = unsigned(in_.read(5));
+          const unsigned len = unsigned(in_.read(6)) + 1;
+          trail_ = 64 - lead_ - len;
+        }
+        const unsigned len = 64 - lead_ - trail_;
+        value_ ^= in_.read(len) << trail_;
+      }
+    }
+    if (in_.error()) return false;
+    restantes_--;
+    leidas_++;
+    ts = ts_;
+    v = detail::deBits(value_);
+    return true;
+  }
+
+  bool error() const { return in_.error(); }
+
+ private:
+  BitReader in_;
+  uint32_t restantes_;
+  uint32_t leidas_ = 0;
+  int64_t ts_ = 0, delta_ = 0;
+  uint64_t value_ = 0;
+  unsigned lead_ = 0, trail_ = 0;
+};
+
+}  // namespace tsdb
@@ -0,0 +1,369 @@
+// --- BASE DE DATOS DE SERIES TEMPORALES ---
+// guarda el histórico de la telemetría en un directorio, sin servidor:
+//
+//   series            nombres de las series, uno por línea (el id es el número de línea)
+//   wal.log           muestras que aún no están en un segmento (Wal.h)
+//   seg-00000001.tsg  segmentos inmutables con los chunks cerrados (Segment.h), abiertos con mmap
+//
+// Cada serie tiene un chunk abierto en memoria (ChunkEncoder) que se cierra al cambiar de ventana (1 h por defecto,
+//   alineadas a la hora) o al llenarse. Cuando al cerrar un chunk el WAL pasa de walBytes, los chunks cerrados se
+//   escriben en un segmento nuevo y el WAL se reescribe con solo lo que sigue abierto: el WAL se queda en unas horas
+//   de datos y reabrir es rápido.
+//
+// Esos segmentos pequeños se van fusionando por niveles: cuando los últimos fanIn segmentos son del mismo nivel se
+//   juntan en uno del nivel siguiente (hasta maxLevel). Con los valores por defecto y muestras cada 3 s, un año queda
+//   en unas decenas de ficheros. El segmento fusionado guarda desde qué número reemplaza; si el proceso se cae antes de
+//   borrar los antiguos, se borran al abrir.
+//
+// Las consultas recorren los segmentos, los chunks cerrados y el abierto, en orden de tiempo. downsample() agrega en
+//   intervalos de `step` ms alineados a múltiplos de step: un chunk que cae entero dentro de un intervalo se agrega
+//   con su resumen, sin descomprimirlo (por eso conviene que step sea múltiplo de la ventana de los chunks).
+//
+// Un solo hilo: quien la usa desde varios tiene que serializar las llamadas.
+#pragma once
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Chunk.h"
+#include "Segment.h"
+#include "Wal.h"
+
+namespace tsdb {
+
+struct Options {
+  int64_t chunkWindowMs = 3600 * 1000; // con muestras cada 3 s son 1200 por chunk
+  uint32_t maxChunkSamples = 4096;
+  size_t walBytes = 1 << 20; // ~43000 muestras: unas 6 h de las 6 series del invernadero
+  uint32_t fanIn = 8;
+  uint32_t maxLevel = 3;
+  // para consultar el directorio de otro proceso que está escribiendo: no crea series ni escribe nada
+  bool readOnly = false;
+};
+
+// un intervalo de downsample()
+struct Bucket {
+  int64_t start;
+  uint64_t count;
+  double min, max, sum;
+  double avg() const { return count ? sum / double(count) : NAN; }
+};
+
+class Db {
+ public:
+  static constexpr uint32_t kNoSeries = UINT32_MAX;
+
+  ~Db() { close(); }
+
+  bool open(const std::string& dir, const Options& opt = {}) {
+    close();
+    dir_ = dir;
+    opt_ = opt;
+    if (!opt.readOnly) ::mkdir(dir.c_str(), 0755);
+
+    // series
+    if (FILE* f = std::fopen((dir + "/series").c_str(), "r")) {
+      char linea[256];
+      while (std::fgets(linea, sizeof(linea), f)) {
+        std::string nombre(linea);
+        while (!nombre.empty() && (nombre.back() == '\n' || nombre.back() == '\r')) nombre.pop_back();
+        addSeries(nombre);
+      }
+      std::fclose(f);
+    }
+    if (!opt.readOnly) {
+      seriesFile_ = std::fopen((dir + "/series").c_str(), "a");
+      if (!seriesFile_) return false;
+    }
+
+    // segmentos, en orden de número (que es el orden de tiempo)
+    std::vector<uint32_t> numeros;
+    if (DIR* d = ::opendir(dir.c_str())) {
+      while (dirent* e = ::readdir(d)) {
+        const std::string n = e->d_name;
+        if (n.size() > 4 && n.compare(n.size() - 4, 4, ".tmp") == 0) {
+          if (opt.readOnly) continue;
+          std::remove((dir + "/" + n).c_str()); // restos de una escritura que no llegó a renombrarse
+        } else if (n.rfind("seg-", 0) == 0 && n.size() == 16) {
+          numeros.push_back(uint32_t(std::strtoul(n.c_str() + 4, nullptr, 10)));
+        }
+      }
+      ::closedir(d);
+    }
+    std::sort(numeros.begin(), numeros.end());
+    for (uint32_t n : numeros) {
+      SegmentFile f{n, Segment()};
+      if (!f.seg.open(segmentPath(n))) continue;
+      // una fusión que no llegó a borrar los segmentos que reemplaza
+      while (f.seg.replaces() && !segments_.empty() && segments_.back().number >= f.seg.replaces()) {
+        if (!opt.readOnly) std::remove(segments_.back().seg.path().c_str());
+        segments_.pop_back();
+      }
+      nextSegment_ = n + 1;
+      segments_.push_back(std::move(f));
+    }
+    for (uint32_t id = 0; id < series_.size(); id++) {
+      for (const SegmentFile& f : segments_) series_[id].lastTs = std::max(series_[id].lastTs, f.seg.lastTs(id));
+    }
+
+    // WAL: lo que ya esté en un segmento (si la caída fue entre escribir el segmento y reescribir el WAL) se salta
+    replaying_ = true;
+    const bool ok = wal_.open(
+        dir + "/wal.log",
+        [this](uint32_t s, int64_t ts, double v) {
+          if (s < series_.size() && ts > series_[s].lastTs) appendInterno(s, ts, v);
+        },
+        opt.readOnly);
+    replaying_ = opt.readOnly;
+    return ok && (opt.readOnly || wal_.bytes() < opt_.walBytes || cutSegment());
+  }
+
+  // escribe lo pendiente del WAL y cierra; los chunks abiertos siguen en el WAL para la próxima vez
+  void close() {
+    wal_.close();
+    replaying_ = false;
+    if (seriesFile_) std::fclose(seriesFile_);
+    seriesFile_ = nullptr;
+    series_.clear();
+    ids_.clear();
+    sealed_.clear();
+    segments_.clear();
+    nextSegment_ = 1;
+  }
+
+  // id de la serie; si no existe y create, la crea. kNoSeries si no existe (o no se puede crear)
+  uint32_t series(std::string_view name, bool create = true) {
+    const auto it = ids_.find(std::string(name));
+    if (it != ids_.end()) return it->second;
+    if (!create || name.empty() || name.find('\n') != std::string_view::npos || !seriesFile_) return kNoSeries;
+    std::fprintf(seriesFile_, "%.*s\n", int(name.size()), name.data());
+    if (std::fflush(seriesFile_) != 0 || ::fsync(fileno(seriesFile_)) != 0) return kNoSeries;
+    return addSeries(std::string(name));
+  }
+
+  const std::string& seriesName(uint32_t id) const { return series_[id].name; }
+  size_t seriesCount() const { return series_.size(); }
+
+  // añade una muestra; false si la serie no existe, el valor no es finito o el ts no es posterior al último
+  bool append(uint32_t series, int64_t ts, double v) {
+    if (opt_.readOnly || series >= series_.size() || ts <= series_[series].lastTs || !std::isfinite(v)) return false;
+    wal_.append(series, ts, v);
+    return appendInterno(series, ts, v);
+  }
+
+  // lleva el WAL al disco (ver Wal.h)
+  bool sync() { return wal_.sync(); }
+
+  // cierra también los chunks abiertos y lo escribe todo en segmentos (p. ej. antes de copiar el directorio)
+  bool flush() {
+    if (opt_.readOnly) return false;
+    for (Series& s : series_) {
+      if (!s.head.empty()) seal(s);
+    }
+    return cutSegment();
+  }
+
+  // llama a fn(ts, value) con las muestras de [from, to) en orden
+  template <class Fn>
+  void scan(uint32_t series, int64_t from, int64_t to, Fn&& fn) const {
+    forEachChunk(series, from, to, [&](const ChunkMeta& m, const uint8_t* p) {
+      ChunkDecoder d(p, m.len, m.count);
+      int64_t ts;
+      double v;
+      while (d.next(ts, v)) {
+        if (ts >= to) break;
+        if (ts >= from) fn(ts, v);
+      }
+    });
+  }
+
+  // min/max/media de [from, to) en intervalos de step ms; solo salen los intervalos con muestras
+  void downsample(uint32_t series, int64_t from, int64_t to, int64_t step, std::vector<Bucket>& out) const {
+    out.clear();
+    if (step <= 0) return;
+    const auto inicio = [step](int64_t ts) { return ts - ((ts % step) + step) % step; };
+    const auto cubo = [&out](int64_t start) -> Bucket& {
+      if (out.empty() || out.back().start != start) out.push_back(Bucket{start, 0, INFINITY, -INFINITY, 0});
+      return out.back();
+    };
+    forEachChunk(series, from, to, [&](const ChunkMeta& m, const uint8_t* p) {
+      if (m.minTs >= from && m.maxTs < to && inicio(m.minTs) == inicio(m.maxTs)) {
+        Bucket& b = cubo(inicio(m.minTs));
+        b.count += m.count;
+        b.sum += m.sum;
+        b.min = std::min(b.min, m.min);
+        b.max = std::max(b.max, m.max);
+        return;
+      }
+      ChunkDecoder d(p, m.len, m.count);
+      int64_t ts;
+      double v;
+      while (d.next(ts, v)) {
+        if (ts >= to) break;
+        if (ts < from) continue;
+        Bucket& b = cubo(inicio(ts));
+        b.count++;
+        b.sum += v;
+        b.min = std::min(b.min, v);
+        b.max = std::max(b.max, v);
+      }
+    });
+  }
+
+  int64_t lastTs(uint32_t series) const { return series < series_.size() ? series_[series].lastTs : INT64_MIN; }
+
+  size_t segmentCount() const { return segments_.size(); }
+  size_t segmentBytes() const {
+    size_t n = 0;
+    for (const SegmentFile& f : segments_) n += f.seg.bytes();
+    return n;
+  }
+  size_t walBytes() const { return wal_.bytes(); }
+  // comprueba los CRC de todos los segmentos
+  bool verify() const {
+    return std::all_of(segments_.begin(), segments_.end(), [](const SegmentFile& f) { return f.seg.verify(); });
+  }
+
+ private:
+  struct Series {
+    std::string name;
+    ChunkEncoder head;
+    int64_t lastTs = INT64_MIN;
+  };
+
+  struct SegmentFile {
+    uint32_t number;
+    Segment seg;
+  };
+
+  uint32_t addSeries(const std::string& name) {
+    const uint32_t id = uint32_t(series_.size());
+    series_.push_back(Series{name, ChunkEncoder(id), INT64_MIN});
+    ids_.emplace(name, id);
+    return id;
+  }
+
+  std::string segmentPath(uint32_t n) const {
+    char nombre[32];
+    std::snprintf(nombre, sizeof(nombre), "/seg-%08u.tsg", n);
+    return dir_ + nombre;
+  }
+
+  int64_t ventana(int64_t ts) const {
+    return ts - ((ts % opt_.chunkWindowMs) + opt_.chunkWindowMs) % opt_.chunkWindowMs;
+  }
+
+  bool appendInterno(uint32_t id, int64_t ts, double v) {
+    Series& s = series_[id];
+    bool sellado = false;
+    if (!s.head.empty() &&
+        (ventana(ts) != ventana(s.head.meta().minTs) || s.head.count() >= opt_.maxChunkSamples)) {
+      seal(s);
+      sellado = true;
+    }
+    s.head.append(ts, v);
+    s.lastTs = ts;
+    return !sellado || replaying_ || wal_.bytes() < opt_.walBytes || cutSegment();
+  }
+
+  void seal(Series& s) {
+    sealed_.push_back(SealedChunk{s.head.meta(), s.head.bytes()});
+    s.head.reset(s.head.meta().series);
+  }
+
+  bool addSegment(std::vector<SealedChunk>& chunks, uint32_t level, uint32_t replaces) {
+    const uint32_t n = nextSegment_;
+    SegmentFile f{n, Segment()};
+    if (!writeSegment(segmentPath(n), chunks, level, replaces) || !f.seg.open(segmentPath(n))) {
+      std::fprintf(stderr, "tsdb: no se puede escribir %s\n", segmentPath(n).c_str());
+      return false;
+    }
+    nextSegment_++;
+    segments_.push_back(std::move(f));
+    return true;
+  }
+
+  bool cutSegment() {
+    if (sealed_.empty()) return true;
+    if (!addSegment(sealed_, 0, 0)) return false;
+    sealed_.clear();
+    // el WAL ya solo necesita lo que sigue en los chunks abiertos
+    const bool ok = wal_.rewrite([this](auto&& add) {
+      for (const Series& s : series_) {
+        ChunkDecoder d(s.head.bytes().data(), s.head.bytes().size(), s.head.count());
+        int64_t ts;
+        double v;
+        while (d.next(ts, v)) add(s.head.meta().series, ts, v);
+      }
+    });
+    return ok && compact();
+  }
+
+  // fusiona los últimos fanIn segmentos mientras sean todos del mismo nivel
+  bool compact() {
+    while (segments_.size() >= opt_.fanIn) {
+      const size_t desde = segments_.size() - opt_.fanIn;
+      const uint32_t nivel = segments_.back().seg.level();
+      if (nivel >= opt_.maxLevel) break;
+      bool iguales = true;
+      for (size_t i = desde; i < segments_.size(); i++) iguales = iguales && segments_[i].seg.level() == nivel;
+      if (!iguales) break;
+
+      std::vector<SealedChunk> chunks;
+      for (size_t i = desde; i < segments_.size(); i++) {
+        segments_[i].seg.forEachChunk([&](const ChunkMeta& m, const uint8_t* p) {
+          chunks.push_back(SealedChunk{m, std::vector<uint8_t>(p, p + m.len)});
+        });
+      }
+      if (!addSegment(chunks, nivel + 1, segments_[desde].number)) return false;
+      std::vector<std::string> viejos;
+      for (size_t i = desde; i + 1 < segments_.size(); i++) viejos.push_back(segments_[i].seg.path());
+      segments_.erase(segments_.begin() + long(desde), segments_.end() - 1); // desmapea los antiguos
+      for (const std::string& p : viejos) std::remove(p.c_str());
+    }
+    return true;
+  }
+
+  // segmentos, luego chunks cerrados y luego el abierto: en orden de tiempo porque las muestras llegan en orden
+  template <class Fn>
+  void forEachChunk(uint32_t series, int64_t from, int64_t to, Fn&& fn) const {
+    if (series >= series_.size() || from >= to) return;
+    for (const SegmentFile& f : segments_) f.seg.forEachChunk(series, from, to, fn);
+    for (const SealedChunk& c : sealed_) {
+      if (c.meta.series == series && c.meta.minTs < to && c.meta.maxTs >= from) {
+        ChunkMeta m = c.meta;
+        m.len = uint32_t(c.bytes.size());
+        fn(m, c.bytes.data());
+      }
+    }
+    const ChunkEncoder& h = series_[series].head;
+    if (!h.empty() && h.meta().minTs < to && h.meta().maxTs >= from) {
+      ChunkMeta m = h.meta();
+      m.len = uint32_t(h.bytes().size());
+      fn(m, h.bytes().data());
+    }
+  }
+
+  std::string dir_;
+  Options opt_;
+  FILE* seriesFile_ = nullptr;
+  std::vector<Series> series_;
+  std::unordered_map<std::string, uint32_t> ids_;
+  std::vector<SealedChunk> sealed_;
+  std::vector<SegmentFile> segments_;
+  uint32_t nextSegment_ = 1;
+  Wal wal_;
+  bool replaying_ = false;
+};
+
+}  // namespace tsdb
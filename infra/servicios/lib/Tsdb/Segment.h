@@ -0,0 +1,195 @@
+// --- SEGMENTOS INMUTABLES EN DISCO ---
+// un segmento es un fichero con chunks ya cerrados de varias series, que no se vuelve a modificar:
+//
+//   cabecera  "TSG1" | versión u32 | nivel u32 | reemplaza u32 (ver Db.h)
+//   datos     los bytes de cada chunk, seguidos
+//   índice    ChunkMeta[n], ordenado por (serie, minTs), alineado a 8
+//   pie       offset del índice u64 | n u32 | "TSGE"
+//
+// Se abre con mmap: el índice se usa tal cual desde el mapa (sin copiarlo ni parsearlo) y los chunks se
+//   descomprimen directamente de la página. Los enteros van en el orden de bytes de la máquina (x86 y ARM: little
+//   endian), como los ficheros de la flash de los nodos.
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Chunk.h"
+
+namespace tsdb {
+
+constexpr uint32_t kSegmentMagic = 0x31475354;    // "TSG1"
+constexpr uint32_t kSegmentEndMagic = 0x45475354; // "TSGE"
+constexpr uint32_t kSegmentVersion = 1;
+
+// chunk cerrado pendiente de escribir: resumen y bytes
+struct SealedChunk {
+  ChunkMeta meta;
+  std::vector<uint8_t> bytes;
+};
+
+namespace detail {
+inline bool escribirTodo(int fd, const void* p, size_t n) {
+  const auto* b = static_cast<const uint8_t*>(p);
+  while (n) {
+    const ssize_t w = ::write(fd, b, n);
+    if (w < 0) return false;
+    b += w;
+    n -= size_t(w);
+  }
+  return true;
+}
+}  // namespace detail
+
+// escribe el segmento en path.tmp, lo sincroniza y lo renombra: o está entero o no está
+inline bool writeSegment(const std::string& path, std::vector<SealedChunk>& chunks, uint32_t level = 0,
+                         uint32_t replaces = 0) {
+  std::sort(chunks.begin(), chunks.end(), [](const SealedChunk& a, const SealedChunk& b) {
+    return a.meta.series != b.meta.series ? a.meta.series < b.meta.series : a.meta.minTs < b.meta.minTs;
+  });
+  const std::string tmp = path + ".tmp";
+  const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) return false;
+
+  std::string buf;
+  const uint32_t cab[4] = {kSegmentMagic, kSegmentVersion, level, replaces};
+  buf.append(reinterpret_cast<const char*>(cab), sizeof(cab));
+  std::vector<ChunkMeta> indice;
+  indice.reserve(chunks.size());
+  for (const SealedChunk& c : chunks) {
+    ChunkMeta m = c.meta;
+    m.offset = buf.size();
+    m.len = uint32_t(c.bytes.size());
+    m.crc = crc32(c.bytes.data(), c.bytes.size());
+    buf.append(reinterpret_cast<const char*>(c.bytes.data()), c.bytes.size());
+    indice.push_back(m);
+  }
+  buf.resize((buf.size() + 7) & ~size_t(7), '\0');
+  const uint64_t offIndice = buf.size();
+  buf.append(reinterpret_cast<const char*>(indice.data()), indice.size() * sizeof(ChunkMeta));
+  const uint32_t pie[2] = {uint32_t(indice.size()), kSegmentEndMagic};
+  buf.append(reinterpret_cast<const char*>(&offIndice), sizeof(offIndice));
+  buf.append(reinterpret_cast<const char*>(pie), sizeof(pie));
+
+  const bool ok = detail::escribirTodo(fd, buf.data(), buf.size()) && ::fsync(fd) == 0;
+  ::close(fd);
+  if (!ok || std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+class Segment {
+ public:
+  Segment() = default;
+  Segment(const Segment&) = delete;
+  Segment& operator=(const Segment&) = delete;
+  Segment(Segment&& o) noexcept { *this = std::move(o); }
+  Segment& operator=(Segment&& o) noexcept {
+    std::swap(map_, o.map_);
+    std::swap(size_, o.size_);
+    std::swap(index_, o.index_);
+    std::swap(n_, o.n_);
+    std::swap(level_, o.level_);
+    std::swap(replaces_, o.replaces_);
+    std::swap(path_, o.path_);
+    return *this;
+  }
+  ~Segment() {
+    if (map_) ::munmap(const_cast<uint8_t*>(map_), size_);
+  }
+
+  // mapea el fichero y comprueba cabecera y pie; false si no es un segmento válido
+  bool open(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || size_t(st.st_size) < 32) {
+      ::close(fd);
+      return false;
+    }
+    void* m = ::mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (m == MAP_FAILED) return false;
+    map_ = static_cast<const uint8_t*>(m);
+    size_ = size_t(st.st_size);
+    path_ = path;
+
+    uint32_t cab[4], pie[2];
+    uint64_t offIndice;
+    std::memcpy(cab, map_, sizeof(cab));
+    std::memcpy(&offIndice, map_ + size_ - 16, sizeof(offIndice));
+    std::memcpy(pie, map_ + size_ - 8, sizeof(pie));
+    if (cab[0] != kSegmentMagic || cab[1] != kSegmentVersion || pie[1] != kSegmentEndMagic || offIndice % 8 ||
+        offIndice + uint64_t(pie[0]) * sizeof(ChunkMeta) != size_ - 16) {
+      std::fprintf(stderr, "tsdb: %s no es un segmento válido\n", path.c_str());
+      return false;
+    }
+    index_ = reinterpret_cast<const ChunkMeta*>(map_ + offIndice);
+    n_ = pie[0];
+    level_ = cab[2];
+    replaces_ = cab[3];
+    return true;
+  }
+
+  // chunks de la serie que se solapan con [from, to), en orden de tiempo
+  template <class Fn>
+  void forEachChunk(uint32_t series, int64_t from, int64_t to, Fn&& fn) const {
+    const ChunkMeta* fin = index_ + n_;
+    // dentro de una serie los chunks no se solapan: el primero que acaba en from o después es el primero que toca
+    const ChunkMeta* c = std::lower_bound(index_, fin, series, [from](const ChunkMeta& m, uint32_t s) {
+      return m.series < s || (m.series == s && m.maxTs < from);
+    });
+    for (; c != fin && c->series == series && c->minTs < to; ++c) fn(*c, map_ + c->offset);
+  }
+
+  // todos los chunks, en el orden del índice
+  template <class Fn>
+  void forEachChunk(Fn&& fn) const {
+    for (uint32_t i = 0; i < n_; i++) fn(index_[i], map_ + index_[i].offset);
+  }
+
+  // último ts de la serie en este segmento (INT64_MIN si no tiene)
+  int64_t lastTs(uint32_t series) const {
+    int64_t ts = INT64_MIN;
+    forEachChunk(series, INT64_MIN, INT64_MAX, [&](const ChunkMeta& m, const uint8_t*) { ts = m.maxTs; });
+    return ts;
+  }
+
+  // comprueba el CRC de todos los chunks (lee el fichero entero)
+  bool verify() const {
+    for (uint32_t i = 0; i < n_; i++) {
+      if (index_[i].offset + index_[i].len > size_ ||
+          crc32(map_ + index_[i].offset, index_[i].len) != index_[i].crc) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  size_t bytes() const { return size_; }
+  uint32_t chunks() const { return n_; }
+  uint32_t level() const { return level_; }
+  uint32_t replaces() const { return replaces_; }
+  const std::string& path() const { return path_; }
+
+ private:
+  const uint8_t* map_ = nullptr;
+  size_t size_ = 0;
+  const ChunkMeta* index_ = nullptr;
+  uint32_t n_ = 0;
+  uint32_t level_ = 0, replaces_ = 0;
+  std::string path_;
+};
+
+}  // namespace tsdb
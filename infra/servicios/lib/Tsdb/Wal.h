@@ -0,0 +1,142 @@
+// --- REGISTRO DE ESCRITURA ANTICIPADA (WAL) ---
+// las muestras de los chunks abiertos solo están en memoria; antes de aceptarlas se añaden a wal.log para no perderlas
+//   si el proceso se cae. Cada registro es fijo, de 24 bytes: serie u32 | ts i64 | valor f64 | crc u32. Al abrir se
+//   releen los registros hasta el primero incompleto o con el CRC mal (una escritura cortada) y se trunca ahí.
+//
+// append() solo copia al buffer; sync() lo escribe y hace fdatasync. Lo que se pierde en una caída es lo añadido
+//   desde el último sync(), y quien usa Db decide cada cuánto llamarlo.
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "Chunk.h"
+
+namespace tsdb {
+
+class Wal {
+ public:
+  static constexpr size_t kRecord = 24;
+
+  ~Wal() { close(); }
+
+  // abre (o crea) el fichero y llama a fn(series, ts, value) con cada registro válido. Con readOnly solo lo lee (si
+  //   no existe no pasa nada) y no se puede escribir.
+  template <class Fn>
+  bool open(const std::string& path, Fn&& fn, bool readOnly = false) {
+    close();
+    path_ = path;
+    fd_ = ::open(path.c_str(), readOnly ? O_RDONLY | O_CLOEXEC : O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) return readOnly && errno == ENOENT;
+    std::string buf;
+    char tmp[64 * 1024];
+    for (ssize_t n; (n = ::read(fd_, tmp, sizeof(tmp))) > 0;) buf.append(tmp, size_t(n));
+    size_t pos = 0;
+    for (; pos + kRecord <= buf.size(); pos += kRecord) {
+      const char* r = buf.data() + pos;
+      uint32_t series, crc;
+      int64_t ts;
+      double v;
+      std::memcpy(&series, r, 4);
+      std::memcpy(&ts, r + 4, 8);
+      std::memcpy(&v, r + 12, 8);
+      std::memcpy(&crc, r + 20, 4);
+      if (crc32(r, 20) != crc) break;
+      fn(series, ts, v);
+    }
+    if (readOnly) {
+      bytes_ = pos;
+      return true;
+    }
+    if (pos != buf.size()) {
+      std::fprintf(stderr, "tsdb: %s cortado a %zu bytes (%zu descartados)\n", path.c_str(), pos, buf.size() - pos);
+      if (::ftruncate(fd_, off_t(pos)) != 0) return false;
+    }
+    bytes_ = pos;
+    return ::lseek(fd_, off_t(pos), SEEK_SET) == off_t(pos);
+  }
+
+  void append(uint32_t series, int64_t ts, double v) {
+    putRecord(buf_, series, ts, v);
+    bytes_ += kRecord;
+    if (buf_.size() >= kFlushBytes) write();
+  }
+
+  // escribe lo pendiente y lo lleva al disco
+  bool sync() { return write() && ::fdatasync(fd_) == 0; }
+
+  // sustituye el WAL por uno con solo las muestras que da fill(append): las de los chunks que siguen abiertos tras
+  //   escribir un segmento. Se escribe aparte y se renombra encima, igual que los segmentos.
+  template <class Fill>
+  bool rewrite(Fill&& fill) {
+    std::string nuevo;
+    fill([&nuevo](uint32_t s, int64_t ts, double v) { putRecord(nuevo, s, ts, v); });
+    const std::string tmp = path_ + ".tmp";
+    const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    bool ok = true;
+    for (size_t off = 0; ok && off < nuevo.size();) {
+      const ssize_t w = ::write(fd, nuevo.data() + off, nuevo.size() - off);
+      ok = w > 0;
+      off += ok ? size_t(w) : 0;
+    }
+    ok = ok && ::fdatasync(fd) == 0;
+    if (!ok || std::rename(tmp.c_str(), path_.c_str()) != 0) {
+      ::close(fd);
+      std::remove(tmp.c_str());
+      return false;
+    }
+    buf_.clear();
+    bytes_ = nuevo.size();
+    ::close(fd_);
+    fd_ = fd;
+    return true;
+  }
+
+  // tamaño del WAL, contando lo que aún está en el buffer
+  size_t bytes() const { return bytes_; }
+
+  void close() {
+    if (fd_ < 0) return;
+    write();
+    ::close(fd_);
+    fd_ = -1;
+  }
+
+ private:
+  static constexpr size_t kFlushBytes = 64 * 1024;
+
+  static void putRecord(std::string& out, uint32_t series, int64_t ts, double v) {
+    char r[kRecord];
+    std::memcpy(r, &series, 4);
+    std::memcpy(r + 4, &ts, 8);
+    std::memcpy(r + 12, &v, 8);
+    const uint32_t crc = crc32(r, 20);
+    std::memcpy(r + 20, &crc, 4);
+    out.append(r, kRecord);
+  }
+
+  bool write() {
+    size_t off = 0;
+    while (off < buf_.size()) {
+      const ssize_t w = ::write(fd_, buf_.data() + off, buf_.size() - off);
+      if (w <= 0) return false;
+      off += size_t(w);
+    }
+    buf_.clear();
+    return true;
+  }
+
+  std::string path_;
+  int fd_ = -1;
+  std::string buf_;
+  size_t bytes_ = 0;
+};
+
+}  // namespace tsdb
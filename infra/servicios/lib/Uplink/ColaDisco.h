@@ -0,0 +1,111 @@
+// --- COLA FIFO EN DISCO ---
+// registros de tamaño fijo (T trivialmente copiable) que sobreviven a un reinicio:
+//   - <dir>/cola.dat: los registros, uno tras otro; push() añade al final y hace fdatasync
+//   - <dir>/cola.pos: cuántos bytes del principio ya se han consumido; pop() lo reescribe (8 bytes) y hace fdatasync
+//   Al abrir se descarta un registro final a medias (una escritura cortada). Cuando se ha consumido todo y el fichero
+//   pasa de 1 MB se trunca a cero, así que no crece sin límite mientras la subida funcione.
+//
+// Entrega al menos una vez: si el proceso cae entre subir un lote y pop(), ese lote se vuelve a leer al arrancar.
+#pragma once
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+template <class T>
+class ColaDisco {
+  static_assert(std::is_trivially_copyable_v<T>, "la cola guarda los registros tal cual");
+
+ public:
+  static constexpr uint64_t kRegistro = sizeof(T);
+
+  ~ColaDisco() { close(); }
+
+  // maxRegistros: si se llena, push() tira los más antiguos (y los cuenta en descartados())
+  bool open(const std::string& dir, uint64_t maxRegistros) {
+    close();
+    max_ = maxRegistros;
+    ::mkdir(dir.c_str(), 0755);
+    datos_ = ::open((dir + "/cola.dat").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    pos_ = ::open((dir + "/cola.pos").c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (datos_ < 0 || pos_ < 0) {
+      std::fprintf(stderr, "cola: no se puede abrir %s: %s\n", dir.c_str(), std::strerror(errno));
+      return false;
+    }
+    struct stat st;
+    if (::fstat(datos_, &st) != 0) return false;
+    fin_ = uint64_t(st.st_size) / kRegistro * kRegistro;
+    if (fin_ != uint64_t(st.st_size)) {
+      std::fprintf(stderr, "cola: descartado un registro a medias (%llu bytes)\n",
+                   (unsigned long long)(uint64_t(st.st_size) - fin_));
+      if (::ftruncate(datos_, off_t(fin_)) != 0) return false;
+    }
+    if (::pread(pos_, &inicio_, sizeof(inicio_), 0) != ssize_t(sizeof(inicio_))) inicio_ = 0;
+    // truncado justo antes de guardar la posición: lo consumido ya no está
+    if (inicio_ > fin_ || inicio_ % kRegistro) inicio_ = fin_;
+    return true;
+  }
+
+  bool push(const T& r) {
+    if (size() >= max_) {
+      inicio_ += kRegistro;
+      descartados_++;
+      guardarPos();
+    }
+    if (::pwrite(datos_, &r, kRegistro, off_t(fin_)) != ssize_t(kRegistro)) return false;
+    fin_ += kRegistro;
+    return ::fdatasync(datos_) == 0;
+  }
+
+  // copia a out hasta n registros desde el principio, sin quitarlos. En desde (si no es nulo) queda la posición de
+  //   lo leído, para pop(): mientras se sube, push() puede tirar los más antiguos y mover el principio
+  size_t front(size_t n, std::vector<T>& out, uint64_t* desde = nullptr) const {
+    if (desde) *desde = inicio_;
+    out.resize(std::min<uint64_t>(n, size()));
+    if (out.empty()) return 0;
+    const ssize_t bytes = ssize_t(out.size() * kRegistro);
+    if (::pread(datos_, out.data(), size_t(bytes), off_t(inicio_)) != bytes) out.clear();
+    return out.size();
+  }
+
+  // quita los n registros leídos por front() en desde (ya entregados). Si push() ha tirado algunos entretanto, solo
+  //   quita los que queden de esos n; nunca los que vienen detrás
+  bool pop(uint64_t desde, size_t n) {
+    const uint64_t hasta = std::min(fin_, desde + n * kRegistro);
+    if (hasta <= inicio_) return true;
+    inicio_ = hasta;
+    if (inicio_ == fin_ && fin_ >= kCompactar) {
+      if (::ftruncate(datos_, 0) != 0) return false;
+      inicio_ = fin_ = 0;
+    }
+    return guardarPos();
+  }
+
+  uint64_t size() const { return (fin_ - inicio_) / kRegistro; }
+  uint64_t descartados() const { return descartados_; }
+
+  void close() {
+    if (datos_ >= 0) ::close(datos_);
+    if (pos_ >= 0) ::close(pos_);
+    datos_ = pos_ = -1;
+  }
+
+ private:
+  static constexpr uint64_t kCompactar = 1 << 20;
+
+  bool guardarPos() {
+    return ::pwrite(pos_, &inicio_, sizeof(inicio_), 0) == ssize_t(sizeof(inicio_)) && ::fdatasync(pos_) == 0;
+  }
+
+  int datos_ = -1, pos_ = -1;
+  uint64_t inicio_ = 0, fin_ = 0, max_ = 0, descartados_ = 0;
+};
@@ -0,0 +1,117 @@
+// --- FILAS PARA THINGSPEAK ---
+// la telemetría llega como un mensaje por tipo y ThingSpeak guarda filas de hasta 8 campos. Agregador junta las
+//   muestras de un periodo fijo en una fila con la media de cada campo; bulkJson() monta el cuerpo de
+//   POST /channels/<canal>/bulk_update.json con muchas filas, cada una con su created_at.
+//
+// Los campos son los de la función "Format ThingSpeak" de Node-RED:
+//   field1 temp | field2 hum | field3 soil | field4 light | field5 tank | field6 aire
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <string_view>
+
+namespace thingspeak {
+
+constexpr size_t kCampos = 8;
+
+// límites de la API para cuentas gratuitas
+constexpr uint32_t kMaxLote = 960;         // filas por bulk_update
+constexpr uint32_t kIntervaloMinMs = 15000; // entre dos bulk_update del mismo canal
+
+struct Fila {
+  int64_t ts;      // inicio del periodo, ms desde 1970
+  uint32_t campos; // bit i = hay field(i+1)
+  uint32_t muestras;
+  double valor[kCampos];
+};
+
+// índice del campo (0 = field1) de un type de la telemetría, o -1 si ThingSpeak no lo guarda
+inline int campoDe(std::string_view type) {
+  static const char* const kTipos[] = {"temp", "hum", "soil", "light", "tank", "aire"};
+  for (int i = 0; i < int(sizeof(kTipos) / sizeof(kTipos[0])); i++) {
+    if (type == kTipos[i]) return i;
+  }
+  return -1;
+}
+
+class Agregador {
+ public:
+  explicit Agregador(int64_t periodoMs) : periodo_(periodoMs) {}
+
+  // añade una muestra. Si es de un periodo posterior al de la fila abierta, la cierra y la deja en cerrada (true).
+  //   Una muestra que llega tarde (de un periodo ya cerrado) cuenta en la fila abierta.
+  bool add(int64_t ts, int campo, double v, Fila& cerrada) {
+    const int64_t inicio = ts - ts % periodo_;
+    bool hay = false;
+    if (abierta_ && inicio > inicio_) hay = cerrar(cerrada);
+    if (!abierta_) {
+      abierta_ = true;
+      inicio_ = inicio;
+    }
+    suma_[campo] += v;
+    n_[campo]++;
+    return hay;
+  }
+
+  // cierra la fila abierta si su periodo acabó hace más de margenMs (por si deja de llegar telemetría)
+  bool cerrarVencida(int64_t ahora, int64_t margenMs, Fila& cerrada) {
+    if (!abierta_ || ahora < inicio_ + periodo_ + margenMs) return false;
+    return cerrar(cerrada);
+  }
+
+ private:
+  bool cerrar(Fila& f) {
+    f = Fila{};
+    f.ts = inicio_;
+    for (size_t i = 0; i < kCampos; i++) {
+      if (!n_[i]) continue;
+      f.campos |= 1u << i;
+      f.valor[i] = suma_[i] / double(n_[i]);
+      f.muestras += n_[i];
+      suma_[i] = 0;
+      n_[i] = 0;
+    }
+    abierta_ = false;
+    return f.campos != 0;
+  }
+
+  int64_t periodo_;
+  bool abierta_ = false;
+  int64_t inicio_ = 0;
+  double suma_[kCampos] = {};
+  uint32_t n_[kCampos] = {};
+};
+
+// "2025-01-01 10:00:00 +0000", el formato de created_at de la documentación de bulk_update
+inline size_t fecha(int64_t ms, char* buf, size_t cap) {
+  const time_t s = time_t(ms / 1000);
+  tm t;
+  gmtime_r(&s, &t);
+  return std::strftime(buf, cap, "%Y-%m-%d %H:%M:%S +0000", &t);
+}
+
+inline void bulkJson(const std::string& clave, const Fila* filas, size_t n, std::string& out) {
+  out = "{\"write_api_key\":\"" + clave + "\",\"updates\":[";
+  char b[64];
+  for (size_t i = 0; i < n; i++) {
+    if (i) out += ',';
+    fecha(filas[i].ts, b, sizeof(b));
+    out += "{\"created_at\":\"";
+    out += b;
+    out += '"';
+    for (size_t c = 0; c < kCampos; c++) {
+      if (!(filas[i].campos >> c & 1)) continue;
+      // dos decimales sobran para sensores de resolución 1 (0,1 el DHT) y el campo es texto en ThingSpeak
+      std::snprintf(b, sizeof(b), ",\"field%zu\":%.2f", c + 1, filas[i].valor[c]);
+      out += b;
+    }
+    out += '}';
+  }
+  out += "]}";
+}
+
+}  // namespace thingspeak
@@ -0,0 +1,284 @@
+// --- ESTADÍSTICAS MÓVILES Y FALLOS DE LOS SENSORES ---
+// las alertas de "Reglas Auto" solo miran el último valor contra un umbral: una sonda de suelo atascada, un DHT11 que
+//   devuelve siempre lo mismo o un nodo que ha dejado de leer (el driver no publica si la lectura falla) no avisan.
+//   Aquí cada serie (<nodo>/<type>) lleva una ventana de las últimas N muestras y, por muestra y en O(1):
+//   - media y desviación con Welford sobre la ventana deslizante (la muestra que sale se resta)
+//   - mínimo y máximo con dos colas monótonas (cada muestra entra y sale como mucho una vez de cada una)
+//   - pendiente: de la muestra más antigua de la ventana a la última, en unidades por minuto
+//   y detecta cuatro fallos:
+//   - plano: el valor no se ha movido más de eps en planoMs (sonda atascada, DHT11 congelado)
+//   - silencio: no llega nada en silencioMs; es lo que se ve de un sensor que falla al leer
+//   - invalido: el valor no es un número (null, "NaN")
+//   - pico: una muestra se aleja más de z desviaciones de la media de la ventana y la siguiente vuelve. Un salto que se
+//     queda (el suelo después de regar) no es un pico. Es un evento suelto, sin estado.
+//
+// Disposición: las series son índices en vectores. Lo que toca cada muestra (Welford, contadores de las colas, plano,
+//   pico) va junto en un bloque de 64 bytes por serie, y lo que se recorre de todas las series a la vez (el límite del
+//   silencio) va en una columna aparte. Las ventanas, sus tiempos y las colas van en bloques de N por serie en tres
+//   vectores grandes; N es potencia de 2 para que la posición en el anillo sea una máscara.
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace vig {
+
+// --- PARÁMETROS POR TIPO ---
+// los nodos publican por excepción con un latido por minuto (PublishPolicy.h), así que una serie quieta sigue llegando.
+//   planoMs es largo porque una lectura estable es normal (la luz de noche, el tanque sin riego): solo avisa de días o
+//   medias jornadas sin un solo cambio. sigmaMin evita que con la ventana plana cualquier cambio de resolución sea un
+//   pico.
+struct Parametros {
+  const char* type;
+  double eps;         // cambio mínimo que cuenta como movimiento (resolución del sensor)
+  int64_t planoMs;
+  int64_t silencioMs;
+  double sigmaMin;    // desviación mínima para los picos
+  double z;
+};
+
+constexpr Parametros kParametros[] = {
+    {"temp", 0.05, 6 * 3600000, 300000, 0.5, 5},
+    {"hum", 0.5, 6 * 3600000, 300000, 2, 5},
+    {"soil", 0.5, 24 * 3600000, 300000, 2, 5},
+    {"light", 0.5, 24 * 3600000, 300000, 3, 6},
+    {"aire", 0.5, 12 * 3600000, 300000, 2, 5},
+    {"tank", 0.5, 48 * 3600000, 300000, 2, 5},
+};
+
+// nullptr si el tipo no es de la telemetría
+inline const Parametros* parametros(std::string_view type) {
+  for (const Parametros& p : kParametros) {
+    if (type == p.type) return &p;
+  }
+  return nullptr;
+}
+
+enum Fallo : uint8_t { Plano = 1, Silencio = 2, Invalido = 4, Pico = 8 };
+
+inline const char* nombreFallo(Fallo f) {
+  switch (f) {
+    case Plano: return "plano";
+    case Silencio: return "silencio";
+    case Invalido: return "invalido";
+    case Pico: return "pico";
+  }
+  return "?";
+}
+
+struct Features {
+  uint32_t n;
+  double media, desv, min, max;
+  double pendiente; // por minuto
+  double valor;     // la última muestra
+  int64_t ts;
+};
+
+// --- VENTANAS ---
+class Ventanas {
+ public:
+  // muestras por ventana, redondeadas a potencia de 2 (entre 4 y 4096)
+  explicit Ventanas(uint32_t muestras = 32) {
+    while (n_ < muestras && n_ < 4096) n_ *= 2;
+    mask_ = n_ - 1;
+  }
+
+  // serie nueva con los parámetros de su tipo (se copian); devuelve su índice
+  uint32_t nueva(const Parametros& p, int64_t ahora) {
+    const uint32_t s = uint32_t(estado_.size());
+    size_t t = 0;
+    while (t < tipos_.size() && !igual(tipos_[t], p)) t++;
+    if (t == tipos_.size()) tipos_.push_back(p);
+    Estado e{};
+    e.picoCentro = NAN;
+    e.tipo = uint8_t(t);
+    estado_.push_back(e);
+    limiteMs_.push_back(ahora + p.silencioMs);
+    valores_.resize(valores_.size() + n_);
+    ts_.resize(ts_.size() + n_);
+    colas_.resize(colas_.size() + 2 * n_);
+    return s;
+  }
+
+  // muestra nueva (ts de la lectura en ms; ahora, hora de llegada para el silencio). Llama a
+  //   fn(Fallo, bool activo, double valor) por cada fallo que empieza o acaba con ella.
+  template <class Fn>
+  void add(uint32_t s, int64_t ts, double v, int64_t ahora, Fn&& fn) {
+    Estado& e = estado_[s];
+    const Parametros& p = tipos_[e.tipo];
+    limiteMs_[s] = ahora + p.silencioMs;
+    if (e.activos & (Silencio | Invalido)) {
+      const uint8_t fin = e.activos & (Silencio | Invalido);
+      e.activos &= uint8_t(~fin);
+      if (fin & Silencio) fn(Silencio, false, v);
+      if (fin & Invalido) fn(Invalido, false, v);
+    }
+
+    // pico: la anterior se salió de la banda; si esta vuelve, era un pico y no un salto
+    if (!std::isnan(e.picoCentro)) {
+      if (std::fabs(v - e.picoCentro) <= e.picoBanda) fn(Pico, true, double(e.picoValor));
+      e.picoCentro = NAN;
+    }
+    if (e.llenas >= n_ / 2) {
+      const double banda = p.z * std::fmax(std::sqrt(e.m2 / double(e.llenas)), p.sigmaMin);
+      if (std::fabs(v - e.media) > banda) {
+        e.picoCentro = float(e.media);
+        e.picoBanda = float(banda);
+        e.picoValor = float(v);
+      }
+    }
+
+    // plano: desde el último movimiento de más de eps
+    if (!e.seq || std::fabs(v - e.refValor) > p.eps) {
+      e.refValor = v;
+      e.refTs = ts;
+      if (e.activos & Plano) {
+        e.activos &= uint8_t(~Plano);
+        fn(Plano, false, v);
+      }
+    } else if (!(e.activos & Plano) && ts - e.refTs >= p.planoMs) {
+      e.activos |= Plano;
+      fn(Plano, true, v);
+    }
+
+    meter(s, e, ts, v);
+  }
+
+  // el valor de la lectura no era un número
+  template <class Fn>
+  void invalido(uint32_t s, int64_t ahora, Fn&& fn) {
+    Estado& e = estado_[s];
+    limiteMs_[s] = ahora + tipos_[e.tipo].silencioMs;
+    if (e.activos & Invalido) return;
+    e.activos |= Invalido;
+    fn(Invalido, true, NAN);
+  }
+
+  // series que llevan silencioMs sin recibir nada: fn(serie) una vez por silencio
+  template <class Fn>
+  void revisar(int64_t ahora, Fn&& fn) {
+    const size_t total = limiteMs_.size();
+    for (size_t s = 0; s < total; s++) {
+      if (ahora < limiteMs_[s]) continue;
+      limiteMs_[s] = INT64_MAX; // hasta que llegue algo
+      estado_[s].activos |= Silencio;
+      fn(uint32_t(s));
+    }
+  }
+
+  Features features(uint32_t s) const {
+    Features f{};
+    const Estado& e = estado_[s];
+    if (!e.llenas) return f;
+    const uint32_t ultima = e.seq - 1, primera = e.seq - e.llenas;
+    const size_t base = size_t(s) * n_;
+    const uint16_t* colas = &colas_[2 * base];
+    f.n = e.llenas;
+    f.media = e.media;
+    f.desv = e.llenas > 1 ? std::sqrt(e.m2 / double(e.llenas - 1)) : 0;
+    f.min = valores_[base + (colas[e.minCab & mask_] & mask_)];
+    f.max = valores_[base + (colas[n_ + (e.maxCab & mask_)] & mask_)];
+    f.valor = valores_[base + (ultima & mask_)];
+    f.ts = ts_[base + (ultima & mask_)];
+    const int64_t dt = f.ts - ts_[base + (primera & mask_)];
+    f.pendiente = dt > 0 ? (f.valor - valores_[base + (primera & mask_)]) * 60000.0 / double(dt) : 0;
+    return f;
+  }
+
+  uint8_t activos(uint32_t s) const { return estado_[s].activos; }
+  size_t size() const { return estado_.size(); }
+  uint32_t ventana() const { return n_; }
+  size_t bytesPorSerie() const {
+    return sizeof(Estado) + sizeof(int64_t) + n_ * (sizeof(double) + sizeof(int64_t) + 2 * sizeof(uint16_t));
+  }
+
+ private:
+  // lo que toca cada muestra, junto en una línea de caché. Los contadores de 16 bits dan la vuelta en un múltiplo de
+  //   N, así que la posición en el anillo sigue siendo & mask_.
+  struct alignas(64) Estado {
+    double media, m2;      // Welford
+    double refValor;       // plano: valor y hora del último movimiento
+    int64_t refTs;
+    float picoCentro;      // pico pendiente de confirmar (NaN: ninguno); en float para caber en la línea
+    float picoBanda, picoValor;
+    uint32_t seq;          // número de la siguiente muestra
+    uint16_t llenas;       // muestras en la ventana (hasta N)
+    uint16_t minCab, minCola, maxCab, maxCola;
+    uint8_t activos;       // fallos con estado activos (Plano | Silencio | Invalido)
+    uint8_t tipo;          // índice en tipos_
+  };
+  static_assert(sizeof(Estado) == 64, "el estado de una serie tiene que caber en una línea de caché");
+
+  static bool igual(const Parametros& a, const Parametros& b) {
+    return std::string_view(a.type) == b.type && a.eps == b.eps && a.planoMs == b.planoMs &&
+           a.silencioMs == b.silencioMs && a.sigmaMin == b.sigmaMin && a.z == b.z;
+  }
+
+  // la muestra entra en la ventana (y sale la de hace N si estaba llena)
+  void meter(uint32_t s, Estado& e, int64_t ts, double v) {
+    const size_t base = size_t(s) * n_;
+    double* vals = &valores_[base];
+    const uint32_t q = e.seq;
+    const uint32_t pos = q & mask_;
+
+    // Welford: añadir, o sustituir la que sale por la que entra sin cambiar n
+    if (e.llenas < n_) {
+      const uint32_t n = ++e.llenas;
+      const double d = v - e.media;
+      e.media += d / double(n);
+      e.m2 += d * (v - e.media);
+    } else {
+      const double sale = vals[pos];
+      const double mediaAntes = e.media;
+      e.media += (v - sale) / double(n_);
+      e.m2 += (v - sale) * (v - e.media + sale - mediaAntes);
+      if (e.m2 < 0) e.m2 = 0;
+    }
+
+    // las colas guardan números de muestra (16 bits); primero se quita la que sale, que es la única que puede
+    //   caducar y cuyo hueco en el anillo se va a pisar
+    uint16_t* cmin = &colas_[2 * base];
+    uint16_t* cmax = cmin + n_;
+    const uint16_t q16 = uint16_t(q);
+    if (e.minCola != e.minCab && uint16_t(q16 - cmin[e.minCab & mask_]) >= n_) e.minCab++;
+    if (e.maxCola != e.maxCab && uint16_t(q16 - cmax[e.maxCab & mask_]) >= n_) e.maxCab++;
+    vals[pos] = v;
+    ts_[base + pos] = ts;
+    while (e.minCola != e.minCab && vals[cmin[uint16_t(e.minCola - 1) & mask_] & mask_] >= v) e.minCola--;
+    cmin[e.minCola++ & mask_] = q16;
+    while (e.maxCola != e.maxCab && vals[cmax[uint16_t(e.maxCola - 1) & mask_] & mask_] <= v) e.maxCola--;
+    cmax[e.maxCola++ & mask_] = q16;
+    e.seq = q + 1;
+
+    // restar la que sale acumula error de redondeo: cada 64 vueltas al anillo se recalcula (O(1) amortizado)
+    if (e.llenas == n_ && (e.seq & (64 * n_ - 1)) == 0) recalcular(e, vals);
+  }
+
+  void recalcular(Estado& e, const double* vals) {
+    double suma = 0;
+    for (uint32_t i = 0; i < n_; i++) suma += vals[i];
+    const double media = suma / double(n_);
+    double m2 = 0;
+    for (uint32_t i = 0; i < n_; i++) m2 += (vals[i] - media) * (vals[i] - media);
+    e.media = media;
+    e.m2 = m2;
+  }
+
+  uint32_t n_ = 4;
+  uint32_t mask_ = 3;
+  std::vector<Parametros> tipos_;
+
+  // una entrada por serie
+  std::vector<Estado> estado_;
+  std::vector<int64_t> limiteMs_; // silencio: hora de llegada de lo último + silencioMs (columna aparte para revisar)
+
+  // bloques de N por serie
+  std::vector<double> valores_;
+  std::vector<int64_t> ts_;
+  std::vector<uint16_t> colas_; // N de la cola del mínimo y N de la del máximo, de la muestra más antigua a la última
+};
+
+}  // namespace vig
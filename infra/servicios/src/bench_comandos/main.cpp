@@ -0,0 +1,439 @@
+// --- BENCHMARK DEL CAMINO DE LAS ÓRDENES A LOS ACTUADORES ---
+// mide lo que tarda una orden de invernadero/cmd/{nodo}/{dispositivo} en mover la salida del nodo y en volver su
+//   estado por invernadero/act/{nodo}/{dispositivo}, contra un broker local. Tres partes:
+//   1. en proceso, sin red: coste por orden de lo que hace el nodo (leer la orden, descartar repetidas, aplicarla y
+//      escribir el estado), con el mismo código que el firmware (common/lib/Comandos/Comando.h)
+//   2. de extremo a extremo: un nodo simulado por dispositivo (soil/riego, ldr/luz, dht11/ventilador, las tablas de
+//      los drivers) en su propio hilo y con su conexión, y un controlador que manda órdenes con id a la tasa pedida,
+//      una pendiente por dispositivo como haría Node-RED. Una fracción se manda dos veces seguidas (lo que hace el
+//      broker al reentregar con QoS 1) y el nodo "pierde" otra fracción, que el controlador reintenta con el mismo id
+//      si no ve el estado. Se comprueba que cada orden mueve la salida exactamente una vez.
+//   3. órdenes temporizadas ("seconds": 1): del estado "on" al "off" que publica el nodo al vencer, con la misma
+//      resolución que el firmware (actuatorPollMs).
+//
+// La latencia orden -> actuación se mide con el reloj compartido del proceso: del primer envío a que el nodo simulado
+//   cambia la salida (donde el firmware hace el digitalWrite); la de orden -> estado, hasta que el controlador recibe
+//   el estado con su id. Las órdenes que han necesitado un reintento van en una fila aparte.
+//
+// Uso: program [--host 127.0.0.1] [--port 1884] [--ordenes 3000] [--tasa 100] [--duplicadas 0.2] [--perdida 0.05]
+//              [--reintento-ms 250] [--temporizadas 5] [--solo-local 1]
+#include <Comando.h>
+#include <JsonScan.h>
+#include <MqttClient.h>
+#include <PayloadWriter.h>
+#include <Percentil.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t nowNs() {
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+}
+
+struct Config {
+  std::string host = "127.0.0.1";
+  uint16_t port = 1884;
+  uint32_t ordenes = 3000;
+  uint32_t tasa = 100; // órdenes/s entre todos los dispositivos
+  double duplicadas = 0.2;
+  double perdida = 0.05;
+  uint32_t reintentoMs = 250;
+  uint32_t temporizadas = 5; // rondas de órdenes de 1 s por dispositivo
+  bool soloLocal = false;
+};
+
+// --- DISPOSITIVOS ---
+// los de kActuators en los drivers de infra/sensores
+struct Dispositivo {
+  const char* nodo;
+  const char* nombre;
+  bool pwm;
+  uint32_t maxOnMs;
+};
+constexpr Dispositivo kDispositivos[] = {{"soil", "riego", false, 600000}, {"ldr", "luz", false, 0},
+                                         {"dht11", "ventilador", true, 0}};
+constexpr size_t kNumDisp = sizeof(kDispositivos) / sizeof(kDispositivos[0]);
+constexpr uint32_t kPollMs = 100; // node_config::actuatorPollMs
+
+// orden k del controlador: cada dispositivo alterna encendido y apagado, así que todas mueven la salida
+size_t orden(char* out, size_t cap, uint32_t k) {
+  const uint32_t j = k / kNumDisp;
+  if (j % 2) return size_t(std::snprintf(out, cap, "{\"cmd\":\"off\",\"id\":\"c%u\"}", k));
+  if (kDispositivos[k % kNumDisp].pwm) {
+    return size_t(std::snprintf(out, cap, "{\"cmd\":\"on\",\"level\":%u,\"reason\":\"bench\",\"id\":\"c%u\"}",
+                                30 + j % 70, k));
+  }
+  return size_t(std::snprintf(out, cap, "{\"cmd\":\"on\",\"reason\":\"bench\",\"id\":\"c%u\"}", k));
+}
+
+// --- 1. EN PROCESO ---
+void benchLocal() {
+  constexpr uint32_t kVueltas = 1000000;
+  char msgs[64][96];
+  size_t lens[64];
+  for (uint32_t i = 0; i < 64; i++) lens[i] = orden(msgs[i], sizeof(msgs[i]), i);
+  cmd::Vistos<16> vistos;
+  cmd::Salida s;
+  char buf[96];
+  size_t bytes = 0;
+  uint32_t cambios = 0;
+  const uint64_t t0 = nowNs();
+  for (uint32_t i = 0; i < kVueltas; i++) {
+    cmd::Orden o;
+    if (!cmd::parse(msgs[i & 63], lens[i & 63], o)) continue;
+    const bool nueva = vistos.nueva(o.idHash ^ i); // ids distintos en cada vuelta
+    if (nueva && s.aplicar(o, i, 0)) cambios++;
+    PayloadWriter w(buf, sizeof(buf));
+    w.begin();
+    cmd::estado(w, s, i, true, o.id, !nueva);
+    bytes += w.end();
+  }
+  const double ns = double(nowNs() - t0) / kVueltas;
+  std::printf("orden en proceso (leer, deduplicar, aplicar y escribir el estado): %.0f ns (%u cambios, %zu bytes)\n",
+              ns, cambios, bytes);
+}
+
+// --- 2. DE EXTREMO A EXTREMO ---
+// lo que apuntan los nodos simulados de cada orden "c<k>"
+struct Registro {
+  explicit Registro(size_t n) : actuaciones(n), actuadoNs(n) {}
+  std::vector<std::atomic<uint32_t>> actuaciones;
+  std::vector<std::atomic<uint64_t>> actuadoNs; // primera actuación
+};
+
+class NodoSimulado {
+ public:
+  NodoSimulado(const Config& cfg, const Dispositivo& d, Registro& reg, uint32_t semilla)
+      : cfg_(cfg), d_(d), reg_(reg), rng_(semilla) {
+    cmdTopic_ = std::string("invernadero/cmd/") + d.nodo + "/" + d.nombre;
+    actTopic_ = std::string("invernadero/act/") + d.nodo + "/" + d.nombre;
+  }
+
+  bool conectar() {
+    const std::string id = std::string("bench-comandos-") + d_.nodo;
+    return cli_.connect(cfg_.host.c_str(), cfg_.port, id) &&
+           cli_.subscribe(std::string("invernadero/cmd/") + d_.nodo + "/+", 1);
+  }
+
+  void operator()() {
+    uint32_t ultimoPoll = 0;
+    while (!fin.load(std::memory_order_relaxed)) {
+      if (!cli_.poll(10, [this](const mqtt::PublishView& p) { recibir(p); })) {
+        std::fprintf(stderr, "el nodo %s ha perdido la conexión\n", d_.nodo);
+        return;
+      }
+      // la tarea del firmware que apaga las salidas temporizadas
+      const uint32_t ahora = ms();
+      if (ahora - ultimoPoll >= kPollMs) {
+        ultimoPoll = ahora;
+        if (salida_.vencida(ahora)) {
+          salida_.apagar();
+          publicar(false);
+        }
+      }
+    }
+    cli_.disconnect();
+  }
+
+  std::atomic<bool> fin{false};
+  uint32_t recibidas = 0, perdidas = 0, duplicadas = 0, rechazadas = 0;
+
+ private:
+  uint32_t ms() const { return uint32_t((nowNs() - t0_) / 1000000); }
+
+  // lo mismo que Commands::onMessage() del firmware
+  void recibir(const mqtt::PublishView& p) {
+    recibidas++;
+    if (p.topic != cmdTopic_) {
+      rechazadas++;
+      return;
+    }
+    if (std::uniform_real_distribution<double>(0, 1)(rng_) < cfg_.perdida) {
+      perdidas++; // como si el broker no la hubiera entregado
+      return;
+    }
+    cmd::Orden o;
+    if (!cmd::parse(p.payload.data(), p.payload.size(), o)) {
+      rechazadas++;
+      return;
+    }
+    const bool nueva = vistos_.nueva(o.idHash);
+    if (nueva) {
+      if (salida_.aplicar(o, ms(), d_.maxOnMs)) actuar(o.id);
+      std::strcpy(ultimoId_, o.id);
+    } else {
+      duplicadas++;
+    }
+    publicar(!nueva);
+  }
+
+  void actuar(const char* id) {
+    if (id[0] != 'c') return;
+    const uint32_t k = uint32_t(std::strtoul(id + 1, nullptr, 10));
+    if (k >= reg_.actuaciones.size()) return;
+    if (reg_.actuaciones[k].fetch_add(1, std::memory_order_relaxed) == 0) {
+      reg_.actuadoNs[k].store(nowNs(), std::memory_order_relaxed);
+    }
+  }
+
+  void publicar(bool dup) {
+    char buf[96];
+    PayloadWriter w(buf, sizeof(buf));
+    w.begin();
+    cmd::estado(w, salida_, ms(), d_.pwm, ultimoId_, dup);
+    const size_t n = w.end();
+    if (n) cli_.publish(actTopic_, std::string_view(buf, n), 0, true);
+  }
+
+  const Config& cfg_;
+  const Dispositivo& d_;
+  Registro& reg_;
+  std::mt19937 rng_;
+  MqttClient cli_;
+  std::string cmdTopic_, actTopic_;
+  cmd::Vistos<16> vistos_;
+  cmd::Salida salida_;
+  char ultimoId_[cmd::kIdMax] = {};
+  const uint64_t t0_ = nowNs();
+};
+
+// estado recibido por el controlador
+struct Estado {
+  size_t disp = kNumDisp;
+  bool on = false;
+  bool dup = false;
+  char tipo = 0; // 'c' o 't' (el prefijo del id)
+  uint32_t k = 0;
+};
+
+bool leerEstado(const mqtt::PublishView& p, Estado& e) {
+  constexpr std::string_view kPrefijo = "invernadero/act/";
+  if (p.topic.substr(0, kPrefijo.size()) != kPrefijo) return false;
+  const std::string_view resto = p.topic.substr(kPrefijo.size());
+  for (size_t d = 0; d < kNumDisp; d++) {
+    if (resto == std::string(kDispositivos[d].nodo) + "/" + kDispositivos[d].nombre) e.disp = d;
+  }
+  if (e.disp == kNumDisp) return false;
+  json::forEachField(p.payload, [&](std::string_view k, std::string_view v) {
+    if (k == "state") e.on = v == "on";
+    else if (k == "dup") e.dup = v == "1";
+    else if (k == "id" && v.size() > 1) {
+      e.tipo = v[0];
+      e.k = uint32_t(std::strtoul(std::string(v.substr(1)).c_str(), nullptr, 10));
+    }
+  });
+  return true;
+}
+
+struct Pendiente {
+  bool ocupado = false;
+  uint32_t k = 0;
+  uint64_t primerEnvio = 0, ultimoEnvio = 0;
+};
+
+bool benchBroker(const Config& cfg) {
+  Registro reg(cfg.ordenes);
+  std::vector<std::unique_ptr<NodoSimulado>> nodos;
+  for (size_t d = 0; d < kNumDisp; d++) {
+    nodos.push_back(std::make_unique<NodoSimulado>(cfg, kDispositivos[d], reg, uint32_t(7 + d)));
+    if (!nodos.back()->conectar()) {
+      std::fprintf(stderr, "no se puede conectar a %s:%u\n", cfg.host.c_str(), cfg.port);
+      return false;
+    }
+  }
+  MqttClient ctl;
+  if (!ctl.connect(cfg.host.c_str(), cfg.port, "bench-comandos-ctl") || !ctl.subscribe("invernadero/act/+/+", 0)) {
+    std::fprintf(stderr, "no se puede conectar a %s:%u\n", cfg.host.c_str(), cfg.port);
+    return false;
+  }
+  std::vector<std::thread> hilos;
+  for (auto& n : nodos) hilos.emplace_back([&n] { (*n)(); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(300)); // suscripciones activas y estados iniciales
+
+  std::printf("\nde extremo a extremo contra %s:%u: %u órdenes a %u/s, %.0f %% duplicadas, %.0f %% perdidas\n",
+              cfg.host.c_str(), cfg.port, cfg.ordenes, cfg.tasa, cfg.duplicadas * 100, cfg.perdida * 100);
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<double> azar(0, 1);
+  std::vector<uint64_t> primerEnvio(cfg.ordenes), acuseNs(cfg.ordenes);
+  std::vector<bool> reintentada(cfg.ordenes);
+  Pendiente pend[kNumDisp];
+  uint32_t siguiente = 0, enviadas = 0, reintentos = 0, acusesDup = 0;
+  char buf[128];
+  auto enviar = [&](uint32_t k) {
+    const Dispositivo& d = kDispositivos[k % kNumDisp];
+    const size_t n = orden(buf, sizeof(buf), k);
+    const std::string topic = std::string("invernadero/cmd/") + d.nodo + "/" + d.nombre;
+    ctl.publish(topic, std::string_view(buf, n), 1);
+    enviadas++;
+    if (azar(rng) < cfg.duplicadas) {
+      ctl.publish(topic, std::string_view(buf, n), 1);
+      enviadas++;
+    }
+  };
+  auto alRecibir = [&](const mqtt::PublishView& p) {
+    Estado e;
+    if (!leerEstado(p, e) || e.tipo != 'c' || e.k >= cfg.ordenes) return;
+    if (e.dup) acusesDup++;
+    Pendiente& q = pend[e.disp];
+    if (q.ocupado && q.k == e.k) {
+      acuseNs[e.k] = nowNs();
+      q.ocupado = false;
+    }
+  };
+
+  const uint64_t t0 = nowNs();
+  const uint64_t limite = t0 + (uint64_t(cfg.ordenes) * 1000 / std::max(1u, cfg.tasa) + 10000) * 1000000ull;
+  while (nowNs() < limite) {
+    const uint64_t ahora = nowNs();
+    // las órdenes que tocan según la tasa, si su dispositivo no tiene otra pendiente
+    while (siguiente < cfg.ordenes && ahora >= t0 + uint64_t(siguiente) * 1000000000ull / cfg.tasa) {
+      Pendiente& q = pend[siguiente % kNumDisp];
+      if (q.ocupado) break;
+      q = {true, siguiente, ahora, ahora};
+      primerEnvio[siguiente] = ahora;
+      enviar(siguiente++);
+    }
+    // reintentos con el mismo id de las que no tienen estado
+    for (Pendiente& q : pend) {
+      if (q.ocupado && ahora - q.ultimoEnvio >= uint64_t(cfg.reintentoMs) * 1000000) {
+        q.ultimoEnvio = ahora;
+        reintentos++;
+        reintentada[q.k] = true;
+        enviar(q.k);
+      }
+    }
+    if (!ctl.poll(1, alRecibir)) {
+      std::fprintf(stderr, "el controlador ha perdido la conexión\n");
+      break;
+    }
+    if (siguiente == cfg.ordenes && std::none_of(pend, pend + kNumDisp, [](const Pendiente& q) { return q.ocupado; })) {
+      break;
+    }
+  }
+  const double segundos = double(nowNs() - t0) / 1e9;
+
+  // --- 3. TEMPORIZADAS ---
+  // en todos los dispositivos a la vez: "on" 1 s y esperamos el "off" con el mismo id
+  std::vector<uint64_t> errorUs;
+  uint32_t sinApagar = 0;
+  for (uint32_t r = 0; r < cfg.temporizadas; r++) {
+    uint64_t onNs[kNumDisp] = {}, offNs[kNumDisp] = {}, envioNs[kNumDisp] = {};
+    const uint32_t base = r * uint32_t(kNumDisp);
+    auto temporizada = [&](size_t d) {
+      const int n = std::snprintf(buf, sizeof(buf), "{\"cmd\":\"on\",\"seconds\":1,\"id\":\"t%u\"}", base + uint32_t(d));
+      ctl.publish(std::string("invernadero/cmd/") + kDispositivos[d].nodo + "/" + kDispositivos[d].nombre,
+                  std::string_view(buf, size_t(n)), 1);
+      envioNs[d] = nowNs();
+    };
+    for (size_t d = 0; d < kNumDisp; d++) temporizada(d);
+    const uint64_t fin = nowNs() + 5000000000ull;
+    size_t hechos = 0;
+    while (hechos < kNumDisp && nowNs() < fin) {
+      for (size_t d = 0; d < kNumDisp; d++) {
+        if (!onNs[d] && nowNs() - envioNs[d] >= uint64_t(cfg.reintentoMs) * 1000000) temporizada(d);
+      }
+      ctl.poll(5, [&](const mqtt::PublishView& p) {
+        Estado e;
+        if (!leerEstado(p, e) || e.tipo != 't' || e.k != base + e.disp) return;
+        if (e.on && !onNs[e.disp]) onNs[e.disp] = nowNs();
+        if (!e.on && onNs[e.disp] && !offNs[e.disp]) {
+          offNs[e.disp] = nowNs();
+          hechos++;
+        }
+      });
+    }
+    for (size_t d = 0; d < kNumDisp; d++) {
+      if (!offNs[d]) {
+        sinApagar++;
+        continue;
+      }
+      const int64_t err = int64_t(offNs[d] - onNs[d]) / 1000 - 1000000;
+      errorUs.push_back(uint64_t(err < 0 ? -err : err));
+    }
+  }
+
+  for (auto& n : nodos) n->fin = true;
+  for (auto& h : hilos) h.join();
+  ctl.disconnect();
+
+  // --- RESULTADOS ---
+  std::vector<uint64_t> actUs, acuseUs, actRetryUs;
+  uint32_t sinAcuse = 0, sinActuar = 0, repetidas = 0;
+  for (uint32_t k = 0; k < siguiente; k++) {
+    const uint32_t a = reg.actuaciones[k].load();
+    if (!a) sinActuar++;
+    if (a > 1) repetidas++;
+    if (a) (reintentada[k] ? actRetryUs : actUs).push_back((reg.actuadoNs[k].load() - primerEnvio[k]) / 1000);
+    if (!acuseNs[k]) sinAcuse++;
+    else if (!reintentada[k]) acuseUs.push_back((acuseNs[k] - primerEnvio[k]) / 1000);
+  }
+  uint32_t perdidas = 0, duplicadas = 0, rechazadas = 0;
+  for (auto& n : nodos) {
+    perdidas += n->perdidas;
+    duplicadas += n->duplicadas;
+    rechazadas += n->rechazadas;
+  }
+  std::printf("  órdenes %u en %.1f s, envíos %u (reintentos %u), perdidas por el nodo %u, repetidas descartadas %u, "
+              "rechazadas %u\n",
+              siguiente, segundos, enviadas, reintentos, perdidas, duplicadas, rechazadas);
+  // las reintentadas esperan al menos --reintento-ms: van aparte para no tapar la latencia del camino
+  std::printf("  %-30s %9s %9s %9s %9s\n", "", "órdenes", "p50 ms", "p99 ms", "max ms");
+  auto fila = [](const char* nombre, const std::vector<uint64_t>& us) {
+    std::printf("  %-30s %9zu %9.2f %9.2f %9.2f\n", nombre, us.size(), percentil(us, 50) / 1000.0,
+                percentil(us, 99) / 1000.0, percentil(us, 100) / 1000.0);
+  };
+  fila("orden -> actuación", actUs);
+  fila("orden -> estado", acuseUs);
+  fila("orden -> actuación (reintento)", actRetryUs);
+  std::printf("  idempotencia: %u órdenes aplicadas más de una vez, %u sin aplicar, %u sin estado (%u estados dup)\n",
+              repetidas, sinActuar, sinAcuse, acusesDup);
+  if (cfg.temporizadas) {
+    std::printf("  temporizadas de 1 s: error p50 %.0f ms, máx %.0f ms, %u sin apagar\n", percentil(errorUs, 50) / 1000.0,
+                percentil(errorUs, 100) / 1000.0, sinApagar);
+  }
+  return repetidas == 0 && sinActuar == 0 && sinAcuse == 0 && sinApagar == 0;
+}
+
+bool leerArgs(int argc, char** argv, Config& c) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string k = argv[i];
+    const char* v = argv[i + 1];
+    if (k == "--host") c.host = v;
+    else if (k == "--port") c.port = uint16_t(std::atoi(v));
+    else if (k == "--ordenes") c.ordenes = uint32_t(std::max(1, std::atoi(v)));
+    else if (k == "--tasa") c.tasa = uint32_t(std::max(1, std::atoi(v)));
+    else if (k == "--duplicadas") c.duplicadas = std::atof(v);
+    else if (k == "--perdida") c.perdida = std::atof(v);
+    else if (k == "--reintento-ms") c.reintentoMs = uint32_t(std::max(1, std::atoi(v)));
+    else if (k == "--temporizadas") c.temporizadas = uint32_t(std::atoi(v));
+    else if (k == "--solo-local") c.soloLocal = std::atoi(v) != 0;
+    else return false;
+  }
+  return (argc % 2) == 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Config cfg;
+  if (!leerArgs(argc, argv, cfg)) {
+    std::fprintf(stderr, "argumentos no válidos (ver el comentario de src/bench_comandos/main.cpp)\n");
+    return 2;
+  }
+  benchLocal();
+  if (cfg.soloLocal) return 0;
+  return benchBroker(cfg) ? 0 : 1;
+}
@@ -0,0 +1,288 @@
+// --- BENCHMARK DEL SERVICIO DE CONSULTAS ---
+// mide la latencia de los GET de /api/greenhouse y /api/alexa con muchos clientes a la vez, contra el servicio de
+//   consultas o contra Node-RED (--port 1881) para comparar:
+//
+//   1. en proceso: lecturas por segundo de un Seqlock con una foto como la del servicio, con --hilos lectores y un
+//      escritor publicando sin parar (el peor caso de reintentos)
+//   2. HTTP: --conexiones keep-alive repartidas en --hilos, cada una en bucle cerrado (manda una petición, espera la
+//      respuesta y manda la siguiente), rotando por todas las rutas. Si se da --mqtt-port, mientras tanto publica
+//      telemetría a --tasa-mqtt mensajes/s para que la ingesta escriba a la vez que se lee.
+//   Saca peticiones por segundo y p50/p99/p99,9/máx por ruta y en total, y cuántas respuestas no han sido 200.
+//
+// Uso: program [--host 127.0.0.1] [--port 1882] [--conexiones 64] [--hilos 4] [--segundos 5]
+//              [--mqtt-port 0] [--tasa-mqtt 1000]
+#include <MqttClient.h>
+#include <Percentil.h>
+#include <Rollup.h>
+#include <Seqlock.h>
+
+#include <sys/epoll.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double segundosDesde(Clock::time_point t0) {
+  return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+struct Config {
+  std::string host = "127.0.0.1";
+  uint16_t port = 1882;
+  uint32_t conexiones = 64;
+  uint32_t hilos = std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+  uint32_t segundos = 5;
+  uint16_t mqttPort = 0;
+  uint32_t tasaMqtt = 1000;
+};
+
+constexpr const char* kRutas[] = {
+    "/api/greenhouse/temperature", "/api/greenhouse/humidity", "/api/greenhouse/soil", "/api/greenhouse/tank",
+    "/api/greenhouse/light",       "/api/greenhouse/status",   "/api/alexa/dht",       "/api/alexa/soil",
+    "/api/alexa/tank",             "/api/alexa/light",         "/api/alexa/aire",
+};
+constexpr size_t kNumRutas = sizeof(kRutas) / sizeof(kRutas[0]);
+
+// --- 1. SEQLOCK EN PROCESO ---
+struct Foto { // la misma forma que la del servicio
+  int64_t ts;
+  double value;
+  cache::Resumen ventanas[cache::Rollups::kN];
+};
+
+void benchSeqlock(uint32_t lectores) {
+  Seqlock<Foto> s;
+  std::atomic<bool> fin{false};
+  std::atomic<uint64_t> lecturas{0}, rotas{0};
+  std::thread escritor([&] {
+    Foto f{};
+    for (int64_t i = 1; !fin.load(std::memory_order_relaxed); i++) {
+      f.ts = i;
+      f.value = double(i);
+      for (cache::Resumen& r : f.ventanas) r = {uint64_t(i), double(i), double(i), double(i)};
+      s.store(f);
+    }
+  });
+  std::vector<std::thread> hilos;
+  for (uint32_t h = 0; h < lectores; h++) {
+    hilos.emplace_back([&] {
+      uint64_t n = 0, mal = 0;
+      while (!fin.load(std::memory_order_relaxed)) {
+        for (int i = 0; i < 1000; i++) {
+          const Foto f = s.load();
+          // una foto a medias tendría campos de escrituras distintas
+          if (double(f.ts) != f.value || (f.ts && f.ventanas[2].n != uint64_t(f.ts))) mal++;
+        }
+        n += 1000;
+      }
+      lecturas += n;
+      rotas += mal;
+    });
+  }
+  const auto t0 = Clock::now();
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  fin = true;
+  escritor.join();
+  for (std::thread& h : hilos) h.join();
+  const double seg = segundosDesde(t0);
+  std::printf("seqlock: %u lectores con un escritor sin pausa: %.1f M lecturas/s (%.0f ns cada una por hilo), "
+              "%s\n\n",
+              lectores, double(lecturas.load()) / seg / 1e6, seg * lectores * 1e9 / double(lecturas.load()),
+              rotas.load() ? "ERROR: fotos a medias" : "ninguna foto a medias");
+}
+
+// --- 2. CARGA HTTP ---
+struct Cliente {
+  int fd = -1;
+  size_t ruta = 0;
+  Clock::time_point enviada;
+  std::string entrada;
+};
+
+struct Resultado {
+  std::vector<float> us[kNumRutas]; // latencias en microsegundos
+  uint64_t no200 = 0, errores = 0;
+};
+
+void enviar(Cliente& c) {
+  char req[160];
+  const int n = std::snprintf(req, sizeof(req), "GET %s HTTP/1.1\r\nHost: invernadero\r\n\r\n", kRutas[c.ruta]);
+  c.enviada = Clock::now();
+  if (send(c.fd, req, size_t(n), MSG_NOSIGNAL) != n) c.fd = -1;
+}
+
+// respuesta completa al principio de c.entrada: la quita y devuelve el status (0 si aún falta, -1 si no se entiende)
+int respuesta(Cliente& c) {
+  const size_t fin = c.entrada.find("\r\n\r\n");
+  if (fin == std::string::npos) return 0;
+  const size_t cl = c.entrada.find("Content-Length:");
+  if (cl == std::string::npos || cl > fin || c.entrada.compare(0, 9, "HTTP/1.1 ") != 0) return -1;
+  const size_t largo = size_t(std::strtoull(c.entrada.c_str() + cl + 15, nullptr, 10));
+  if (c.entrada.size() < fin + 4 + largo) return 0;
+  const int status = std::atoi(c.entrada.c_str() + 9);
+  c.entrada.erase(0, fin + 4 + largo);
+  return status;
+}
+
+void cargar(const Config& cfg, const sockaddr_in& addr, uint32_t conexiones, uint32_t primera,
+            const std::atomic<bool>& fin, Resultado& res) {
+  const int ep = epoll_create1(EPOLL_CLOEXEC);
+  std::vector<Cliente> clientes(conexiones);
+  for (uint32_t i = 0; i < conexiones; i++) {
+    Cliente& c = clientes[i];
+    c.fd = net::connectTcp(addr, false);
+    if (c.fd < 0) {
+      res.errores++;
+      continue;
+    }
+    c.ruta = (primera + i) % kNumRutas;
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u32 = i;
+    epoll_ctl(ep, EPOLL_CTL_ADD, c.fd, &ev);
+    enviar(c);
+  }
+  for (auto& v : res.us) v.reserve(size_t(cfg.segundos) * 100000 / kNumRutas);
+  epoll_event evs[256];
+  char buf[16 * 1024];
+  while (!fin.load(std::memory_order_relaxed)) {
+    const int n = epoll_wait(ep, evs, 256, 100);
+    for (int e = 0; e < n; e++) {
+      Cliente& c = clientes[evs[e].data.u32];
+      const ssize_t r = recv(c.fd, buf, sizeof(buf), MSG_DONTWAIT);
+      if (r <= 0) {
+        if (r < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+        res.errores++;
+        epoll_ctl(ep, EPOLL_CTL_DEL, c.fd, nullptr);
+        ::close(c.fd);
+        c.fd = -1;
+        continue;
+      }
+      c.entrada.append(buf, size_t(r));
+      int status;
+      while ((status = respuesta(c)) != 0) {
+        const auto ahora = Clock::now();
+        if (status < 0) {
+          res.errores++;
+          c.entrada.clear();
+          break;
+        }
+        if (status != 200) res.no200++;
+        res.us[c.ruta].push_back(float(std::chrono::duration<double, std::micro>(ahora - c.enviada).count()));
+        c.ruta = (c.ruta + 1) % kNumRutas;
+        enviar(c);
+      }
+    }
+  }
+  for (Cliente& c : clientes) {
+    if (c.fd >= 0) ::close(c.fd);
+  }
+  ::close(ep);
+}
+
+// telemetría de los seis tipos a ritmo fijo, para que la ingesta escriba mientras se lee
+void publicarTelemetria(const Config& cfg, const std::atomic<bool>& fin) {
+  static const char* const kTipos[][2] = {{"node1", "temp"}, {"node1", "hum"},  {"node2", "soil"},
+                                          {"node3", "light"}, {"node4", "tank"}, {"node4", "aire"}};
+  MqttClient cli;
+  if (!cli.connect(cfg.host.c_str(), cfg.mqttPort, "bench-consultas")) {
+    std::fprintf(stderr, "no se puede conectar al broker %s:%u\n", cfg.host.c_str(), cfg.mqttPort);
+    return;
+  }
+  const auto t0 = Clock::now();
+  uint64_t enviados = 0;
+  while (!fin.load(std::memory_order_relaxed)) {
+    const uint64_t debidos = uint64_t(segundosDesde(t0) * cfg.tasaMqtt);
+    for (; enviados < debidos; enviados++) {
+      const auto& t = kTipos[enviados % 6];
+      char topic[48], json[96];
+      std::snprintf(topic, sizeof(topic), "greenhouse/%s/telemetry", t[0]);
+      std::snprintf(json, sizeof(json), "{\"ts\":%llu,\"type\":\"%s\",\"value\":%llu}",
+                    (unsigned long long)(1767225600000ull + enviados), t[1], (unsigned long long)(enviados % 100));
+      cli.publish(topic, json);
+    }
+    cli.flush();
+    cli.poll(1, [](const mqtt::PublishView&) {});
+  }
+  std::printf("telemetría publicada durante la carga: %llu mensajes\n", (unsigned long long)enviados);
+  cli.disconnect();
+}
+
+bool leerArgs(int argc, char** argv, Config& c) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string k = argv[i];
+    const char* v = argv[i + 1];
+    if (k == "--host") c.host = v;
+    else if (k == "--port") c.port = uint16_t(std::atoi(v));
+    else if (k == "--conexiones") c.conexiones = uint32_t(std::max(1, std::atoi(v)));
+    else if (k == "--hilos") c.hilos = uint32_t(std::max(1, std::atoi(v)));
+    else if (k == "--segundos") c.segundos = uint32_t(std::max(1, std::atoi(v)));
+    else if (k == "--mqtt-port") c.mqttPort = uint16_t(std::atoi(v));
+    else if (k == "--tasa-mqtt") c.tasaMqtt = uint32_t(std::max(1, std::atoi(v)));
+    else return false;
+  }
+  return (argc % 2) == 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Config cfg;
+  if (!leerArgs(argc, argv, cfg)) {
+    std::fprintf(stderr, "argumentos no válidos (ver el comentario de src/bench_consultas/main.cpp)\n");
+    return 2;
+  }
+  benchSeqlock(cfg.hilos);
+
+  sockaddr_in addr;
+  if (!net::resolve(cfg.host.c_str(), cfg.port, addr)) return 1;
+  std::atomic<bool> fin{false};
+  std::thread telemetria;
+  if (cfg.mqttPort) telemetria = std::thread([&] { publicarTelemetria(cfg, fin); });
+  std::vector<Resultado> res(cfg.hilos);
+  std::vector<std::thread> hilos;
+  for (uint32_t h = 0; h < cfg.hilos; h++) {
+    const uint32_t n = cfg.conexiones / cfg.hilos + (h < cfg.conexiones % cfg.hilos ? 1 : 0);
+    hilos.emplace_back([&, h, n] { cargar(cfg, addr, n, h * 7, fin, res[h]); });
+  }
+  const auto t0 = Clock::now();
+  std::this_thread::sleep_for(std::chrono::seconds(cfg.segundos));
+  fin = true;
+  for (std::thread& h : hilos) h.join();
+  const double seg = segundosDesde(t0);
+  if (telemetria.joinable()) telemetria.join();
+
+  std::printf("%s:%u, %u conexiones en %u hilos, %u s\n\n", cfg.host.c_str(), cfg.port, cfg.conexiones, cfg.hilos,
+              cfg.segundos);
+  std::printf("  %-28s %10s %9s %9s %9s %9s\n", "ruta", "pet/s", "p50 µs", "p99 µs", "p99,9 µs", "máx µs");
+  std::vector<float> todas;
+  uint64_t no200 = 0, errores = 0;
+  for (size_t r = 0; r < kNumRutas; r++) {
+    std::vector<float> v;
+    for (Resultado& x : res) v.insert(v.end(), x.us[r].begin(), x.us[r].end());
+    todas.insert(todas.end(), v.begin(), v.end());
+    const double maximo = v.empty() ? 0 : *std::max_element(v.begin(), v.end());
+    std::printf("  %-28s %10.0f %9.0f %9.0f %9.0f %9.0f\n", kRutas[r], double(v.size()) / seg, percentil(v, 50),
+                percentil(v, 99), percentil(v, 99.9), maximo);
+  }
+  for (Resultado& x : res) {
+    no200 += x.no200;
+    errores += x.errores;
+  }
+  const double maximo = todas.empty() ? 0 : *std::max_element(todas.begin(), todas.end());
+  std::printf("  %-28s %10.0f %9.0f %9.0f %9.0f %9.0f\n", "total", double(todas.size()) / seg, percentil(todas, 50),
+              percentil(todas, 99), percentil(todas, 99.9), maximo);
+  std::printf("\nrespuestas distintas de 200: %llu, errores de conexión: %llu\n", (unsigned long long)no200,
+              (unsigned long long)errores);
+  return errores ? 1 : 0;
+}
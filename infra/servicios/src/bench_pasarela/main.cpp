@@ -0,0 +1,255 @@
+// --- BENCHMARK DE LA NORMALIZACIÓN DE TELEMETRÍA ---
+// dos partes:
+//   1. en proceso, sin red: coste por mensaje de ingesta::normalize con los payloads del firmware
+//   2. contra un broker local, de extremo a extremo: publica en los topics crudos a tasas crecientes desde una sola
+//      conexión y mide en greenhouse/+/telemetry cuántos mensajes salen, cuántos se pierden y con qué latencia. Vale
+//      igual para la pasarela que para las funciones de Node-RED (se comparan lanzándolo con una u otra activa).
+//
+// Para casar cada mensaje de salida con su envío el valor de cada tipo es un contador (temperatura 0-49 ºC, el resto
+//   0-100 %): como el orden por nodo se conserva, el siguiente valor esperado identifica el envío, y un salto de k
+//   cuenta k mensajes perdidos.
+//
+// Uso: program [--host 127.0.0.1] [--port 1884] [--tasas 2000,5000,10000,20000,40000] [--segundos 5]
+//              [--solo-local 1]
+#include <MqttClient.h>
+#include <Normalizer.h>
+#include <Percentil.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t nowNs() {
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+}
+
+struct Config {
+  std::string host = "127.0.0.1";
+  uint16_t port = 1884;
+  std::vector<uint32_t> tasas = {2000, 5000, 10000, 20000, 40000};
+  uint32_t segundos = 5;
+  uint32_t esperaS = 2;
+  bool soloLocal = false;
+};
+
+// --- TIPOS ---
+// el valor de cada publicación es k % modulo; type es el de la telemetría que lo devuelve
+struct Tipo {
+  const char* topic;
+  const char* type;
+  uint32_t modulo;
+};
+constexpr Tipo kTipos[] = {{"dht11", "temp", 50}, {"soil", "soil", 101}, {"ldr", "light", 101}, {"mq135", "aire", 101}};
+constexpr size_t kNumTipos = sizeof(kTipos) / sizeof(kTipos[0]);
+
+// payload con el mismo formato que el firmware
+size_t payload(char* out, size_t cap, size_t tipo, uint32_t v, uint32_t seq) {
+  switch (tipo) {
+    case 0:
+      return size_t(std::snprintf(out, cap, "{\"temperatura\":%u.00,\"humedad\":%u.00,\"seq\":%u}", v, 40 + v % 50, seq));
+    case 1:
+      return size_t(std::snprintf(out, cap, "{\"humedad\":%u,\"raw\":%u,\"seq\":%u}", v, 1023 - v * 1023 / 100, seq));
+    case 2: return size_t(std::snprintf(out, cap, "{\"luz\":%u,\"raw\":%u,\"seq\":%u}", v, v * 1023 / 100, seq));
+    default:
+      return size_t(std::snprintf(out, cap, "{\"raw\":%u,\"percentage\":%u,\"seq\":%u}", v * 1023 / 100, v, seq));
+  }
+}
+
+// --- 1. EN PROCESO ---
+void benchLocal() {
+  constexpr uint32_t kVueltas = 400000;
+  char buf[kNumTipos][64][96];
+  size_t len[kNumTipos][64];
+  for (size_t t = 0; t < kNumTipos; t++) {
+    for (uint32_t i = 0; i < 64; i++) len[t][i] = payload(buf[t][i], sizeof(buf[t][i]), t, i % kTipos[t].modulo, i);
+  }
+  std::printf("normalización en proceso (%u mensajes por topic)\n", kVueltas);
+  std::printf("  %-8s %10s %12s\n", "topic", "ns/msg", "msg/s");
+  for (size_t t = 0; t < kNumTipos; t++) {
+    size_t bytes = 0;
+    const uint64_t t0 = nowNs();
+    for (uint32_t i = 0; i < kVueltas; i++) {
+      ingesta::normalize(kTipos[t].topic, std::string_view(buf[t][i & 63], len[t][i & 63]), 1700000000000ull + i,
+                         [&](std::string_view, std::string_view json) { bytes += json.size(); });
+    }
+    const double ns = double(nowNs() - t0) / kVueltas;
+    if (!bytes) std::printf("  (sin salida)\n");
+    std::printf("  %-8s %10.0f %12.0f\n", kTipos[t].topic, ns, 1e9 / ns);
+  }
+}
+
+// --- 2. DE EXTREMO A EXTREMO ---
+class Receptor {
+ public:
+  Receptor(const Config& cfg, std::vector<std::vector<std::atomic<uint64_t>>>& envios)
+      : cfg_(cfg), envios_(envios) {}
+
+  bool conectar() {
+    return cli_.connect(cfg_.host.c_str(), cfg_.port, "bench-pasarela-rx") &&
+           cli_.subscribe("greenhouse/+/telemetry", 0);
+  }
+
+  void operator()() {
+    while (!fin.load(std::memory_order_relaxed)) {
+      if (!cli_.poll(20, [this](const mqtt::PublishView& p) { recibir(p); })) {
+        std::fprintf(stderr, "el receptor ha perdido la conexión\n");
+        return;
+      }
+    }
+  }
+
+  std::atomic<bool> fin{false};
+  std::atomic<uint64_t> recibidos{0}, perdidos{0}, duplicados{0};
+  std::vector<uint64_t> latUs; // se lee cuando el hilo ya ha terminado
+  uint64_t siguiente[kNumTipos] = {};
+
+ private:
+  void recibir(const mqtt::PublishView& p) {
+    const uint64_t ahora = nowNs();
+    std::string_view type;
+    double v = -1;
+    json::forEachField(p.payload, [&](std::string_view k, std::string_view val) {
+      if (k == "type") type = val;
+      else if (k == "value") json::toDouble(val, v);
+    });
+    recibidos.fetch_add(1, std::memory_order_relaxed);
+    for (size_t t = 0; t < kNumTipos; t++) {
+      if (type != kTipos[t].type) continue;
+      if (v < 0) return;
+      auto& env = envios_[t];
+      const uint32_t m = kTipos[t].modulo;
+      const uint64_t k = siguiente[t];
+      // distancia entre el valor recibido y el esperado: 0 es el siguiente, m-1 es el anterior repetido
+      const uint32_t salto = (uint32_t(v) + m - uint32_t(k % m)) % m;
+      if (salto == m - 1) {
+        duplicados.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      perdidos.fetch_add(salto, std::memory_order_relaxed);
+      const uint64_t idx = k + salto;
+      if (idx < env.size()) {
+        const uint64_t enviado = env[idx].load(std::memory_order_relaxed);
+        if (enviado) latUs.push_back((ahora - enviado) / 1000);
+      }
+      siguiente[t] = idx + 1;
+      return;
+    }
+  }
+
+  const Config& cfg_;
+  std::vector<std::vector<std::atomic<uint64_t>>>& envios_;
+  MqttClient cli_;
+};
+
+bool benchBroker(const Config& cfg) {
+  const uint32_t maxTasa = *std::max_element(cfg.tasas.begin(), cfg.tasas.end());
+  const size_t porTipo = size_t(maxTasa) * cfg.segundos / kNumTipos + 16;
+
+  std::printf("\nde extremo a extremo contra %s:%u (%u s por tasa)\n", cfg.host.c_str(), cfg.port, cfg.segundos);
+  std::printf("  %8s %10s %10s %10s %9s %9s %9s %9s\n", "tasa", "env/s", "salida/s", "pérdida", "dup", "p50 ms",
+              "p99 ms", "max ms");
+  uint32_t sostenida = 0;
+  for (uint32_t tasa : cfg.tasas) {
+    std::vector<std::vector<std::atomic<uint64_t>>> envios(kNumTipos);
+    for (auto& e : envios) e = std::vector<std::atomic<uint64_t>>(porTipo);
+    Receptor rx(cfg, envios);
+    MqttClient tx;
+    if (!rx.conectar() || !tx.connect(cfg.host.c_str(), cfg.port, "bench-pasarela-tx")) {
+      std::fprintf(stderr, "no se puede conectar a %s:%u\n", cfg.host.c_str(), cfg.port);
+      return false;
+    }
+    std::thread hiloRx([&rx] { rx(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200)); // que la suscripción esté activa
+
+    // cada milisegundo publicamos lo que toque según la tasa, en un solo send()
+    uint64_t enviados = 0, k[kNumTipos] = {};
+    const uint64_t t0 = nowNs();
+    const uint64_t total = uint64_t(tasa) * cfg.segundos;
+    char buf[96];
+    while (enviados < total) {
+      const uint64_t ahora = nowNs();
+      const uint64_t debidos = std::min<uint64_t>(total, (ahora - t0) * tasa / 1000000000ull);
+      for (; enviados < debidos; enviados++) {
+        const size_t t = enviados % kNumTipos;
+        if (k[t] >= porTipo) continue;
+        const size_t n = payload(buf, sizeof(buf), t, uint32_t(k[t] % kTipos[t].modulo), uint32_t(k[t]));
+        envios[t][k[t]++].store(nowNs(), std::memory_order_relaxed);
+        tx.publish(kTipos[t].topic, std::string_view(buf, n));
+      }
+      if (!tx.flush()) {
+        std::fprintf(stderr, "el emisor ha perdido la conexión\n");
+        break;
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+    const double envS = double(enviados) * 1e9 / double(nowNs() - t0);
+    const uint64_t recibidosFin = rx.recibidos.load();
+    std::this_thread::sleep_for(std::chrono::seconds(cfg.esperaS));
+    rx.fin = true;
+    hiloRx.join();
+    tx.disconnect();
+
+    // lo que aún no ha llegado tras la espera también se pierde
+    uint64_t perdidos = rx.perdidos.load();
+    uint64_t esperados = 0;
+    for (size_t t = 0; t < kNumTipos; t++) {
+      perdidos += k[t] - std::min(k[t], rx.siguiente[t]);
+      esperados += k[t];
+    }
+    const double perdida = esperados ? 100.0 * double(perdidos) / double(esperados) : 0;
+    const double salidaS = double(recibidosFin) / cfg.segundos;
+    const uint64_t p50 = percentil(rx.latUs, 50), p99 = percentil(rx.latUs, 99), mx = percentil(rx.latUs, 100);
+    std::printf("  %8u %10.0f %10.0f %9.2f%% %9llu %9.1f %9.1f %9.1f\n", tasa, envS, salidaS, perdida,
+                (unsigned long long)rx.duplicados.load(), p50 / 1000.0, p99 / 1000.0, mx / 1000.0);
+    std::fflush(stdout);
+    if (perdida < 0.1 && p99 < 100000) sostenida = tasa;
+  }
+  std::printf("tasa máxima sostenida (pérdida < 0,1 %%, p99 < 100 ms): %u msg/s\n", sostenida);
+  return true;
+}
+
+bool leerArgs(int argc, char** argv, Config& c) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string k = argv[i];
+    const char* v = argv[i + 1];
+    if (k == "--host") c.host = v;
+    else if (k == "--port") c.port = uint16_t(std::atoi(v));
+    else if (k == "--segundos") c.segundos = uint32_t(std::max(1, std::atoi(v)));
+    else if (k == "--espera") c.esperaS = uint32_t(std::atoi(v));
+    else if (k == "--solo-local") c.soloLocal = std::atoi(v) != 0;
+    else if (k == "--tasas") {
+      c.tasas.clear();
+      for (const char* p = v; *p;) {
+        const uint32_t t = uint32_t(std::strtoul(p, const_cast<char**>(&p), 10));
+        if (t) c.tasas.push_back(t);
+        if (*p == ',') p++;
+        else if (*p) return false;
+      }
+      if (c.tasas.empty()) return false;
+    } else {
+      return false;
+    }
+  }
+  return (argc % 2) == 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Config cfg;
+  if (!leerArgs(argc, argv, cfg)) {
+    std::fprintf(stderr, "argumentos no válidos (ver el comentario de src/bench_pasarela/main.cpp)\n");
+    return 2;
+  }
+  benchLocal();
+  if (cfg.soloLocal) return 0;
+  return benchBroker(cfg) ? 0 : 1;
+}
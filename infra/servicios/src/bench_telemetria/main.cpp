@@ -0,0 +1,169 @@
+// --- BENCHMARK: LOTES BINARIOS FRENTE A JSON ---
+// compara, para los cuatro sensores, el formato actual (un JSON por lectura en el topic crudo) con el formato binario
+//   por lotes (BatchFormat.h):
+//   - bytes por muestra: payload, paquete MQTT y "en el aire" (sumando cabeceras TCP/IP y 802.11 por paquete)
+//   - paquetes por muestra (despertares de la radio)
+//   - coste de decodificar en el backend hasta la telemetría normalizada (ns por muestra)
+//
+// Uso: program [muestras por lote] [muestras totales por sensor]
+#include <BatchFormat.h>
+#include <JsonScan.h>
+#include <TelemetryJson.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// cabeceras por paquete fuera de MQTT: IPv4 (20) + TCP (20) + MAC 802.11 con LLC/SNAP y FCS (~36)
+constexpr size_t kOverheadPorPaquete = 20 + 20 + 36;
+
+size_t bytesMqtt(size_t topic, size_t payload) {
+  const size_t remaining = 2 + topic + payload; // PUBLISH QoS 0: longitud del topic + topic + payload
+  return 1 + (remaining < 128 ? 1 : 2) + remaining;
+}
+
+struct Serie {
+  const batch::SensorInfo* info;
+  std::vector<batch::Sample> samples;
+};
+
+// lecturas cada 3 s (con algo de jitter) que cambian poco entre sí, como en el invernadero
+Serie generar(SensorType tipo, size_t n, std::mt19937& rng) {
+  Serie s{batch::sensorInfo(uint8_t(tipo)), {}};
+  std::normal_distribution<double> paso(0, 1);
+  std::uniform_int_distribution<int> jitter(-15, 15);
+  double v[2] = {tipo == SensorType::Dht11 ? 2350.0 : 50.0, 5500.0};
+  uint32_t ts = 10000;
+  for (size_t i = 0; i < n; i++) {
+    batch::Sample m{};
+    m.ts = ts;
+    for (uint8_t f = 0; f < s.info->fields; f++) {
+      v[f] += paso(rng) * (tipo == SensorType::Dht11 ? 20 : 1);
+      m.value[f] = int32_t(v[f]);
+    }
+    s.samples.push_back(m);
+    ts += 3000 + jitter(rng);
+  }
+  return s;
+}
+
+// el JSON que publica hoy cada nodo (mismos campos que los drivers)
+std::string jsonNodo(const Serie& s, const batch::Sample& m) {
+  char buf[64];
+  switch (s.info->id) {
+    case SensorType::Dht11:
+      std::snprintf(buf, sizeof(buf), "{\"temperatura\":%g,\"humedad\":%g}", m.value[0] / 100.0, m.value[1] / 100.0);
+      break;
+    case SensorType::Soil:
+      std::snprintf(buf, sizeof(buf), "{\"humedad\":%d,\"raw\":%d}", m.value[0], 1023 - m.value[0] * 10);
+      break;
+    case SensorType::Ldr:
+      std::snprintf(buf, sizeof(buf), "{\"luz\":%d,\"raw\":%d}", m.value[0], m.value[0] * 10);
+      break;
+    case SensorType::Mq135:
+      std::snprintf(buf, sizeof(buf), "{\"raw\":%d,\"percentage\":%d}", m.value[0] * 10, m.value[0]);
+      break;
+  }
+  return buf;
+}
+
+// claves que usan las funciones *_to_telemetry de Node-RED para cada campo
+const char* claveJson(SensorType t, uint8_t f) {
+  switch (t) {
+    case SensorType::Dht11: return f ? "humedad" : "temperatura";
+    case SensorType::Soil: return "humedad";
+    case SensorType::Ldr: return "luz";
+    case SensorType::Mq135: return "percentage";
+  }
+  return "";
+}
+
+volatile size_t sumidero; // evita que el compilador elimine el trabajo medido
+
+void medir(const Serie& s, size_t porLote) {
+  const size_t n = s.samples.size();
+  const size_t topicCrudo = std::strlen(s.info->rawTopic);
+  const size_t topicBin = topicCrudo + 4; // "<topic>/bin"
+
+  // --- JSON ---
+  std::vector<std::string> mensajes;
+  size_t payloadJson = 0, mqttJson = 0;
+  for (const auto& m : s.samples) {
+    mensajes.push_back(jsonNodo(s, m));
+    payloadJson += mensajes.back().size();
+    mqttJson += bytesMqtt(topicCrudo, mensajes.back().size());
+  }
+
+  // --- BINARIO ---
+  std::vector<std::vector<uint8_t>> lotes;
+  size_t payloadBin = 0, mqttBin = 0;
+  for (size_t i = 0; i < n; i += porLote) {
+    std::vector<uint8_t> buf(batch::maxFrameSize(uint8_t(porLote), s.info->fields));
+    batch::Encoder enc(buf.data(), buf.size());
+    enc.begin(s.info->id, s.info->fields, 0xC0FFEE, uint16_t(lotes.size()), s.samples[i].ts);
+    for (size_t k = i; k < i + porLote && k < n; k++) enc.add(s.samples[k].ts, s.samples[k].value);
+    buf.resize(enc.length());
+    payloadBin += buf.size();
+    mqttBin += bytesMqtt(topicBin, buf.size());
+    lotes.push_back(std::move(buf));
+  }
+
+  // --- DECODIFICACIÓN HASTA LA TELEMETRÍA NORMALIZADA ---
+  // JSON: leer el payload, sacar el campo y formatear {"ts","type","value"} (lo que hacen hoy las funciones de Node-RED)
+  char out[96];
+  auto t0 = std::chrono::steady_clock::now();
+  size_t acc = 0;
+  for (const auto& msg : mensajes) {
+    for (uint8_t f = 0; f < s.info->fields; f++) {
+      const char* clave = claveJson(s.info->id, f);
+      double v = 0;
+      json::forEachField(msg, [&](std::string_view k, std::string_view val) {
+        if (k == clave) json::toDouble(val, v);
+      });
+      acc += telemetry::formatJson(out, sizeof(out), 1700000000000ull, s.info->field[f].type,
+                                   int32_t(v * s.info->field[f].scale), s.info->field[f].scale);
+    }
+  }
+  auto t1 = std::chrono::steady_clock::now();
+  for (const auto& l : lotes) {
+    telemetry::expand(l.data(), l.size(), 1700000000000ull, [&](std::string_view, std::string_view j) { acc += j.size(); });
+  }
+  auto t2 = std::chrono::steady_clock::now();
+  sumidero = acc;
+
+  const double nsJson = std::chrono::duration<double, std::nano>(t1 - t0).count() / double(n);
+  const double nsBin = std::chrono::duration<double, std::nano>(t2 - t1).count() / double(n);
+  const double dn = double(n);
+  const double airJson = double(mqttJson + mensajes.size() * kOverheadPorPaquete) / dn;
+  const double airBin = double(mqttBin + lotes.size() * kOverheadPorPaquete) / dn;
+
+  std::printf("%-6s json    payload %5.1f B  mqtt %5.1f B  aire %6.1f B  paquetes %.3f  decodificar %6.1f ns/muestra\n",
+              s.info->rawTopic, payloadJson / dn, mqttJson / dn, airJson, mensajes.size() / dn, nsJson);
+  std::printf("%-6s binario payload %5.1f B  mqtt %5.1f B  aire %6.1f B  paquetes %.3f  decodificar %6.1f ns/muestra"
+              "  (x%.1f menos bytes en el aire)\n",
+              "", payloadBin / dn, mqttBin / dn, airBin, lotes.size() / dn, nsBin, airJson / airBin);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const size_t porLote = argc > 1 ? size_t(std::atoi(argv[1])) : 10;
+  const size_t total = argc > 2 ? size_t(std::atoi(argv[2])) : 200000;
+  if (!porLote || porLote > batch::kMaxSamples) {
+    std::fprintf(stderr, "muestras por lote entre 1 y %u\n", batch::kMaxSamples);
+    return 1;
+  }
+  std::mt19937 rng(42);
+  std::printf("%zu muestras por sensor, %zu por lote; cabeceras TCP/IP + 802.11 de %zu B por paquete\n\n", total,
+              porLote, kOverheadPorPaquete);
+  for (SensorType t : {SensorType::Dht11, SensorType::Soil, SensorType::Ldr, SensorType::Mq135}) {
+    medir(generar(t, total, rng), porLote);
+  }
+  return 0;
+}
@@ -0,0 +1,221 @@
+// --- BENCHMARK DE LA BASE DE SERIES TEMPORALES ---
+// simula --dias de telemetría cada 3 s (el kPeriodMs de los drivers) de todas las series del invernadero, con el jitter
+//   de recepción y la resolución de cada sensor, y mide:
+//   - ingesta: muestras por segundo a través de Db::append (WAL incluido, con sync cada --sync muestras)
+//   - tamaño: bytes por muestra en los segmentos, frente a 16 en bruto y al JSON de la telemetría
+//   - consultas tras reabrir (mmap de los segmentos y repaso del WAL): p50/p99 de rangos en bruto y con downsample
+//   Al final relee una serie entera y comprueba que cada muestra es la generada.
+//
+// Uso: program [--dir /tmp/bench_tsdb] [--dias 365] [--consultas 200] [--sync 100000]
+#include <Db.h>
+#include <Percentil.h>
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double segundosDesde(Clock::time_point t0) {
+  return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+constexpr int64_t kPeriodoMs = 3000;
+constexpr int64_t kDiaMs = 24 * 3600 * 1000LL;
+constexpr int64_t kInicio = 1735689600000LL; // 2025-01-01 00:00 UTC
+constexpr double kPi = 3.14159265358979;
+
+struct Config {
+  std::string dir = "/tmp/bench_tsdb";
+  uint32_t dias = 365;
+  uint32_t consultas = 200;
+  uint32_t sync = 100000;
+};
+
+// --- DATOS SIMULADOS ---
+// función de (serie, k): así se puede regenerar cualquier muestra para comprobar lo leído
+uint64_t mezcla(uint64_t x) {
+  x += 0x9E3779B97F4A7C15ull;
+  x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+  x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+  return x ^ (x >> 31);
+}
+double ruido(uint32_t serie, uint64_t k) { // [-1, 1)
+  return double(mezcla(uint64_t(serie) << 40 ^ k) >> 11) / double(1ull << 52) - 1.0;
+}
+
+// ts de la muestra k: el periodo nominal más el jitter de recepción (hasta ±20 ms), sin acumularse
+int64_t tsDe(uint64_t k) {
+  return kInicio + int64_t(k) * kPeriodoMs + int64_t(std::lround(ruido(99, k) * 20));
+}
+
+struct Serie {
+  const char* nombre;
+  double resolucion;
+};
+constexpr Serie kSeries[] = {{"node1/temp", 0.1}, {"node1/hum", 1},  {"node2/soil", 1},
+                             {"node3/light", 1},  {"node4/aire", 1}, {"node4/tank", 1}};
+constexpr uint32_t kNumSeries = sizeof(kSeries) / sizeof(kSeries[0]);
+
+double valorDe(uint32_t s, uint64_t k) {
+  const double dia = double(int64_t(k) * kPeriodoMs % kDiaMs) / double(kDiaMs); // 0..1 dentro del día
+  const double diurno = std::sin(2 * kPi * (dia - 0.25));                         // máximo a mediodía
+  const double r = ruido(s, k);
+  double v;
+  switch (s) {
+    case 0: v = 24 + 6 * diurno + 0.12 * r; break;   // temperatura
+    case 1: v = 60 - 15 * diurno + 0.8 * r; break;   // humedad del aire
+    case 2: {                                        // suelo: se seca y se riega cada 3 días
+      const double fase = double(k % 86400) / 86400.0;
+      v = 80 - 45 * fase + 0.7 * r;
+      break;
+    }
+    case 3: v = diurno > 0 ? 90 * diurno + 1.5 * r : 0; break; // luz
+    case 4: v = 30 + 8 * std::sin(2 * kPi * double(k) / 9600) + 0.9 * r; break;
+    default: v = 95 - double(k % 20000) * 0.0045; break;        // tanque: baja y se rellena
+  }
+  const double q = kSeries[s].resolucion;
+  v = std::round(v / q) * q;
+  return std::clamp(v, 0.0, 100.0);
+}
+
+// --- MEDIDAS ---
+bool leerArgs(int argc, char** argv, Config& c) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string k = argv[i];
+    const char* v = argv[i + 1];
+    if (k == "--dir") c.dir = v;
+    else if (k == "--dias") c.dias = uint32_t(std::max(1, std::atoi(v)));
+    else if (k == "--consultas") c.consultas = uint32_t(std::max(1, std::atoi(v)));
+    else if (k == "--sync") c.sync = uint32_t(std::max(1, std::atoi(v)));
+    else return false;
+  }
+  return (argc % 2) == 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Config cfg;
+  if (!leerArgs(argc, argv, cfg)) {
+    std::fprintf(stderr, "argumentos no válidos (ver el comentario de src/bench_tsdb/main.cpp)\n");
+    return 2;
+  }
+  std::system(("rm -rf '" + cfg.dir + "'").c_str());
+  const uint64_t porSerie = uint64_t(cfg.dias) * uint64_t(kDiaMs / kPeriodoMs);
+  const uint64_t total = porSerie * kNumSeries;
+  const int64_t fin = tsDe(porSerie - 1) + 1;
+
+  // --- ingesta ---
+  {
+    tsdb::Db db;
+    if (!db.open(cfg.dir)) {
+      std::fprintf(stderr, "no se puede abrir %s\n", cfg.dir.c_str());
+      return 1;
+    }
+    uint32_t ids[kNumSeries];
+    for (uint32_t s = 0; s < kNumSeries; s++) ids[s] = db.series(kSeries[s].nombre);
+    const auto t0 = Clock::now();
+    uint64_t desdeSync = 0;
+    for (uint64_t k = 0; k < porSerie; k++) {
+      const int64_t ts = tsDe(k);
+      for (uint32_t s = 0; s < kNumSeries; s++) {
+        if (!db.append(ids[s], ts, valorDe(s, k))) {
+          std::fprintf(stderr, "append rechazado en la muestra %llu\n", (unsigned long long)k);
+          return 1;
+        }
+      }
+      if ((desdeSync += kNumSeries) >= cfg.sync) {
+        db.sync();
+        desdeSync = 0;
+      }
+    }
+    db.sync();
+    const double s = segundosDesde(t0);
+    std::printf("ingesta: %llu muestras (%u días, %u series) en %.2f s -> %.2f M muestras/s\n",
+                (unsigned long long)total, cfg.dias, kNumSeries, s, double(total) / s / 1e6);
+    // cerramos sin flush(): los chunks abiertos se quedan en el WAL, como al parar el servicio
+  }
+
+  // --- reapertura ---
+  tsdb::Db db;
+  auto t0 = Clock::now();
+  if (!db.open(cfg.dir)) return 1;
+  const double abrirMs = segundosDesde(t0) * 1000;
+  struct stat st;
+  const size_t wal = ::stat((cfg.dir + "/wal.log").c_str(), &st) == 0 ? size_t(st.st_size) : 0;
+  std::printf("reapertura: %.1f ms (%zu segmentos mapeados, WAL de %zu KB)\n", abrirMs, db.segmentCount(),
+              wal / 1024);
+  const double bytesMuestra = double(db.segmentBytes() + wal) / double(total);
+  std::printf("tamaño: %.1f MB en disco, %.2f bytes/muestra (en bruto 16; como telemetría JSON ~%zu)\n",
+              double(db.segmentBytes() + wal) / 1e6, bytesMuestra,
+              std::string("{\"ts\":1735689600000,\"type\":\"soil\",\"value\":55}").size());
+
+  // --- consultas ---
+  struct Consulta {
+    const char* nombre;
+    int64_t rango, paso; // paso 0 = en bruto
+  };
+  const Consulta consultas[] = {
+      {"1 h en bruto", 3600 * 1000LL, 0},
+      {"1 día en bruto", kDiaMs, 0},
+      {"7 días a 5 min", 7 * kDiaMs, 300 * 1000LL},
+      {"30 días a 1 h", 30 * kDiaMs, 3600 * 1000LL},
+      {"todo a 1 día", int64_t(cfg.dias) * kDiaMs, kDiaMs},
+      {"todo a 1 h", int64_t(cfg.dias) * kDiaMs, 3600 * 1000LL},
+  };
+  std::mt19937_64 rng(1);
+  std::printf("\n  %-16s %10s %10s %12s\n", "consulta", "p50 ms", "p99 ms", "muestras");
+  std::vector<tsdb::Bucket> cubos;
+  volatile double sumidero = 0; // que el compilador no se salte el recorrido
+  for (const Consulta& c : consultas) {
+    std::vector<double> ms;
+    uint64_t muestras = 0;
+    for (uint32_t q = 0; q < cfg.consultas; q++) {
+      const uint32_t s = uint32_t(rng() % kNumSeries);
+      const int64_t hueco = std::max<int64_t>(1, fin - kInicio - c.rango);
+      const int64_t desde = kInicio + int64_t(rng() % uint64_t(hueco));
+      const int64_t hasta = desde + c.rango;
+      t0 = Clock::now();
+      uint64_t n = 0;
+      if (c.paso) {
+        db.downsample(s, desde, hasta, c.paso, cubos);
+        for (const tsdb::Bucket& b : cubos) n += b.count;
+      } else {
+        db.scan(s, desde, hasta, [&](int64_t, double v) {
+          sumidero += v;
+          n++;
+        });
+      }
+      ms.push_back(segundosDesde(t0) * 1000);
+      muestras += n;
+    }
+    std::printf("  %-16s %10.3f %10.3f %12llu\n", c.nombre, percentil(ms, 50), percentil(ms, 99),
+                (unsigned long long)(muestras / cfg.consultas));
+  }
+
+  // --- comprobación ---
+  bool ok = db.verify();
+  uint64_t k = 0;
+  const uint32_t s = 2;
+  db.scan(s, INT64_MIN, INT64_MAX, [&](int64_t ts, double v) {
+    if (ts != tsDe(k) || v != valorDe(s, k)) ok = false;
+    k++;
+  });
+  db.downsample(s, INT64_MIN, INT64_MAX, kDiaMs, cubos);
+  uint64_t agregadas = 0;
+  for (const tsdb::Bucket& b : cubos) agregadas += b.count;
+  ok = ok && k == porSerie && agregadas == porSerie;
+  std::printf("\ncomprobación: %s (%llu muestras de %s releídas)\n", ok ? "ok" : "ERROR", (unsigned long long)k,
+              kSeries[s].nombre);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,247 @@
+// --- BENCHMARK DE LAS ESTADÍSTICAS MÓVILES Y LOS FALLOS ---
+// mide lib/Vigilancia con muchas series a la vez, cada una con una lectura cada 3 s y las lecturas intercaladas entre
+//   series como llegan del broker (una ronda = una muestra de cada serie, en un orden desordenado fijo: el de los
+//   nodos no tiene que ver con el índice de la serie):
+//   - rendimiento: muestras por segundo y ns por muestra con --series distintas (de caber en la caché a no caber),
+//     frente a recalcular la ventana entera en cada muestra (lo ingenuo, O(N))
+//   - revisión del silencio: lo que cuesta recorrer todas las series
+//   - exactitud: media, desviación, mínimo y máximo contra un recálculo directo de la ventana al final
+//   - detección: series planas, picos y saltos inyectados en los datos y cuántos salen como fallo
+//
+// Uso: program [--series 100,1000,10000,100000] [--muestras 32] [--rondas 200]
+#include <Vigilancia.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double segundosDesde(Clock::time_point t0) {
+  return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+constexpr int64_t kPeriodoMs = 3000;
+constexpr int64_t kInicio = 1735689600000LL; // 2025-01-01 00:00 UTC
+
+struct Config {
+  std::vector<uint32_t> series = {100, 1000, 10000, 100000};
+  uint32_t muestras = 32;
+  uint32_t rondas = 200;
+};
+
+// --- DATOS SIMULADOS ---
+// valor de la serie s en la ronda r: una base por serie, una deriva lenta y ruido de una tabla (sin coste de generar
+//   números aleatorios dentro de la medida)
+struct Datos {
+  std::vector<double> base;
+  std::vector<double> ruido;
+
+  Datos(uint32_t series, uint32_t semilla) : base(series), ruido(4096) {
+    std::mt19937 rng(semilla);
+    std::uniform_real_distribution<double> b(20, 80);
+    std::normal_distribution<double> n(0, 0.4);
+    for (double& x : base) x = b(rng);
+    for (double& x : ruido) x = std::round(n(rng) * 10) / 10; // resolución de 0,1
+  }
+
+  double valor(uint32_t s, uint32_t r) const {
+    return base[s] + 0.002 * double(r) + ruido[(size_t(r) * 2654435761u + s) & 4095];
+  }
+};
+
+// --- LO INGENUO ---
+// la ventana en un anillo y todo recalculado en cada muestra
+class Ingenuo {
+ public:
+  Ingenuo(uint32_t series, uint32_t n) : n_(n), vals_(size_t(series) * n), llenas_(series), seq_(series) {}
+
+  double add(uint32_t s, double v) {
+    double* w = &vals_[size_t(s) * n_];
+    w[seq_[s]++ % n_] = v;
+    if (llenas_[s] < n_) llenas_[s]++;
+    const uint32_t k = llenas_[s];
+    double suma = 0, mn = w[0], mx = w[0];
+    for (uint32_t i = 0; i < k; i++) {
+      suma += w[i];
+      mn = std::min(mn, w[i]);
+      mx = std::max(mx, w[i]);
+    }
+    const double media = suma / k;
+    double m2 = 0;
+    for (uint32_t i = 0; i < k; i++) m2 += (w[i] - media) * (w[i] - media);
+    return media + m2 + mn + mx;
+  }
+
+  // media, desviación (n - 1), mínimo y máximo de la ventana
+  void resumen(uint32_t s, double out[4]) const {
+    const double* w = &vals_[size_t(s) * n_];
+    const uint32_t k = llenas_[s];
+    double suma = 0;
+    out[2] = out[3] = w[0];
+    for (uint32_t i = 0; i < k; i++) {
+      suma += w[i];
+      out[2] = std::min(out[2], w[i]);
+      out[3] = std::max(out[3], w[i]);
+    }
+    out[0] = suma / k;
+    double m2 = 0;
+    for (uint32_t i = 0; i < k; i++) m2 += (w[i] - out[0]) * (w[i] - out[0]);
+    out[1] = k > 1 ? std::sqrt(m2 / (k - 1)) : 0;
+  }
+
+ private:
+  uint32_t n_;
+  std::vector<double> vals_;
+  std::vector<uint32_t> llenas_, seq_;
+};
+
+// --- MEDIDAS ---
+volatile double sumidero; // evita que el compilador elimine el recálculo ingenuo
+
+void rendimiento(const Config& cfg) {
+  const vig::Parametros& p = *vig::parametros("soil");
+  std::printf("ventana de %u muestras\n\n", cfg.muestras);
+  std::printf("  %8s %10s %10s %12s %10s %10s %12s %10s\n", "series", "MB", "M mues/s", "ns/muestra", "ingenuo",
+              "veces", "revisión µs", "error máx");
+  for (const uint32_t series : cfg.series) {
+    const Datos datos(series, 7);
+    std::vector<uint32_t> orden(series);
+    for (uint32_t s = 0; s < series; s++) orden[s] = s;
+    std::shuffle(orden.begin(), orden.end(), std::mt19937(3));
+    vig::Ventanas v(cfg.muestras);
+    for (uint32_t s = 0; s < series; s++) v.nueva(p, kInicio);
+    uint64_t eventos = 0;
+    const auto contar = [&](vig::Fallo, bool, double) { eventos++; };
+
+    // las primeras N rondas llenan las ventanas (y la caché, si cabe); no se miden
+    const uint32_t llenar = v.ventana();
+    for (uint32_t r = 0; r < llenar; r++) {
+      const int64_t ts = kInicio + int64_t(r) * kPeriodoMs;
+      for (const uint32_t s : orden) v.add(s, ts, datos.valor(s, r), ts, contar);
+    }
+    // el mismo total de muestras (rondas x 10 000) con cualquier número de series
+    const uint32_t rondas = std::max(4u, uint32_t(uint64_t(cfg.rondas) * 10000 / series));
+    auto t0 = Clock::now();
+    for (uint32_t r = llenar; r < llenar + rondas; r++) {
+      const int64_t ts = kInicio + int64_t(r) * kPeriodoMs;
+      for (const uint32_t s : orden) v.add(s, ts, datos.valor(s, r), ts, contar);
+    }
+    const double seg = segundosDesde(t0);
+    const double total = double(rondas) * series;
+
+    Ingenuo ing(series, v.ventana());
+    double suma = 0;
+    for (uint32_t r = 0; r < llenar; r++) {
+      for (const uint32_t s : orden) suma += ing.add(s, datos.valor(s, r));
+    }
+    t0 = Clock::now();
+    for (uint32_t r = llenar; r < llenar + rondas; r++) {
+      for (const uint32_t s : orden) suma += ing.add(s, datos.valor(s, r));
+    }
+    const double segIng = segundosDesde(t0);
+    sumidero = suma;
+
+    // revisión del silencio (nadie está en silencio: es el coste de recorrerlas)
+    t0 = Clock::now();
+    for (int i = 0; i < 20; i++) {
+      v.revisar(kInicio + int64_t(llenar + rondas) * kPeriodoMs, [&](uint32_t) { eventos++; });
+    }
+    const double revUs = segundosDesde(t0) / 20 * 1e6;
+
+    // exactitud al final contra el recálculo directo
+    double error = 0;
+    for (uint32_t s = 0; s < series; s++) {
+      const vig::Features f = v.features(s);
+      double ref[4];
+      ing.resumen(s, ref);
+      error = std::max({error, std::fabs(f.media - ref[0]), std::fabs(f.desv - ref[1]), std::fabs(f.min - ref[2]),
+                        std::fabs(f.max - ref[3])});
+    }
+    std::printf("  %8u %10.1f %10.1f %12.1f %10.1f %10.1f %12.1f %10.1e\n", series,
+                double(series * v.bytesPorSerie()) / 1e6, total / seg / 1e6, seg / total * 1e9,
+                total / segIng / 1e6, segIng / seg, revUs, error);
+  }
+  std::printf("  (ingenuo y veces: M muestras/s recalculando la ventana y cuántas veces más rápido es lo O(1))\n");
+}
+
+// series con fallos inyectados: cuántos se detectan y cuántos sobran
+void deteccion(const Config& cfg) {
+  constexpr uint32_t kPorTipo = 200, kRondas = 2000; // ~1,7 h de lecturas cada 3 s
+  const vig::Parametros& p = *vig::parametros("temp");
+  vig::Parametros prueba = p;
+  prueba.planoMs = 30 * 60000; // para que quepa en la simulación
+  enum Caso { Normal, Plana, Picos, Saltos, kCasos };
+  const char* nombres[kCasos] = {"normales", "planas", "con picos", "con saltos"};
+  const Datos datos(kPorTipo * kCasos, 11);
+  vig::Ventanas v(cfg.muestras);
+  for (uint32_t s = 0; s < kPorTipo * kCasos; s++) v.nueva(prueba, kInicio);
+
+  uint64_t planos[kCasos] = {}, picos[kCasos] = {};
+  uint32_t picosInyectados = 0;
+  for (uint32_t r = 0; r < kRondas; r++) {
+    const int64_t ts = kInicio + int64_t(r) * kPeriodoMs;
+    for (uint32_t s = 0; s < kPorTipo * kCasos; s++) {
+      const Caso c = Caso(s / kPorTipo);
+      double x = datos.valor(s, r);
+      if (c == Plana && r >= kRondas / 4) x = datos.valor(s, kRondas / 4); // se queda atascada
+      if (c == Picos && r % 97 == 50) {
+        x += 15; // una lectura suelta
+        if (s == Picos * kPorTipo) picosInyectados++;
+      }
+      if (c == Saltos && r >= 500) x += 15 * double(1 + (r - 500) / 400); // escalones que se quedan
+      v.add(s, ts, x, ts, [&](vig::Fallo f, bool activo, double) {
+        if (f == vig::Plano && activo) planos[c]++;
+        if (f == vig::Pico) picos[c]++;
+      });
+    }
+  }
+  std::printf("\ndetección (%u series de cada, %u lecturas; plano a los %lld min):\n", kPorTipo, kRondas,
+              (long long)(prueba.planoMs / 60000));
+  std::printf("  %-12s %10s %10s\n", "series", "planos", "picos");
+  for (int c = 0; c < kCasos; c++) {
+    std::printf("  %-12s %10llu %10llu\n", nombres[c], (unsigned long long)planos[c], (unsigned long long)picos[c]);
+  }
+  std::printf("  (inyectados: %u planas, %u picos en las series con picos, 0 en el resto)\n", kPorTipo,
+              picosInyectados * kPorTipo);
+}
+
+bool leerArgs(int argc, char** argv, Config& c) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string k = argv[i];
+    const char* v = argv[i + 1];
+    if (k == "--series") {
+      c.series.clear();
+      for (const char* s = v; *s;) {
+        char* fin;
+        const unsigned long n = std::strtoul(s, &fin, 10);
+        if (fin == s || !n) return false;
+        c.series.push_back(uint32_t(n));
+        s = *fin == ',' ? fin + 1 : fin;
+      }
+    } else if (k == "--muestras") c.muestras = uint32_t(std::atoi(v));
+    else if (k == "--rondas") c.rondas = uint32_t(std::atoi(v));
+    else return false;
+  }
+  return (argc % 2) == 1 && c.muestras >= 2 && c.rondas > 0 && !c.series.empty();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Config cfg;
+  if (!leerArgs(argc, argv, cfg)) {
+    std::fprintf(stderr, "argumentos no válidos (ver el comentario de src/bench_vigilancia/main.cpp)\n");
+    return 2;
+  }
+  rendimiento(cfg);
+  deteccion(cfg);
+  return 0;
+}
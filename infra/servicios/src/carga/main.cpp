@@ -0,0 +1,711 @@
+// --- GENERADOR DE CARGA: FLOTA DE NODOS VIRTUALES ---
+// abre miles de conexiones MQTT al broker, cada una un nodo virtual que publica en los topics crudos del firmware
+//   (dht11, soil, ldr, mq135 y, si se pide, nivel_agua) los mismos payloads que los drivers, con periodo y jitter
+//   configurables. A la vez se suscribe a greenhouse/+/telemetry y mide lo que sale de Node-RED:
+//   - pérdida: telemetría recibida frente a la esperada por tipo (el dht11 genera dos mensajes, temp y hum)
+//   - latencia de extremo a extremo con "sondas": algunas publicaciones llevan un valor de un rango reservado (p. ej.
+//     suelo 80-99 %), que identifica la sonda al volver normalizada; el resto de la carga usa valores fuera de ese rango
+//   - latencia desde Node-RED: hora de llegada menos el ts que pone la función normalizadora (mismo reloj si el
+//     generador corre en la misma máquina que el docker-compose)
+//
+// Cada hilo gestiona su parte de los nodos con epoll y una cola de vencimientos; no hay un hilo por nodo. Con --rampa
+//   los nodos se conectan poco a poco, y la tabla por segundo muestra dónde empieza a crecer la latencia o la pérdida.
+//   --tormenta simula que se cae la WiFi de todo el invernadero: los nodos pierden la conexión a la vez y reconectan
+//   con la misma política que el firmware (backoff 1 s -> 60 s con jitter) o con la antigua (cada 5 s).
+//
+// Uso: program [--host 127.0.0.1] [--port 1884] [--nodos 1000] [--hilos N] [--segundos 60] [--periodo-ms 3000]
+//              [--jitter-ms 300] [--tipos dht11,soil,ldr,mq135] [--rampa 0] [--tormenta 20,40] [--fraccion 1]
+//              [--reconexion backoff|fija] [--umbral-ms 1000] [--csv fichero]
+#include <JsonScan.h>
+#include <MqttClient.h>
+#include <MqttCodec.h>
+#include <Percentil.h>
+
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t nowNs() {
+  return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+}
+
+uint64_t wallMs() {
+  using namespace std::chrono;
+  return uint64_t(duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count());
+}
+
+// --- CONFIGURACIÓN ---
+struct Config {
+  std::string host = "127.0.0.1";
+  uint16_t port = 1884; // el puerto que publica docker-compose
+  uint32_t nodos = 1000;
+  uint32_t hilos = std::max(1u, std::thread::hardware_concurrency());
+  uint32_t segundos = 60;
+  uint32_t periodoMs = 3000; // kPeriodMs de los drivers
+  uint32_t jitterMs = 300;
+  std::string tipos = "dht11,soil,ldr,mq135";
+  uint32_t rampaS = 0;
+  std::vector<uint32_t> tormentas;
+  double fraccion = 1.0;
+  bool backoff = true;
+  uint32_t umbralMs = 1000;
+  uint32_t esperaS = 3; // tras parar, tiempo para que llegue la telemetría rezagada
+  uint32_t timeoutSondaMs = 10000;
+  std::string csv;
+};
+
+// --- TIPOS DE NODO ---
+// topic y payload de cada firmware, y el rango de valores reservado para las sondas
+enum Tipo : uint8_t { Dht11, Soil, Ldr, Mq135, NivelAgua, kTipos };
+
+struct InfoTipo {
+  const char* topic;
+  const char* telemetria;   // "type" de la telemetría que identifica las sondas ("" = no se normaliza por MQTT)
+  uint8_t mensajes;         // mensajes de telemetría por publicación
+  uint16_t sondas;          // claves de sonda disponibles
+};
+
+constexpr InfoTipo kInfo[kTipos] = {
+    {"dht11", "temp", 2, 250}, // temperatura 30.00-34.98 en pasos de 0.02 (Node-RED trunca a 2 decimales)
+    {"soil", "soil", 1, 20},   // humedad 80-99
+    {"ldr", "light", 1, 20},   // luz 80-99
+    {"mq135", "aire", 1, 20},  // percentage 50-69
+    {"nivel_agua", "", 0, 0},  // en los flujos actuales el nivel lo genera un inject de Node-RED, no un nodo MQTT
+};
+
+// escribe el payload del firmware; clave < 0 = carga normal con valores fuera del rango de las sondas
+size_t payload(Tipo t, int clave, std::mt19937& rng, char* out, size_t cap) {
+  auto u = [&rng](int a, int b) { return std::uniform_int_distribution<int>(a, b)(rng); };
+  switch (t) {
+    case Dht11: {
+      const int temp = clave >= 0 ? 3000 + clave * 2 : u(1800, 2999); // centésimas, como DhtDriver
+      const int hum = u(4000, 7000);
+      return size_t(std::snprintf(out, cap, "{\"temperatura\":%d.%02d,\"humedad\":%d.%02d}", temp / 100, temp % 100,
+                                  hum / 100, hum % 100));
+    }
+    case Soil: {
+      const int h = clave >= 0 ? 80 + clave : u(40, 79);
+      return size_t(std::snprintf(out, cap, "{\"humedad\":%d,\"raw\":%d}", h, 1023 - h * 1023 / 100));
+    }
+    case Ldr: {
+      const int l = clave >= 0 ? 80 + clave : u(40, 79);
+      return size_t(std::snprintf(out, cap, "{\"luz\":%d,\"raw\":%d}", l, l * 1023 / 100));
+    }
+    case Mq135: {
+      const int p = clave >= 0 ? 50 + clave : u(10, 49);
+      return size_t(std::snprintf(out, cap, "{\"raw\":%d,\"percentage\":%d}", p * 1023 / 100, p));
+    }
+    default:
+      return size_t(std::snprintf(out, cap, "{\"nivel\":%d}", u(20, 90)));
+  }
+}
+
+// clave de sonda a partir de la telemetría normalizada; -1 si es carga normal
+int claveSonda(Tipo t, double v) {
+  const long c = std::lround(v * 100);
+  switch (t) {
+    case Dht11: return c >= 3000 && c < 3500 ? int((c + 1 - 3000) / 2) : -1; // admite el truncado de 0.01
+    case Soil:
+    case Ldr: return c >= 8000 && c < 10000 ? int(c / 100 - 80) : -1;
+    case Mq135: return c >= 5000 && c < 7000 ? int(c / 100 - 50) : -1;
+    default: return -1;
+  }
+}
+
+// --- SONDAS ---
+// una clave solo está en vuelo una vez: la marca de tiempo de envío se recupera sin ambigüedad al volver
+//   Como mucho una sonda por tipo cada kSondaNs, para que el resto de la carga conserve sus valores normales.
+constexpr uint64_t kSondaNs = 1000000;
+
+struct Sondas {
+  std::mutex m;
+  std::vector<uint64_t> enviadaNs; // 0 = libre
+  std::vector<uint16_t> libres;
+  uint64_t ultimaNs = 0;
+};
+
+// --- ESTADÍSTICAS COMPARTIDAS ---
+struct Global {
+  Config cfg;
+  sockaddr_in broker;
+  std::atomic<bool> parar{false};
+  std::atomic<uint32_t> tormenta{0};
+  std::atomic<int32_t> conectados{0};
+  std::atomic<uint64_t> enviados[kTipos];
+  std::atomic<uint64_t> conexiones{0}, fallos{0}, caidas{0}, perdidosCliente{0};
+  Sondas sondas[kTipos];
+  uint64_t inicioNs = 0;
+  uint64_t inicioWallMs = 0;
+};
+
+// --- HILO DE TRABAJO ---
+struct Nodo {
+  enum Estado : uint8_t { Parado, Conectando, EsperaConnack, Conectado };
+  int fd = -1;
+  Tipo tipo;
+  Estado estado = Parado;
+  bool quiereEscribir = false;
+  uint32_t id;
+  uint32_t backoffMs = 1000;
+  uint32_t enCola = 0;   // publicaciones en el buffer de salida
+  uint64_t vence = 0;    // próximo evento: publicar, reintentar o timeout de la conexión
+  uint64_t conexionNs = 0;
+  std::string out;
+  mqtt::Reader in;
+};
+
+class Trabajador {
+ public:
+  Trabajador(Global& g, uint32_t primero, uint32_t cuantos, uint32_t semilla) : g_(g), rng_(semilla) {
+    nodos_.resize(cuantos);
+    std::vector<Tipo> tipos = tiposActivos();
+    for (uint32_t i = 0; i < cuantos; i++) {
+      Nodo& n = nodos_[i];
+      n.id = primero + i;
+      n.tipo = tipos[n.id % tipos.size()];
+      // la rampa reparte el arranque de todos los nodos (de todos los hilos) a lo largo de rampaS
+      const uint64_t arranque = g.cfg.rampaS ? uint64_t(g.cfg.rampaS) * 1000000000ull * n.id / g.cfg.nodos : 0;
+      programar(i, g.inicioNs + arranque + uint64_t(i % 1000) * 100000);
+    }
+  }
+
+  void operator()() {
+    ep_ = epoll_create1(EPOLL_CLOEXEC);
+    epoll_event ev[256];
+    uint32_t tormentaVista = 0;
+    while (!g_.parar.load(std::memory_order_relaxed)) {
+      const uint32_t t = g_.tormenta.load(std::memory_order_relaxed);
+      if (t != tormentaVista) {
+        tormentaVista = t;
+        tormenta();
+      }
+      const uint64_t ahora = nowNs();
+      int espera = 50;
+      if (!cola_.empty()) {
+        const uint64_t prox = cola_.top().first;
+        espera = prox <= ahora ? 0 : int(std::min<uint64_t>(50, (prox - ahora) / 1000000 + 1));
+      }
+      const int n = epoll_wait(ep_, ev, 256, espera);
+      for (int i = 0; i < n; i++) evento(ev[i].data.u32, ev[i].events);
+      vencimientos(nowNs());
+    }
+    for (Nodo& n : nodos_) {
+      if (n.estado == Nodo::Conectado) {
+        mqtt::putDisconnect(n.out);
+        net::flushSome(n.fd, n.out);
+      }
+      cerrar(n);
+    }
+    close(ep_);
+  }
+
+  std::vector<uint32_t> latConexionUs; // CONNECT -> CONNACK
+
+ private:
+  std::vector<Tipo> tiposActivos() const {
+    std::vector<Tipo> v;
+    for (uint8_t t = 0; t < kTipos; t++) {
+      if (("," + g_.cfg.tipos + ",").find(std::string(",") + kInfo[t].topic + ",") != std::string::npos) {
+        v.push_back(Tipo(t));
+      }
+    }
+    if (v.empty()) v.push_back(Soil);
+    return v;
+  }
+
+  void programar(uint32_t i, uint64_t cuando) {
+    nodos_[i].vence = cuando;
+    cola_.push({cuando, i});
+  }
+
+  uint64_t periodoNs() {
+    const int j = int(g_.cfg.jitterMs);
+    const int d = j ? std::uniform_int_distribution<int>(-j, j)(rng_) : 0;
+    return uint64_t(int64_t(g_.cfg.periodoMs) + d) * 1000000;
+  }
+
+  void vigilar(Nodo& n, uint32_t i, bool escribir) {
+    epoll_event e{};
+    e.events = EPOLLIN | (escribir ? uint32_t(EPOLLOUT) : 0u);
+    e.data.u32 = i;
+    epoll_ctl(ep_, EPOLL_CTL_MOD, n.fd, &e);
+    n.quiereEscribir = escribir;
+  }
+
+  void vencimientos(uint64_t ahora) {
+    while (!cola_.empty() && cola_.top().first <= ahora) {
+      const auto [cuando, i] = cola_.top();
+      cola_.pop();
+      Nodo& n = nodos_[i];
+      if (cuando != n.vence) continue; // reprogramado después
+      switch (n.estado) {
+        case Nodo::Parado: conectar(i, ahora); break;
+        case Nodo::Conectando:
+        case Nodo::EsperaConnack:
+          g_.fallos++;
+          caida(i, ahora, false);
+          break;
+        case Nodo::Conectado: publicar(i, ahora); break;
+      }
+    }
+  }
+
+  void conectar(uint32_t i, uint64_t ahora) {
+    Nodo& n = nodos_[i];
+    n.fd = net::connectTcp(g_.broker, true);
+    if (n.fd < 0) {
+      g_.fallos++;
+      reintento(i, ahora);
+      return;
+    }
+    epoll_event e{};
+    e.events = EPOLLIN | EPOLLOUT;
+    e.data.u32 = i;
+    epoll_ctl(ep_, EPOLL_CTL_ADD, n.fd, &e);
+    n.quiereEscribir = true;
+    n.estado = Nodo::Conectando;
+    n.conexionNs = ahora;
+    programar(i, ahora + 5000000000ull); // timeout de la conexión
+  }
+
+  void evento(uint32_t i, uint32_t ev) {
+    Nodo& n = nodos_[i];
+    if (n.fd < 0) return;
+    const uint64_t ahora = nowNs();
+    if (ev & (EPOLLERR | EPOLLHUP)) {
+      if (n.estado != Nodo::Conectado) g_.fallos++;
+      caida(i, ahora, n.estado == Nodo::Conectado);
+      return;
+    }
+    if ((ev & EPOLLOUT) && n.estado == Nodo::Conectando) {
+      int err = 0;
+      socklen_t len = sizeof(err);
+      getsockopt(n.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+      if (err) {
+        g_.fallos++;
+        caida(i, ahora, false);
+        return;
+      }
+      char cid[32];
+      std::snprintf(cid, sizeof(cid), "carga-%s-%u", kInfo[n.tipo].topic, n.id);
+      // keepalive de PubSubClient (15 s), o más si el periodo es largo: solo mandamos PINGREQ si no publicamos
+      const uint16_t keepAlive = uint16_t(std::max<uint32_t>(15, g_.cfg.periodoMs * 2 / 1000));
+      mqtt::putConnect(n.out, cid, keepAlive);
+      n.estado = Nodo::EsperaConnack;
+    }
+    if (ev & EPOLLIN) {
+      const ssize_t r = recv(n.fd, n.in.space(4096), 4096, MSG_DONTWAIT);
+      if (r == 0 || (r < 0 && errno != EAGAIN && errno != EINTR)) {
+        if (n.estado != Nodo::Conectado) g_.fallos++;
+        caida(i, ahora, n.estado == Nodo::Conectado);
+        return;
+      }
+      if (r > 0) n.in.commit(size_t(r));
+      mqtt::Packet p;
+      while (n.in.next(p)) {
+        if (p.type == mqtt::Connack && n.estado == Nodo::EsperaConnack) {
+          if (mqtt::connackCode(p) != 0) {
+            g_.fallos++;
+            caida(i, ahora, false);
+            return;
+          }
+          n.estado = Nodo::Conectado;
+          n.backoffMs = 1000;
+          g_.conectados++;
+          g_.conexiones++;
+          latConexionUs.push_back(uint32_t((ahora - n.conexionNs) / 1000));
+          // la primera publicación cae en cualquier punto del periodo, como el ticker del firmware
+          programar(i, ahora + std::uniform_int_distribution<uint64_t>(0, uint64_t(g_.cfg.periodoMs) * 1000000)(rng_));
+        }
+      }
+    }
+    escribir(i, ahora);
+  }
+
+  void escribir(uint32_t i, uint64_t ahora) {
+    Nodo& n = nodos_[i];
+    if (n.fd < 0) return;
+    if (!net::flushSome(n.fd, n.out)) {
+      caida(i, ahora, n.estado == Nodo::Conectado);
+      return;
+    }
+    if (n.out.empty()) {
+      g_.enviados[n.tipo] += n.enCola;
+      n.enCola = 0;
+    }
+    const bool pendiente = !n.out.empty() || n.estado == Nodo::Conectando;
+    if (pendiente != n.quiereEscribir) vigilar(n, i, pendiente);
+  }
+
+  void publicar(uint32_t i, uint64_t ahora) {
+    Nodo& n = nodos_[i];
+    // una de cada pocas publicaciones es una sonda, si queda alguna clave libre
+    int clave = -1;
+    Sondas& s = g_.sondas[n.tipo];
+    if (kInfo[n.tipo].sondas && s.m.try_lock()) {
+      if (!s.libres.empty() && ahora - s.ultimaNs >= kSondaNs) {
+        s.ultimaNs = ahora;
+        clave = s.libres.back();
+        s.libres.pop_back();
+        s.enviadaNs[size_t(clave)] = ahora;
+      }
+      s.m.unlock();
+    }
+    char buf[64];
+    const size_t len = payload(n.tipo, clave, rng_, buf, sizeof(buf));
+    mqtt::putPublish(n.out, kInfo[n.tipo].topic, std::string_view(buf, len));
+    n.enCola++;
+    programar(i, ahora + periodoNs());
+    escribir(i, ahora);
+  }
+
+  // el broker (o la red) ha cortado la conexión, o ha fallado el intento
+  void caida(uint32_t i, uint64_t ahora, bool estabaConectado) {
+    Nodo& n = nodos_[i];
+    if (estabaConectado) g_.caidas++;
+    cerrar(n);
+    reintento(i, ahora);
+  }
+
+  void cerrar(Nodo& n) {
+    if (n.fd >= 0) {
+      epoll_ctl(ep_, EPOLL_CTL_DEL, n.fd, nullptr);
+      close(n.fd);
+    }
+    if (n.estado == Nodo::Conectado) g_.conectados--;
+    g_.perdidosCliente += n.enCola;
+    n.fd = -1;
+    n.estado = Nodo::Parado;
+    n.enCola = 0;
+    n.out.clear();
+    n.in.clear();
+  }
+
+  // como Connection.h del firmware: la mitad del backoff + una parte aleatoria de la otra mitad, y se dobla.
+  //   La política antigua (reconnect() con delay(5000)) reintentaba cada 5 s fijos.
+  void reintento(uint32_t i, uint64_t ahora) {
+    Nodo& n = nodos_[i];
+    uint64_t esperaMs = 5000;
+    if (g_.cfg.backoff) {
+      esperaMs = n.backoffMs / 2 + std::uniform_int_distribution<uint32_t>(0, n.backoffMs / 2)(rng_);
+      n.backoffMs = std::min<uint32_t>(n.backoffMs * 2, 60000);
+    }
+    programar(i, ahora + esperaMs * 1000000);
+  }
+
+  // se cae la WiFi: una fracción de los nodos conectados pierde la conexión sin DISCONNECT
+  void tormenta() {
+    const uint64_t ahora = nowNs();
+    std::uniform_real_distribution<double> u(0, 1);
+    for (uint32_t i = 0; i < nodos_.size(); i++) {
+      if (nodos_[i].estado == Nodo::Conectado && u(rng_) < g_.cfg.fraccion) caida(i, ahora, true);
+    }
+  }
+
+  Global& g_;
+  std::mt19937 rng_;
+  int ep_ = -1;
+  std::vector<Nodo> nodos_;
+  std::priority_queue<std::pair<uint64_t, uint32_t>, std::vector<std::pair<uint64_t, uint32_t>>, std::greater<>> cola_;
+};
+
+// --- SUSCRIPTOR DE LA TELEMETRÍA ---
+struct Segundo {
+  uint32_t t;
+  int32_t conectados;
+  uint64_t enviados, recibidos;
+  uint32_t p50Us, p99Us;
+};
+
+class Receptor {
+ public:
+  explicit Receptor(Global& g) : g_(g) {}
+
+  bool conectar() {
+    return cli_.connect(g_.cfg.host.c_str(), g_.cfg.port, "carga-receptor") &&
+           cli_.subscribe("greenhouse/+/telemetry", 0);
+  }
+
+  void operator()() {
+    uint64_t siguiente = g_.inicioNs + 1000000000ull;
+    uint64_t enviadosAntes = 0, recibidosAntes = 0;
+    while (!fin_.load(std::memory_order_relaxed)) {
+      if (!cli_.poll(20, [this](const mqtt::PublishView& p) { recibir(p); })) {
+        std::fprintf(stderr, "el receptor ha perdido la conexión; reconectando\n");
+        conectar();
+      }
+      const uint64_t ahora = nowNs();
+      if (ahora < siguiente) continue;
+      siguiente += 1000000000ull;
+      caducar(ahora);
+      uint64_t env = 0;
+      for (auto& e : g_.enviados) env += e.load();
+      uint64_t rec = 0;
+      for (uint64_t r : recibidos_) rec += r;
+      Segundo s{uint32_t((ahora - g_.inicioNs) / 1000000000ull), g_.conectados.load(), env - enviadosAntes,
+                rec - recibidosAntes, percentil(segundo_, 50), percentil(segundo_, 99)};
+      enviadosAntes = env;
+      recibidosAntes = rec;
+      segundo_.clear();
+      segundos.push_back(s);
+      std::printf("%5u s  %6d conectados  %7llu env/s  %7llu rec/s  p50 %8.2f ms  p99 %8.2f ms\n", s.t, s.conectados,
+                  (unsigned long long)s.enviados, (unsigned long long)s.recibidos, s.p50Us / 1000.0, s.p99Us / 1000.0);
+      std::fflush(stdout);
+    }
+  }
+
+  void terminar() { fin_ = true; }
+
+  uint64_t recibidos_[kTipos] = {};
+  uint64_t hum_ = 0;
+  uint64_t ajenos = 0;
+  uint64_t sondasPerdidas = 0;
+  std::vector<uint32_t> latUs;       // extremo a extremo, sondas
+  std::vector<uint32_t> desdeNodeRed; // llegada - ts de la función normalizadora (ms)
+  std::vector<Segundo> segundos;
+
+ private:
+  void recibir(const mqtt::PublishView& p) {
+    const uint64_t ahora = nowNs();
+    std::string_view tipo;
+    double valor = NAN, ts = 0;
+    json::forEachField(p.payload, [&](std::string_view k, std::string_view v) {
+      if (k == "type") tipo = v;
+      else if (k == "value") json::toDouble(v, valor);
+      else if (k == "ts") json::toDouble(v, ts);
+    });
+    // telemetría de antes de empezar (o del inject del tanque): no es nuestra
+    if (ts < double(g_.inicioWallMs) || std::isnan(valor)) {
+      ajenos++;
+      return;
+    }
+    const uint64_t llegada = wallMs();
+    if (llegada >= uint64_t(ts)) desdeNodeRed.push_back(uint32_t(llegada - uint64_t(ts)));
+
+    Tipo t = kTipos;
+    for (uint8_t i = 0; i < kTipos; i++) {
+      if (*kInfo[i].telemetria && tipo == kInfo[i].telemetria) t = Tipo(i);
+    }
+    if (tipo == "hum") {
+      hum_++;
+      return;
+    }
+    if (t == kTipos) {
+      ajenos++;
+      return;
+    }
+    recibidos_[t]++;
+    const int clave = claveSonda(t, valor);
+    if (clave < 0) return;
+    Sondas& s = g_.sondas[t];
+    std::lock_guard<std::mutex> lock(s.m);
+    if (size_t(clave) < s.enviadaNs.size() && s.enviadaNs[size_t(clave)]) {
+      const uint32_t us = uint32_t((ahora - s.enviadaNs[size_t(clave)]) / 1000);
+      latUs.push_back(us);
+      segundo_.push_back(us);
+      s.enviadaNs[size_t(clave)] = 0;
+      s.libres.push_back(uint16_t(clave));
+    }
+  }
+
+  // una sonda que no vuelve en timeoutSondaMs se da por perdida y su clave se reutiliza
+  void caducar(uint64_t ahora) {
+    const uint64_t limite = uint64_t(g_.cfg.timeoutSondaMs) * 1000000;
+    for (Sondas& s : g_.sondas) {
+      std::lock_guard<std::mutex> lock(s.m);
+      for (size_t k = 0; k < s.enviadaNs.size(); k++) {
+        if (s.enviadaNs[k] && ahora - s.enviadaNs[k] > limite) {
+          s.enviadaNs[k] = 0;
+          s.libres.push_back(uint16_t(k));
+          sondasPerdidas++;
+        }
+      }
+    }
+  }
+
+  Global& g_;
+  MqttClient cli_;
+  std::atomic<bool> fin_{false};
+  std::vector<uint32_t> segundo_;
+};
+
+bool leerArgs(int argc, char** argv, Config& c) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string k = argv[i];
+    const char* v = argv[i + 1];
+    if (k == "--host") c.host = v;
+    else if (k == "--port") c.port = uint16_t(std::atoi(v));
+    else if (k == "--nodos") c.nodos = uint32_t(std::atoi(v));
+    else if (k == "--hilos") c.hilos = std::max(1, std::atoi(v));
+    else if (k == "--segundos") c.segundos = uint32_t(std::atoi(v));
+    else if (k == "--periodo-ms") c.periodoMs = uint32_t(std::max(1, std::atoi(v)));
+    else if (k == "--jitter-ms") c.jitterMs = uint32_t(std::atoi(v));
+    else if (k == "--tipos") c.tipos = v;
+    else if (k == "--rampa") c.rampaS = uint32_t(std::atoi(v));
+    else if (k == "--fraccion") c.fraccion = std::atof(v);
+    else if (k == "--reconexion") c.backoff = std::string(v) != "fija";
+    else if (k == "--umbral-ms") c.umbralMs = uint32_t(std::atoi(v));
+    else if (k == "--espera") c.esperaS = uint32_t(std::atoi(v));
+    else if (k == "--csv") c.csv = v;
+    else if (k == "--tormenta") {
+      for (const char* p = v; *p;) {
+        c.tormentas.push_back(uint32_t(std::strtoul(p, const_cast<char**>(&p), 10)));
+        if (*p == ',') p++;
+        else if (*p) return false;
+      }
+    } else {
+      return false;
+    }
+  }
+  if (c.jitterMs >= c.periodoMs) c.jitterMs = c.periodoMs - 1;
+  return (argc % 2) == 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  static Global g;
+  if (!leerArgs(argc, argv, g.cfg)) {
+    std::fprintf(stderr, "argumentos no válidos (ver el comentario de src/carga/main.cpp)\n");
+    return 2;
+  }
+  const Config& cfg = g.cfg;
+  if (!net::resolve(cfg.host.c_str(), cfg.port, g.broker)) {
+    std::fprintf(stderr, "no se puede resolver %s\n", cfg.host.c_str());
+    return 2;
+  }
+  // un descriptor por nodo: subimos el límite de ficheros abiertos todo lo que deje el sistema
+  rlimit rl;
+  if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+    rl.rlim_cur = rl.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &rl);
+  }
+  if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < cfg.nodos + 64) {
+    std::fprintf(stderr, "aviso: el límite de ficheros abiertos (%lu) no da para %u nodos\n",
+                 (unsigned long)rl.rlim_cur, cfg.nodos);
+  }
+
+  for (uint8_t t = 0; t < kTipos; t++) {
+    g.sondas[t].enviadaNs.assign(kInfo[t].sondas, 0);
+    for (uint16_t k = kInfo[t].sondas; k > 0; k--) g.sondas[t].libres.push_back(uint16_t(k - 1));
+  }
+
+  g.inicioNs = nowNs();
+  g.inicioWallMs = wallMs();
+  Receptor receptor(g);
+  if (!receptor.conectar()) {
+    std::fprintf(stderr, "no se puede conectar al broker %s:%u\n", cfg.host.c_str(), cfg.port);
+    return 1;
+  }
+  std::printf("%u nodos (%s) en %u hilos contra %s:%u, periodo %u ms +- %u ms\n", cfg.nodos, cfg.tipos.c_str(),
+              cfg.hilos, cfg.host.c_str(), cfg.port, cfg.periodoMs, cfg.jitterMs);
+
+  std::vector<std::unique_ptr<Trabajador>> trabajadores;
+  for (uint32_t h = 0; h < cfg.hilos; h++) {
+    const uint32_t primero = uint32_t(uint64_t(cfg.nodos) * h / cfg.hilos);
+    const uint32_t ultimo = uint32_t(uint64_t(cfg.nodos) * (h + 1) / cfg.hilos);
+    trabajadores.push_back(std::make_unique<Trabajador>(g, primero, ultimo - primero, 1000 + h));
+  }
+  std::thread hiloReceptor(std::ref(receptor));
+  std::vector<std::thread> hilos;
+  for (auto& t : trabajadores) hilos.emplace_back(std::ref(*t));
+
+  // tormentas en los segundos pedidos
+  std::vector<uint32_t> tormentas = cfg.tormentas;
+  std::sort(tormentas.begin(), tormentas.end());
+  size_t siguienteTormenta = 0;
+  while (nowNs() - g.inicioNs < uint64_t(cfg.segundos) * 1000000000ull) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const uint64_t s = (nowNs() - g.inicioNs) / 1000000000ull;
+    if (siguienteTormenta < tormentas.size() && s >= tormentas[siguienteTormenta]) {
+      std::printf("--- tormenta de reconexiones (%.0f %% de los nodos) ---\n", cfg.fraccion * 100);
+      g.tormenta++;
+      siguienteTormenta++;
+    }
+  }
+  g.parar = true;
+  for (auto& h : hilos) h.join();
+  std::this_thread::sleep_for(std::chrono::seconds(cfg.esperaS));
+  receptor.terminar();
+  hiloReceptor.join();
+
+  // --- RESUMEN ---
+  std::printf("\n%-11s %10s %10s %10s %8s\n", "tipo", "enviados", "esperados", "recibidos", "pérdida");
+  uint64_t totalEsperados = 0, totalRecibidos = 0;
+  for (uint8_t t = 0; t < kTipos; t++) {
+    const uint64_t env = g.enviados[t].load();
+    if (!env) continue;
+    const uint64_t esperados = env * kInfo[t].mensajes;
+    const uint64_t rec = receptor.recibidos_[t] + (t == Dht11 ? receptor.hum_ : 0);
+    totalEsperados += esperados;
+    totalRecibidos += rec;
+    if (!esperados) {
+      std::printf("%-11s %10llu %10s %10s %8s\n", kInfo[t].topic, (unsigned long long)env, "-", "-", "(sin normalizador)");
+      continue;
+    }
+    std::printf("%-11s %10llu %10llu %10llu %7.2f%%\n", kInfo[t].topic, (unsigned long long)env,
+                (unsigned long long)esperados, (unsigned long long)rec,
+                esperados > rec ? 100.0 * double(esperados - rec) / double(esperados) : 0.0);
+  }
+  std::printf("telemetría ajena (inject del tanque, Generar Datos, anterior al inicio): %llu\n",
+              (unsigned long long)receptor.ajenos);
+  std::printf("pérdida total %.2f %%; perdidos en el cliente al caer la conexión: %llu\n",
+              totalEsperados > totalRecibidos ? 100.0 * double(totalEsperados - totalRecibidos) / double(totalEsperados)
+                                              : 0.0,
+              (unsigned long long)g.perdidosCliente.load());
+
+  // las sondas que siguen en vuelo al terminar tampoco han vuelto
+  for (Sondas& s : g.sondas) {
+    for (uint64_t t : s.enviadaNs) receptor.sondasPerdidas += t != 0;
+  }
+  std::vector<uint32_t> lat = receptor.latUs;
+  std::printf("latencia extremo a extremo (%zu sondas, %llu sin respuesta): p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+              lat.size(), (unsigned long long)receptor.sondasPerdidas, percentil(lat, 50) / 1000.0,
+              percentil(lat, 99) / 1000.0, percentil(lat, 100) / 1000.0);
+  std::vector<uint32_t> nr = receptor.desdeNodeRed;
+  std::printf("desde la normalización de Node-RED: p50 %u ms, p99 %u ms\n", percentil(nr, 50), percentil(nr, 99));
+
+  std::vector<uint32_t> conexion;
+  for (auto& t : trabajadores) conexion.insert(conexion.end(), t->latConexionUs.begin(), t->latConexionUs.end());
+  std::printf("conexiones %llu (fallidas %llu, caídas %llu): CONNACK p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+              (unsigned long long)g.conexiones.load(), (unsigned long long)g.fallos.load(),
+              (unsigned long long)g.caidas.load(), percentil(conexion, 50) / 1000.0, percentil(conexion, 99) / 1000.0,
+              percentil(conexion, 100) / 1000.0);
+
+  // saturación: primer segundo con el p99 de las sondas por encima del umbral
+  for (const Segundo& s : receptor.segundos) {
+    if (s.p99Us > cfg.umbralMs * 1000) {
+      std::printf("p99 > %u ms por primera vez en el segundo %u, con %d nodos conectados (%llu env/s)\n", cfg.umbralMs,
+                  s.t, s.conectados, (unsigned long long)s.enviados);
+      break;
+    }
+  }
+
+  if (!cfg.csv.empty()) {
+    if (FILE* f = std::fopen(cfg.csv.c_str(), "w")) {
+      std::fprintf(f, "segundo,conectados,enviados,recibidos,p50_ms,p99_ms\n");
+      for (const Segundo& s : receptor.segundos) {
+        std::fprintf(f, "%u,%d,%llu,%llu,%.3f,%.3f\n", s.t, s.conectados, (unsigned long long)s.enviados,
+                     (unsigned long long)s.recibidos, s.p50Us / 1000.0, s.p99Us / 1000.0);
+      }
+      std::fclose(f);
+    }
+  }
+  return 0;
+}
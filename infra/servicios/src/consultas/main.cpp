@@ -0,0 +1,360 @@
+// --- SERVICIO DE CONSULTAS: ÚLTIMO VALOR Y RESÚMENES POR HTTP ---
+// sirve los GET que contestaban las funciones de Node-RED ("Get Temp", "Obtener estado completo", "GET Soil"...) con
+//   el mismo JSON, sin pasar por el flow context en cada petición:
+//
+//   /api/greenhouse/{temperature,humidity,soil,tank,light}  {"temperature":23.4,"timestamp":...} (503 si no hay dato)
+//   /api/greenhouse/status                                  el resumen con "speech" para Google Home
+//   /api/alexa/{dht,soil,tank,light,aire}                   {"ok":true,"temp":..,"hum":..}, {"ok":true,"soil":..}...
+//   /api/greenhouse/rollups                                 nuevo: último valor y min/max/media de 1 min, 1 h y 24 h
+//
+//   - un hilo se suscribe a greenhouse/+/telemetry y, por cada muestra, actualiza los resúmenes de ese tipo
+//     (Rollup.h) y publica una foto nueva en su seqlock; cada segundo vuelve a publicarlas todas para que las ventanas
+//     avancen aunque un sensor deje de mandar
+//   - los hilos HTTP solo copian fotos de los seqlocks: no hay locks ni reservas de memoria en el camino de una
+//     consulta, y muchos lectores no frenan a la ingesta
+//   - como en Node-RED, el último valor es por tipo (last_<type>), sea del nodo que sea
+//
+// Uso: program [--host 127.0.0.1] [--port 1884] [--http-host 0.0.0.0] [--http-port 1882] [--hilos N]
+#include <HttpServer.h>
+#include <JsonScan.h>
+#include <MqttClient.h>
+#include <Rollup.h>
+#include <Seqlock.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+namespace {
+
+uint64_t wallMs() {
+  using namespace std::chrono;
+  return uint64_t(duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count());
+}
+
+struct Config {
+  std::string host = "127.0.0.1";
+  uint16_t port = 1884; // el puerto que publica docker-compose
+  std::string httpHost = "0.0.0.0";
+  uint16_t httpPort = 1882; // Node-RED está en el 1881
+  uint32_t hilos = std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+};
+
+// --- ESTADO ---
+// lo que ven los hilos HTTP de cada tipo; ts 0 = aún no ha llegado nada
+struct Foto {
+  int64_t ts;
+  double value;
+  cache::Resumen ventanas[cache::Rollups::kN];
+};
+
+enum Tipo { kTemp, kHum, kSoil, kLight, kTank, kAire, kNumTipos };
+constexpr const char* kTipos[kNumTipos] = {"temp", "hum", "soil", "light", "tank", "aire"};
+
+struct Estado {
+  Seqlock<Foto> fotos[kNumTipos];
+  std::atomic<uint64_t> muestras{0};
+};
+
+// --- INGESTA ---
+class Ingesta {
+ public:
+  Ingesta(const Config& cfg, Estado& estado, const std::atomic<bool>& fin) : cfg_(cfg), estado_(estado), fin_(fin) {}
+
+  void operator()() {
+    conectar();
+    uint64_t siguiente = wallMs() + 1000;
+    while (!fin_.load()) {
+      if (!cli_.poll(200, [this](const mqtt::PublishView& p) { guardar(p); })) {
+        std::fprintf(stderr, "ingesta: conexión perdida; reconectando\n");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        conectar();
+      }
+      const uint64_t ahora = wallMs();
+      if (ahora >= siguiente) {
+        siguiente = ahora + 1000;
+        for (int t = 0; t < kNumTipos; t++) publicar(t, int64_t(ahora));
+      }
+    }
+    cli_.disconnect();
+  }
+
+ private:
+  void conectar() {
+    char cid[48];
+    std::snprintf(cid, sizeof(cid), "consultas-%d", int(getpid()));
+    for (uint32_t espera = 1000; !fin_.load(); espera = std::min(espera * 2, 30000u)) {
+      if (cli_.connect(cfg_.host.c_str(), cfg_.port, cid) && cli_.subscribe("greenhouse/+/telemetry", 0)) return;
+      std::fprintf(stderr, "ingesta: no se puede conectar a %s:%u, reintento en %u ms\n", cfg_.host.c_str(), cfg_.port,
+                   espera);
+      std::this_thread::sleep_for(std::chrono::milliseconds(espera));
+    }
+  }
+
+  void guardar(const mqtt::PublishView& p) {
+    std::string_view type;
+    double ts = 0, value = 0;
+    bool hayValor = false;
+    json::forEachField(p.payload, [&](std::string_view k, std::string_view v) {
+      if (k == "type") type = v;
+      else if (k == "ts") json::toDouble(v, ts);
+      else if (k == "value") hayValor = json::toDouble(v, value);
+    });
+    if (!hayValor || !std::isfinite(value)) return;
+    int t = 0;
+    while (t < kNumTipos && type != kTipos[t]) t++;
+    if (t == kNumTipos) return;
+    // como el "Last value" de Node-RED: sin ts válido, la hora de llegada
+    const int64_t cuando = ts > 0 ? int64_t(ts) : int64_t(wallMs());
+    rollups_[t].add(cuando, value);
+    ultimo_[t] = {cuando, value};
+    publicar(t, std::max(cuando, int64_t(wallMs())));
+    estado_.muestras.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void publicar(int t, int64_t ahora) {
+    if (!ultimo_[t].ts) return;
+    Foto f;
+    f.ts = ultimo_[t].ts;
+    f.value = ultimo_[t].value;
+    for (size_t w = 0; w < cache::Rollups::kN; w++) f.ventanas[w] = rollups_[t].ventanas[w].resumen(ahora);
+    estado_.fotos[t].store(f);
+  }
+
+  struct Ultimo {
+    int64_t ts = 0;
+    double value = 0;
+  };
+
+  const Config& cfg_;
+  Estado& estado_;
+  const std::atomic<bool>& fin_;
+  MqttClient cli_;
+  cache::Rollups rollups_[kNumTipos];
+  Ultimo ultimo_[kNumTipos];
+};
+
+// --- RESPUESTAS ---
+// los números como los escribe JSON.stringify en los casos que salen aquí (enteros sin decimales)
+void num(std::string& out, double v) {
+  char b[32];
+  const int n = std::snprintf(b, sizeof(b), "%.15g", v);
+  out.append(b, size_t(n));
+}
+void campoNum(std::string& out, const char* k, double v) {
+  out += '"';
+  out += k;
+  out += "\":";
+  num(out, v);
+}
+long redondeo(double v) { return long(std::floor(v + 0.5)); } // Math.round
+
+struct Endpoint {
+  const char* campo; // clave del valor en el JSON
+  Tipo tipo;
+  const char* falta;
+};
+
+// /api/greenhouse/<ruta>: como las funciones "Get Temp", "Get Humidity"...
+void greenhouse(const Estado& e, const Endpoint& ep, http::Respuesta& r) {
+  const Foto f = e.fotos[ep.tipo].load();
+  if (!f.ts) {
+    r.status = 503;
+    r.cuerpo = std::string("{\"error\":\"") + ep.falta + "\"}";
+    return;
+  }
+  r.cuerpo += '{';
+  campoNum(r.cuerpo, ep.campo, f.value);
+  r.cuerpo += ',';
+  campoNum(r.cuerpo, "timestamp", double(f.ts));
+  r.cuerpo += '}';
+}
+
+// /api/alexa/<ruta>: como "GET Soil", "GET DHT"... (el valor a secas, sin ts)
+void alexa(const Estado& e, std::initializer_list<std::pair<const char*, Tipo>> campos, const char* falta,
+           http::Respuesta& r) {
+  r.cuerpo = "{\"ok\":true";
+  for (const auto& [campo, tipo] : campos) {
+    const Foto f = e.fotos[tipo].load();
+    if (!f.ts) {
+      r.status = 503;
+      r.cuerpo = std::string("{\"ok\":false,\"error\":\"") + falta + "\"}";
+      return;
+    }
+    r.cuerpo += ',';
+    campoNum(r.cuerpo, campo, f.value);
+  }
+  r.cuerpo += '}';
+}
+
+// /api/greenhouse/status: "Obtener estado completo"
+void status(const Estado& e, http::Respuesta& r) {
+  struct Parte {
+    Tipo tipo;
+    const char* campo;
+    const char* frase;
+    const char* unidad;
+  };
+  static const Parte kPartes[] = {
+      {kTemp, "temperature", "Temperatura: %ld grados", "°C"},
+      {kHum, "humidity", "Humedad ambiental: %ld por ciento", "%"},
+      {kSoil, "soil", "Humedad del suelo: %ld por ciento", "%"},
+      {kTank, "tank", "Nivel del tanque: %ld por ciento", "%"},
+      {kLight, "light", "Iluminación: %ld unidades", "ADC"},
+  };
+  Foto fotos[5];
+  bool alguno = false;
+  for (size_t i = 0; i < 5; i++) {
+    fotos[i] = e.fotos[kPartes[i].tipo].load();
+    alguno = alguno || fotos[i].ts;
+  }
+  const uint64_t ahora = wallMs();
+  if (!alguno) {
+    r.status = 503;
+    r.cuerpo = "{\"speech\":\"No hay datos disponibles del invernadero en este momento. Los sensores pueden estar "
+               "desconectados.\",\"error\":\"No data available\",";
+    campoNum(r.cuerpo, "timestamp", double(ahora));
+    r.cuerpo += '}';
+    return;
+  }
+  r.cuerpo = "{\"speech\":\"El invernadero está funcionando. ";
+  bool primera = true;
+  for (size_t i = 0; i < 5; i++) {
+    if (!fotos[i].ts) continue;
+    char frase[96];
+    std::snprintf(frase, sizeof(frase), kPartes[i].frase, redondeo(fotos[i].value));
+    if (!primera) r.cuerpo += ". ";
+    r.cuerpo += frase;
+    primera = false;
+  }
+  r.cuerpo += ".\"";
+  // JSON.stringify se salta las claves undefined
+  for (size_t i = 0; i < 5; i++) {
+    if (!fotos[i].ts) continue;
+    r.cuerpo += ',';
+    campoNum(r.cuerpo, kPartes[i].campo, fotos[i].value);
+  }
+  r.cuerpo += ',';
+  campoNum(r.cuerpo, "timestamp", double(ahora));
+  r.cuerpo += ",\"units\":{";
+  for (size_t i = 0; i < 5; i++) {
+    if (i) r.cuerpo += ',';
+    r.cuerpo += '"';
+    r.cuerpo += kPartes[i].campo;
+    r.cuerpo += "\":\"";
+    r.cuerpo += kPartes[i].unidad;
+    r.cuerpo += '"';
+  }
+  r.cuerpo += "}}";
+}
+
+// /api/greenhouse/rollups: {"timestamp":..,"temp":{"value":..,"ts":..,"1m":{"n":..,"min":..,"max":..,"avg":..},..},..}
+void rollups(const Estado& e, http::Respuesta& r) {
+  r.cuerpo = '{';
+  campoNum(r.cuerpo, "timestamp", double(wallMs()));
+  for (int t = 0; t < kNumTipos; t++) {
+    const Foto f = e.fotos[t].load();
+    if (!f.ts) continue;
+    r.cuerpo += ",\"";
+    r.cuerpo += kTipos[t];
+    r.cuerpo += "\":{";
+    campoNum(r.cuerpo, "value", f.value);
+    r.cuerpo += ',';
+    campoNum(r.cuerpo, "ts", double(f.ts));
+    for (size_t w = 0; w < cache::Rollups::kN; w++) {
+      const cache::Resumen& v = f.ventanas[w];
+      r.cuerpo += ",\"";
+      r.cuerpo += cache::Rollups::kNombres[w];
+      r.cuerpo += "\":{";
+      campoNum(r.cuerpo, "n", double(v.n));
+      if (v.n) {
+        r.cuerpo += ',';
+        campoNum(r.cuerpo, "min", v.min);
+        r.cuerpo += ',';
+        campoNum(r.cuerpo, "max", v.max);
+        r.cuerpo += ',';
+        campoNum(r.cuerpo, "avg", v.avg());
+      }
+      r.cuerpo += '}';
+    }
+    r.cuerpo += '}';
+  }
+  r.cuerpo += '}';
+}
+
+void atender(const Estado& e, const http::Peticion& p, http::Respuesta& r) {
+  static const std::pair<const char*, Endpoint> kGreenhouse[] = {
+      {"/api/greenhouse/temperature", {"temperature", kTemp, "No temperature data available"}},
+      {"/api/greenhouse/humidity", {"humidity", kHum, "No humidity data available"}},
+      {"/api/greenhouse/soil", {"soil", kSoil, "No soil data available"}},
+      {"/api/greenhouse/tank", {"tank", kTank, "No tank data available"}},
+      {"/api/greenhouse/light", {"light", kLight, "No light data available"}},
+  };
+  if (p.metodo != "GET") {
+    r.status = 405;
+    r.cuerpo = "{\"error\":\"Method Not Allowed\"}";
+    return;
+  }
+  const std::string_view ruta = p.ruta;
+  for (const auto& [ruta_, ep] : kGreenhouse) {
+    if (ruta == ruta_) return greenhouse(e, ep, r);
+  }
+  if (ruta == "/api/greenhouse/status") return status(e, r);
+  if (ruta == "/api/greenhouse/rollups") return rollups(e, r);
+  if (ruta == "/api/alexa/dht") return alexa(e, {{"temp", kTemp}, {"hum", kHum}}, "No hay dato de temp/hum aún", r);
+  if (ruta == "/api/alexa/soil") return alexa(e, {{"soil", kSoil}}, "No hay dato de soil aún", r);
+  if (ruta == "/api/alexa/tank") return alexa(e, {{"tank", kTank}}, "No hay dato de tank aún", r);
+  if (ruta == "/api/alexa/light") return alexa(e, {{"light", kLight}}, "No hay dato de luz aún", r);
+  // la función de Node-RED lee "gas_pct"; el tipo que publica la pasarela es "aire"
+  if (ruta == "/api/alexa/aire") return alexa(e, {{"gas_pct", kAire}}, "No hay dato de calidad de aire aún", r);
+  r.status = 404;
+  r.cuerpo = "{\"error\":\"Not Found\"}";
+}
+
+std::atomic<bool> gFin{false};
+
+bool leerArgs(int argc, char** argv, Config& c) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string k = argv[i];
+    const char* v = argv[i + 1];
+    if (k == "--host") c.host = v;
+    else if (k == "--port") c.port = uint16_t(std::atoi(v));
+    else if (k == "--http-host") c.httpHost = v;
+    else if (k == "--http-port") c.httpPort = uint16_t(std::atoi(v));
+    else if (k == "--hilos") c.hilos = uint32_t(std::max(1, std::atoi(v)));
+    else return false;
+  }
+  return (argc % 2) == 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Config cfg;
+  if (!leerArgs(argc, argv, cfg)) {
+    std::fprintf(stderr, "argumentos no válidos (ver el comentario de src/consultas/main.cpp)\n");
+    return 2;
+  }
+  std::signal(SIGINT, [](int) { gFin = true; });
+  std::signal(SIGTERM, [](int) { gFin = true; });
+
+  Estado estado;
+  http::Servidor servidor;
+  if (!servidor.listen(cfg.httpHost.c_str(), cfg.httpPort, cfg.hilos)) return 1;
+  std::thread ingesta([&] { Ingesta(cfg, estado, gFin)(); });
+  std::printf("consultas: http://%s:%u (%u hilos), telemetría de %s:%u\n", cfg.httpHost.c_str(), servidor.port(),
+              cfg.hilos, cfg.host.c_str(), cfg.port);
+  std::fflush(stdout);
+  servidor.run([&estado](const http::Peticion& p, http::Respuesta& r) { atender(estado, p, r); }, gFin);
+  ingesta.join();
+  std::printf("consultas: %llu muestras recibidas\n", (unsigned long long)estado.muestras.load());
+  return 0;
+}
@@ -0,0 +1,346 @@
+// --- GRABADOR Y REPRODUCTOR DEL TRÁFICO ---
+// para probar la pasarela, el histórico o las reglas con el tráfico de verdad del invernadero (y no con el de carga)
+//   y poder repetir una prueba exactamente igual. Tres modos sobre el formato de lib/Grabacion:
+//   - grabar: se suscribe con QoS 1 a los topics crudos de los nodos, a sus lotes binarios y a
+//     greenhouse/+/telemetry (o a --topics) y añade cada mensaje con su hora de llegada en us. Los retenidos que
+//     manda el broker al suscribirse no son tráfico de ese momento y no se graban. Hace sync cada segundo; si se corta
+//     a medias, al volver a grabar en el mismo fichero se sigue al final.
+//   - reproducir: vuelve a publicar los mensajes con los mismos huecos entre ellos, a tiempo real o --velocidad
+//     veces más rápido (0: todo lo rápido que se pueda). Los payloads salen byte a byte como se grabaron, en el mismo
+//     orden, así que dos reproducciones de la misma grabación dan la misma entrada a quien escuche; ojo, los "ts" de
+//     los nodos son los de la grabación. Cada mensaje se programa sobre el reloj monótono desde el principio de la
+//     reproducción (no desde el anterior), así que un retraso no se acumula. Al terminar imprime el retraso
+//     p50/p99/máx de los envíos respecto a su hora.
+//   - info: mensajes, intervalo, bytes y huecos por topic.
+//
+// --desde/--hasta: ms desde 1970, o relativo a la grabación: +30m desde el principio, -10m antes del final (s, m, h, d;
+//   sin unidad, ms). --filtro: filtros MQTT separados por comas; p. ej. con la pasarela en marcha conviene reproducir
+//   solo los crudos (dht11,soil,ldr,mq135,nivel_agua,+/bin), o saldría la telemetría dos veces. --prefijo se pone
+//   delante de cada topic para reproducir sin mezclarse con los nodos de verdad. --qos -1 publica con el de la
+//   grabación.
+//
+// Uso: program [--modo grabar] [--archivo trafico.trz] [--host 127.0.0.1] [--port 1884] [--topics dht11,soil,...]
+//              [--segundos 0]
+//      program --modo reproducir [--archivo trafico.trz] [--host 127.0.0.1] [--port 1884] [--velocidad 1]
+//              [--desde +0] [--hasta 0] [--filtro #] [--prefijo ""] [--qos -1] [--retain 0]
+//      program --modo info [--archivo trafico.trz]
+#include <Grabacion.h>
+#include <MqttClient.h>
+#include <Percentil.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t nowUs() {
+  return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count());
+}
+
+uint64_t wallUs() {
+  using namespace std::chrono;
+  return uint64_t(duration_cast<microseconds>(system_clock::now().time_since_epoch()).count());
+}
+
+// --- CONFIGURACIÓN ---
+struct Config {
+  std::string modo = "grabar";
+  std::string archivo = "trafico.trz";
+  std::string host = "127.0.0.1";
+  uint16_t port = 1884; // el puerto que publica docker-compose
+  std::string topics = "dht11,soil,ldr,mq135,nivel_agua,+/bin,greenhouse/+/telemetry";
+  uint32_t segundos = 0; // grabar: 0 = hasta Ctrl+C
+  double velocidad = 1;
+  std::string desde = "+0", hasta = "0";
+  std::string filtro = "#";
+  std::string prefijo;
+  int qos = -1;
+  bool retain = false;
+};
+
+std::vector<std::string> separar(const std::string& s) {
+  std::vector<std::string> out;
+  for (size_t a = 0; a <= s.size();) {
+    const size_t b = std::min(s.find(',', a), s.size());
+    if (b > a) out.push_back(s.substr(a, b - a));
+    a = b + 1;
+  }
+  return out;
+}
+
+// "1700000000000" (ms desde 1970), "+30m" (desde el principio de la grabación), "-10m" (antes del final) -> us.
+//   "0" es sin límite (vale finUs).
+bool leerTiempo(const std::string& s, const grab::Lector& lector, uint64_t finUs, uint64_t& out) {
+  char* fin;
+  const double n = std::strtod(s.c_str(), &fin);
+  if (fin == s.c_str()) return false;
+  const std::string unidad = fin;
+  double ms;
+  if (unidad.empty() || unidad == "ms") ms = n;
+  else if (unidad == "s") ms = n * 1000;
+  else if (unidad == "m") ms = n * 60000;
+  else if (unidad == "h") ms = n * 3600000;
+  else if (unidad == "d") ms = n * 86400000;
+  else return false;
+  const int64_t us = int64_t(ms * 1000);
+  if (s[0] == '+') out = lector.primeroUs() + uint64_t(us);
+  else if (s[0] == '-') out = uint64_t(std::max<int64_t>(0, int64_t(lector.ultimoUs()) + us));
+  else if (us == 0) out = finUs;
+  else out = uint64_t(us);
+  return true;
+}
+
+// hora UTC legible de un instante en us
+std::string fecha(uint64_t us) {
+  const time_t t = time_t(us / 1000000);
+  tm u;
+  gmtime_r(&t, &u);
+  char buf[40];
+  const size_t n = std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &u);
+  std::snprintf(buf + n, sizeof(buf) - n, ".%03u UTC", unsigned(us / 1000 % 1000));
+  return buf;
+}
+
+std::atomic<bool> gFin{false};
+
+// --- GRABAR ---
+int grabar(const Config& cfg) {
+  grab::Escritor esc;
+  if (!esc.open(cfg.archivo, wallUs())) return 1;
+  const std::vector<std::string> topics = separar(cfg.topics);
+  MqttClient cli;
+  char cid[48];
+  std::snprintf(cid, sizeof(cid), "grabador-%d", int(getpid()));
+  const auto conectar = [&] {
+    if (!cli.connect(cfg.host.c_str(), cfg.port, cid)) return false;
+    for (const std::string& t : topics) {
+      if (!cli.subscribe(t, 1)) return false;
+    }
+    return true;
+  };
+  for (uint32_t espera = 1000; !gFin && !conectar(); espera = std::min(espera * 2, 30000u)) {
+    std::fprintf(stderr, "no se puede conectar a %s:%u, reintento en %u ms\n", cfg.host.c_str(), cfg.port, espera);
+    std::this_thread::sleep_for(std::chrono::milliseconds(espera));
+  }
+  std::printf("grabando %zu topics en %s (%.1f MB ya grabados)\n", topics.size(), cfg.archivo.c_str(),
+              double(esc.bytes()) / 1e6);
+  std::fflush(stdout);
+
+  uint64_t retenidos = 0, grandes = 0;
+  const auto guardar = [&](const mqtt::PublishView& p) {
+    if (p.retain) return retenidos++, void();
+    if (!esc.append(wallUs(), p.topic, p.payload, p.qos, p.retain)) grandes++;
+  };
+
+  const uint64_t inicio = nowUs();
+  uint64_t siguienteSync = inicio + 1000000, siguienteLog = inicio + 60000000;
+  while (!gFin && (!cfg.segundos || nowUs() - inicio < uint64_t(cfg.segundos) * 1000000)) {
+    if (!cli.poll(200, guardar)) {
+      std::fprintf(stderr, "conexión perdida; reconectando\n");
+      std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+      conectar();
+    }
+    const uint64_t ahora = nowUs();
+    if (ahora >= siguienteSync) {
+      siguienteSync = ahora + 1000000;
+      if (!esc.sync()) std::fprintf(stderr, "no se puede escribir %s\n", cfg.archivo.c_str());
+    }
+    if (ahora >= siguienteLog) {
+      siguienteLog = ahora + 60000000;
+      std::printf("grabados %llu, retenidos %llu, grandes %llu; %.1f MB\n", (unsigned long long)esc.registros(),
+                  (unsigned long long)retenidos, (unsigned long long)grandes, double(esc.bytes()) / 1e6);
+      std::fflush(stdout);
+    }
+  }
+  const bool ok = esc.sync();
+  cli.disconnect();
+  std::printf("grabados %llu, retenidos %llu, grandes %llu; %.1f MB\n", (unsigned long long)esc.registros(),
+              (unsigned long long)retenidos, (unsigned long long)grandes, double(esc.bytes()) / 1e6);
+  return ok ? 0 : 1;
+}
+
+// --- REPRODUCIR ---
+int reproducir(const Config& cfg) {
+  grab::Lector lector;
+  if (!lector.open(cfg.archivo)) return 1;
+  uint64_t desde, hasta;
+  if (!leerTiempo(cfg.desde, lector, 0, desde) || !leerTiempo(cfg.hasta, lector, UINT64_MAX, hasta) ||
+      cfg.velocidad < 0 || cfg.qos > 1) {
+    std::fprintf(stderr, "argumentos no válidos\n");
+    return 2;
+  }
+  if (lector.indiceRehecho()) std::fprintf(stderr, "índice de %s rehecho en memoria\n", cfg.archivo.c_str());
+  const std::vector<std::string> filtros = separar(cfg.filtro);
+  const auto pasa = [&](std::string_view topic) {
+    for (const std::string& f : filtros) {
+      if (mqtt::topicMatches(f, topic)) return true;
+    }
+    return false;
+  };
+  // primero se cuentan, para el progreso y para empezar a la hora del primero que sale
+  uint64_t total = 0, primero = 0;
+  lector.forEach(desde, hasta, [&](const grab::Registro& r) {
+    if (pasa(r.topic) && !total++) primero = r.us;
+    return true;
+  });
+  if (!total) {
+    std::fprintf(stderr, "no hay mensajes en ese intervalo\n");
+    return 1;
+  }
+
+  MqttClient cli;
+  char cid[48];
+  std::snprintf(cid, sizeof(cid), "reproductor-%d", int(getpid()));
+  if (!cli.connect(cfg.host.c_str(), cfg.port, cid)) {
+    std::fprintf(stderr, "no se puede conectar a %s:%u\n", cfg.host.c_str(), cfg.port);
+    return 1;
+  }
+  std::printf("reproduciendo %llu mensajes desde %s a x%g\n", (unsigned long long)total, fecha(primero).c_str(),
+              cfg.velocidad);
+  std::fflush(stdout);
+
+  const auto ignorar = [](const mqtt::PublishView&) {};
+  std::vector<uint64_t> retrasoUs;
+  retrasoUs.reserve(size_t(total));
+  std::string topic = cfg.prefijo;
+  uint64_t enviados = 0, pendientes = 0;
+  bool ok = true;
+  // con velocidad, un margen para que el primero no salga ya tarde
+  const uint64_t inicio = nowUs() + (cfg.velocidad > 0 ? 100000 : 0);
+  uint64_t siguienteLog = inicio + 10000000;
+  lector.forEach(desde, hasta, [&](const grab::Registro& r) {
+    if (!pasa(r.topic)) return true;
+    // hora programada: los huecos de la grabación divididos por la velocidad, desde el principio
+    const uint64_t hora = cfg.velocidad > 0 ? inicio + uint64_t(double(r.us - primero) / cfg.velocidad) : 0;
+    uint64_t ahora = nowUs();
+    if (ahora + 1000 < hora) {
+      // lo que queda en el buffer sale ya; mientras tanto se atienden los PUBACK y el keepalive
+      pendientes = 0;
+      while (ok && !gFin && (ahora = nowUs()) + 1000 < hora) ok = cli.poll(int((hora - ahora) / 1000), ignorar);
+    }
+    while (ahora < hora) ahora = nowUs(); // el último milisegundo, en espera activa
+    if (!ok || gFin) return false;
+    topic.resize(cfg.prefijo.size());
+    topic.append(r.topic.data(), r.topic.size());
+    cli.publish(topic, r.payload, uint8_t(cfg.qos < 0 ? r.qos : cfg.qos), cfg.retain);
+    if (hora) retrasoUs.push_back(ahora - hora);
+    enviados++;
+    // sin esperas entre medias (deprisa o con retraso) se juntan hasta 256 en cada send()
+    if (++pendientes >= 256 || hora) {
+      ok = cli.poll(0, ignorar);
+      pendientes = 0;
+    }
+    if (ahora >= siguienteLog) {
+      siguienteLog = ahora + 10000000;
+      std::printf("  %llu/%llu, grabación en %s\n", (unsigned long long)enviados, (unsigned long long)total,
+                  fecha(r.us).c_str());
+      std::fflush(stdout);
+    }
+    return ok;
+  });
+  ok = ok && cli.flush();
+  const double segundos = double(nowUs() - inicio) / 1e6;
+  cli.disconnect();
+  if (!ok) std::fprintf(stderr, "conexión perdida\n");
+  std::printf("enviados %llu de %llu en %.2f s (%.0f msg/s)\n", (unsigned long long)enviados,
+              (unsigned long long)total, segundos, double(enviados) / std::max(segundos, 1e-6));
+  if (!retrasoUs.empty()) {
+    std::printf("retraso sobre la hora programada: p50 %.2f ms, p99 %.2f ms, máx %.2f ms\n",
+                double(percentil(retrasoUs, 50)) / 1000, double(percentil(retrasoUs, 99)) / 1000,
+                double(percentil(retrasoUs, 100)) / 1000);
+  }
+  return ok && enviados == total ? 0 : 1;
+}
+
+// --- INFO ---
+int info(const Config& cfg) {
+  grab::Lector lector;
+  if (!lector.open(cfg.archivo)) return 1;
+  struct PorTopic {
+    uint64_t n = 0, bytes = 0, ultimo = 0, hueco = 0;
+  };
+  std::map<std::string, PorTopic, std::less<>> topics;
+  uint64_t n = 0, payload = 0, hueco = 0, anterior = 0;
+  lector.forEach([&](const grab::Registro& r) {
+    auto it = topics.find(r.topic);
+    if (it == topics.end()) it = topics.emplace(std::string(r.topic), PorTopic{}).first;
+    PorTopic& t = it->second;
+    if (t.n) t.hueco = std::max(t.hueco, r.us - t.ultimo);
+    t.ultimo = r.us;
+    t.n++;
+    t.bytes += r.payload.size();
+    if (n) hueco = std::max(hueco, r.us - anterior);
+    anterior = r.us;
+    payload += r.payload.size();
+    n++;
+    return true;
+  });
+  std::printf("%s: creado %s\n", cfg.archivo.c_str(), fecha(lector.creadoUs()).c_str());
+  if (!n) {
+    std::printf("sin mensajes\n");
+    return 0;
+  }
+  const double span = double(lector.ultimoUs() - lector.primeroUs()) / 1e6;
+  std::printf("%llu mensajes de %s a %s (%.0f s)\n", (unsigned long long)n, fecha(lector.primeroUs()).c_str(),
+              fecha(lector.ultimoUs()).c_str(), span);
+  std::printf("%.2f MB, %.1f bytes por mensaje (%.1f de payload), %zu entradas de índice%s, hueco máx %.1f s\n",
+              double(lector.bytes()) / 1e6, double(lector.bytes() - grab::kCabecera) / double(n),
+              double(payload) / double(n), lector.entradasIndice(), lector.indiceRehecho() ? " (rehecho)" : "",
+              double(hueco) / 1e6);
+  std::printf("  %-28s %10s %10s %12s\n", "topic", "mensajes", "payload B", "hueco máx s");
+  for (const auto& [nombre, t] : topics) {
+    std::printf("  %-28s %10llu %10.1f %12.1f\n", nombre.c_str(), (unsigned long long)t.n,
+                double(t.bytes) / double(t.n), double(t.hueco) / 1e6);
+  }
+  return 0;
+}
+
+bool leerArgs(int argc, char** argv, Config& c) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string k = argv[i];
+    const char* v = argv[i + 1];
+    if (k == "--modo") c.modo = v;
+    else if (k == "--archivo") c.archivo = v;
+    else if (k == "--host") c.host = v;
+    else if (k == "--port") c.port = uint16_t(std::atoi(v));
+    else if (k == "--topics") c.topics = v;
+    else if (k == "--segundos") c.segundos = uint32_t(std::atoi(v));
+    else if (k == "--velocidad") c.velocidad = std::atof(v);
+    else if (k == "--desde") c.desde = v;
+    else if (k == "--hasta") c.hasta = v;
+    else if (k == "--filtro") c.filtro = v;
+    else if (k == "--prefijo") c.prefijo = v;
+    else if (k == "--qos") c.qos = std::atoi(v);
+    else if (k == "--retain") c.retain = std::atoi(v) != 0;
+    else return false;
+  }
+  return (argc % 2) == 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Config cfg;
+  if (!leerArgs(argc, argv, cfg) || (cfg.modo != "grabar" && cfg.modo != "reproducir" && cfg.modo != "info")) {
+    std::fprintf(stderr, "argumentos no válidos (ver el comentario de src/grabador/main.cpp)\n");
+    return 2;
+  }
+  std::signal(SIGINT, [](int) { gFin = true; });
+  std::signal(SIGTERM, [](int) { gFin = true; });
+  if (cfg.modo == "info") return info(cfg);
+  if (cfg.modo == "reproducir") return reproducir(cfg);
+  return grabar(cfg);
+}
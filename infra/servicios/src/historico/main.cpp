@@ -0,0 +1,189 @@
+// --- HISTÓRICO DE LA TELEMETRÍA ---
+// dos modos sobre la base de series temporales de lib/Tsdb:
+//   - servicio: se suscribe a greenhouse/+/telemetry y guarda cada {"ts":..,"type":"..","value":..} en la serie
+//     <nodo>/<type> (p. ej. node2/soil). Hace sync del WAL cada segundo y cada minuto imprime lo guardado.
+//   - consulta (--serie): lee el directorio en modo solo lectura, aunque el servicio esté escribiendo, y saca un CSV
+//     en bruto o agregado con --paso.
+//
+// Uso: program [--dir historico] [--host 127.0.0.1] [--port 1884]
+//      program [--dir historico] --serie node2/soil [--desde -30d] [--hasta 0] [--paso 1h]
+//        --desde/--hasta: ms desde 1970 o relativo a ahora (-90s, -5m, -12h, -30d); --paso 0 = en bruto
+#include <Db.h>
+#include <JsonScan.h>
+#include <MqttClient.h>
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+uint64_t wallMs() {
+  using namespace std::chrono;
+  return uint64_t(duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count());
+}
+
+struct Config {
+  std::string dir = "historico";
+  std::string host = "127.0.0.1";
+  uint16_t port = 1884; // el puerto que publica docker-compose
+  std::string serie;
+  std::string desde = "-1d", hasta = "0", paso = "0";
+};
+
+// "1700000000000", "-30d", "5m", "0"... -> ms. Con signo menos (o 0) es relativo a ahora cuando relativo es true.
+bool leerTiempo(const std::string& s, bool relativo, int64_t& out) {
+  char* fin;
+  const double n = std::strtod(s.c_str(), &fin);
+  if (fin == s.c_str()) return false;
+  const std::string unidad = fin;
+  int64_t ms;
+  if (unidad.empty() || unidad == "ms") ms = int64_t(n);
+  else if (unidad == "s") ms = int64_t(n * 1000);
+  else if (unidad == "m") ms = int64_t(n * 60000);
+  else if (unidad == "h") ms = int64_t(n * 3600000);
+  else if (unidad == "d") ms = int64_t(n * 86400000);
+  else return false;
+  out = relativo && (ms <= 0 || !unidad.empty()) ? int64_t(wallMs()) + ms : ms;
+  return true;
+}
+
+std::atomic<bool> gFin{false};
+
+int servicio(const Config& cfg) {
+  tsdb::Db db;
+  if (!db.open(cfg.dir)) {
+    std::fprintf(stderr, "no se puede abrir %s\n", cfg.dir.c_str());
+    return 1;
+  }
+  MqttClient cli;
+  char cid[48];
+  std::snprintf(cid, sizeof(cid), "historico-%d", int(getpid()));
+  uint64_t guardadas = 0, rechazadas = 0, invalidas = 0;
+  const auto conectar = [&] {
+    return cli.connect(cfg.host.c_str(), cfg.port, cid) && cli.subscribe("greenhouse/+/telemetry", 1);
+  };
+  for (uint32_t espera = 1000; !gFin && !conectar(); espera = std::min(espera * 2, 30000u)) {
+    std::fprintf(stderr, "no se puede conectar a %s:%u, reintento en %u ms\n", cfg.host.c_str(), cfg.port, espera);
+    std::this_thread::sleep_for(std::chrono::milliseconds(espera));
+  }
+  std::printf("histórico: %s, %zu series, %zu segmentos\n", cfg.dir.c_str(), db.seriesCount(), db.segmentCount());
+
+  const auto guardar = [&](const mqtt::PublishView& p) {
+    // greenhouse/<nodo>/telemetry
+    const size_t a = p.topic.find('/'), b = p.topic.rfind('/');
+    if (a == std::string_view::npos || b <= a + 1) return invalidas++, void();
+    std::string_view type;
+    double ts = -1, value = 0;
+    bool hayValor = false;
+    json::forEachField(p.payload, [&](std::string_view k, std::string_view v) {
+      if (k == "type") type = v;
+      else if (k == "ts") json::toDouble(v, ts);
+      else if (k == "value") hayValor = json::toDouble(v, value);
+    });
+    if (type.empty() || ts < 0 || !hayValor) return invalidas++, void();
+    std::string nombre(p.topic.substr(a + 1, b - a - 1));
+    nombre += '/';
+    nombre.append(type.data(), type.size());
+    const uint32_t s = db.series(nombre);
+    // el mismo ts dos veces (p. ej. dos normalizadores activos) o desordenado: se queda el primero
+    if (s == tsdb::Db::kNoSeries || !db.append(s, int64_t(ts), value)) return rechazadas++, void();
+    guardadas++;
+  };
+
+  uint64_t siguienteSync = wallMs() + 1000, siguienteLog = wallMs() + 60000;
+  while (!gFin) {
+    if (!cli.poll(200, guardar)) {
+      std::fprintf(stderr, "conexión perdida; reconectando\n");
+      std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+      conectar();
+    }
+    const uint64_t ahora = wallMs();
+    if (ahora >= siguienteSync) {
+      siguienteSync = ahora + 1000;
+      if (!db.sync()) std::fprintf(stderr, "no se puede escribir el WAL\n");
+    }
+    if (ahora >= siguienteLog) {
+      siguienteLog = ahora + 60000;
+      std::printf("guardadas %llu, rechazadas %llu, inválidas %llu; %zu segmentos, %.1f MB\n",
+                  (unsigned long long)guardadas, (unsigned long long)rechazadas, (unsigned long long)invalidas,
+                  db.segmentCount(), double(db.segmentBytes() + db.walBytes()) / 1e6);
+      std::fflush(stdout);
+    }
+  }
+  db.sync();
+  cli.disconnect();
+  return 0;
+}
+
+int consulta(const Config& cfg) {
+  tsdb::Options opt;
+  opt.readOnly = true;
+  tsdb::Db db;
+  int64_t desde, hasta, paso;
+  if (!leerTiempo(cfg.desde, true, desde) || !leerTiempo(cfg.hasta, true, hasta) ||
+      !leerTiempo(cfg.paso, false, paso)) {
+    std::fprintf(stderr, "tiempos no válidos\n");
+    return 2;
+  }
+  if (!db.open(cfg.dir, opt)) {
+    std::fprintf(stderr, "no se puede abrir %s\n", cfg.dir.c_str());
+    return 1;
+  }
+  const uint32_t s = db.series(cfg.serie, false);
+  if (s == tsdb::Db::kNoSeries) {
+    std::fprintf(stderr, "no existe la serie %s; hay:\n", cfg.serie.c_str());
+    for (uint32_t i = 0; i < db.seriesCount(); i++) std::fprintf(stderr, "  %s\n", db.seriesName(i).c_str());
+    return 1;
+  }
+  if (paso <= 0) {
+    std::printf("ts,value\n");
+    db.scan(s, desde, hasta, [](int64_t ts, double v) { std::printf("%lld,%.15g\n", (long long)ts, v); });
+    return 0;
+  }
+  std::vector<tsdb::Bucket> cubos;
+  db.downsample(s, desde, hasta, paso, cubos);
+  std::printf("inicio,n,min,max,media\n");
+  for (const tsdb::Bucket& b : cubos) {
+    std::printf("%lld,%llu,%.15g,%.15g,%.15g\n", (long long)b.start, (unsigned long long)b.count, b.min, b.max,
+                b.avg());
+  }
+  return 0;
+}
+
+bool leerArgs(int argc, char** argv, Config& c) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string k = argv[i];
+    const char* v = argv[i + 1];
+    if (k == "--dir") c.dir = v;
+    else if (k == "--host") c.host = v;
+    else if (k == "--port") c.port = uint16_t(std::atoi(v));
+    else if (k == "--serie") c.serie = v;
+    else if (k == "--desde") c.desde = v;
+    else if (k == "--hasta") c.hasta = v;
+    else if (k == "--paso") c.paso = v;
+    else return false;
+  }
+  return (argc % 2) == 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Config cfg;
+  if (!leerArgs(argc, argv, cfg)) {
+    std::fprintf(stderr, "argumentos no válidos (ver el comentario de src/historico/main.cpp)\n");
+    return 2;
+  }
+  if (!cfg.serie.empty()) return consulta(cfg);
+  std::signal(SIGINT, [](int) { gFin = true; });
+  std::signal(SIGTERM, [](int) { gFin = true; });
+  return servicio(cfg);
+}
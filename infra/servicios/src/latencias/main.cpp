@@ -0,0 +1,432 @@
+// --- LATENCIAS Y PÉRDIDAS DE EXTREMO A EXTREMO ---
+// cuando falta un punto en el dashboard no sabíamos si se había perdido en el sensor, en el broker o en la
+//   normalización. Los nodos marcan ahora cada lectura con "seq" (número de lectura de su arranque) y "ts" (hora de la
+//   lectura por SNTP), y la pasarela copia el "seq" a la telemetría (ver SensorNode.h y Normalizer.h). Esta
+//   herramienta se suscribe a la vez a los topics crudos y a greenhouse/+/telemetry y, por nodo, calcula:
+//   - pérdidas: huecos en la numeración de cada arranque ("faltan": aún no han llegado; un reenvío desde la flash los
+//     puede rellenar más tarde), duplicadas, desordenadas (llegan con un seq menor que el último) y reinicios
+//   - latencia nodo -> broker: hora de recepción del crudo - "ts" del nodo (solo lecturas en directo; las reenviadas
+//     desde la flash llevan "age" y se cuentan aparte). Depende de que los dos relojes estén en hora por NTP.
+//   - latencia broker -> telemetría: del crudo a su mensaje normalizado (mismo nodo, tipo y seq), con el reloj de este
+//     proceso. Los crudos que no salen normalizados en --espera-ms cuentan como "sin normalizar" (valores fuera de
+//     rango, o la normalización los ha perdido).
+//   - latencia de extremo a extremo: telemetría recibida - "ts" del nodo
+//   - de los lotes binarios (<topic>/bin) solo se sigue el número de lote: pérdidas, sin latencias
+//
+// Cada --stats-s segundos imprime una fila por nodo y publica lo mismo en JSON en latencias/<nodo>. Las latencias son
+//   las del intervalo; las pérdidas, desde el arranque de la herramienta. Un nodo incumple el SLO si le falta más del
+//   --slo-perdida % de las lecturas o si el p99 de extremo a extremo pasa de --slo-p99-ms ("slo":0 en el JSON).
+//
+// La telemetría que normaliza Node-RED no lleva "seq": con Node-RED solo salen las pérdidas y la latencia nodo ->
+//   broker, y sus mensajes se cuentan como "sin seq".
+//
+// Uso: program [--host 127.0.0.1] [--port 1884] [--stats-s 10] [--segundos 0] [--espera-ms 10000]
+//              [--slo-perdida 1] [--slo-p99-ms 5000]
+#include <BatchFormat.h>
+#include <JsonScan.h>
+#include <MqttClient.h>
+#include <Percentil.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t nowUs() {
+  return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count());
+}
+
+uint64_t wallMs() {
+  using namespace std::chrono;
+  return uint64_t(duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count());
+}
+
+// --- CONFIGURACIÓN ---
+struct Config {
+  std::string host = "127.0.0.1";
+  uint16_t port = 1884;
+  uint32_t statsS = 10;
+  uint32_t segundos = 0; // 0 = hasta Ctrl+C
+  uint32_t esperaMs = 10000;
+  double sloPerdida = 1;   // % de lecturas que faltan
+  uint32_t sloP99Ms = 5000; // p99 de extremo a extremo
+};
+
+// --- FUENTES ---
+// los topics crudos y los tipos de telemetría que salen de cada uno (los de Normalizer.h)
+struct Fuente {
+  const char* topic;
+  const char* tipos[2];
+};
+constexpr Fuente kFuentes[] = {
+    {"dht11", {"temp", "hum"}}, {"soil", {"soil", nullptr}},  {"ldr", {"light", nullptr}},
+    {"mq135", {"aire", nullptr}}, {"nivel_agua", {"tank", nullptr}},
+};
+constexpr size_t kNumFuentes = sizeof(kFuentes) / sizeof(kFuentes[0]);
+
+int fuenteDeTopic(std::string_view topic) {
+  for (size_t i = 0; i < kNumFuentes; i++) {
+    if (topic == kFuentes[i].topic) return int(i);
+  }
+  return -1;
+}
+
+// índice global del tipo (fuente * 2 + posición), o -1
+int tipoDeTelemetria(std::string_view type) {
+  for (size_t i = 0; i < kNumFuentes; i++) {
+    for (size_t j = 0; j < 2; j++) {
+      if (kFuentes[i].tipos[j] && type == kFuentes[i].tipos[j]) return int(i * 2 + j);
+    }
+  }
+  return -1;
+}
+
+// --- NUMERACIÓN DE UN ARRANQUE ---
+// qué seq han llegado, en un bitmap desde el primero visto (con margen por debajo para los reenvíos de lo anterior)
+class Numeracion {
+ public:
+  enum Llegada { Nueva, Duplicada, Desordenada, FueraDeVentana };
+  static constexpr uint32_t kMargen = 1024;
+
+  Llegada anotar(uint32_t seq) {
+    if (!recibidas_) {
+      base_ = seq > kMargen ? seq - kMargen : 0;
+      min_ = max_ = seq;
+    }
+    if (seq < base_) return FueraDeVentana;
+    const size_t i = seq - base_;
+    if (i / 64 >= bits_.size()) bits_.resize(i / 64 + 1, 0);
+    const uint64_t bit = uint64_t(1) << (i % 64);
+    if (bits_[i / 64] & bit) return Duplicada;
+    bits_[i / 64] |= bit;
+    const bool desordenada = recibidas_ && seq < max_;
+    recibidas_++;
+    min_ = std::min(min_, seq);
+    max_ = std::max(max_, seq);
+    return desordenada ? Desordenada : Nueva;
+  }
+
+  uint64_t esperadas() const { return recibidas_ ? uint64_t(max_ - min_) + 1 : 0; }
+  uint64_t recibidas() const { return recibidas_; }
+  uint32_t max() const { return max_; }
+
+ private:
+  uint32_t base_ = 0, min_ = 0, max_ = 0;
+  uint64_t recibidas_ = 0;
+  std::vector<uint64_t> bits_;
+};
+
+// --- ESTADO DE UN NODO ---
+struct Nodo {
+  explicit Nodo(std::string n) : nombre(std::move(n)) {}
+
+  std::string nombre;
+  Numeracion actual, anterior; // este arranque y el anterior (para los reenvíos con "previo")
+  uint64_t esperadasCerradas = 0, recibidasCerradas = 0; // arranques anteriores a esos dos
+  uint64_t mensajes = 0, duplicadas = 0, desordenadas = 0, fueraDeVentana = 0, reinicios = 0;
+  uint64_t reenviadas = 0, previas = 0, sinSeq = 0, sinNormalizar = 0, huerfanas = 0, telemetriaSinSeq = 0;
+  std::vector<int64_t> nodoBroker, brokerTelemetria, extremo; // ms (el segundo en us), del intervalo
+
+  uint64_t esperadas() const { return esperadasCerradas + anterior.esperadas() + actual.esperadas(); }
+  uint64_t recibidas() const { return recibidasCerradas + anterior.recibidas() + actual.recibidas(); }
+
+  void reiniciar() {
+    esperadasCerradas += anterior.esperadas();
+    recibidasCerradas += anterior.recibidas();
+    anterior = std::move(actual);
+    actual = Numeracion();
+    reinicios++;
+  }
+
+  void anotar(Numeracion::Llegada l) {
+    if (l == Numeracion::Duplicada) duplicadas++;
+    else if (l == Numeracion::Desordenada) desordenadas++;
+    else if (l == Numeracion::FueraDeVentana) fueraDeVentana++;
+  }
+};
+
+// crudo esperando a su telemetría normalizada
+struct Pendiente {
+  uint64_t rxUs;   // recepción del crudo
+  uint64_t tsNodo; // 0 si no traía "ts" o es un reenvío
+  size_t nodo;
+};
+
+std::atomic<bool> gFin{false};
+
+// --- ANALIZADOR ---
+class Analizador {
+ public:
+  explicit Analizador(const Config& cfg) : cfg_(cfg) {
+    for (const Fuente& f : kFuentes) nodos_.emplace_back(f.topic);
+  }
+
+  bool conectar() {
+    char cid[48];
+    std::snprintf(cid, sizeof(cid), "latencias-%d", int(getpid()));
+    if (!cli_.connect(cfg_.host.c_str(), cfg_.port, cid)) return false;
+    for (const Fuente& f : kFuentes) {
+      if (!cli_.subscribe(f.topic, 0)) return false;
+    }
+    return cli_.subscribe("+/bin", 0) && cli_.subscribe("greenhouse/+/telemetry", 0);
+  }
+
+  void operator()() {
+    uint32_t espera = 1000;
+    while (!gFin.load() && !conectar()) {
+      std::fprintf(stderr, "no se puede conectar a %s:%u, reintento en %u ms\n", cfg_.host.c_str(), cfg_.port, espera);
+      std::this_thread::sleep_for(std::chrono::milliseconds(espera));
+      espera = std::min(espera * 2, 30000u);
+    }
+    std::printf("latencias: %s:%u, informe cada %u s\n", cfg_.host.c_str(), cfg_.port, cfg_.statsS);
+    const uint64_t inicio = nowUs();
+    uint64_t siguiente = inicio + uint64_t(std::max(1u, cfg_.statsS)) * 1000000;
+    while (!gFin.load()) {
+      if (!cli_.poll(100, [this](const mqtt::PublishView& p) { recibir(p); })) {
+        std::fprintf(stderr, "conexión perdida; reconectando\n");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        conectar();
+        continue;
+      }
+      caducar(nowUs());
+      const uint64_t ahora = nowUs();
+      if (ahora >= siguiente) {
+        siguiente += uint64_t(std::max(1u, cfg_.statsS)) * 1000000;
+        informe();
+      }
+      if (cfg_.segundos && ahora - inicio >= uint64_t(cfg_.segundos) * 1000000) break;
+    }
+    informe();
+    cli_.disconnect();
+  }
+
+ private:
+  void recibir(const mqtt::PublishView& p) {
+    const uint64_t us = nowUs();
+    const uint64_t ms = wallMs();
+    if (p.topic.size() > 4 && p.topic.substr(p.topic.size() - 4) == "/bin") {
+      lote(p.topic, p.payload);
+      return;
+    }
+    if (p.topic.substr(0, 11) == "greenhouse/") {
+      telemetria(p.payload, us, ms);
+      return;
+    }
+    const int f = fuenteDeTopic(p.topic);
+    if (f >= 0) crudo(size_t(f), p.payload, us, ms);
+  }
+
+  void crudo(size_t f, std::string_view payload, uint64_t us, uint64_t ms) {
+    Nodo& n = nodos_[f];
+    n.mensajes++;
+    double seq = -1, ts = 0, age = -1, previo = 0;
+    json::forEachField(payload, [&](std::string_view k, std::string_view v) {
+      if (k == "seq") json::toDouble(v, seq);
+      else if (k == "ts") json::toDouble(v, ts);
+      else if (k == "age") json::toDouble(v, age);
+      else if (k == "previo") json::toDouble(v, previo);
+    });
+    if (seq < 0) {
+      n.sinSeq++;
+      return;
+    }
+    const uint32_t s = uint32_t(seq);
+    if (previo) {
+      // reenvío desde la flash de una lectura de un arranque anterior: se apunta en la numeración de aquel
+      n.previas++;
+      n.anotar(n.anterior.anotar(s));
+      return;
+    }
+    if (age >= 0) {
+      n.reenviadas++;
+    } else if (n.actual.recibidas() && (s == 0 || s + kReorden < n.actual.max())) {
+      // en directo los seq de un nodo solo crecen (una sola conexión, en orden): si vuelve a 0, o muy atrás, el nodo
+      //   ha vuelto a arrancar (las primeras del arranque pueden haber ido a la flash)
+      n.reiniciar();
+    }
+    n.anotar(n.actual.anotar(s));
+    const bool enDirecto = age < 0 && ts > 0;
+    if (enDirecto) n.nodoBroker.push_back(int64_t(ms) - int64_t(ts));
+    for (size_t j = 0; j < 2; j++) {
+      if (!kFuentes[f].tipos[j]) continue;
+      pendientes_[clave(int(f * 2 + j), s)] = Pendiente{us, enDirecto ? uint64_t(ts) : 0, f};
+    }
+  }
+
+  void telemetria(std::string_view payload, uint64_t us, uint64_t ms) {
+    std::string_view type;
+    double seq = -1;
+    json::forEachField(payload, [&](std::string_view k, std::string_view v) {
+      if (k == "type") type = v;
+      else if (k == "seq") json::toDouble(v, seq);
+    });
+    const int t = tipoDeTelemetria(type);
+    if (t < 0) return;
+    Nodo& n = nodos_[size_t(t) / 2];
+    if (seq < 0) {
+      n.telemetriaSinSeq++;
+      return;
+    }
+    const auto it = pendientes_.find(clave(t, uint32_t(seq)));
+    if (it == pendientes_.end()) {
+      n.huerfanas++; // el crudo llegó antes de arrancar, o ya había caducado
+      return;
+    }
+    n.brokerTelemetria.push_back(int64_t(us - it->second.rxUs));
+    if (it->second.tsNodo) n.extremo.push_back(int64_t(ms) - int64_t(it->second.tsNodo));
+    pendientes_.erase(it);
+  }
+
+  // número de lote de <topic>/bin (16 bits, se desenrolla respecto al último)
+  void lote(std::string_view topic, std::string_view payload) {
+    const auto* p = reinterpret_cast<const uint8_t*>(payload.data());
+    std::string nombre(topic);
+    auto it = lotes_.find(nombre);
+    if (it == lotes_.end()) it = lotes_.emplace(nombre, Nodo(nombre)).first;
+    Nodo& n = it->second;
+    n.mensajes++;
+    if (payload.size() < batch::kHeaderSize || p[0] != batch::kMagic) {
+      n.sinSeq++;
+      return;
+    }
+    const uint16_t seq16 = batch::getU16(p + 9);
+    uint32_t seq = seq16;
+    if (n.actual.recibidas()) {
+      const uint32_t ultimo = n.actual.max();
+      seq = (ultimo & ~0xFFFFu) | seq16;
+      if (seq + 0x8000 < ultimo) seq += 0x10000;
+      else if (seq > ultimo + 0x8000 && seq >= 0x10000) seq -= 0x10000;
+      if (seq < ultimo && ultimo - seq > Numeracion::kMargen) {
+        n.reiniciar(); // el número de lote también vuelve a 0 en cada arranque
+        seq = seq16;
+      }
+    }
+    n.anotar(n.actual.anotar(seq));
+  }
+
+  void caducar(uint64_t us) {
+    const uint64_t limite = uint64_t(cfg_.esperaMs) * 1000;
+    for (auto it = pendientes_.begin(); it != pendientes_.end();) {
+      if (us - it->second.rxUs > limite) {
+        nodos_[it->second.nodo].sinNormalizar++;
+        it = pendientes_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  static constexpr uint32_t kReorden = 16; // un seq en directo más atrás que esto es de un arranque nuevo
+
+  static uint64_t clave(int tipo, uint32_t seq) { return uint64_t(tipo) << 32 | seq; }
+
+  void informe() {
+    std::printf("%-11s %8s %7s %7s %5s %5s %5s %6s | %-17s | %-15s | %-17s | %6s\n", "nodo", "recib.", "faltan",
+                "%", "dup", "desor", "reini", "sinseq", "nodo->broker ms", "->telemetría ms", "extremo ms",
+                "sinnor");
+    for (Nodo& n : nodos_) fila(n, true);
+    for (auto& [nombre, n] : lotes_) fila(n, false);
+    std::fflush(stdout);
+  }
+
+  void fila(Nodo& n, bool conLatencias) {
+    if (!n.mensajes) return;
+    const uint64_t esperadas = n.esperadas(), recibidas = n.recibidas();
+    const uint64_t faltan = esperadas - std::min(esperadas, recibidas);
+    const double pct = esperadas ? 100.0 * double(faltan) / double(esperadas) : 0;
+    const int64_t nb50 = percentil(n.nodoBroker, 50), nb99 = percentil(n.nodoBroker, 99);
+    const double bt50 = percentil(n.brokerTelemetria, 50) / 1000.0, bt99 = percentil(n.brokerTelemetria, 99) / 1000.0;
+    const int64_t e50 = percentil(n.extremo, 50), e99 = percentil(n.extremo, 99);
+    const int64_t emax = n.extremo.empty() ? 0 : *std::max_element(n.extremo.begin(), n.extremo.end());
+    const bool slo = pct <= cfg_.sloPerdida && e99 <= int64_t(cfg_.sloP99Ms);
+    if (conLatencias) {
+      std::printf("%-11s %8llu %7llu %7.2f %5llu %5llu %5llu %6llu | %7lld %9lld | %6.1f %8.1f | %6lld %10lld | %6llu%s\n",
+                  n.nombre.c_str(), (unsigned long long)recibidas, (unsigned long long)faltan, pct,
+                  (unsigned long long)n.duplicadas, (unsigned long long)n.desordenadas, (unsigned long long)n.reinicios,
+                  (unsigned long long)n.sinSeq, (long long)nb50, (long long)nb99, bt50, bt99, (long long)e50,
+                  (long long)e99, (unsigned long long)n.sinNormalizar, slo ? "" : "  SLO incumplido");
+    } else {
+      std::printf("%-11s %8llu %7llu %7.2f %5llu %5llu %5llu %6llu |\n", n.nombre.c_str(),
+                  (unsigned long long)recibidas, (unsigned long long)faltan, pct, (unsigned long long)n.duplicadas,
+                  (unsigned long long)n.desordenadas, (unsigned long long)n.reinicios, (unsigned long long)n.sinSeq);
+    }
+
+    char json[640];
+    int len = std::snprintf(
+        json, sizeof(json),
+        "{\"mensajes\":%llu,\"recibidas\":%llu,\"faltan\":%llu,\"faltan_pct\":%.3f,\"duplicadas\":%llu,"
+        "\"desordenadas\":%llu,\"fuera_de_ventana\":%llu,\"reinicios\":%llu,\"reenviadas\":%llu,\"previas\":%llu,"
+        "\"sin_seq\":%llu",
+        (unsigned long long)n.mensajes, (unsigned long long)recibidas, (unsigned long long)faltan, pct,
+        (unsigned long long)n.duplicadas, (unsigned long long)n.desordenadas, (unsigned long long)n.fueraDeVentana,
+        (unsigned long long)n.reinicios, (unsigned long long)n.reenviadas, (unsigned long long)n.previas,
+        (unsigned long long)n.sinSeq);
+    if (conLatencias && len > 0 && size_t(len) < sizeof(json)) {
+      len += std::snprintf(
+          json + len, sizeof(json) - size_t(len),
+          ",\"nodo_broker_p50_ms\":%lld,\"nodo_broker_p99_ms\":%lld,\"broker_telemetria_p50_ms\":%.2f,"
+          "\"broker_telemetria_p99_ms\":%.2f,\"extremo_p50_ms\":%lld,\"extremo_p99_ms\":%lld,\"extremo_max_ms\":%lld,"
+          "\"sin_normalizar\":%llu,\"huerfanas\":%llu,\"telemetria_sin_seq\":%llu,\"slo\":%d",
+          (long long)nb50, (long long)nb99, bt50, bt99, (long long)e50, (long long)e99, (long long)emax,
+          (unsigned long long)n.sinNormalizar, (unsigned long long)n.huerfanas,
+          (unsigned long long)n.telemetriaSinSeq, slo ? 1 : 0);
+    }
+    if (len > 0 && size_t(len) + 1 < sizeof(json)) {
+      json[len++] = '}';
+      cli_.publish("latencias/" + n.nombre, std::string_view(json, size_t(len)));
+    }
+    n.nodoBroker.clear();
+    n.brokerTelemetria.clear();
+    n.extremo.clear();
+  }
+
+  const Config& cfg_;
+  MqttClient cli_;
+  std::vector<Nodo> nodos_;
+  std::map<std::string, Nodo> lotes_;
+  std::unordered_map<uint64_t, Pendiente> pendientes_;
+};
+
+bool leerArgs(int argc, char** argv, Config& c) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string k = argv[i];
+    const char* v = argv[i + 1];
+    if (k == "--host") c.host = v;
+    else if (k == "--port") c.port = uint16_t(std::atoi(v));
+    else if (k == "--stats-s") c.statsS = uint32_t(std::max(1, std::atoi(v)));
+    else if (k == "--segundos") c.segundos = uint32_t(std::atoi(v));
+    else if (k == "--espera-ms") c.esperaMs = uint32_t(std::atoi(v));
+    else if (k == "--slo-perdida") c.sloPerdida = std::atof(v);
+    else if (k == "--slo-p99-ms") c.sloP99Ms = uint32_t(std::atoi(v));
+    else return false;
+  }
+  return (argc % 2) == 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Config cfg;
+  if (!leerArgs(argc, argv, cfg)) {
+    std::fprintf(stderr, "argumentos no válidos (ver el comentario de src/latencias/main.cpp)\n");
+    return 2;
+  }
+  std::signal(SIGINT, [](int) { gFin = true; });
+  std::signal(SIGTERM, [](int) { gFin = true; });
+  Analizador analizador(cfg);
+  analizador();
+  return 0;
+}
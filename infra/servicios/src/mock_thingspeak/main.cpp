@@ -0,0 +1,219 @@
+// --- THINGSPEAK DE PRUEBA ---
+// servidor local con la API de bulk_update para probar la subida sin tocar el canal real ni gastar mensajes:
+//
+//   POST /channels/<canal>/bulk_update.json   {"write_api_key":"..","updates":[{"created_at":"..","field1":..},..]}
+//     200 {"success":true}   aceptado
+//     401                    clave distinta de --clave
+//     400                    JSON que no se entiende o más de --max-lote filas
+//     429                    menos de --intervalo-s desde la última petición aceptada del canal (como ThingSpeak)
+//     500                    fallo inyectado con probabilidad --fallos
+//   además, con probabilidad --lentas tarda --lenta-s en contestar (pero guarda el lote): si el cliente se cansa antes
+//   y lo reintenta, llegan duplicados, que se cuentan aparte.
+//   GET /stats   las cuentas en JSON (también se imprimen cada --stats-s segundos)
+//
+// Uso: program [--port 18080] [--clave PRUEBA] [--intervalo-s 15] [--max-lote 960] [--fallos 0] [--lentas 0]
+//              [--lenta-s 30] [--stats-s 10]
+#include <HttpServer.h>
+#include <JsonScan.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Config {
+  uint16_t port = 18080;
+  std::string clave = "PRUEBA";
+  double intervaloS = 15, fallos = 0, lentas = 0, lentaS = 30;
+  uint32_t maxLote = 960;
+  uint32_t statsS = 10;
+};
+
+struct Estado {
+  std::mutex mu;
+  std::mt19937 azar{12345};
+  Clock::time_point ultima{};
+  bool hayUltima = false;
+  std::set<std::string> filas; // created_at de lo guardado
+  uint64_t peticiones = 0, aceptadas = 0, limitadas = 0, inyectados = 0, lentas = 0, malas = 0;
+  uint64_t duplicadas = 0, maxLote = 0;
+  std::string primera, ultima_;
+};
+
+std::atomic<bool> gFin{false};
+
+void stats(Estado& e, std::string& out) {
+  char b[512];
+  std::snprintf(b, sizeof(b),
+                "{\"peticiones\":%llu,\"aceptadas\":%llu,\"limitadas\":%llu,\"fallos\":%llu,\"lentas\":%llu,"
+                "\"malas\":%llu,\"filas\":%zu,\"duplicadas\":%llu,\"max_lote\":%llu,\"primera\":\"%s\","
+                "\"ultima\":\"%s\"}",
+                (unsigned long long)e.peticiones, (unsigned long long)e.aceptadas, (unsigned long long)e.limitadas,
+                (unsigned long long)e.inyectados, (unsigned long long)e.lentas, (unsigned long long)e.malas,
+                e.filas.size(), (unsigned long long)e.duplicadas, (unsigned long long)e.maxLote, e.primera.c_str(),
+                e.ultima_.c_str());
+  out = b;
+}
+
+// recorre los objetos de "updates" (planos) y llama a fn(created_at) por cada uno; false si algo no se entiende
+template <class Fn>
+bool updates(std::string_view cuerpo, std::string& clave, Fn&& fn) {
+  const size_t k = cuerpo.find("\"write_api_key\"");
+  const size_t u = cuerpo.find("\"updates\"");
+  if (k == std::string_view::npos || u == std::string_view::npos) return false;
+  const size_t c0 = cuerpo.find('"', cuerpo.find(':', k) + 1);
+  const size_t c1 = cuerpo.find('"', c0 + 1);
+  if (c0 == std::string_view::npos || c1 == std::string_view::npos) return false;
+  clave.assign(cuerpo.substr(c0 + 1, c1 - c0 - 1));
+  size_t i = cuerpo.find('[', u);
+  if (i == std::string_view::npos) return false;
+  for (;;) {
+    const size_t a = cuerpo.find_first_of("{]", i);
+    if (a == std::string_view::npos) return false;
+    if (cuerpo[a] == ']') return true;
+    const size_t b = cuerpo.find('}', a);
+    if (b == std::string_view::npos) return false;
+    std::string_view creada;
+    bool campos = false;
+    if (!json::forEachField(cuerpo.substr(a, b - a + 1), [&](std::string_view kk, std::string_view v) {
+          if (kk == "created_at") creada = v;
+          else if (kk.substr(0, 5) == "field") campos = true;
+        }) ||
+        creada.empty() || !campos) {
+      return false;
+    }
+    fn(creada);
+    i = b + 1;
+  }
+}
+
+void atender(const Config& cfg, Estado& e, const http::Peticion& p, http::Respuesta& r) {
+  if (p.metodo == "GET" && p.ruta == "/stats") {
+    std::lock_guard<std::mutex> l(e.mu);
+    return stats(e, r.cuerpo);
+  }
+  const bool bulk = p.ruta.size() > 27 && p.ruta.substr(0, 10) == "/channels/" &&
+                    p.ruta.substr(p.ruta.size() - 17) == "/bulk_update.json";
+  if (p.metodo != "POST" || !bulk) {
+    r.status = 404;
+    r.cuerpo = "{\"error\":\"Not Found\"}";
+    return;
+  }
+  bool lenta;
+  {
+    std::unique_lock<std::mutex> l(e.mu);
+    e.peticiones++;
+    std::string clave;
+    std::vector<std::string> filas;
+    if (!updates(p.cuerpo, clave, [&](std::string_view c) { filas.emplace_back(c); }) || filas.empty() ||
+        filas.size() > cfg.maxLote) {
+      e.malas++;
+      r.status = 400;
+      r.cuerpo = "{\"error\":\"bad request\"}";
+      return;
+    }
+    if (clave != cfg.clave) {
+      e.malas++;
+      r.status = 401;
+      r.cuerpo = "{\"error\":\"Incorrect API key\"}";
+      return;
+    }
+    const auto ahora = Clock::now();
+    if (e.hayUltima && ahora - e.ultima < std::chrono::milliseconds(int64_t(cfg.intervaloS * 1000))) {
+      e.limitadas++;
+      r.status = 429;
+      r.cuerpo = "{\"error\":\"Too Many Requests\"}";
+      return;
+    }
+    std::uniform_real_distribution<double> u(0, 1);
+    if (u(e.azar) < cfg.fallos) {
+      e.inyectados++;
+      r.status = 500;
+      r.cuerpo = "{\"error\":\"Internal Server Error\"}";
+      return;
+    }
+    lenta = u(e.azar) < cfg.lentas;
+    e.lentas += lenta;
+    e.hayUltima = true;
+    e.ultima = ahora;
+    e.aceptadas++;
+    e.maxLote = std::max<uint64_t>(e.maxLote, filas.size());
+    for (std::string& f : filas) {
+      if (e.primera.empty() || f < e.primera) e.primera = f;
+      if (f > e.ultima_) e.ultima_ = f;
+      if (!e.filas.insert(std::move(f)).second) e.duplicadas++;
+    }
+  }
+  if (lenta) std::this_thread::sleep_for(std::chrono::milliseconds(int64_t(cfg.lentaS * 1000)));
+  r.cuerpo = "{\"success\":true}";
+}
+
+bool leerArgs(int argc, char** argv, Config& c) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string k = argv[i];
+    const char* v = argv[i + 1];
+    if (k == "--port") c.port = uint16_t(std::atoi(v));
+    else if (k == "--clave") c.clave = v;
+    else if (k == "--intervalo-s") c.intervaloS = std::atof(v);
+    else if (k == "--max-lote") c.maxLote = uint32_t(std::max(1, std::atoi(v)));
+    else if (k == "--fallos") c.fallos = std::atof(v);
+    else if (k == "--lentas") c.lentas = std::atof(v);
+    else if (k == "--lenta-s") c.lentaS = std::atof(v);
+    else if (k == "--stats-s") c.statsS = uint32_t(std::atoi(v));
+    else return false;
+  }
+  return (argc % 2) == 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Config cfg;
+  if (!leerArgs(argc, argv, cfg)) {
+    std::fprintf(stderr, "argumentos no válidos (ver el comentario de src/mock_thingspeak/main.cpp)\n");
+    return 2;
+  }
+  std::signal(SIGINT, [](int) { gFin = true; });
+  std::signal(SIGTERM, [](int) { gFin = true; });
+
+  Estado e;
+  http::Servidor servidor;
+  // dos hilos: una respuesta lenta no deja sin servicio a /stats
+  if (!servidor.listen("127.0.0.1", cfg.port, 2)) return 1;
+  std::printf("thingspeak de prueba en http://127.0.0.1:%u (intervalo %.1f s, fallos %.0f %%, lentas %.0f %%)\n",
+              servidor.port(), cfg.intervaloS, cfg.fallos * 100, cfg.lentas * 100);
+  std::fflush(stdout);
+  std::thread informe([&] {
+    std::string s;
+    auto siguiente = Clock::now() + std::chrono::seconds(cfg.statsS);
+    while (!gFin.load()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      if (!cfg.statsS || Clock::now() < siguiente) continue;
+      siguiente += std::chrono::seconds(cfg.statsS);
+      {
+        std::lock_guard<std::mutex> l(e.mu);
+        stats(e, s);
+      }
+      std::printf("%s\n", s.c_str());
+      std::fflush(stdout);
+    }
+  });
+  servidor.run([&](const http::Peticion& p, http::Respuesta& r) { atender(cfg, e, p, r); }, gFin);
+  informe.join();
+  std::string s;
+  stats(e, s);
+  std::printf("%s\n", s.c_str());
+  return 0;
+}
@@ -0,0 +1,356 @@
+// --- PASARELA DE INGESTA: NORMALIZACIÓN NATIVA DE LA TELEMETRÍA ---
+// sustituye a las funciones *_to_telemetry de Node-RED: se suscribe a los topics crudos de los nodos (dht11, soil,
+//   ldr, mq135, nivel_agua y los lotes binarios +/bin) y publica la telemetría normalizada en
+//   greenhouse/<nodo>/telemetry con el mismo formato ({"ts":..,"type":"..","value":..}), así que lo que hay detrás
+//   (dashboard, Home Assistant, Alexa) no cambia.
+//
+//   - una conexión de entrada: cada mensaje se marca con la hora de recepción (el ts de la telemetría, como el
+//     Date.now() de Node-RED) y se copia a la cola del hilo que le toca
+//   - el reparto es por nodo de destino (ingesta::claveNodo): los mensajes de un mismo nodo los procesa siempre el mismo
+//     hilo, en orden de llegada
+//   - cada hilo normaliza sin reservar memoria (Normalizer.h) y publica por su propia conexión, juntando en un send()
+//     todo lo que haya sacado de la cola en esa vuelta
+//   - los valores fuera de rango o mal formados se descartan y se cuentan; cada --stats-s segundos se imprimen las
+//     cuentas y se publican en pasarela/stats
+//   - si una cola se llena, la entrada espera (no descarta): el atasco se nota en el socket y lo absorbe el broker.
+//     Solo al cerrar se descarta lo que no cabe ("perdidos")
+//
+// Uso: program [--host 127.0.0.1] [--port 1884] [--hilos N] [--stats-s 10] [--qos-salida 0]
+#include <MqttClient.h>
+#include <Normalizer.h>
+#include <SpscRing.h>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint64_t nowUs() {
+  return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now().time_since_epoch()).count());
+}
+
+uint64_t wallMs() {
+  using namespace std::chrono;
+  return uint64_t(duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count());
+}
+
+// --- CONFIGURACIÓN ---
+struct Config {
+  std::string host = "127.0.0.1";
+  uint16_t port = 1884; // el puerto que publica docker-compose
+  uint32_t hilos = std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+  uint32_t statsS = 10;
+  uint8_t qosSalida = 0; // como los nodos MQTT out de Node-RED
+};
+
+// topics crudos; los nodos publican con QoS 0, la suscripción con QoS 1 no añade nada salvo los PUBACK
+constexpr const char* kEntradas[] = {"dht11", "soil", "ldr", "mq135", "nivel_agua", "+/bin"};
+
+// --- MENSAJES ENTRE HILOS ---
+// el topic y el payload van seguidos en data; lo que no quepa (ningún nodo publica tanto) se descarta al entrar
+struct Mensaje {
+  uint64_t ts;    // hora de recepción, ms desde 1970
+  uint64_t recUs; // la misma en el reloj monótono, para medir cuánto tarda en salir
+  uint16_t topicLen, payloadLen;
+  char data[496];
+};
+
+// histograma de latencias en potencias de 2 de microsegundos: lo escribe un hilo, lo lee el de las estadísticas
+struct Latencias {
+  std::array<std::atomic<uint64_t>, 32> cubos{};
+
+  void anotar(uint64_t us) {
+    int b = 0;
+    while (us >> b && b < 31) b++;
+    cubos[size_t(b)].fetch_add(1, std::memory_order_relaxed);
+  }
+};
+
+// percentil (cota superior del cubo) de la diferencia entre dos fotos del histograma
+uint64_t percentil(const std::array<uint64_t, 32>& h, double p) {
+  uint64_t total = 0;
+  for (uint64_t c : h) total += c;
+  if (!total) return 0;
+  const uint64_t objetivo = uint64_t(p / 100.0 * double(total));
+  uint64_t acum = 0;
+  for (size_t b = 0; b < h.size(); b++) {
+    acum += h[b];
+    if (acum > objetivo) return b ? (uint64_t(1) << b) - 1 : 0;
+  }
+  return ~uint64_t(0);
+}
+
+struct Cuentas {
+  std::atomic<uint64_t> entrada{0}, salida{0}, invalidos{0}, fueraDeRango{0}, desconocidos{0};
+};
+
+std::atomic<bool> gFin{false};
+
+// --- HILOS DE NORMALIZACIÓN ---
+class Trabajador {
+ public:
+  Trabajador(const Config& cfg, uint32_t id) : cfg_(cfg), id_(id), despertador_(eventfd(0, EFD_NONBLOCK)) {}
+  ~Trabajador() { ::close(despertador_); }
+
+  void arrancar() { hilo_ = std::thread([this] { (*this)(); }); }
+  void unir() {
+    if (hilo_.joinable()) hilo_.join();
+  }
+
+  // la entrada llama a avisar() tras cada push(): solo escribe en el eventfd si el hilo está dormido
+  void avisar() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (dormido_.load(std::memory_order_relaxed)) {
+      const uint64_t uno = 1;
+      if (write(despertador_, &uno, sizeof(uno)) < 0) return; // ya tenía un aviso pendiente
+    }
+  }
+
+  SpscRing<Mensaje, 4096> cola;
+  Cuentas cuentas;
+  Latencias latencias;
+
+ private:
+  // cola vacía: dormimos hasta que llegue algo a la cola o a la conexión (o 1 s, para el keepalive)
+  void dormir() {
+    dormido_.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!cola.front()) {
+      pollfd fds[2] = {{cli_.fd(), POLLIN, 0}, {despertador_, POLLIN, 0}};
+      ::poll(fds, 2, 1000);
+      uint64_t avisos;
+      if ((fds[1].revents & POLLIN) && read(despertador_, &avisos, sizeof(avisos)) < 0) avisos = 0;
+    }
+    dormido_.store(false, std::memory_order_relaxed);
+  }
+
+  void conectar() {
+    char cid[48];
+    std::snprintf(cid, sizeof(cid), "pasarela-%d-out%u", int(getpid()), id_);
+    for (uint32_t espera = 1000; !gFin.load() && !cli_.connect(cfg_.host.c_str(), cfg_.port, cid);
+         espera = std::min(espera * 2, 30000u)) {
+      std::fprintf(stderr, "salida %u: no se puede conectar a %s:%u, reintento en %u ms\n", id_, cfg_.host.c_str(),
+                   cfg_.port, espera);
+      std::this_thread::sleep_for(std::chrono::milliseconds(espera));
+    }
+  }
+
+  void operator()() {
+    conectar();
+    const auto publicar = [this](std::string_view topic, std::string_view json) {
+      cli_.publish(topic, json, cfg_.qosSalida);
+      cuentas.salida.fetch_add(1, std::memory_order_relaxed);
+    };
+    std::vector<uint64_t> recibidos;
+    recibidos.reserve(256);
+    while (!gFin.load(std::memory_order_relaxed)) {
+      // sacamos un tramo de la cola y lo mandamos todo junto
+      recibidos.clear();
+      while (recibidos.size() < 256) {
+        const Mensaje* m = cola.front();
+        if (!m) break;
+        const std::string_view topic(m->data, m->topicLen);
+        const std::string_view payload(m->data + m->topicLen, m->payloadLen);
+        switch (ingesta::normalize(topic, payload, m->ts, publicar)) {
+          case ingesta::Resultado::Ok: break;
+          case ingesta::Resultado::Invalido: cuentas.invalidos.fetch_add(1, std::memory_order_relaxed); break;
+          case ingesta::Resultado::FueraDeRango: cuentas.fueraDeRango.fetch_add(1, std::memory_order_relaxed); break;
+          case ingesta::Resultado::Desconocido: cuentas.desconocidos.fetch_add(1, std::memory_order_relaxed); break;
+        }
+        recibidos.push_back(m->recUs);
+        cola.pop();
+      }
+      if (!recibidos.empty()) {
+        if (!cli_.flush()) {
+          // lo de este tramo se pierde con la conexión, igual que con Node-RED (QoS 0)
+          std::fprintf(stderr, "salida %u: conexión perdida\n", id_);
+          conectar();
+          continue;
+        }
+        const uint64_t ahora = nowUs();
+        for (uint64_t r : recibidos) latencias.anotar(ahora - r);
+        continue;
+      }
+      dormir();
+      if (!cli_.poll(0, [](const mqtt::PublishView&) {})) {
+        std::fprintf(stderr, "salida %u: conexión perdida\n", id_);
+        conectar();
+      }
+    }
+    cli_.disconnect();
+  }
+
+  const Config& cfg_;
+  const uint32_t id_;
+  MqttClient cli_;
+  std::thread hilo_;
+  const int despertador_;
+  std::atomic<bool> dormido_{false};
+};
+
+// --- ENTRADA ---
+class Entrada {
+ public:
+  Entrada(const Config& cfg, std::vector<std::unique_ptr<Trabajador>>& trabajadores)
+      : cfg_(cfg), trabajadores_(trabajadores) {}
+
+  bool conectar() {
+    char cid[48];
+    std::snprintf(cid, sizeof(cid), "pasarela-%d-in", int(getpid()));
+    if (!cli_.connect(cfg_.host.c_str(), cfg_.port, cid)) return false;
+    for (const char* t : kEntradas) {
+      if (!cli_.subscribe(t, 1)) return false;
+    }
+    return true;
+  }
+
+  void operator()() {
+    uint32_t espera = 1000;
+    while (!gFin.load() && !conectar()) {
+      std::fprintf(stderr, "entrada: no se puede conectar a %s:%u, reintento en %u ms\n", cfg_.host.c_str(), cfg_.port,
+                   espera);
+      std::this_thread::sleep_for(std::chrono::milliseconds(espera));
+      espera = std::min(espera * 2, 30000u);
+    }
+    std::printf("pasarela: %s:%u, %zu hilos de normalización\n", cfg_.host.c_str(), cfg_.port, trabajadores_.size());
+    uint64_t siguiente = nowUs() + uint64_t(cfg_.statsS) * 1000000;
+    while (!gFin.load()) {
+      if (!cli_.poll(100, [this](const mqtt::PublishView& p) { repartir(p); })) {
+        std::fprintf(stderr, "entrada: conexión perdida; reconectando\n");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        conectar();
+        continue;
+      }
+      if (cfg_.statsS && nowUs() >= siguiente) {
+        siguiente += uint64_t(cfg_.statsS) * 1000000;
+        estadisticas();
+      }
+    }
+    estadisticas();
+    cli_.disconnect();
+  }
+
+ private:
+  void repartir(const mqtt::PublishView& p) {
+    const uint64_t ts = wallMs();
+    const uint64_t us = nowUs();
+    if (p.topic.size() + p.payload.size() > sizeof(Mensaje::data)) {
+      grandes_++;
+      return;
+    }
+    const uint32_t clave = ingesta::claveNodo(p.topic, p.payload);
+    Trabajador& t = *trabajadores_[clave % trabajadores_.size()];
+    Mensaje* m = t.cola.prepare();
+    if (!m) {
+      // cola llena: esperamos a que el hilo avance (sin leer más del socket). Al cerrar, los hilos ya no vacían sus
+      //   colas: lo que queda se da por perdido para que SIGINT/SIGTERM no se quede aquí para siempre
+      esperas_++;
+      while (!(m = t.cola.prepare())) {
+        if (gFin.load(std::memory_order_relaxed)) {
+          perdidos_++;
+          return;
+        }
+        std::this_thread::yield();
+      }
+    }
+    m->ts = ts;
+    m->recUs = us;
+    m->topicLen = uint16_t(p.topic.size());
+    m->payloadLen = uint16_t(p.payload.size());
+    std::memcpy(m->data, p.topic.data(), p.topic.size());
+    std::memcpy(m->data + p.topic.size(), p.payload.data(), p.payload.size());
+    t.cola.push();
+    t.avisar();
+    t.cuentas.entrada.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void estadisticas() {
+    uint64_t entrada = 0, salida = 0, invalidos = 0, fuera = 0, desconocidos = 0;
+    std::array<uint64_t, 32> hist{};
+    for (const auto& t : trabajadores_) {
+      entrada += t->cuentas.entrada.load();
+      salida += t->cuentas.salida.load();
+      invalidos += t->cuentas.invalidos.load();
+      fuera += t->cuentas.fueraDeRango.load();
+      desconocidos += t->cuentas.desconocidos.load();
+      for (size_t b = 0; b < hist.size(); b++) hist[b] += t->latencias.cubos[b].load();
+    }
+    std::array<uint64_t, 32> intervalo;
+    for (size_t b = 0; b < hist.size(); b++) intervalo[b] = hist[b] - histAntes_[b];
+    histAntes_ = hist;
+    const double segundos = double(std::max(1u, cfg_.statsS));
+    const double entradaS = double(entrada - entradaAntes_) / segundos;
+    const double salidaS = double(salida - salidaAntes_) / segundos;
+    entradaAntes_ = entrada;
+    salidaAntes_ = salida;
+
+    char json[384];
+    const int n = std::snprintf(
+        json, sizeof(json),
+        "{\"entrada\":%llu,\"salida\":%llu,\"invalidos\":%llu,\"fuera_de_rango\":%llu,\"desconocidos\":%llu,"
+        "\"grandes\":%llu,\"esperas\":%llu,\"perdidos\":%llu,\"entrada_s\":%.0f,\"salida_s\":%.0f,"
+        "\"lat_p50_us\":%llu,\"lat_p99_us\":%llu}",
+        (unsigned long long)entrada, (unsigned long long)salida, (unsigned long long)invalidos,
+        (unsigned long long)fuera, (unsigned long long)desconocidos, (unsigned long long)grandes_,
+        (unsigned long long)esperas_, (unsigned long long)perdidos_, entradaS, salidaS,
+        (unsigned long long)percentil(intervalo, 50), (unsigned long long)percentil(intervalo, 99));
+    std::printf("%s\n", json);
+    std::fflush(stdout);
+    if (n > 0 && size_t(n) < sizeof(json)) cli_.publish("pasarela/stats", std::string_view(json, size_t(n)));
+  }
+
+  const Config& cfg_;
+  std::vector<std::unique_ptr<Trabajador>>& trabajadores_;
+  MqttClient cli_;
+  uint64_t grandes_ = 0, esperas_ = 0, perdidos_ = 0;
+  uint64_t entradaAntes_ = 0, salidaAntes_ = 0;
+  std::array<uint64_t, 32> histAntes_{};
+};
+
+bool leerArgs(int argc, char** argv, Config& c) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string k = argv[i];
+    const char* v = argv[i + 1];
+    if (k == "--host") c.host = v;
+    else if (k == "--port") c.port = uint16_t(std::atoi(v));
+    else if (k == "--hilos") c.hilos = uint32_t(std::max(1, std::atoi(v)));
+    else if (k == "--stats-s") c.statsS = uint32_t(std::atoi(v));
+    else if (k == "--qos-salida") c.qosSalida = uint8_t(std::atoi(v) ? 1 : 0);
+    else return false;
+  }
+  return (argc % 2) == 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Config cfg;
+  if (!leerArgs(argc, argv, cfg)) {
+    std::fprintf(stderr, "argumentos no válidos (ver el comentario de src/pasarela/main.cpp)\n");
+    return 2;
+  }
+  std::signal(SIGINT, [](int) { gFin = true; });
+  std::signal(SIGTERM, [](int) { gFin = true; });
+
+  std::vector<std::unique_ptr<Trabajador>> trabajadores;
+  for (uint32_t i = 0; i < cfg.hilos; i++) trabajadores.push_back(std::make_unique<Trabajador>(cfg, i));
+  for (auto& t : trabajadores) t->arrancar();
+  Entrada(cfg, trabajadores)();
+  for (auto& t : trabajadores) t->unir();
+  return 0;
+}
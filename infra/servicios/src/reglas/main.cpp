@@ -0,0 +1,594 @@
+// --- COMPILADOR DE REGLAS PARA LOS NODOS ---
+// las reglas de riego y de luz que hoy decide "Reglas Auto" en Node-RED, escritas en texto y compiladas al programa
+//   que ejecutan los nodos con actuadores (formato e intérprete en ../sensores/common/lib/Reglas/Reglas.h). Con
+//   --publicar 1 lo manda con retain a invernadero/rules/<nodo>: el nodo lo guarda en flash y lo evalúa con cada
+//   lectura, y contesta en invernadero/rules/<nodo>/estado con el crc que ha cargado.
+//
+// Una regla por línea (# comenta hasta el final de la línea):
+//   riego: encender si humedad < 30; apagar si humedad >= 50; min_encendido 60; min_apagado 300; max_encendido 600
+//   luz: encender si luz < 24 y ventana 06:00-22:00; apagar si luz > 40 o no ventana 06:00-22:00
+//
+//   - el dispositivo es uno de kActuators del driver; "encender si" y "apagar si" son obligatorios
+//   - condiciones: comparaciones (< <= > >= == !=), y, o, no, paréntesis. Los campos son los de la lectura del nodo en
+//     sus unidades (humedad 0-100 %, luz 0-100 %, temperatura y humedad del dht11 en grados y %, con decimales)
+//   - hora: el minuto del día (hora >= 07:30); ventana HH:MM-HH:MM: dentro de ese horario (puede cruzar la
+//     medianoche). Sin hora por SNTP el nodo no cumple ninguna ventana
+//   - encendido <dispositivo>, desde <dispositivo>: si está encendido y segundos desde su último cambio
+//   - min_encendido, min_apagado, max_encendido: segundos (0 = sin límite)
+//
+// Con --simular ejecuta el programa con el mismo intérprete que el nodo sobre una traza CSV "segundos,campo[,campo]"
+//   (los valores en las unidades de arriba), imprime cada cambio y mide lo que cuesta evaluar una lectura.
+//
+// Uso: program --nodo soil --reglas riego.txt [--hex 1] [--publicar 1] [--borrar 1] [--host 127.0.0.1]
+//              [--port 1884] [--simular traza.csv] [--hora 06:00]
+#include <MqttClient.h>
+#include <Reglas.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Config {
+  std::string host = "127.0.0.1";
+  uint16_t port = 1884;
+  std::string nodo, reglas, simular;
+  bool hex = false, publicar = false, borrar = false;
+  int horaInicio = -1; // minuto del día de la primera fila de la traza (-1 = sin hora)
+};
+
+// --- NODOS ---
+// los campos de Driver::values() y los kActuators de los drivers de infra/sensores
+struct Campo {
+  const char* nombre;
+  int32_t escala; // unidades del nodo por unidad del texto (el dht11 va en centésimas)
+};
+struct Nodo {
+  const char* topic;
+  std::vector<Campo> campos;
+  std::vector<const char*> dispositivos;
+  std::vector<uint32_t> maxOnS; // maxOnMs del actuador, que el nodo aplica aunque la regla no lo diga
+};
+const Nodo kNodos[] = {
+    {"soil", {{"humedad", 1}}, {"riego"}, {600}},
+    {"ldr", {{"luz", 1}}, {"luz"}, {0}},
+    {"dht11", {{"temperatura", 100}, {"humedad", 100}}, {"ventilador"}, {0}},
+};
+
+const Nodo* buscarNodo(const std::string& topic) {
+  for (const Nodo& n : kNodos) {
+    if (topic == n.topic) return &n;
+  }
+  return nullptr;
+}
+
+int indice(const std::vector<const char*>& v, const std::string& s) {
+  for (size_t i = 0; i < v.size(); i++) {
+    if (s == v[i]) return int(i);
+  }
+  return -1;
+}
+
+// --- COMPILADOR ---
+void put16(std::vector<uint8_t>& o, uint32_t v) {
+  o.push_back(uint8_t(v));
+  o.push_back(uint8_t(v >> 8));
+}
+void put32(std::vector<uint8_t>& o, uint32_t v) {
+  put16(o, v);
+  put16(o, v >> 16);
+}
+
+// descenso recursivo sobre una condición; emite en postfijo
+class Expr {
+ public:
+  Expr(std::string s, const Nodo& n) : s_(std::move(s)), n_(n) {}
+
+  bool compilar(std::vector<uint8_t>& out, std::string& err) {
+    out_ = &out;
+    err_ = &err;
+    siguiente();
+    if (!o()) return false;
+    if (tok_ != Fin) return fallo("sobra '" + txt_ + "'");
+    return true;
+  }
+
+ private:
+  enum Tok { Fin, Palabra, Numero, Hora, Operador, Abre, Cierra, Guion, Malo };
+
+  // un operando de una comparación: código ya emitido o número pendiente (se escala con el campo del otro lado)
+  struct Operando {
+    bool numero = false;
+    double valor = 0;
+    int32_t escala = 1;
+    std::vector<uint8_t> codigo;
+  };
+
+  void siguiente() {
+    while (p_ < s_.size() && (s_[p_] == ' ' || s_[p_] == '\t')) p_++;
+    txt_.clear();
+    if (p_ >= s_.size()) {
+      tok_ = Fin;
+      return;
+    }
+    const unsigned char c = uint8_t(s_[p_]);
+    if (std::isdigit(c)) {
+      tok_ = Numero;
+      while (p_ < s_.size() && (std::isdigit(uint8_t(s_[p_])) || s_[p_] == '.' || s_[p_] == ':')) {
+        if (s_[p_] == ':') tok_ = Hora;
+        txt_ += s_[p_++];
+      }
+    } else if (std::isalpha(c) || c == '_' || c >= 0x80) {
+      tok_ = Palabra;
+      while (p_ < s_.size() &&
+             (std::isalnum(uint8_t(s_[p_])) || s_[p_] == '_' || uint8_t(s_[p_]) >= 0x80)) {
+        txt_ += s_[p_++];
+      }
+    } else if (c == '<' || c == '>' || c == '=' || c == '!') {
+      tok_ = Operador;
+      txt_ += s_[p_++];
+      if (p_ < s_.size() && s_[p_] == '=') txt_ += s_[p_++];
+    } else {
+      tok_ = c == '(' ? Abre : c == ')' ? Cierra : c == '-' ? Guion : Malo;
+      txt_ += s_[p_++];
+    }
+  }
+
+  bool fallo(const std::string& m) {
+    *err_ = m;
+    return false;
+  }
+
+  // o := y ('o' y)*
+  bool o() {
+    if (!y()) return false;
+    while (tok_ == Palabra && txt_ == "o") {
+      siguiente();
+      if (!y()) return false;
+      out_->push_back(reglas::Or);
+    }
+    return true;
+  }
+
+  // y := no ('y' no)*
+  bool y() {
+    if (!no()) return false;
+    while (tok_ == Palabra && txt_ == "y") {
+      siguiente();
+      if (!no()) return false;
+      out_->push_back(reglas::And);
+    }
+    return true;
+  }
+
+  // no := 'no' no | '(' o ')' | comparación
+  bool no() {
+    if (tok_ == Palabra && txt_ == "no") {
+      siguiente();
+      if (!no()) return false;
+      out_->push_back(reglas::Not);
+      return true;
+    }
+    if (tok_ == Abre) {
+      siguiente();
+      if (!o()) return false;
+      if (tok_ != Cierra) return fallo("falta ')'");
+      siguiente();
+      return true;
+    }
+    return comparacion();
+  }
+
+  // comparación := operando [op operando]; un operando solo (ventana, encendido) es una condición
+  bool comparacion() {
+    Operando a;
+    if (!operando(a)) return false;
+    if (tok_ != Operador) {
+      if (a.numero) return fallo("un número no es una condición");
+      out_->insert(out_->end(), a.codigo.begin(), a.codigo.end());
+      return true;
+    }
+    static const char* const kOps[] = {"<", "<=", ">", ">=", "==", "!="};
+    static const uint8_t kCod[] = {reglas::Lt, reglas::Le, reglas::Gt, reglas::Ge, reglas::Eq, reglas::Ne};
+    int op = -1;
+    for (int i = 0; i < 6; i++) {
+      if (txt_ == kOps[i]) op = i;
+    }
+    if (op < 0) return fallo("operador '" + txt_ + "' no válido");
+    siguiente();
+    Operando b;
+    if (!operando(b)) return false;
+    if (a.numero && b.numero) return fallo("comparación entre dos números");
+    if (!emitir(a, b.escala) || !emitir(b, a.escala)) return false;
+    out_->push_back(kCod[op]);
+    return true;
+  }
+
+  bool emitir(const Operando& x, int32_t escala) {
+    if (!x.numero) {
+      out_->insert(out_->end(), x.codigo.begin(), x.codigo.end());
+      return true;
+    }
+    const double v = std::round(x.valor * escala);
+    if (std::fabs(v) > 2147483647.0) return fallo("número fuera de rango");
+    const int32_t i = int32_t(v);
+    if (i >= -32768 && i <= 32767) {
+      out_->push_back(reglas::Const16);
+      put16(*out_, uint16_t(int16_t(i)));
+    } else {
+      out_->push_back(reglas::Const32);
+      put32(*out_, uint32_t(i));
+    }
+    return true;
+  }
+
+  bool minuto(uint16_t& m) {
+    unsigned h = 0, mm = 0;
+    if (tok_ != Hora || std::sscanf(txt_.c_str(), "%u:%u", &h, &mm) != 2 || h > 23 || mm > 59) {
+      return fallo("hora '" + txt_ + "' no válida (HH:MM)");
+    }
+    m = uint16_t(h * 60 + mm);
+    siguiente();
+    return true;
+  }
+
+  bool operando(Operando& x) {
+    if (tok_ == Numero) {
+      x.numero = true;
+      x.valor = std::atof(txt_.c_str());
+      siguiente();
+      return true;
+    }
+    if (tok_ == Guion) {
+      siguiente();
+      if (tok_ != Numero) return fallo("falta un número después de '-'");
+      x.numero = true;
+      x.valor = -std::atof(txt_.c_str());
+      siguiente();
+      return true;
+    }
+    if (tok_ == Hora) {
+      uint16_t m;
+      if (!minuto(m)) return false;
+      x.numero = true;
+      x.valor = m;
+      return true;
+    }
+    if (tok_ != Palabra) return fallo(tok_ == Fin ? "falta la condición" : "no se entiende '" + txt_ + "'");
+    const std::string w = txt_;
+    siguiente();
+    if (w == "hora") {
+      x.codigo.push_back(reglas::Hora);
+      return true;
+    }
+    if (w == "ventana") {
+      uint16_t desde, hasta;
+      if (!minuto(desde)) return false;
+      if (tok_ != Guion) return fallo("ventana HH:MM-HH:MM");
+      siguiente();
+      if (!minuto(hasta)) return false;
+      x.codigo.push_back(reglas::Ventana);
+      put16(x.codigo, desde);
+      put16(x.codigo, hasta);
+      return true;
+    }
+    if (w == "encendido" || w == "desde") {
+      const int d = tok_ == Palabra ? indice(n_.dispositivos, txt_) : -1;
+      if (d < 0) return fallo("dispositivo '" + txt_ + "' desconocido en " + n_.topic);
+      siguiente();
+      x.codigo.push_back(w == "encendido" ? reglas::Estado : reglas::Desde);
+      x.codigo.push_back(uint8_t(d));
+      return true;
+    }
+    for (size_t i = 0; i < n_.campos.size(); i++) {
+      if (w == n_.campos[i].nombre) {
+        x.codigo.push_back(reglas::Campo);
+        x.codigo.push_back(uint8_t(i));
+        x.escala = n_.campos[i].escala;
+        return true;
+      }
+    }
+    return fallo("campo '" + w + "' desconocido en " + n_.topic);
+  }
+
+  const std::string s_;
+  const Nodo& n_;
+  size_t p_ = 0;
+  Tok tok_ = Fin;
+  std::string txt_;
+  std::vector<uint8_t>* out_ = nullptr;
+  std::string* err_ = nullptr;
+};
+
+std::string recortar(const std::string& s) {
+  const size_t a = s.find_first_not_of(" \t\r");
+  if (a == std::string::npos) return "";
+  return s.substr(a, s.find_last_not_of(" \t\r") - a + 1);
+}
+
+bool segundos(const std::string& v, uint16_t& out) {
+  char* end = nullptr;
+  const long n = std::strtol(v.c_str(), &end, 10);
+  if (v.empty() || *end || n < 0 || n > 65535) return false;
+  out = uint16_t(n);
+  return true;
+}
+
+// una regla: "dispositivo: encender si ...; apagar si ...; min_encendido N; ..."
+bool compilarRegla(const std::string& linea, const Nodo& n, std::vector<uint8_t>& out, std::string& err) {
+  const size_t dos = linea.find(':');
+  if (dos == std::string::npos) {
+    err = "falta 'dispositivo:'";
+    return false;
+  }
+  const std::string disp = recortar(linea.substr(0, dos));
+  const int d = indice(n.dispositivos, disp);
+  if (d < 0) {
+    err = "dispositivo '" + disp + "' desconocido en " + n.topic;
+    return false;
+  }
+  uint16_t minOn = 0, minOff = 0, maxOn = 0;
+  std::vector<uint8_t> on, off;
+  bool hayOn = false, hayOff = false;
+  std::stringstream ss(linea.substr(dos + 1));
+  std::string parte;
+  while (std::getline(ss, parte, ';')) {
+    parte = recortar(parte);
+    if (parte.empty()) continue;
+    const size_t sp = parte.find(' ');
+    const std::string k = parte.substr(0, sp);
+    const std::string v = sp == std::string::npos ? "" : recortar(parte.substr(sp + 1));
+    if (k == "encender" || k == "apagar") {
+      if (v.compare(0, 3, "si ") != 0) {
+        err = "'" + k + " si <condición>'";
+        return false;
+      }
+      Expr e(v.substr(3), n);
+      if (!e.compilar(k == "encender" ? on : off, err)) return false;
+      (k == "encender" ? hayOn : hayOff) = true;
+    } else if (k == "min_encendido" || k == "min_apagado" || k == "max_encendido") {
+      uint16_t& dst = k == "min_encendido" ? minOn : k == "min_apagado" ? minOff : maxOn;
+      if (!segundos(v, dst)) {
+        err = k + ": segundos de 0 a 65535";
+        return false;
+      }
+    } else {
+      err = "no se entiende '" + parte + "'";
+      return false;
+    }
+  }
+  if (!hayOn || !hayOff) {
+    err = "falta 'encender si' o 'apagar si'";
+    return false;
+  }
+  if (on.size() > 255 || off.size() > 255) {
+    err = "condición demasiado larga";
+    return false;
+  }
+  out.push_back(uint8_t(d));
+  out.push_back(0);
+  put16(out, minOn);
+  put16(out, minOff);
+  put16(out, maxOn);
+  out.push_back(uint8_t(on.size()));
+  out.push_back(uint8_t(off.size()));
+  out.insert(out.end(), on.begin(), on.end());
+  out.insert(out.end(), off.begin(), off.end());
+  return true;
+}
+
+bool compilar(const std::string& fichero, const Nodo& n, std::vector<uint8_t>& prog) {
+  std::ifstream in(fichero);
+  if (!in) {
+    std::fprintf(stderr, "no se puede abrir %s\n", fichero.c_str());
+    return false;
+  }
+  prog = {reglas::kMagic, reglas::kVersion, 0, 0};
+  std::string linea;
+  for (int num = 1; std::getline(in, linea); num++) {
+    linea = recortar(linea.substr(0, linea.find('#')));
+    if (linea.empty()) continue;
+    std::string err;
+    if (prog[2] == reglas::kMaxRules) err = "como mucho " + std::to_string(reglas::kMaxRules) + " reglas";
+    if (err.empty() && compilarRegla(linea, n, prog, err)) {
+      prog[2]++;
+      continue;
+    }
+    std::fprintf(stderr, "%s:%d: %s\n", fichero.c_str(), num, err.c_str());
+    return false;
+  }
+  put32(prog, reglas::crc32(prog.data(), prog.size()));
+  // lo que comprobará el nodo
+  reglas::Programa p;
+  const reglas::Error e = p.cargar(prog.data(), prog.size(), uint8_t(n.campos.size()), uint8_t(n.dispositivos.size()));
+  if (e != reglas::Ok) {
+    std::fprintf(stderr, "el programa no es válido para el nodo: %s\n", reglas::nombreError(e));
+    return false;
+  }
+  return true;
+}
+
+// --- SIMULACIÓN ---
+uint64_t nowNs() {
+  using namespace std::chrono;
+  return uint64_t(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count());
+}
+
+struct Fila {
+  uint32_t t;
+  int32_t campos[4];
+};
+
+bool leerTraza(const std::string& fichero, const Nodo& n, std::vector<Fila>& filas) {
+  std::ifstream in(fichero);
+  if (!in) {
+    std::fprintf(stderr, "no se puede abrir %s\n", fichero.c_str());
+    return false;
+  }
+  std::string linea;
+  while (std::getline(in, linea)) {
+    if (linea.empty() || !std::isdigit(uint8_t(linea[0]))) continue; // cabecera y comentarios
+    std::stringstream ss(linea);
+    std::string v;
+    Fila f{};
+    std::getline(ss, v, ',');
+    f.t = uint32_t(std::atol(v.c_str()));
+    size_t i = 0;
+    for (; i < n.campos.size() && std::getline(ss, v, ','); i++) {
+      f.campos[i] = int32_t(std::lround(std::atof(v.c_str()) * n.campos[i].escala));
+    }
+    if (i < n.campos.size()) {
+      std::fprintf(stderr, "%s: faltan campos en '%s'\n", fichero.c_str(), linea.c_str());
+      return false;
+    }
+    filas.push_back(f);
+  }
+  return !filas.empty();
+}
+
+// lo mismo que Rules::evaluate() y Commands en el nodo, con el tiempo de la traza
+void simular(const Config& cfg, const Nodo& n, const std::vector<uint8_t>& prog, const std::vector<Fila>& filas) {
+  reglas::Programa p;
+  p.cargar(prog.data(), prog.size(), uint8_t(n.campos.size()), uint8_t(n.dispositivos.size()));
+  const size_t nd = n.dispositivos.size();
+  std::vector<uint32_t> cambioS(nd, 0), encendidoS(nd, 0), desde(nd);
+  std::vector<uint32_t> cambios(nd, 0);
+  uint8_t on = 0;
+  for (const Fila& f : filas) {
+    for (size_t d = 0; d < nd; d++) {
+      // el máximo del actuador (Salida::aplicar) apaga aunque no haya regla
+      if ((on >> d & 1) && n.maxOnS[d] && f.t - cambioS[d] >= n.maxOnS[d]) {
+        on = uint8_t(on & ~(1u << d));
+        encendidoS[d] += f.t - cambioS[d];
+        cambioS[d] = f.t;
+        std::printf("%7us  %s off (máximo del actuador)\n", f.t, n.dispositivos[d]);
+      }
+      desde[d] = f.t - cambioS[d];
+    }
+    const int16_t minuto = cfg.horaInicio < 0 ? -1 : int16_t((uint32_t(cfg.horaInicio) + f.t / 60) % 1440);
+    reglas::Entorno e{f.campos, minuto, on, desde.data()};
+    for (uint8_t k = 0; k < p.reglas(); k++) {
+      const reglas::Regla& r = p.regla(k);
+      const int8_t a = reglas::decidir(r, e);
+      if (a < 0) continue;
+      const uint8_t d = r.dispositivo;
+      if (!a) encendidoS[d] += f.t - cambioS[d];
+      on = uint8_t(a ? on | (1u << d) : on & ~(1u << d));
+      e.encendidos = on;
+      cambioS[d] = f.t;
+      desde[d] = 0;
+      cambios[d]++;
+      std::printf("%7us  %s %s (regla %u)", f.t, n.dispositivos[d], a ? "on" : "off", k);
+      for (size_t i = 0; i < n.campos.size(); i++) {
+        std::printf("  %s=%.2f", n.campos[i].nombre, double(f.campos[i]) / n.campos[i].escala);
+      }
+      if (minuto >= 0) std::printf("  %02d:%02d", minuto / 60, minuto % 60);
+      std::printf("\n");
+    }
+  }
+  const uint32_t fin = filas.back().t;
+  for (size_t d = 0; d < nd; d++) {
+    if (on >> d & 1) encendidoS[d] += fin - cambioS[d];
+    std::printf("%s: %u cambios por las reglas, encendido %u s de %u s\n", n.dispositivos[d], cambios[d], encendidoS[d], fin);
+  }
+
+  // coste de evaluar el programa con una lectura, con el estado congelado (todas las condiciones se evalúan)
+  constexpr uint32_t kVueltas = 2000000;
+  std::vector<uint32_t> quieto(nd, 1u << 20);
+  volatile int32_t sumidero = 0;
+  const uint64_t t0 = nowNs();
+  for (uint32_t i = 0; i < kVueltas; i++) {
+    const Fila& f = filas[i % filas.size()];
+    reglas::Entorno e{f.campos, int16_t(i % 1440), uint8_t(i & 1 ? (1u << nd) - 1 : 0), quieto.data()};
+    for (uint8_t k = 0; k < p.reglas(); k++) sumidero = sumidero + reglas::decidir(p.regla(k), e);
+  }
+  std::printf("evaluación de %u reglas: %.1f ns por lectura\n", p.reglas(), double(nowNs() - t0) / kVueltas);
+}
+
+// --- PUBLICACIÓN ---
+bool publicar(const Config& cfg, const std::string& payload) {
+  MqttClient mqtt;
+  if (!mqtt.connect(cfg.host.c_str(), cfg.port, "reglas-" + cfg.nodo)) {
+    std::fprintf(stderr, "no se puede conectar al broker %s:%u\n", cfg.host.c_str(), cfg.port);
+    return false;
+  }
+  const std::string topic = "invernadero/rules/" + cfg.nodo;
+  // retenido: el nodo lo recibe también si ahora está desconectado, en cuanto se suscriba
+  mqtt.publish(topic, payload, 1, true);
+  bool ok = mqtt.flush();
+  // esperamos el estado del nodo un momento, si está conectado (el retenido anterior llega primero)
+  if (ok && mqtt.subscribe(topic + "/estado", 0)) {
+    const uint64_t limite = net::nowMs() + 2000;
+    while (net::nowMs() < limite && mqtt.poll(100, [](const mqtt::PublishView& p) {
+      std::printf("estado: %.*s\n", int(p.payload.size()), p.payload.data());
+    })) {
+    }
+  }
+  mqtt.disconnect();
+  if (ok) std::printf("%s en %s (%zu bytes)\n", payload.empty() ? "borrado" : "publicado", topic.c_str(), payload.size());
+  return ok;
+}
+
+int minutoDia(const char* v) {
+  unsigned h = 0, m = 0;
+  if (std::sscanf(v, "%u:%u", &h, &m) != 2 || h > 23 || m > 59) return -2;
+  return int(h * 60 + m);
+}
+
+bool leerArgs(int argc, char** argv, Config& c) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string k = argv[i];
+    const char* v = argv[i + 1];
+    if (k == "--host") c.host = v;
+    else if (k == "--port") c.port = uint16_t(std::atoi(v));
+    else if (k == "--nodo") c.nodo = v;
+    else if (k == "--reglas") c.reglas = v;
+    else if (k == "--hex") c.hex = std::atoi(v) != 0;
+    else if (k == "--publicar") c.publicar = std::atoi(v) != 0;
+    else if (k == "--borrar") c.borrar = std::atoi(v) != 0;
+    else if (k == "--simular") c.simular = v;
+    else if (k == "--hora") c.horaInicio = minutoDia(v);
+    else return false;
+  }
+  return (argc % 2) == 1 && !c.nodo.empty() && c.horaInicio > -2 && (c.borrar || !c.reglas.empty());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Config cfg;
+  if (!leerArgs(argc, argv, cfg)) {
+    std::fprintf(stderr, "argumentos no válidos (ver el comentario de src/reglas/main.cpp)\n");
+    return 2;
+  }
+  const Nodo* n = buscarNodo(cfg.nodo);
+  if (!n) {
+    std::fprintf(stderr, "el nodo %s no tiene actuadores (soil, ldr o dht11)\n", cfg.nodo.c_str());
+    return 2;
+  }
+  if (cfg.borrar) return publicar(cfg, "") ? 0 : 1;
+
+  std::vector<uint8_t> prog;
+  if (!compilar(cfg.reglas, *n, prog)) return 1;
+  std::printf("%u reglas, %zu bytes, crc %08x\n", prog[2], prog.size(), reglas::rd32(prog.data() + prog.size() - 4));
+  if (cfg.hex) {
+    for (size_t i = 0; i < prog.size(); i++) std::printf("%02x%s", prog[i], (i + 1) % 16 && i + 1 < prog.size() ? " " : "\n");
+  }
+  if (!cfg.simular.empty()) {
+    std::vector<Fila> filas;
+    if (!leerTraza(cfg.simular, *n, filas)) return 1;
+    simular(cfg, *n, prog, filas);
+  }
+  if (cfg.publicar && !publicar(cfg, std::string(prog.begin(), prog.end()))) return 1;
+  return 0;
+}
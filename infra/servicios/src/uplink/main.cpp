@@ -0,0 +1,305 @@
+// --- SUBIDA A THINGSPEAK POR LOTES ---
+// sustituye a "Format ThingSpeak" + el http request de Node-RED, que hacían un /update por cada fila del join y
+//   chocaban con el límite del canal (una escritura cada 15 s): lo que llegaba entre medias o mientras la red iba lenta
+//   se perdía.
+//
+//   - un hilo lee greenhouse/+/telemetry y junta cada --fila-s segundos una fila con la media de cada campo
+//     (ThingSpeak.h); cada fila cerrada va a una cola en disco (ColaDisco.h) que sobrevive a reinicios
+//   - otro hilo sube la cola con bulk_update.json: cuando la fila más antigua lleva --subida-s esperando o hay un lote
+//     lleno (--max-lote), y nunca más a menudo que --intervalo-s. Solo quita de la cola lo que ThingSpeak ha aceptado.
+//   - si falla (red, plazo, 5xx, 408 o 429), reintenta con espera exponencial hasta 10 min. Un 401, 403 o 404 (clave
+//     o canal mal configurados) también: la cola se conserva y se avisa en cada intento. Solo un 400 o un 413 (lote
+//     que ThingSpeak no acepta nunca) se descarta y se cuenta, para que no bloquee la cola.
+//   - cada --stats-s segundos imprime y publica en uplink/stats la profundidad de la cola, filas por petición y el
+//     retraso de subida
+//
+// ThingSpeak acepta HTTP en claro en el puerto 80; este cliente no tiene TLS. La clave de escritura se lee de --clave
+//   o de la variable THINGSPEAK_WRITE_KEY.
+//
+// Uso: program --canal 123456 [--clave XXXX] [--host 127.0.0.1] [--port 1884] [--ts-host api.thingspeak.com]
+//              [--ts-port 80] [--dir uplink] [--fila-s 15] [--subida-s 60] [--intervalo-s 15] [--max-lote 960]
+//              [--max-filas 500000] [--plazo-s 20] [--stats-s 60]
+#include <ColaDisco.h>
+#include <HttpClient.h>
+#include <JsonScan.h>
+#include <MqttClient.h>
+#include <ThingSpeak.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+uint64_t wallMs() {
+  using namespace std::chrono;
+  return uint64_t(duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count());
+}
+
+struct Config {
+  std::string host = "127.0.0.1";
+  uint16_t port = 1884; // el puerto que publica docker-compose
+  std::string tsHost = "api.thingspeak.com";
+  uint16_t tsPort = 80;
+  std::string canal, clave;
+  std::string dir = "uplink";
+  double filaS = 15, subidaS = 60, intervaloS = thingspeak::kIntervaloMinMs / 1000.0, plazoS = 20;
+  uint32_t maxLote = thingspeak::kMaxLote;
+  uint64_t maxFilas = 500000; // ~87 días a una fila cada 15 s, 40 MB
+  uint32_t statsS = 60;
+};
+
+std::atomic<bool> gFin{false};
+
+// --- ESTADO COMPARTIDO ---
+struct Metricas {
+  std::atomic<uint64_t> filas{0}, peticiones{0}, fallos{0}, rechazadas{0}, subidas{0};
+  std::atomic<uint64_t> configuracion{0}; // respuestas 401/403/404: clave o canal mal
+  std::atomic<uint64_t> ultimoLote{0}, ultimoRetrasoMs{0};
+};
+
+struct Compartido {
+  std::mutex mu;
+  ColaDisco<thingspeak::Fila> cola; // con mu
+  Metricas m;
+};
+
+// --- SUBIDA ---
+class Subida {
+ public:
+  Subida(const Config& cfg, Compartido& c) : cfg_(cfg), c_(c), azar_(std::random_device{}()) {}
+
+  void operator()() {
+    using Clock = std::chrono::steady_clock;
+    const std::string ruta = "/channels/" + cfg_.canal + "/bulk_update.json";
+    auto proxima = Clock::now();
+    uint32_t seguidos = 0; // fallos seguidos
+    std::vector<thingspeak::Fila> lote;
+    std::string cuerpo;
+    while (!gFin.load()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(200));
+      if (Clock::now() < proxima || !toca()) continue;
+      uint64_t desde;
+      {
+        std::lock_guard<std::mutex> l(c_.mu);
+        c_.cola.front(cfg_.maxLote, lote, &desde);
+      }
+      if (lote.empty()) continue;
+      thingspeak::bulkJson(cfg_.clave, lote.data(), lote.size(), cuerpo);
+      const http::Resultado r = http::peticion(cfg_.tsHost, cfg_.tsPort, "POST", ruta, "application/json", cuerpo,
+                                               int(cfg_.plazoS * 1000));
+      c_.m.peticiones++;
+      proxima = Clock::now() + std::chrono::milliseconds(int64_t(cfg_.intervaloS * 1000));
+      if (r.status == 200 || r.status == 202) {
+        quitar(desde, lote.size());
+        c_.m.subidas += lote.size();
+        c_.m.ultimoLote = lote.size();
+        c_.m.ultimoRetrasoMs = wallMs() - uint64_t(lote.front().ts);
+        seguidos = 0;
+        continue;
+      }
+      // 400 y 413: el lote está mal y no se aceptará nunca; se descarta para que no bloquee la cola
+      if (r.status == 400 || r.status == 413) {
+        std::fprintf(stderr, "subida: %d, se descartan %zu filas: %.200s\n", r.status, lote.size(), r.cuerpo.c_str());
+        quitar(desde, lote.size());
+        c_.m.rechazadas += lote.size();
+        continue;
+      }
+      // 401, 403 y 404: clave o canal mal configurados. El lote vale; se queda en la cola hasta que se corrija
+      if (r.status == 401 || r.status == 403 || r.status == 404) {
+        c_.m.configuracion++;
+        std::fprintf(stderr,
+                     "subida: HTTP %d: REVISAR --clave (o THINGSPEAK_WRITE_KEY) Y --canal %s; la cola se conserva "
+                     "(%zu filas en este lote)\n",
+                     r.status, cfg_.canal.c_str(), lote.size());
+      }
+      // reintento con espera exponencial (y algo de azar para no sincronizarse con otros clientes)
+      c_.m.fallos++;
+      seguidos = std::min(seguidos + 1, 16u);
+      const double espera = std::min(cfg_.intervaloS * double(1u << seguidos), 600.0) *
+                            std::uniform_real_distribution<double>(1.0, 1.2)(azar_);
+      proxima = Clock::now() + std::chrono::milliseconds(int64_t(espera * 1000));
+      std::fprintf(stderr, "subida: %s, reintento en %.0f s\n",
+                   r.status ? ("HTTP " + std::to_string(r.status)).c_str() : "sin respuesta", espera);
+    }
+  }
+
+ private:
+  // hay un lote lleno o la fila más antigua ya ha esperado bastante
+  bool toca() {
+    std::vector<thingspeak::Fila> primera;
+    std::lock_guard<std::mutex> l(c_.mu);
+    if (c_.cola.size() >= cfg_.maxLote) return true;
+    if (!c_.cola.front(1, primera)) return false;
+    const int64_t cerrada = primera[0].ts + int64_t(cfg_.filaS * 1000);
+    return int64_t(wallMs()) - cerrada >= int64_t(cfg_.subidaS * 1000);
+  }
+
+  void quitar(uint64_t desde, size_t n) {
+    std::lock_guard<std::mutex> l(c_.mu);
+    if (!c_.cola.pop(desde, n)) std::fprintf(stderr, "subida: no se puede guardar la posición de la cola\n");
+  }
+
+  const Config& cfg_;
+  Compartido& c_;
+  std::mt19937 azar_;
+};
+
+// --- ENTRADA Y ESTADÍSTICAS ---
+class Entrada {
+ public:
+  Entrada(const Config& cfg, Compartido& c) : cfg_(cfg), c_(c), agregador_(int64_t(cfg.filaS * 1000)) {}
+
+  void operator()() {
+    conectar();
+    uint64_t siguiente = wallMs() + uint64_t(cfg_.statsS) * 1000;
+    while (!gFin.load()) {
+      if (!cli_.poll(200, [this](const mqtt::PublishView& p) { guardar(p); })) {
+        std::fprintf(stderr, "entrada: conexión perdida; reconectando\n");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        conectar();
+      }
+      thingspeak::Fila f;
+      if (agregador_.cerrarVencida(int64_t(wallMs()), 2000, f)) encolar(f);
+      if (cfg_.statsS && wallMs() >= siguiente) {
+        siguiente += uint64_t(cfg_.statsS) * 1000;
+        estadisticas();
+      }
+    }
+    // la fila a medias también se guarda: se sube en el siguiente arranque
+    thingspeak::Fila f;
+    if (agregador_.cerrarVencida(INT64_MAX / 2, 0, f)) encolar(f);
+    estadisticas();
+    cli_.disconnect();
+  }
+
+ private:
+  void conectar() {
+    char cid[48];
+    std::snprintf(cid, sizeof(cid), "uplink-%d", int(getpid()));
+    for (uint32_t espera = 1000; !gFin.load(); espera = std::min(espera * 2, 30000u)) {
+      if (cli_.connect(cfg_.host.c_str(), cfg_.port, cid) && cli_.subscribe("greenhouse/+/telemetry", 0)) return;
+      std::fprintf(stderr, "entrada: no se puede conectar a %s:%u, reintento en %u ms\n", cfg_.host.c_str(), cfg_.port,
+                   espera);
+      std::this_thread::sleep_for(std::chrono::milliseconds(espera));
+    }
+  }
+
+  void guardar(const mqtt::PublishView& p) {
+    std::string_view type;
+    double ts = 0, value = 0;
+    bool hayValor = false;
+    json::forEachField(p.payload, [&](std::string_view k, std::string_view v) {
+      if (k == "type") type = v;
+      else if (k == "ts") json::toDouble(v, ts);
+      else if (k == "value") hayValor = json::toDouble(v, value);
+    });
+    const int campo = thingspeak::campoDe(type);
+    if (!hayValor || campo < 0) return;
+    thingspeak::Fila f;
+    if (agregador_.add(ts > 0 ? int64_t(ts) : int64_t(wallMs()), campo, value, f)) encolar(f);
+  }
+
+  void encolar(const thingspeak::Fila& f) {
+    std::lock_guard<std::mutex> l(c_.mu);
+    if (!c_.cola.push(f)) std::fprintf(stderr, "entrada: no se puede escribir en la cola\n");
+    c_.m.filas++;
+  }
+
+  void estadisticas() {
+    uint64_t cola, descartadas;
+    int64_t retraso = 0;
+    {
+      std::vector<thingspeak::Fila> primera;
+      std::lock_guard<std::mutex> l(c_.mu);
+      cola = c_.cola.size();
+      descartadas = c_.cola.descartados();
+      if (c_.cola.front(1, primera)) retraso = int64_t(wallMs()) - primera[0].ts;
+    }
+    const Metricas& m = c_.m;
+    const uint64_t peticionesOk = m.peticiones.load() - m.fallos.load();
+    char json[384];
+    const int n = std::snprintf(
+        json, sizeof(json),
+        "{\"cola\":%llu,\"filas\":%llu,\"subidas\":%llu,\"peticiones\":%llu,\"fallos\":%llu,\"rechazadas\":%llu,"
+        "\"configuracion\":%llu,\"descartadas\":%llu,\"filas_por_peticion\":%.1f,\"ultimo_lote\":%llu,\"retraso_cola_s\":%.1f,"
+        "\"retraso_ultima_subida_s\":%.1f}",
+        (unsigned long long)cola, (unsigned long long)m.filas.load(), (unsigned long long)m.subidas.load(),
+        (unsigned long long)m.peticiones.load(), (unsigned long long)m.fallos.load(),
+        (unsigned long long)m.rechazadas.load(), (unsigned long long)m.configuracion.load(),
+        (unsigned long long)descartadas,
+        peticionesOk ? double(m.subidas.load() + m.rechazadas.load()) / double(peticionesOk) : 0.0,
+        (unsigned long long)m.ultimoLote.load(), double(retraso) / 1000, double(m.ultimoRetrasoMs.load()) / 1000);
+    std::printf("%s\n", json);
+    std::fflush(stdout);
+    if (n > 0 && size_t(n) < sizeof(json)) {
+      cli_.publish("uplink/stats", std::string_view(json, size_t(n)));
+      cli_.flush();
+    }
+  }
+
+  const Config& cfg_;
+  Compartido& c_;
+  MqttClient cli_;
+  thingspeak::Agregador agregador_;
+};
+
+bool leerArgs(int argc, char** argv, Config& c) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string k = argv[i];
+    const char* v = argv[i + 1];
+    if (k == "--host") c.host = v;
+    else if (k == "--port") c.port = uint16_t(std::atoi(v));
+    else if (k == "--ts-host") c.tsHost = v;
+    else if (k == "--ts-port") c.tsPort = uint16_t(std::atoi(v));
+    else if (k == "--canal") c.canal = v;
+    else if (k == "--clave") c.clave = v;
+    else if (k == "--dir") c.dir = v;
+    else if (k == "--fila-s") c.filaS = std::max(1.0, std::atof(v));
+    else if (k == "--subida-s") c.subidaS = std::max(0.0, std::atof(v));
+    else if (k == "--intervalo-s") c.intervaloS = std::max(0.1, std::atof(v));
+    else if (k == "--max-lote") c.maxLote = uint32_t(std::clamp(std::atoi(v), 1, int(thingspeak::kMaxLote)));
+    else if (k == "--max-filas") c.maxFilas = uint64_t(std::max(1, std::atoi(v)));
+    else if (k == "--plazo-s") c.plazoS = std::max(1.0, std::atof(v));
+    else if (k == "--stats-s") c.statsS = uint32_t(std::atoi(v));
+    else return false;
+  }
+  return (argc % 2) == 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Config cfg;
+  if (!leerArgs(argc, argv, cfg)) {
+    std::fprintf(stderr, "argumentos no válidos (ver el comentario de src/uplink/main.cpp)\n");
+    return 2;
+  }
+  if (cfg.clave.empty() && std::getenv("THINGSPEAK_WRITE_KEY")) cfg.clave = std::getenv("THINGSPEAK_WRITE_KEY");
+  if (cfg.canal.empty() || cfg.clave.empty()) {
+    std::fprintf(stderr, "faltan --canal y --clave (o THINGSPEAK_WRITE_KEY)\n");
+    return 2;
+  }
+  std::signal(SIGINT, [](int) { gFin = true; });
+  std::signal(SIGTERM, [](int) { gFin = true; });
+
+  Compartido c;
+  if (!c.cola.open(cfg.dir, cfg.maxFilas)) return 1;
+  std::printf("uplink: canal %s en %s:%u, %llu filas pendientes en %s\n", cfg.canal.c_str(), cfg.tsHost.c_str(),
+              cfg.tsPort, (unsigned long long)c.cola.size(), cfg.dir.c_str());
+  std::fflush(stdout);
+  std::thread subida([&] { Subida(cfg, c)(); });
+  Entrada(cfg, c)();
+  subida.join();
+  return 0;
+}
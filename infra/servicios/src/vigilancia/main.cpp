@@ -0,0 +1,251 @@
+// --- VIGILANCIA DE LOS SENSORES ---
+// se suscribe a greenhouse/+/telemetry y lleva por cada serie <nodo>/<type> las estadísticas de una ventana de las
+//   últimas --muestras lecturas y los fallos de lib/Vigilancia (plano, silencio, invalido, pico). Publica:
+//   - greenhouse/<nodo>/estadisticas, cada --features-s y solo de las series que han recibido algo:
+//     {"ts":..,"type":"soil","n":32,"media":41.3,"desv":0.6,"min":40,"max":42,"pendiente":-0.05,"valor":41,"fallos":""}
+//     (pendiente por minuto; fallos: los activos separados por comas)
+//   - greenhouse/<nodo>/fallos, cuando un fallo empieza o acaba:
+//     {"ts":..,"type":"soil","fallo":"plano","activo":1,"valor":41}
+//     Los picos son sueltos: solo salen con "activo":1.
+//   - greenhouse/alerts, cuando un fallo empieza, con el formato de las alertas de "Reglas Auto" para que salgan en el
+//     mismo sitio del dashboard ([{"level":"WARN","title":"..","msg":".."}]); --alertas 0 lo quita.
+//
+// Un DHT11 que falla al leer no publica nada (DhtDriver.h), así que sus errores aparecen como silencio. La hora de las
+//   ventanas y del plano es el "ts" de la telemetría; la del silencio, la de llegada, para que una reproducción acelerada
+//   (grabador) no dé silencios falsos.
+//
+// Uso: program [--host 127.0.0.1] [--port 1884] [--muestras 32] [--features-s 10] [--alertas 1] [--stats-s 60]
+#include <JsonScan.h>
+#include <MqttClient.h>
+#include <Vigilancia.h>
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+uint64_t wallMs() {
+  using namespace std::chrono;
+  return uint64_t(duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count());
+}
+
+struct Config {
+  std::string host = "127.0.0.1";
+  uint16_t port = 1884; // el puerto que publica docker-compose
+  uint32_t muestras = 32;
+  uint32_t featuresS = 10;
+  bool alertas = true;
+  uint32_t statsS = 60;
+};
+
+// lo que hace falta para publicar; el estado de las ventanas está en vig::Ventanas con el mismo índice
+struct Serie {
+  std::string nodo;
+  const char* type;
+  bool nueva = false; // ha recibido algo desde las últimas estadísticas
+};
+
+// "plano,silencio"
+std::string nombresFallos(uint8_t activos) {
+  std::string s;
+  for (const vig::Fallo f : {vig::Plano, vig::Silencio, vig::Invalido}) {
+    if (!(activos & f)) continue;
+    if (!s.empty()) s += ',';
+    s += vig::nombreFallo(f);
+  }
+  return s;
+}
+
+std::atomic<bool> gFin{false};
+
+class Vigilancia {
+ public:
+  explicit Vigilancia(const Config& cfg) : cfg_(cfg), ventanas_(cfg.muestras) {}
+
+  bool conectar() {
+    char cid[48];
+    std::snprintf(cid, sizeof(cid), "vigilancia-%d", int(getpid()));
+    return cli_.connect(cfg_.host.c_str(), cfg_.port, cid) && cli_.subscribe("greenhouse/+/telemetry", 1);
+  }
+
+  int operator()() {
+    for (uint32_t espera = 1000; !gFin && !conectar(); espera = std::min(espera * 2, 30000u)) {
+      std::fprintf(stderr, "no se puede conectar a %s:%u, reintento en %u ms\n", cfg_.host.c_str(), cfg_.port, espera);
+      std::this_thread::sleep_for(std::chrono::milliseconds(espera));
+    }
+    std::printf("vigilancia: %s:%u, ventanas de %u muestras\n", cfg_.host.c_str(), cfg_.port, ventanas_.ventana());
+    std::fflush(stdout);
+    uint64_t siguienteRevision = wallMs() + 1000;
+    uint64_t siguientesFeatures = wallMs() + uint64_t(cfg_.featuresS) * 1000;
+    uint64_t siguienteLog = wallMs() + uint64_t(cfg_.statsS) * 1000;
+    while (!gFin) {
+      if (!cli_.poll(200, [this](const mqtt::PublishView& p) { recibir(p); })) {
+        std::fprintf(stderr, "conexión perdida; reconectando\n");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+        conectar();
+        continue;
+      }
+      const uint64_t ahora = wallMs();
+      if (ahora >= siguienteRevision) {
+        siguienteRevision = ahora + 1000;
+        ventanas_.revisar(int64_t(ahora), [&](uint32_t s) { fallo(s, vig::Silencio, true, NAN, ahora); });
+      }
+      if (cfg_.featuresS && ahora >= siguientesFeatures) {
+        siguientesFeatures = ahora + uint64_t(cfg_.featuresS) * 1000;
+        publicarFeatures(ahora);
+      }
+      if (cfg_.statsS && ahora >= siguienteLog) {
+        siguienteLog = ahora + uint64_t(cfg_.statsS) * 1000;
+        estadisticas();
+      }
+      cli_.flush();
+    }
+    estadisticas();
+    cli_.disconnect();
+    return 0;
+  }
+
+ private:
+  void recibir(const mqtt::PublishView& p) {
+    const uint64_t ahora = wallMs();
+    // greenhouse/<nodo>/telemetry
+    const size_t a = p.topic.find('/'), b = p.topic.rfind('/');
+    if (a == std::string_view::npos || b <= a + 1) return desconocidas_++, void();
+    std::string_view type, valor;
+    double ts = -1;
+    json::forEachField(p.payload, [&](std::string_view k, std::string_view v) {
+      if (k == "type") type = v;
+      else if (k == "ts") json::toDouble(v, ts);
+      else if (k == "value") valor = v;
+    });
+    const vig::Parametros* param = vig::parametros(type);
+    if (!param) return desconocidas_++, void();
+
+    clave_.assign(p.topic.data() + a + 1, b - a - 1);
+    clave_ += '/';
+    clave_.append(type.data(), type.size());
+    auto it = indice_.find(clave_);
+    if (it == indice_.end()) {
+      it = indice_.emplace(clave_, ventanas_.nueva(*param, int64_t(ahora))).first;
+      series_.push_back({std::string(p.topic.substr(a + 1, b - a - 1)), param->type});
+    }
+    const uint32_t s = it->second;
+    series_[s].nueva = true;
+    const auto alCambiar = [&](vig::Fallo f, bool activo, double v) { fallo(s, f, activo, v, ahora); };
+    double v;
+    if (!json::toDouble(valor, v) || !std::isfinite(v)) {
+      invalidas_++;
+      ventanas_.invalido(s, int64_t(ahora), alCambiar);
+      return;
+    }
+    muestras_++;
+    ventanas_.add(s, ts >= 0 ? int64_t(ts) : int64_t(ahora), v, int64_t(ahora), alCambiar);
+  }
+
+  void fallo(uint32_t s, vig::Fallo f, bool activo, double v, uint64_t ahora) {
+    const Serie& serie = series_[s];
+    eventos_++;
+    char topic[160], json[192];
+    std::snprintf(topic, sizeof(topic), "greenhouse/%s/fallos", serie.nodo.c_str());
+    int n = std::isnan(v) ? std::snprintf(json, sizeof(json),
+                                          "{\"ts\":%llu,\"type\":\"%s\",\"fallo\":\"%s\",\"activo\":%d}",
+                                          (unsigned long long)ahora, serie.type, vig::nombreFallo(f), activo ? 1 : 0)
+                          : std::snprintf(json, sizeof(json),
+                                          "{\"ts\":%llu,\"type\":\"%s\",\"fallo\":\"%s\",\"activo\":%d,\"valor\":%.15g}",
+                                          (unsigned long long)ahora, serie.type, vig::nombreFallo(f), activo ? 1 : 0, v);
+    if (n > 0 && size_t(n) < sizeof(json)) cli_.publish(topic, std::string_view(json, size_t(n)), 1);
+    if (!activo || !cfg_.alertas) return;
+
+    const char* titulo = "SENSOR CON PICOS";
+    const char* detalle = "lectura fuera de lo normal";
+    if (f == vig::Plano) titulo = "SENSOR PLANO", detalle = "sin cambios en horas";
+    else if (f == vig::Silencio) titulo = "SENSOR SIN DATOS", detalle = "no llegan lecturas";
+    else if (f == vig::Invalido) titulo = "SENSOR CON ERRORES", detalle = "valor no numérico";
+    n = std::snprintf(json, sizeof(json), "[{\"level\":\"WARN\",\"title\":\"%s\",\"msg\":\"%s/%s: %s\"}]", titulo,
+                      serie.nodo.c_str(), serie.type, detalle);
+    if (n > 0 && size_t(n) < sizeof(json)) cli_.publish("greenhouse/alerts", std::string_view(json, size_t(n)), 1);
+  }
+
+  void publicarFeatures(uint64_t ahora) {
+    char topic[160], json[320];
+    for (uint32_t s = 0; s < series_.size(); s++) {
+      Serie& serie = series_[s];
+      if (!serie.nueva) continue;
+      serie.nueva = false;
+      const vig::Features f = ventanas_.features(s);
+      if (!f.n) continue; // solo ha recibido inválidas
+      std::snprintf(topic, sizeof(topic), "greenhouse/%s/estadisticas", serie.nodo.c_str());
+      const int n = std::snprintf(json, sizeof(json),
+                                  "{\"ts\":%llu,\"type\":\"%s\",\"n\":%u,\"media\":%.4g,\"desv\":%.4g,\"min\":%.15g,"
+                                  "\"max\":%.15g,\"pendiente\":%.4g,\"valor\":%.15g,\"fallos\":\"%s\"}",
+                                  (unsigned long long)ahora, serie.type, f.n, f.media, f.desv, f.min, f.max,
+                                  f.pendiente, f.valor, nombresFallos(ventanas_.activos(s)).c_str());
+      if (n > 0 && size_t(n) < sizeof(json)) cli_.publish(topic, std::string_view(json, size_t(n)));
+      // con miles de series no se deja crecer el buffer de salida
+      if (s % 256 == 255) cli_.flush();
+    }
+  }
+
+  void estadisticas() {
+    uint32_t activos[3] = {};
+    for (uint32_t s = 0; s < series_.size(); s++) {
+      const uint8_t a = ventanas_.activos(s);
+      activos[0] += (a & vig::Plano) != 0;
+      activos[1] += (a & vig::Silencio) != 0;
+      activos[2] += (a & vig::Invalido) != 0;
+    }
+    std::printf("series %zu (%.1f MB), muestras %llu, inválidas %llu, desconocidas %llu, eventos %llu; "
+                "ahora planas %u, en silencio %u, con errores %u\n",
+                series_.size(), double(series_.size() * ventanas_.bytesPorSerie()) / 1e6,
+                (unsigned long long)muestras_, (unsigned long long)invalidas_, (unsigned long long)desconocidas_,
+                (unsigned long long)eventos_, activos[0], activos[1], activos[2]);
+    std::fflush(stdout);
+  }
+
+  const Config& cfg_;
+  MqttClient cli_;
+  vig::Ventanas ventanas_;
+  std::vector<Serie> series_;
+  std::unordered_map<std::string, uint32_t> indice_;
+  std::string clave_;
+  uint64_t muestras_ = 0, invalidas_ = 0, desconocidas_ = 0, eventos_ = 0;
+};
+
+bool leerArgs(int argc, char** argv, Config& c) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    const std::string k = argv[i];
+    const char* v = argv[i + 1];
+    if (k == "--host") c.host = v;
+    else if (k == "--port") c.port = uint16_t(std::atoi(v));
+    else if (k == "--muestras") c.muestras = uint32_t(std::atoi(v));
+    else if (k == "--features-s") c.featuresS = uint32_t(std::atoi(v));
+    else if (k == "--alertas") c.alertas = std::atoi(v) != 0;
+    else if (k == "--stats-s") c.statsS = uint32_t(std::atoi(v));
+    else return false;
+  }
+  return (argc % 2) == 1 && c.muestras >= 2 && c.muestras <= 4096;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Config cfg;
+  if (!leerArgs(argc, argv, cfg)) {
+    std::fprintf(stderr, "argumentos no válidos (ver el comentario de src/vigilancia/main.cpp)\n");
+    return 2;
+  }
+  std::signal(SIGINT, [](int) { gFin = true; });
+  std::signal(SIGTERM, [](int) { gFin = true; });
+  Vigilancia v(cfg);
+  return v();
+}